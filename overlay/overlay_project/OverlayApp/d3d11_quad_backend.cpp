@@ -0,0 +1,72 @@
+#include "d3d11_quad_backend.h"
+
+#include <cstring>
+
+// Function to create the vertex ring; the caller keeps the shaders and input layout bound
+bool D3D11QuadBackend::Init(ID3D11Device* newDevice, ID3D11DeviceContext* newContext, ID3D11RenderTargetView* newTarget, size_t ringBytes) {
+    device = newDevice;
+    context = newContext;
+    target = newTarget;
+    return CreateRing(ringBytes);
+}
+
+bool D3D11QuadBackend::CreateRing(size_t bytes) {
+    ring.Reset();
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = static_cast<UINT>(bytes / sizeof(QuadVertex) * sizeof(QuadVertex));
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device->CreateBuffer(&bufferDesc, nullptr, ring.ReleaseAndGetAddressOf()))) {
+        ringVertices = 0;
+        return false;
+    }
+    ringVertices = bufferDesc.ByteWidth / sizeof(QuadVertex);
+    writeVertex = ringVertices;  // Force a discard on first use
+    return true;
+}
+
+void D3D11QuadBackend::Clear(const QuadColor& color) {
+    float clearColor[4] = { color.r, color.g, color.b, color.a };
+    context->ClearRenderTargetView(target.Get(), clearColor);
+}
+
+bool D3D11QuadBackend::Draw(const QuadBatch& batch) {
+    UINT count = static_cast<UINT>(batch.VertexCount());
+    if (count == 0) {
+        return true;
+    }
+
+    // Grow the ring if a single frame no longer fits; this only happens on a new peak
+    if (count > ringVertices && !CreateRing(static_cast<size_t>(count) * 2 * sizeof(QuadVertex))) {
+        return false;
+    }
+
+    // Append behind the vertices the GPU may still be reading, or start over when the ring is full
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (writeVertex + count > ringVertices) {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        writeVertex = 0;
+    }
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(context->Map(ring.Get(), 0, mapType, 0, &mapped))) {
+        return false;
+    }
+    memcpy(static_cast<QuadVertex*>(mapped.pData) + writeVertex, batch.Vertices(), count * sizeof(QuadVertex));
+    context->Unmap(ring.Get(), 0);
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = static_cast<float>(batch.TargetWidth());
+    viewport.Height = static_cast<float>(batch.TargetHeight());
+    viewport.MaxDepth = 1.0f;
+    context->RSSetViewports(1, &viewport);
+
+    UINT stride = sizeof(QuadVertex);
+    UINT offset = 0;
+    ID3D11Buffer* buffer = ring.Get();
+    context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->Draw(count, writeVertex);
+    writeVertex += count;
+    return true;
+}
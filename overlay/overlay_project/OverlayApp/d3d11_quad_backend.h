@@ -0,0 +1,32 @@
+#ifndef D3D11_QUAD_BACKEND_H
+#define D3D11_QUAD_BACKEND_H
+
+#include "quad_batch.h"
+
+#include <d3d11.h>
+#include <wrl.h>
+
+// Draws quad batches with Direct3D 11. Vertices are streamed into one dynamic vertex buffer
+// used as a ring: each frame appends with D3D11_MAP_WRITE_NO_OVERWRITE and the buffer is only
+// discarded when it wraps, so a frame costs one Map, one copy and one Draw call regardless of
+// how many boxes it holds.
+class D3D11QuadBackend : public RenderBackend {
+public:
+    // Function to create the vertex ring; the caller keeps the shaders and input layout bound
+    bool Init(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11RenderTargetView* target, size_t ringBytes = 4 << 20);
+
+    void Clear(const QuadColor& color) override;
+    bool Draw(const QuadBatch& batch) override;
+
+private:
+    bool CreateRing(size_t bytes);
+
+    Microsoft::WRL::ComPtr<ID3D11Device> device;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+    Microsoft::WRL::ComPtr<ID3D11RenderTargetView> target;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> ring;
+    UINT ringVertices = 0;
+    UINT writeVertex = 0;
+};
+
+#endif // D3D11_QUAD_BACKEND_H
@@ -4,43 +4,101 @@
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
-#include <dxgi1_2.h>
+#include <dxgi1_5.h>
 #include <wrl.h>
 #include <sstream>
+#include <chrono>
+#include <memory>
+#include "async_log.h"
+#include "d3d11_quad_backend.h"
+#include "damage_tracker.h"
+#include "multi_output_pipeline.h"
+#include "frame_trace.h"
+#include "heatmap.h"
+#include "metrics.h"
+#include "region_mask.h"
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "d3dcompiler.lib")
-
-// Structure to represent a moving object
-struct MovingObject {
-    int x, y;
-    int velocityX, velocityY;
-};
-
-// Global list of moving objects
-std::vector<MovingObject> objects = {
-    {50, 50, 5, 3},
-    {100, 100, -3, 4},
-    {200, 150, 4, -2}
-};
+#pragma comment(lib, "dxgi.lib")
 
 // DirectX variables
 IDXGISwapChain* swapChain = nullptr;
+Microsoft::WRL::ComPtr<IDXGISwapChain1> swapChain1;
 ID3D11Device* device = nullptr;
 ID3D11DeviceContext* deviceContext = nullptr;
 ID3D11RenderTargetView* renderTargetView = nullptr;
 
-// DirectX variables for desktop duplication
-Microsoft::WRL::ComPtr<IDXGIOutputDuplication> outputDuplication;
-Microsoft::WRL::ComPtr<ID3D11Texture2D> acquiredDesktopImage;
+// One duplicated display output. Each output has its own device on its adapter, so outputs are
+// captured on their own threads without sharing an immediate context with each other or with
+// the overlay's render thread.
+struct DuplicatedOutput {
+    UINT adapterIndex = 0;
+    UINT outputIndex = 0;
+    // Position on the virtual desktop
+    RECT desktopRect = {};
+    Microsoft::WRL::ComPtr<ID3D11Device> device;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+    Microsoft::WRL::ComPtr<IDXGIOutputDuplication> duplication;
+    // First image, used to size the staging texture
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> acquiredDesktopImage;
+    // Staging texture used to read captured frames back into the pipeline's frame buffers
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> stagingFrame;
+    // HDR desktops are duplicated as 10-bit or half-float surfaces
+    PixelFormat pixelFormat = PixelFormat::BGRA8;
+};
+
+// Every output attached to the desktop
+std::vector<std::unique_ptr<DuplicatedOutput>> duplicatedOutputs;
 
-// Buffer to store previous frame
-Microsoft::WRL::ComPtr<ID3D11Texture2D> previousFrame;
+// Top-left corner of the virtual screen. The overlay window covers the whole virtual screen and
+// outputs are placed relative to this corner, so detection results are overlay window pixels.
+POINT virtualOrigin = {};
 
-// Vertex structure
-struct Vertex {
-    DirectX::XMFLOAT3 position;
-    DirectX::XMFLOAT4 color;
-};
+// Movement detection settings; the detector itself runs on the pipeline's detect thread
+DetectorConfig detectorConfig;
+
+// Detected boxes are merged into at most coalesceConfig.maxBoxes before they are drawn
+CoalesceConfig coalesceConfig;
+
+// Split changes into moved and newly drawn regions (--motion)
+bool estimateMotion = false;
+
+// Capture pacing (--fps N, 0 captures every desktop update as it arrives)
+SchedulerConfig scheduleConfig = { 60 };
+
+// The message thread's timer only polls the mask file; frames are paced by the pipeline
+const UINT kMaskPollMs = 250;
+
+// Optional include/exclude regions, reloaded whenever the file is rewritten (--mask <path>)
+std::string maskPath;
+FILETIME maskWriteTime = {};
+MultiOutputPipeline* activePipeline = nullptr;
+
+// Optional recording of captured frames for offline replay (--record <path>)
+std::string tracePath;
+TraceEncoding traceEncoding = TraceEncoding::DeltaTiles;
+TraceWriter traceWriter;
+std::chrono::steady_clock::time_point traceStartTime;
+
+// Optional stage timing snapshots written as JSON lines (--metrics <path>)
+std::string metricsPath;
+
+// Optional shared memory ring other processes read detected boxes and tracks from (--events <name>)
+std::string eventsName;
+EventRingWriter eventRing;
+
+// Optional per-output motion heatmaps, written on Ctrl+Alt+H and at exit (--heatmap <path>)
+std::string heatmapPath;
+std::vector<std::unique_ptr<Heatmap>> heatmaps;
+const int kHeatmapHotKey = 1;
+
+// Quads drawn each frame are collected into one batch and submitted with a single draw
+QuadBatch quadBatch;
+D3D11QuadBackend quadBackend;
+
+// Frames only repaint and present the rectangles whose quads changed
+DamageTracker damageTracker;
+std::vector<RECT> dirtyRects;
 
 // DirectX shader variables
 ID3D11VertexShader* vertexShader = nullptr;
@@ -79,13 +137,6 @@ float4 main(PS_INPUT input) : SV_TARGET {
 }
 )";
 
-// Function to convert an integer to a string
-std::string IntToString(int value) {
-    std::ostringstream oss;
-    oss << value;
-    return oss.str();
-}
-
 // Function to set DPI awareness
 void SetDPIAwareness() {
     HMODULE hUser32 = LoadLibraryA("user32.dll");
@@ -99,34 +150,65 @@ void SetDPIAwareness() {
     }
 }
 
-// Function to log errors
-void LogError(const std::string& message) {
-    std::cerr << "Error: " << message << std::endl;
-    MessageBoxA(nullptr, message.c_str(), "Error", MB_OK | MB_ICONERROR);
-}
-
-// Function to log information
-void LogInfo(const std::string& message) {
-    std::cout << "Info: " << message << std::endl;
+// Function to report an error that stops the application. The message box blocks, so this is
+// only used during start-up; other errors are logged with OVERLAY_LOG_ERROR.
+void ReportFatalError(const char* message) {
+    OVERLAY_LOG_ERROR("{}", message);
+    FlushLog();
+    MessageBoxA(nullptr, message, "Error", MB_OK | MB_ICONERROR);
 }
 
-// Function to update positions of all objects
-void UpdateObjectPositions() {
-    RECT rect;
-    GetClientRect(GetDesktopWindow(), &rect);
-    for (auto& obj : objects) {
-        obj.x += obj.velocityX;
-        obj.y += obj.velocityY;
-
-        // Bounce off the window edges
-        if (obj.x < 0 || obj.x > rect.right - 50) obj.velocityX = -obj.velocityX;
-        if (obj.y < 0 || obj.y > rect.bottom - 50) obj.velocityY = -obj.velocityY;
+// Function to parse command line options such as "--threads 4"
+void ParseCommandLine(const char* commandLine) {
+    std::istringstream args(commandLine ? commandLine : "");
+    std::string option;
+    while (args >> option) {
+        if (option == "--threads") {
+            args >> detectorConfig.threadCount;
+        } else if (option == "--hash-tiles") {
+            detectorConfig.mode = DetectionMode::TileHash;
+        } else if (option == "--verify-hashes") {
+            detectorConfig.verifyHashes = true;
+        } else if (option == "--pyramid") {
+            detectorConfig.mode = DetectionMode::Pyramid;
+            args >> detectorConfig.pyramidScale;
+        } else if (option == "--background") {
+            detectorConfig.mode = DetectionMode::Background;
+            args >> detectorConfig.backgroundThreshold;
+        } else if (option == "--min-box-area") {
+            args >> detectorConfig.minBoxArea;
+        } else if (option == "--merge-gap") {
+            args >> coalesceConfig.gap;
+        } else if (option == "--max-boxes") {
+            args >> coalesceConfig.maxBoxes;
+        } else if (option == "--motion") {
+            estimateMotion = true;
+        } else if (option == "--mask") {
+            args >> maskPath;
+        } else if (option == "--record") {
+            args >> tracePath;
+        } else if (option == "--record-raw") {
+            args >> tracePath;
+            traceEncoding = TraceEncoding::Raw;
+        } else if (option == "--metrics") {
+            args >> metricsPath;
+        } else if (option == "--events") {
+            args >> eventsName;
+        } else if (option == "--heatmap") {
+            args >> heatmapPath;
+        } else if (option == "--fps") {
+            args >> scheduleConfig.targetFps;
+        } else if (option == "--sample-hot") {
+            args >> detectorConfig.sampling.sampleInterval;
+        } else {
+            OVERLAY_LOG_INFO("Ignoring unknown option: {}", option);
+        }
     }
 }
 
 // Function to initialize DirectX
 bool InitDirectX(HWND hwnd) {
-    LogInfo("Initializing DirectX...");
+    OVERLAY_LOG_INFO("Initializing DirectX...");
     DXGI_SWAP_CHAIN_DESC scd = {};
     scd.BufferCount = 1;
     scd.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -134,7 +216,9 @@ bool InitDirectX(HWND hwnd) {
     scd.OutputWindow = hwnd;
     scd.SampleDesc.Count = 1;
     scd.Windowed = TRUE;
-    scd.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+    // Sequential keeps the single back buffer's contents across Present, so a frame only has to
+    // repaint what changed
+    scd.SwapEffect = DXGI_SWAP_EFFECT_SEQUENTIAL;
 
     HRESULT hr = D3D11CreateDeviceAndSwapChain(
         nullptr,
@@ -152,30 +236,35 @@ bool InitDirectX(HWND hwnd) {
     );
 
     if (FAILED(hr)) {
-        LogError("Failed to create DirectX device and swap chain.");
+        OVERLAY_LOG_ERROR("Failed to create DirectX device and swap chain.");
         return false;
     }
-    LogInfo("DirectX device and swap chain created successfully.");
+    OVERLAY_LOG_INFO("DirectX device and swap chain created successfully.");
 
     ID3D11Texture2D* backBuffer = nullptr;
     hr = swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&backBuffer);
     if (FAILED(hr)) {
-        LogError("Failed to get back buffer.");
+        OVERLAY_LOG_ERROR("Failed to get back buffer.");
         return false;
     }
-    LogInfo("Back buffer obtained successfully.");
+    OVERLAY_LOG_INFO("Back buffer obtained successfully.");
 
     hr = device->CreateRenderTargetView(backBuffer, nullptr, &renderTargetView);
     if (FAILED(hr)) {
-        LogError("Failed to create render target view.");
+        OVERLAY_LOG_ERROR("Failed to create render target view.");
         return false;
     }
-    LogInfo("Render target view created successfully.");
+    OVERLAY_LOG_INFO("Render target view created successfully.");
 
     backBuffer->Release();
 
     deviceContext->OMSetRenderTargets(1, &renderTargetView, nullptr);
 
+    // Present1 takes dirty rectangles; without it every frame is presented whole
+    if (FAILED(swapChain->QueryInterface(__uuidof(IDXGISwapChain1), reinterpret_cast<void**>(swapChain1.GetAddressOf())))) {
+        OVERLAY_LOG_INFO("IDXGISwapChain1 unavailable, presenting full frames.");
+    }
+
     return true;
 }
 
@@ -186,37 +275,37 @@ HRESULT CompileShader(const char* source, const char* entryPoint, const char* ta
 
 // Function to initialize shaders
 bool InitShaders() {
-    LogInfo("Initializing shaders...");
+    OVERLAY_LOG_INFO("Initializing shaders...");
     ID3DBlob* vsBlob = nullptr;
     ID3DBlob* psBlob = nullptr;
 
     // Compile vertex shader
     if (FAILED(CompileShader(vertexShaderSource, "main", "vs_5_0", &vsBlob))) {
-        LogError("Failed to compile vertex shader.");
+        OVERLAY_LOG_ERROR("Failed to compile vertex shader.");
         return false;
     }
-    LogInfo("Vertex shader compiled successfully.");
+    OVERLAY_LOG_INFO("Vertex shader compiled successfully.");
 
     // Compile pixel shader
     if (FAILED(CompileShader(pixelShaderSource, "main", "ps_5_0", &psBlob))) {
-        LogError("Failed to compile pixel shader.");
+        OVERLAY_LOG_ERROR("Failed to compile pixel shader.");
         return false;
     }
-    LogInfo("Pixel shader compiled successfully.");
+    OVERLAY_LOG_INFO("Pixel shader compiled successfully.");
 
     // Create vertex shader
     if (FAILED(device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &vertexShader))) {
-        LogError("Failed to create vertex shader.");
+        OVERLAY_LOG_ERROR("Failed to create vertex shader.");
         return false;
     }
-    LogInfo("Vertex shader created successfully.");
+    OVERLAY_LOG_INFO("Vertex shader created successfully.");
 
     // Create pixel shader
     if (FAILED(device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &pixelShader))) {
-        LogError("Failed to create pixel shader.");
+        OVERLAY_LOG_ERROR("Failed to create pixel shader.");
         return false;
     }
-    LogInfo("Pixel shader created successfully.");
+    OVERLAY_LOG_INFO("Pixel shader created successfully.");
 
     // Define input layout
     D3D11_INPUT_ELEMENT_DESC layout[] = {
@@ -226,10 +315,10 @@ bool InitShaders() {
 
     // Create input layout
     if (FAILED(device->CreateInputLayout(layout, ARRAYSIZE(layout), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &inputLayout))) {
-        LogError("Failed to create input layout.");
+        OVERLAY_LOG_ERROR("Failed to create input layout.");
         return false;
     }
-    LogInfo("Input layout created successfully.");
+    OVERLAY_LOG_INFO("Input layout created successfully.");
 
     // Release shader blobs
     vsBlob->Release();
@@ -238,10 +327,65 @@ bool InitShaders() {
     return true;
 }
 
-// Function to render a frame with DirectX
-void RenderFrame() {
-    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f }; // Ensure fully transparent background
-    deviceContext->ClearRenderTargetView(renderTargetView, clearColor);
+// Function to render overlay based on detected changes
+void RenderOverlay(const std::vector<Box>& boxes) {
+    // Add boxes around detected changes to this frame's batch
+    quadBatch.AddQuads(boxes, { 1.0f, 0.0f, 0.0f, 1.0f }); // Red
+}
+
+// Function to present the back buffer, passing the repainted rectangles when only part of it changed
+void PresentFrame(DamageKind damage) {
+    OVERLAY_METRICS_SCOPE(StageMetric::Present);
+    if (damage == DamageKind::Partial && swapChain1) {
+        const std::vector<Box>& rects = damageTracker.DirtyRects();
+        dirtyRects.resize(rects.size());
+        for (size_t i = 0; i < rects.size(); ++i) {
+            dirtyRects[i] = { rects[i].left, rects[i].top, rects[i].right, rects[i].bottom };
+        }
+        DXGI_PRESENT_PARAMETERS parameters = {};
+        parameters.DirtyRectsCount = static_cast<UINT>(dirtyRects.size());
+        parameters.pDirtyRects = dirtyRects.data();
+        swapChain1->Present1(0, 0, &parameters);
+        return;
+    }
+    swapChain->Present(0, 0);
+}
+
+// Function to render a frame with DirectX, runs on the pipeline's render thread
+void RenderFrame(const PipelineResult& result) {
+    DXGI_SWAP_CHAIN_DESC scd;
+    swapChain->GetDesc(&scd);
+    quadBatch.Begin(static_cast<int>(scd.BufferDesc.Width), static_cast<int>(scd.BufferDesc.Height));
+
+    // Add each tracked object, as tracked by the pipeline's detect stage
+    for (const Track& track : result.tracks) {
+        quadBatch.AddQuad(track.box, { 0.0f, 1.0f, 0.0f, 0.25f }); // Semi-transparent green
+    }
+
+    // Add regions that change in most frames, such as playing videos, sampled at a lower rate
+    for (const Box& region : result.activity) {
+        quadBatch.AddQuad(region, { 1.0f, 0.5f, 0.0f, 0.25f }); // Semi-transparent orange
+    }
+
+    // Add regions that only moved since the previous frame
+    for (const MoveRect& move : result.moves) {
+        quadBatch.AddQuad(move.box, { 0.0f, 0.5f, 1.0f, 0.25f }); // Semi-transparent blue
+    }
+
+    // Add boxes around the changes found in the latest detected frame
+    RenderOverlay(result.boxes);
+
+    // Only repaint the parts of the overlay whose quads changed since the last frame
+    const QuadColor transparent = { 0.0f, 0.0f, 0.0f, 0.0f };
+    DamageKind damage = damageTracker.Update(quadBatch, transparent);
+    if (damage == DamageKind::None) {
+        return;
+    }
+    OVERLAY_METRICS_COUNT(CounterMetric::DirtyPixels, damageTracker.Stats().dirtyPixels);
+
+    if (damage == DamageKind::Full) {
+        quadBackend.Clear(transparent); // Ensure fully transparent background
+    }
 
     // Set shaders
     deviceContext->VSSetShader(vertexShader, nullptr, 0);
@@ -250,265 +394,359 @@ void RenderFrame() {
     // Set input layout
     deviceContext->IASetInputLayout(inputLayout);
 
-    // Draw each moving object
-    for (const auto& obj : objects) {
-        // Define vertices for a rectangle (box)
-        Vertex vertices[] = {
-            { { static_cast<float>(obj.x), static_cast<float>(obj.y), 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } }, // Fully transparent
-            { { static_cast<float>(obj.x + 50), static_cast<float>(obj.y), 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } },
-            { { static_cast<float>(obj.x), static_cast<float>(obj.y + 50), 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } },
-            { { static_cast<float>(obj.x + 50), static_cast<float>(obj.y + 50), 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } },
-        };
-
-        // Create vertex buffer
-        D3D11_BUFFER_DESC bufferDesc = {};
-        bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        bufferDesc.ByteWidth = sizeof(vertices);
-        bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        D3D11_SUBRESOURCE_DATA initData = { vertices, 0, 0 };
-        ID3D11Buffer* vertexBuffer;
-        device->CreateBuffer(&bufferDesc, &initData, &vertexBuffer);
-
-        // Set vertex buffer
-        UINT stride = sizeof(Vertex);
-        UINT offset = 0;
-        deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-
-        // Draw rectangle
-        deviceContext->Draw(4, 0);
-
-        // Release vertex buffer
-        vertexBuffer->Release();
+    // Draw every quad, or the clears and clipped quads repairing the dirty rectangles, with one
+    // upload and one draw call
+    if (!quadBackend.Draw(damage == DamageKind::Full ? quadBatch : damageTracker.RepairBatch())) {
+        OVERLAY_LOG_ERROR("Failed to draw overlay quads.");
+        damageTracker.Invalidate();
     }
 
-    swapChain->Present(0, 0);
+    PresentFrame(damage);
 }
 
-// Function to initialize desktop duplication
-bool InitDesktopDuplication(ID3D11Device* device) {
-    LogInfo("Initializing desktop duplication...");
-    Microsoft::WRL::ComPtr<IDXGIDevice> dxgiDevice;
-    device->QueryInterface(__uuidof(IDXGIDevice), reinterpret_cast<void**>(dxgiDevice.GetAddressOf()));
-
-    Microsoft::WRL::ComPtr<IDXGIAdapter> dxgiAdapter;
-    dxgiDevice->GetParent(__uuidof(IDXGIAdapter), reinterpret_cast<void**>(dxgiAdapter.GetAddressOf()));
-
-    Microsoft::WRL::ComPtr<IDXGIOutput> dxgiOutput;
-    dxgiAdapter->EnumOutputs(0, dxgiOutput.GetAddressOf());
+// Function to duplicate one output on its own device, returns false if it cannot be duplicated
+bool InitOutputDuplication(IDXGIAdapter1* adapter, IDXGIOutput* dxgiOutput, DuplicatedOutput& output) {
+    HRESULT hr = D3D11CreateDevice(adapter, D3D_DRIVER_TYPE_UNKNOWN, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+                                   output.device.GetAddressOf(), nullptr, output.context.GetAddressOf());
+    if (FAILED(hr)) {
+        OVERLAY_LOG_ERROR("Failed to create capture device. HRESULT: {}", hr);
+        return false;
+    }
 
     Microsoft::WRL::ComPtr<IDXGIOutput1> dxgiOutput1;
     dxgiOutput->QueryInterface(__uuidof(IDXGIOutput1), reinterpret_cast<void**>(dxgiOutput1.GetAddressOf()));
-
-    if (!dxgiDevice) {
-        LogError("Failed to get DXGI device.");
+    if (!dxgiOutput1) {
+        OVERLAY_LOG_ERROR("Failed to get DXGI output1.");
         return false;
     }
-    LogInfo("DXGI device obtained successfully.");
 
-    if (!dxgiAdapter) {
-        LogError("Failed to get DXGI adapter.");
+    // Ask for the desktop's own format where DuplicateOutput1 exists, so HDR desktops are not
+    // converted to 8-bit; the detector handles each of these formats
+    hr = E_NOINTERFACE;
+    Microsoft::WRL::ComPtr<IDXGIOutput5> dxgiOutput5;
+    if (SUCCEEDED(dxgiOutput->QueryInterface(__uuidof(IDXGIOutput5), reinterpret_cast<void**>(dxgiOutput5.GetAddressOf())))) {
+        const DXGI_FORMAT formats[] = { DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R10G10B10A2_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM };
+        hr = dxgiOutput5->DuplicateOutput1(output.device.Get(), 0, ARRAYSIZE(formats), formats, output.duplication.GetAddressOf());
+    }
+    if (FAILED(hr)) {
+        hr = dxgiOutput1->DuplicateOutput(output.device.Get(), output.duplication.GetAddressOf());
+    }
+    if (FAILED(hr)) {
+        OVERLAY_LOG_ERROR("Failed to duplicate output. HRESULT: {}", hr);
         return false;
     }
-    LogInfo("DXGI adapter obtained successfully.");
+    return true;
+}
 
-    if (!dxgiOutput) {
-        LogError("Failed to get DXGI output.");
+// Function to initialize desktop duplication for every output attached to the desktop
+bool InitDesktopDuplication() {
+    OVERLAY_LOG_INFO("Initializing desktop duplication...");
+    Microsoft::WRL::ComPtr<IDXGIFactory1> factory;
+    if (FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void**>(factory.GetAddressOf())))) {
+        OVERLAY_LOG_ERROR("Failed to create DXGI factory.");
         return false;
     }
-    LogInfo("DXGI output obtained successfully.");
 
-    if (!dxgiOutput1) {
-        LogError("Failed to get DXGI output1.");
-        return false;
+    Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
+    for (UINT adapterIndex = 0; factory->EnumAdapters1(adapterIndex, adapter.ReleaseAndGetAddressOf()) != DXGI_ERROR_NOT_FOUND; ++adapterIndex) {
+        Microsoft::WRL::ComPtr<IDXGIOutput> dxgiOutput;
+        for (UINT outputIndex = 0; adapter->EnumOutputs(outputIndex, dxgiOutput.ReleaseAndGetAddressOf()) != DXGI_ERROR_NOT_FOUND; ++outputIndex) {
+            DXGI_OUTPUT_DESC outputDesc;
+            if (FAILED(dxgiOutput->GetDesc(&outputDesc)) || !outputDesc.AttachedToDesktop) {
+                continue;
+            }
+            std::unique_ptr<DuplicatedOutput> output = std::make_unique<DuplicatedOutput>();
+            output->adapterIndex = adapterIndex;
+            output->outputIndex = outputIndex;
+            output->desktopRect = outputDesc.DesktopCoordinates;
+            const RECT& rect = output->desktopRect;
+            if (!InitOutputDuplication(adapter.Get(), dxgiOutput.Get(), *output)) {
+                OVERLAY_LOG_ERROR("Skipping output {} of adapter {}.", outputIndex, adapterIndex);
+                continue;
+            }
+            OVERLAY_LOG_INFO("Duplicating output {} of adapter {}: {}x{} at {},{}.", outputIndex, adapterIndex, rect.right - rect.left,
+                             rect.bottom - rect.top, rect.left, rect.top);
+            duplicatedOutputs.push_back(std::move(output));
+        }
     }
-    LogInfo("DXGI output1 obtained successfully.");
 
-    HRESULT hr = dxgiOutput1->DuplicateOutput(device, outputDuplication.GetAddressOf());
-    if (FAILED(hr)) {
-        LogError("Failed to initialize desktop duplication.");
+    if (duplicatedOutputs.empty()) {
+        OVERLAY_LOG_ERROR("Failed to initialize desktop duplication.");
         return false;
     }
-    LogInfo("Desktop duplication initialized successfully.");
+    OVERLAY_LOG_INFO("Desktop duplication initialized successfully for {} output(s).", duplicatedOutputs.size());
     return true;
 }
 
 // Function to capture a frame
-bool CaptureFrame() {
-    LogInfo("Capturing frame...");
-    if (!outputDuplication) {
-        LogError("Output duplication not initialized.");
+bool CaptureFrame(DuplicatedOutput& output) {
+    OVERLAY_LOG_INFO("Capturing frame...");
+    if (!output.duplication) {
+        OVERLAY_LOG_ERROR("Output duplication not initialized.");
         return false;
     }
 
     DXGI_OUTDUPL_FRAME_INFO frameInfo;
     Microsoft::WRL::ComPtr<IDXGIResource> desktopResource;
-    HRESULT hr = outputDuplication->AcquireNextFrame(0, &frameInfo, desktopResource.GetAddressOf());
+    // Wait for the first image instead of failing when the desktop has not been presented yet
+    HRESULT hr = output.duplication->AcquireNextFrame(500, &frameInfo, desktopResource.GetAddressOf());
     if (FAILED(hr)) {
-        LogError("Failed to acquire next frame.");
+        OVERLAY_LOG_ERROR("Failed to acquire next frame.");
         return false;
     }
-    LogInfo("Next frame acquired successfully.");
+    OVERLAY_LOG_INFO("Next frame acquired successfully.");
 
-    hr = desktopResource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(acquiredDesktopImage.GetAddressOf()));
+    hr = desktopResource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(output.acquiredDesktopImage.GetAddressOf()));
     if (FAILED(hr)) {
-        LogError("Failed to query interface for acquired desktop image.");
-        outputDuplication->ReleaseFrame();
+        OVERLAY_LOG_ERROR("Failed to query interface for acquired desktop image.");
+        output.duplication->ReleaseFrame();
         return false;
     }
-    LogInfo("Acquired desktop image queried successfully.");
+    OVERLAY_LOG_INFO("Acquired desktop image queried successfully.");
 
     // Ensure the acquired image is in the correct state
     D3D11_TEXTURE2D_DESC desc;
-    acquiredDesktopImage->GetDesc(&desc);
-    LogInfo("Acquired image width: " + IntToString(desc.Width) + ", height: " + IntToString(desc.Height) + ", format: " + IntToString(desc.Format) + ", usage: " + IntToString(desc.Usage) + ", CPU access flags: " + IntToString(desc.CPUAccessFlags));
+    output.acquiredDesktopImage->GetDesc(&desc);
+    OVERLAY_LOG_INFO("Acquired image width: {}, height: {}, format: {}, usage: {}, CPU access flags: {}", desc.Width, desc.Height, desc.Format, desc.Usage, desc.CPUAccessFlags);
 
     // Process the frame (e.g., detect changes)
 
-    outputDuplication->ReleaseFrame();
+    output.duplication->ReleaseFrame();
     return true;
 }
 
+// Function to capture the next frame of an output into a pipeline frame buffer, runs on the
+// output's capture thread. Returns false when the output has not changed within the timeout. A
+// paced pipeline only calls this when a frame is due, so it polls; otherwise it waits up to 16 ms
+// for an update.
+bool ReadFrame(DuplicatedOutput& output, PipelineFrame& frame) {
+    DXGI_OUTDUPL_FRAME_INFO frameInfo;
+    Microsoft::WRL::ComPtr<IDXGIResource> desktopResource;
+#if OVERLAY_ENABLE_METRICS
+    uint64_t acquireStart = MetricsClockNs();
+#endif
+    UINT timeoutMs = scheduleConfig.targetFps > 0 ? 0 : 16;
+    HRESULT hr = output.duplication->AcquireNextFrame(timeoutMs, &frameInfo, desktopResource.GetAddressOf());
+    if (hr == DXGI_ERROR_WAIT_TIMEOUT) {
+        return false;
+    }
+    OVERLAY_METRICS_TIME(StageMetric::Capture, MetricsClockNs() - acquireStart);
+    if (FAILED(hr)) {
+        OVERLAY_LOG_ERROR("Failed to acquire next frame. HRESULT: {}", hr);
+        return false;
+    }
+    int64_t captureTimeUs = PipelineClockUs();
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> desktopImage;
+    hr = desktopResource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(desktopImage.GetAddressOf()));
+    if (FAILED(hr)) {
+        OVERLAY_LOG_ERROR("Failed to query interface for acquired desktop image.");
+        output.duplication->ReleaseFrame();
+        return false;
+    }
+
+    // Copy the desktop image to the staging texture and read it back into the frame buffer
+    OVERLAY_METRICS_SCOPE(StageMetric::Readback);
+    D3D11_TEXTURE2D_DESC desc;
+    output.stagingFrame->GetDesc(&desc);
+    output.context->CopyResource(output.stagingFrame.Get(), desktopImage.Get());
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    hr = output.context->Map(output.stagingFrame.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr)) {
+        OVERLAY_LOG_ERROR("Failed to map staging frame. HRESULT: {}", hr);
+        output.duplication->ReleaseFrame();
+        return false;
+    }
+    size_t rowBytes = static_cast<size_t>(desc.Width) * PixelFormatBytes(output.pixelFormat);
+    for (UINT y = 0; y < desc.Height; ++y) {
+        memcpy(frame.pixels.data() + y * rowBytes, static_cast<const uint8_t*>(mapped.pData) + y * mapped.RowPitch, rowBytes);
+    }
+    output.context->Unmap(output.stagingFrame.Get(), 0);
+    output.duplication->ReleaseFrame();
+
+    frame.view = { frame.pixels.data(), static_cast<int>(desc.Width), static_cast<int>(desc.Height), static_cast<int>(rowBytes), output.pixelFormat };
+    frame.captureTimeUs = captureTimeUs;
+    return true;
+}
+
+// Function to map a duplicated surface format to the detector's pixel format, returns false if unsupported
+bool PixelFormatFromDxgi(DXGI_FORMAT dxgiFormat, PixelFormat& format) {
+    switch (dxgiFormat) {
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+        format = PixelFormat::BGRA8;
+        return true;
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+        format = PixelFormat::RGB10A2;
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        format = PixelFormat::RGBA16F;
+        return true;
+    default:
+        return false;
+    }
+}
+
 // Function to initialize frame buffers
-bool InitFrameBuffers() {
-    LogInfo("Initializing frame buffers...");
-    if (!acquiredDesktopImage) {
-        LogError("Acquired desktop image is not initialized.");
+bool InitFrameBuffers(DuplicatedOutput& output) {
+    OVERLAY_LOG_INFO("Initializing frame buffers...");
+    if (!output.acquiredDesktopImage) {
+        OVERLAY_LOG_ERROR("Acquired desktop image is not initialized.");
         return false;
     }
 
     D3D11_TEXTURE2D_DESC desc;
-    acquiredDesktopImage->GetDesc(&desc);
+    output.acquiredDesktopImage->GetDesc(&desc);
+    if (!PixelFormatFromDxgi(desc.Format, output.pixelFormat)) {
+        OVERLAY_LOG_ERROR("Unsupported desktop format: {}", desc.Format);
+        return false;
+    }
+    OVERLAY_LOG_INFO("Desktop pixel format: {}", PixelFormatName(output.pixelFormat));
     desc.BindFlags = 0;
     desc.Usage = D3D11_USAGE_STAGING;
     desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
     desc.MiscFlags = 0;
 
-    HRESULT hr = device->CreateTexture2D(&desc, nullptr, previousFrame.GetAddressOf());
+    HRESULT hr = output.device->CreateTexture2D(&desc, nullptr, output.stagingFrame.GetAddressOf());
     if (FAILED(hr)) {
-        LogError("Failed to create previous frame buffer.");
+        OVERLAY_LOG_ERROR("Failed to create staging frame buffer.");
         return false;
     }
-    LogInfo("Previous frame buffer created successfully.");
+    OVERLAY_LOG_INFO("Staging frame buffer created successfully.");
     return true;
 }
 
-// Function to detect movement
-std::vector<RECT> DetectMovement() {
-    LogInfo("Detecting movement...");
-    std::vector<RECT> movingAreas;
+// Function to append a captured frame to the trace file when recording is enabled.
+// Delta traces reuse the detector's tile map when it is exact, so only changed tiles are
+// encoded; otherwise (`changedTiles` null) the writer finds them from tile hashes.
+void RecordFrame(const FrameView& frame, const TileMap* changedTiles) {
+    if (tracePath.empty()) {
+        return;
+    }
+    // Traces store 8-bit BGRA only
+    if (frame.format != PixelFormat::BGRA8) {
+        OVERLAY_LOG_ERROR("Cannot record {} frames, recording stopped.", PixelFormatName(frame.format));
+        tracePath.clear();
+        return;
+    }
+    if (!traceWriter.IsOpen()) {
+        TraceWriterOptions options;
+        options.encoding = traceEncoding;
+        options.tileSize = detectorConfig.tileSize;
+        if (!traceWriter.Open(tracePath.c_str(), frame.width, frame.height, options)) {
+            OVERLAY_LOG_ERROR("Failed to create trace file: {}", tracePath);
+            tracePath.clear();
+            return;
+        }
+        traceStartTime = std::chrono::steady_clock::now();
+        OVERLAY_LOG_INFO("Recording frames to {}", tracePath);
+    }
+    int64_t timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - traceStartTime).count();
+    if (!traceWriter.WriteFrame(frame, timestampUs, changedTiles)) {
+        OVERLAY_LOG_ERROR("Failed to write frame to trace file, recording stopped.");
+        traceWriter.Close();
+        tracePath.clear();
+    }
+}
+
+// Pipeline stage reading one output's desktop duplication frames
+class DesktopCapture : public CaptureStage {
+public:
+    explicit DesktopCapture(DuplicatedOutput& output) : output(output) {}
+    bool Capture(PipelineFrame& frame) override { return ReadFrame(output, frame); }
+
+private:
+    DuplicatedOutput& output;
+};
+
+// Pipeline stage presenting the overlay for each detection result
+class OverlayRender : public RenderStage {
+public:
+    void Render(const PipelineResult& result) override { RenderFrame(result); }
+};
 
-    // Verify acquiredDesktopImage is not null
-    if (!acquiredDesktopImage) {
-        LogError("Acquired desktop image is null.");
-        return movingAreas;
+// Pipeline hook recording each detected frame of the first output when --record is given
+class FrameRecorder : public DetectListener {
+public:
+    void OnFrameDetected(const PipelineFrame& frame, const MotionDetector& detector) override {
+        RecordFrame(frame.view, detector.TilesAreExact() ? &detector.Tiles() : nullptr);
     }
+};
 
-    // Map the current and previous frames for reading
-    D3D11_MAPPED_SUBRESOURCE currentMapped, previousMapped;
-    HRESULT hr = deviceContext->Map(acquiredDesktopImage.Get(), 0, D3D11_MAP_READ, 0, &currentMapped);
-    if (FAILED(hr)) {
-        LogError("Failed to map current frame. HRESULT: " + IntToString(hr));
-        return movingAreas;
+// Function to load the mask regions into the running pipeline when the mask file was written
+// since the last check; polled from the message thread's timer every kMaskPollMs
+void ReloadMaskIfChanged() {
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (maskPath.empty() || !activePipeline || !GetFileAttributesExA(maskPath.c_str(), GetFileExInfoStandard, &attributes)) {
+        return;
     }
-    hr = deviceContext->Map(previousFrame.Get(), 0, D3D11_MAP_READ, 0, &previousMapped);
-    if (FAILED(hr)) {
-        LogError("Failed to map previous frame. HRESULT: " + IntToString(hr));
-        deviceContext->Unmap(acquiredDesktopImage.Get(), 0);
-        return movingAreas;
+    if (CompareFileTime(&attributes.ftLastWriteTime, &maskWriteTime) == 0) {
+        return;
     }
-
-    // Compare pixel data to detect changes
-    BYTE* currentPixels = static_cast<BYTE*>(currentMapped.pData);
-    BYTE* previousPixels = static_cast<BYTE*>(previousMapped.pData);
-    D3D11_TEXTURE2D_DESC desc;
-    acquiredDesktopImage->GetDesc(&desc);
-    int width = desc.Width;
-    int height = desc.Height;
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            int index = (y * currentMapped.RowPitch) + (x * 4);
-            if (memcmp(&currentPixels[index], &previousPixels[index], 4) != 0) {
-                // Movement detected, calculate bounding box
-                RECT rect = { x, y, x + 50, y + 50 }; // Example size
-                movingAreas.push_back(rect);
-            }
-        }
+    maskWriteTime = attributes.ftLastWriteTime;
+    std::vector<MaskRegion> regions;
+    if (LoadMaskRegions(maskPath.c_str(), regions)) {
+        activePipeline->SetRegions(regions);
+        OVERLAY_LOG_INFO("Loaded {} mask region(s) from {}", regions.size(), maskPath);
+    } else {
+        OVERLAY_LOG_ERROR("Failed to read mask file: {}", maskPath);
     }
+}
 
-    // Unmap the resources
-    deviceContext->Unmap(acquiredDesktopImage.Get(), 0);
-    deviceContext->Unmap(previousFrame.Get(), 0);
-
-    // Update previous frame
-    deviceContext->CopyResource(previousFrame.Get(), acquiredDesktopImage.Get());
-
-    LogInfo("Movement detection completed.");
-    return movingAreas;
+// Function to get the file output `index` of `count` writes its heatmap to: the --heatmap path
+// itself for a single output, with "-<index>" inserted before the extension otherwise
+std::string HeatmapOutputPath(size_t index, size_t count) {
+    if (count == 1) {
+        return heatmapPath;
+    }
+    size_t separator = heatmapPath.find_last_of("/\\");
+    size_t dot = heatmapPath.find_last_of('.');
+    if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) {
+        dot = heatmapPath.size();
+    }
+    return heatmapPath.substr(0, dot) + "-" + std::to_string(index) + heatmapPath.substr(dot);
 }
 
-// Function to render overlay based on detected changes
-void RenderOverlay() {
-    LogInfo("Rendering overlay...");
-    std::vector<RECT> movingAreas = DetectMovement();
-
-    // Use DirectX to draw boxes around detected changes
-    for (const RECT& area : movingAreas) {
-        // Define vertices for a rectangle (box)
-        Vertex vertices[] = {
-            { { static_cast<float>(area.left), static_cast<float>(area.top), 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } }, // Red
-            { { static_cast<float>(area.right), static_cast<float>(area.top), 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
-            { { static_cast<float>(area.left), static_cast<float>(area.bottom), 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
-            { { static_cast<float>(area.right), static_cast<float>(area.bottom), 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
-        };
-
-        // Create vertex buffer
-        D3D11_BUFFER_DESC bufferDesc = {};
-        bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        bufferDesc.ByteWidth = sizeof(vertices);
-        bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        D3D11_SUBRESOURCE_DATA initData = { vertices, 0, 0 };
-        ID3D11Buffer* vertexBuffer;
-        device->CreateBuffer(&bufferDesc, &initData, &vertexBuffer);
-
-        // Set vertex buffer
-        UINT stride = sizeof(Vertex);
-        UINT offset = 0;
-        deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-
-        // Draw rectangle
-        deviceContext->Draw(4, 0);
-
-        // Release vertex buffer
-        vertexBuffer->Release();
+// Function to write every output's latest heatmap snapshot; detection keeps running meanwhile
+void ExportHeatmaps() {
+    for (size_t i = 0; i < heatmaps.size(); ++i) {
+        std::string path = HeatmapOutputPath(i, heatmaps.size());
+        if (heatmaps[i]->Write(path.c_str())) {
+            OVERLAY_LOG_INFO("Wrote heatmap of output {} to {}", i, path);
+        } else {
+            OVERLAY_LOG_ERROR("Failed to write heatmap of output {} to {}", i, path);
+        }
     }
 }
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     switch (uMsg) {
     case WM_DESTROY:
-        std::cout << "WM_DESTROY received." << std::endl;
+        OVERLAY_LOG_DEBUG("WM_DESTROY received.");
         PostQuitMessage(0);
         return 0;
     case WM_TIMER:
-        std::cout << "WM_TIMER received." << std::endl;
-        UpdateObjectPositions();
-        InvalidateRect(hwnd, nullptr, TRUE);
+        OVERLAY_LOG_DEBUG("WM_TIMER received.");
+        ReloadMaskIfChanged();
+        return 0;
+    case WM_HOTKEY:
+        if (wParam == kHeatmapHotKey) {
+            ExportHeatmaps();
+        }
         return 0;
     case WM_PAINT:
-        std::cout << "WM_PAINT received." << std::endl;
+        OVERLAY_LOG_DEBUG("WM_PAINT received.");
         {
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hwnd, &ps);
             // Perform any necessary painting here
             // For now, just clear the area with a solid color
             FillRect(hdc, &ps.rcPaint, (HBRUSH)(COLOR_WINDOW+1));
-            std::cout << "Painting completed." << std::endl;
+            OVERLAY_LOG_DEBUG("Painting completed.");
             EndPaint(hwnd, &ps);
         }
         return 0;
     default:
-        std::cout << "Unhandled message: " << uMsg << std::endl;
+        OVERLAY_LOG_DEBUG("Unhandled message: {}", uMsg);
         break;
     }
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
@@ -522,18 +760,23 @@ void InitializeConsole() {
     std::ios::sync_with_stdio();
     std::cout.clear();
     std::cerr.clear();
-    std::cout << "Console initialized successfully." << std::endl;
+    OVERLAY_LOG_INFO("Console initialized successfully.");
 }
 
 void WaitForExit() {
+    FlushLog();
     std::cout << "Press Enter to exit..." << std::endl;
     std::cin.get();
+    StopLog();
 }
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nShowCmd) {
     InitializeConsole();
-    LogInfo("Application started.");
+    OVERLAY_LOG_INFO("Application started.");
     SetDPIAwareness();
+    // Tiles that change in most frames are compared every 8th frame unless --sample-hot says otherwise
+    detectorConfig.sampling.sampleInterval = 8;
+    ParseCommandLine(lpCmdLine);
 
     const wchar_t CLASS_NAME[] = L"OverlayWindowClass";
 
@@ -543,21 +786,23 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
     wc.lpszClassName = CLASS_NAME;
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
 
-    std::cout << "Registering window class..." << std::endl;
+    OVERLAY_LOG_INFO("Registering window class...");
     if (!RegisterClass(&wc)) {
-        LogError("Failed to register window class.");
+        ReportFatalError("Failed to register window class.");
         WaitForExit();
         return 0;
     }
-    std::cout << "Window class registered successfully." << std::endl;
+    OVERLAY_LOG_INFO("Window class registered successfully.");
 
-    std::cout << "Creating window..." << std::endl;
+    OVERLAY_LOG_INFO("Creating window...");
+    // One window spanning every output
+    virtualOrigin = { GetSystemMetrics(SM_XVIRTUALSCREEN), GetSystemMetrics(SM_YVIRTUALSCREEN) };
     HWND hwnd = CreateWindowEx(
         WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TRANSPARENT,
         CLASS_NAME,
         L"Overlay",
         WS_POPUP,
-        0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN),
+        virtualOrigin.x, virtualOrigin.y, GetSystemMetrics(SM_CXVIRTUALSCREEN), GetSystemMetrics(SM_CYVIRTUALSCREEN),
         nullptr,
         nullptr,
         hInstance,
@@ -565,105 +810,194 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
     );
 
     if (hwnd == nullptr) {
-        LogError("Failed to create window.");
+        ReportFatalError("Failed to create window.");
         WaitForExit();
         return 0;
     }
-    LogInfo("Window created successfully.");
+    OVERLAY_LOG_INFO("Window created successfully.");
 
     // Attempt to make the overlay "screenshot-resistant"
     BOOL affinityResult = SetWindowDisplayAffinity(hwnd, WDA_MONITOR);
     if (!affinityResult) {
         DWORD lastError = GetLastError();
         // Not necessarily fatal; just log it
-        LogError("SetWindowDisplayAffinity failed with error code: " + IntToString(lastError));
+        OVERLAY_LOG_ERROR("SetWindowDisplayAffinity failed with error code: {}", lastError);
     }
 
     // Continue as before
     SetLayeredWindowAttributes(hwnd, RGB(0, 0, 0), 0, LWA_COLORKEY);
 
-    std::cout << "Initializing DirectX..." << std::endl;
+    OVERLAY_LOG_INFO("Initializing DirectX...");
     if (!InitDirectX(hwnd)) {
-        LogError("DirectX initialization failed.");
+        ReportFatalError("DirectX initialization failed.");
         WaitForExit();
         return 0;
     }
-    std::cout << "DirectX initialized successfully." << std::endl;
+    OVERLAY_LOG_INFO("DirectX initialized successfully.");
 
-    std::cout << "Initializing desktop duplication..." << std::endl;
-    if (!InitDesktopDuplication(device)) {
-        LogError("Desktop duplication initialization failed.");
+    OVERLAY_LOG_INFO("Initializing desktop duplication...");
+    if (!InitDesktopDuplication()) {
+        ReportFatalError("Desktop duplication initialization failed.");
         WaitForExit();
         return 0;
     }
-    std::cout << "Desktop duplication initialized successfully." << std::endl;
+    OVERLAY_LOG_INFO("Desktop duplication initialized successfully.");
 
-    // Capture an initial frame before initializing frame buffers
-    std::cout << "Capturing initial frame..." << std::endl;
-    if (!CaptureFrame()) {
-        LogError("Failed to capture initial frame.");
-        WaitForExit();
-        return 0;
+    for (std::unique_ptr<DuplicatedOutput>& output : duplicatedOutputs) {
+        // Capture an initial frame before initializing frame buffers
+        OVERLAY_LOG_INFO("Capturing initial frame...");
+        if (!CaptureFrame(*output)) {
+            ReportFatalError("Failed to capture initial frame.");
+            WaitForExit();
+            return 0;
+        }
+        OVERLAY_LOG_INFO("Initial frame captured successfully.");
+
+        OVERLAY_LOG_INFO("Initializing frame buffers...");
+        if (!InitFrameBuffers(*output)) {
+            ReportFatalError("Frame buffer initialization failed.");
+            WaitForExit();
+            return 0;
+        }
+        OVERLAY_LOG_INFO("Frame buffers initialized successfully.");
     }
-    std::cout << "Initial frame captured successfully." << std::endl;
 
-    std::cout << "Initializing frame buffers..." << std::endl;
-    if (!InitFrameBuffers()) {
-        LogError("Frame buffer initialization failed.");
+    OVERLAY_LOG_INFO("Initializing shaders...");
+    if (!InitShaders()) {
+        ReportFatalError("Shader initialization failed.");
         WaitForExit();
         return 0;
     }
-    std::cout << "Frame buffers initialized successfully." << std::endl;
+    OVERLAY_LOG_INFO("Shaders initialized successfully.");
 
-    std::cout << "Initializing shaders..." << std::endl;
-    if (!InitShaders()) {
-        LogError("Shader initialization failed.");
+    if (!quadBackend.Init(device, deviceContext, renderTargetView)) {
+        ReportFatalError("Failed to create overlay vertex buffer.");
         WaitForExit();
         return 0;
     }
-    std::cout << "Shaders initialized successfully." << std::endl;
 
-    std::cout << "Setting layered window attributes..." << std::endl;
+    OVERLAY_LOG_INFO("Setting layered window attributes...");
     if (!SetLayeredWindowAttributes(hwnd, RGB(0, 0, 0), 0, LWA_COLORKEY)) {
-        LogError("Failed to set layered window attributes.");
+        ReportFatalError("Failed to set layered window attributes.");
         WaitForExit();
         return 0;
     }
-    std::cout << "Layered window attributes set successfully." << std::endl;
+    OVERLAY_LOG_INFO("Layered window attributes set successfully.");
 
     ShowWindow(hwnd, nShowCmd);
 
-    std::cout << "Setting timer..." << std::endl;
-    if (!SetTimer(hwnd, 1, 30, nullptr)) {
-        LogError("Failed to set timer.");
+    OVERLAY_LOG_INFO("Setting timer...");
+    if (!SetTimer(hwnd, 1, kMaskPollMs, nullptr)) {
+        ReportFatalError("Failed to set timer.");
         WaitForExit();
         return 0;
     }
-    std::cout << "Timer set successfully." << std::endl;
+    OVERLAY_LOG_INFO("Timer set successfully.");
+
+    // Every output is captured and detected on its own threads and the merged results are drawn
+    // on one render thread; this thread only handles messages
+    PipelineConfig pipelineConfig;
+    pipelineConfig.detector = detectorConfig;
+    pipelineConfig.trackObjects = true;
+    pipelineConfig.coalesceBoxes = true;
+    pipelineConfig.estimateMotion = estimateMotion;
+    pipelineConfig.coalesce = coalesceConfig;
+    pipelineConfig.schedule = scheduleConfig;
+    std::vector<std::unique_ptr<DesktopCapture>> desktopCaptures;
+    std::vector<OutputConfig> outputConfigs;
+    FrameRecorder frameRecorder;
+    for (std::unique_ptr<DuplicatedOutput>& output : duplicatedOutputs) {
+        D3D11_TEXTURE2D_DESC desc;
+        output->stagingFrame->GetDesc(&desc);
+        const RECT& rect = output->desktopRect;
+        if (static_cast<LONG>(desc.Width) != rect.right - rect.left || static_cast<LONG>(desc.Height) != rect.bottom - rect.top) {
+            OVERLAY_LOG_WARNING("Output {} of adapter {} is rotated; its boxes are drawn unrotated.", output->outputIndex, output->adapterIndex);
+        }
+        desktopCaptures.push_back(std::make_unique<DesktopCapture>(*output));
+        OutputConfig outputConfig;
+        outputConfig.capture = desktopCaptures.back().get();
+        outputConfig.bounds.left = rect.left - virtualOrigin.x;
+        outputConfig.bounds.top = rect.top - virtualOrigin.y;
+        outputConfig.bounds.right = outputConfig.bounds.left + static_cast<int>(desc.Width);
+        outputConfig.bounds.bottom = outputConfig.bounds.top + static_cast<int>(desc.Height);
+        outputConfig.format = output->pixelFormat;
+        // Traces hold one frame size, so only the first output is recorded
+        outputConfig.listener = outputConfigs.empty() ? &frameRecorder : nullptr;
+        outputConfigs.push_back(outputConfig);
+    }
+    OverlayRender overlayRender;
+    MultiOutputPipeline pipeline(pipelineConfig, outputConfigs, overlayRender);
+    OVERLAY_LOG_INFO("Movement detection on {} output(s) using {} thread(s) each.", pipeline.OutputCount(),
+                     pipeline.Output(0).Detector().Config().threadCount);
+    if (scheduleConfig.targetFps > 0) {
+        OVERLAY_LOG_INFO("Capturing at {} fps, backing off to {} ms between frames while idle.", scheduleConfig.targetFps,
+                         scheduleConfig.maxIntervalMs);
+    }
+    if (!metricsPath.empty()) {
+        if (StartMetricsExport(metricsPath.c_str(), 1000)) {
+            OVERLAY_LOG_INFO("Writing metrics to {}", metricsPath);
+        } else {
+            OVERLAY_LOG_ERROR("Failed to create metrics file: {}", metricsPath);
+        }
+    }
+    if (!eventsName.empty()) {
+        if (eventRing.Open(eventsName.c_str())) {
+            pipeline.SetEventRing(&eventRing);
+            OVERLAY_LOG_INFO("Publishing motion events to shared memory {}", eventsName);
+        } else {
+            OVERLAY_LOG_ERROR("Failed to create event ring: {}", eventsName);
+        }
+    }
+    if (!heatmapPath.empty()) {
+        for (size_t i = 0; i < pipeline.OutputCount(); ++i) {
+            heatmaps.push_back(std::make_unique<Heatmap>());
+            pipeline.SetHeatmap(i, heatmaps.back().get());
+        }
+        if (RegisterHotKey(hwnd, kHeatmapHotKey, MOD_CONTROL | MOD_ALT | MOD_NOREPEAT, 'H')) {
+            OVERLAY_LOG_INFO("Accumulating heatmaps; Ctrl+Alt+H writes them to {}", heatmapPath);
+        } else {
+            OVERLAY_LOG_WARNING("Failed to register the heatmap hotkey; heatmaps are written to {} at exit only", heatmapPath);
+        }
+    }
+    activePipeline = &pipeline;
+    ReloadMaskIfChanged();
+    pipeline.Start();
 
-    std::cout << "Entering message loop..." << std::endl;
+    OVERLAY_LOG_INFO("Entering message loop...");
     MSG msg;
     while (GetMessage(&msg, nullptr, 0, 0)) {
-        LogInfo("Message received: " + IntToString(msg.message));
+        OVERLAY_LOG_DEBUG("Message received: {}", msg.message);
         TranslateMessage(&msg);
         DispatchMessage(&msg);
+    }
 
-        // Capture a frame
-        if (CaptureFrame()) {
-            LogInfo("Frame captured successfully.");
-            // Render overlay based on captured frame
-            RenderOverlay();
-        } else {
-            LogError("Failed to capture frame.");
-        }
-
-        // Render a frame
-        RenderFrame();
+    OVERLAY_LOG_INFO("Exiting message loop.");
+    pipeline.Stop();
+    activePipeline = nullptr;
+    eventRing.Close();
+    if (!heatmaps.empty()) {
+        ExportHeatmaps();
+    }
+    StopMetricsExport();
+    PipelineStats stats = pipeline.Stats();
+    OVERLAY_LOG_INFO("Captured {} frames, detected {}, rendered {}, mean latency {} ms.", stats.captured, stats.detected,
+                     stats.rendered, stats.MeanLatencyUs() / 1000.0);
+    if (scheduleConfig.targetFps > 0) {
+        OVERLAY_LOG_INFO("Missed {} capture deadline(s), woke {} time(s) from idle.", stats.missedDeadlines, stats.scheduleWakeups);
+    }
+    for (size_t i = 0; i < pipeline.OutputCount(); ++i) {
+        PipelineStats outputStats = pipeline.Output(i).Stats();
+        OVERLAY_LOG_INFO("Output {}: captured {} frames, detected {}.", i, outputStats.captured, outputStats.detected);
     }
 
-    LogInfo("Exiting message loop.");
+    if (traceWriter.IsOpen()) {
+        OVERLAY_LOG_INFO("Recorded {} frames.", traceWriter.FrameCount());
+        traceWriter.Close();
+    }
 
     // Clean up DirectX
+    duplicatedOutputs.clear();
+    swapChain1.Reset();
     if (swapChain) swapChain->Release();
     if (device) device->Release();
     if (deviceContext) deviceContext->Release();
@@ -674,4 +1008,4 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
 
     WaitForExit();
     return 0;
-} 
\ No newline at end of file
+} 
@@ -0,0 +1,1560 @@
+// Benchmarks for the detection core on synthetic frames.
+//
+//   overlay_bench threads [--width W] [--height H] [--frames N] [--sprites N] [--max-threads N]
+//   overlay_bench record <trace> [--width W] [--height H] [--frames N] [--sprites N] [--delta] [--video]
+//   overlay_bench pipeline [--width W] [--height H] [--frames N] [--sprites N] [--fps N] [--threads N]
+//   overlay_bench render [--width W] [--height H] [--frames N] [--boxes N]
+//   overlay_bench noise [--width W] [--height H] [--frames N] [--sprites N] [--shimmer N]
+//   overlay_bench track [--width W] [--height H] [--frames N] [--blobs N]
+//   overlay_bench coalesce [--width W] [--height H] [--frames N] [--boxes N] [--gap N] [--max-boxes N]
+//   overlay_bench scroll [--width W] [--height H] [--frames N] [--sprites N] [--scroll N]
+//   overlay_bench mask [--width W] [--height H] [--frames N] [--sprites N] [--excluded N]
+//   overlay_bench formats [--width W] [--height H] [--frames N] [--sprites N]
+//   overlay_bench damage [--width W] [--height H] [--frames N] [--sprites N]
+//   overlay_bench schedule [--fps N]
+//   overlay_bench sampling [--width W] [--height H] [--frames N] [--sprites N] [--sample-hot N]
+//   overlay_bench heatmap [--width W] [--height H] [--frames N] [--sprites N]
+//   overlay_bench suite [--frames N] [--threads N] [--json <path>]
+//   overlay_bench pyramid [--frames N] [--threads N]
+
+#include "alloc_hook.h"
+#include "box_coalescer.h"
+#include "damage_tracker.h"
+#include "frame_pipeline.h"
+#include "frame_scheduler.h"
+#include "frame_trace.h"
+#include "heatmap.h"
+#include "motion_detector.h"
+#include "motion_estimator.h"
+#include "object_tracker.h"
+#include "quad_batch.h"
+#include "region_mask.h"
+#include "synthetic_scene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+struct BenchOptions {
+    int width = 3840;
+    int height = 2160;
+    int frames = 60;
+    int sprites = 24;
+    int maxThreads = 0;
+    int fps = 60;
+    int threads = 1;
+    int boxes = 10000;
+    int shimmer = 20000;
+    int blobs = 2000;
+    int gap = 8;
+    int maxBoxes = 256;
+    int scroll = 4;
+    int excluded = 75;
+    int sampleHot = 8;
+    bool delta = false;
+    bool video = false;
+    const char* jsonPath = nullptr;
+};
+
+static bool ParseOptions(int argc, char** argv, int first, BenchOptions& options) {
+    for (int i = first; i < argc; ++i) {
+        if (strcmp(argv[i], "--delta") == 0) {
+            options.delta = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--video") == 0) {
+            options.video = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+        if (strcmp(argv[i], "--json") == 0) {
+            options.jsonPath = argv[++i];
+            continue;
+        }
+        int value = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--width") == 0) options.width = value;
+        else if (strcmp(argv[i], "--height") == 0) options.height = value;
+        else if (strcmp(argv[i], "--frames") == 0) options.frames = value;
+        else if (strcmp(argv[i], "--sprites") == 0) options.sprites = value;
+        else if (strcmp(argv[i], "--max-threads") == 0) options.maxThreads = value;
+        else if (strcmp(argv[i], "--fps") == 0) options.fps = value;
+        else if (strcmp(argv[i], "--threads") == 0) options.threads = value;
+        else if (strcmp(argv[i], "--boxes") == 0) options.boxes = value;
+        else if (strcmp(argv[i], "--shimmer") == 0) options.shimmer = value;
+        else if (strcmp(argv[i], "--blobs") == 0) options.blobs = value;
+        else if (strcmp(argv[i], "--gap") == 0) options.gap = value;
+        else if (strcmp(argv[i], "--max-boxes") == 0) options.maxBoxes = value;
+        else if (strcmp(argv[i], "--scroll") == 0) options.scroll = value;
+        else if (strcmp(argv[i], "--excluded") == 0) options.excluded = value;
+        else if (strcmp(argv[i], "--sample-hot") == 0) options.sampleHot = value;
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+// Function to pre-render a sequence of frames so scene generation stays out of the timings
+static std::vector<std::vector<uint8_t>> RenderFrames(const BenchOptions& options) {
+    SyntheticScene scene(options.width, options.height);
+    scene.AddRandomSprites(options.sprites, 200);
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < options.frames + 1; ++i) {
+        FrameView view = scene.View();
+        frames.emplace_back(view.pixels, view.pixels + static_cast<size_t>(view.rowPitch) * view.height);
+        scene.Step();
+    }
+    return frames;
+}
+
+static FrameView MakeView(const std::vector<uint8_t>& pixels, const BenchOptions& options) {
+    FrameView view;
+    view.pixels = pixels.data();
+    view.width = options.width;
+    view.height = options.height;
+    view.rowPitch = options.width * 4;
+    return view;
+}
+
+// Function to measure banded detection throughput from one thread up to maxThreads
+static int RunThreadScaling(const BenchOptions& options) {
+    int maxThreads = options.maxThreads > 0 ? options.maxThreads : static_cast<int>(std::thread::hardware_concurrency());
+    maxThreads = maxThreads > 0 ? maxThreads : 1;
+    std::vector<std::vector<uint8_t>> frames = RenderFrames(options);
+
+    printf("%dx%d, %d frames, %d sprites, kernel %s\n", options.width, options.height, options.frames,
+           options.sprites, DiffKernelName(SelectDiffKernel()));
+    printf("%8s %12s %10s %9s %8s\n", "threads", "ms/frame", "fps", "speedup", "boxes");
+
+    double baseline = 0.0;
+    std::vector<Box> boxes;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        DetectorConfig config;
+        config.threadCount = threads;
+        MotionDetector detector(config);
+
+        // One warm-up pass sizes the mask, tiles and per-band scratch buffers
+        detector.Detect(MakeView(frames[1], options), MakeView(frames[0], options), boxes);
+
+        size_t totalBoxes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 1; i <= options.frames; ++i) {
+            detector.Detect(MakeView(frames[i], options), MakeView(frames[i - 1], options), boxes);
+            totalBoxes += boxes.size();
+        }
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        double perFrame = elapsed / options.frames;
+        if (threads == 1) {
+            baseline = perFrame;
+        }
+        printf("%8d %12.3f %10.1f %8.2fx %8.1f\n", threads, perFrame, 1000.0 / perFrame, baseline / perFrame,
+               static_cast<double>(totalBoxes) / options.frames);
+        if (threads < maxThreads && threads * 2 > maxThreads) {
+            threads = maxThreads / 2;
+        }
+    }
+    return 0;
+}
+
+// Function to write a synthetic scene to a trace file at 60 fps timestamps for overlay_replay,
+// optionally with a video playing in front of the sprites in its centre quarter
+static int RecordTrace(const char* path, const BenchOptions& options) {
+    SyntheticScene scene(options.width, options.height);
+    scene.AddRandomSprites(options.sprites, 200);
+    if (options.video) {
+        scene.SetVideo(options.width / 4, options.height / 4, options.width * 3 / 4, options.height * 3 / 4, true);
+    }
+    TraceWriterOptions writerOptions;
+    writerOptions.encoding = options.delta ? TraceEncoding::DeltaTiles : TraceEncoding::Raw;
+    TraceWriter writer;
+    if (!writer.Open(path, options.width, options.height, writerOptions)) {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return 1;
+    }
+    for (int i = 0; i < options.frames; ++i) {
+        if (!writer.WriteFrame(scene.View(), static_cast<int64_t>(i) * 1000000 / 60)) {
+            fprintf(stderr, "Failed to write frame %d\n", i);
+            return 1;
+        }
+        scene.Step();
+    }
+    if (!writer.Close()) {
+        fprintf(stderr, "Failed to finish %s\n", path);
+        return 1;
+    }
+    printf("Wrote %d frames of %dx%d to %s (%.1f MB)\n", options.frames, options.width, options.height, path,
+           writer.BytesWritten() / (1024.0 * 1024.0));
+    return 0;
+}
+
+// Capture stub that copies pre-rendered frames into the pipeline's buffers at a fixed rate,
+// standing in for desktop duplication and the staging texture read-back
+class SyntheticCapture : public CaptureStage {
+public:
+    SyntheticCapture(const std::vector<std::vector<uint8_t>>& frames, const BenchOptions& options)
+        : frames(frames), options(options) {}
+
+    bool Capture(PipelineFrame& frame) override {
+        int64_t now = PipelineClockUs();
+        if (options.fps > 0) {
+            if (nextFrameUs == 0) {
+                nextFrameUs = now;
+            }
+            if (now < nextFrameUs) {
+                return false;
+            }
+            nextFrameUs += 1000000 / options.fps;
+        }
+        const std::vector<uint8_t>& source = frames[next];
+        next = (next + 1) % frames.size();
+        memcpy(frame.pixels.data(), source.data(), source.size());
+        frame.view = MakeView(frame.pixels, options);
+        frame.captureTimeUs = now;
+        return true;
+    }
+
+private:
+    const std::vector<std::vector<uint8_t>>& frames;
+    const BenchOptions& options;
+    size_t next = 0;
+    int64_t nextFrameUs = 0;
+};
+
+// Render stub that only counts the boxes it is handed
+class CountingRender : public RenderStage {
+public:
+    void Render(const PipelineResult& result) override { boxes += result.boxes.size(); }
+
+    size_t boxes = 0;
+};
+
+// Function to compare capture, detect and render run back to back against the threaded pipeline
+static int RunPipeline(const BenchOptions& options) {
+    std::vector<std::vector<uint8_t>> frames = RenderFrames(options);
+    DetectorConfig detectorConfig;
+    detectorConfig.threadCount = options.threads;
+
+    std::string rate = options.fps > 0 ? std::to_string(options.fps) + " fps" : "full speed";
+    printf("%dx%d, %d frames, %d sprites, capture at %s, %d detection thread(s)\n", options.width, options.height,
+           options.frames, options.sprites, rate.c_str(), options.threads);
+    printf("%10s %10s %10s %10s %12s %12s\n", "mode", "captured", "rendered", "fps", "latency ms", "max ms");
+
+    // Serial: every stage waits for the previous one, as in the original message loop
+    {
+        SyntheticCapture capture(frames, options);
+        CountingRender render;
+        MotionDetector detector(detectorConfig);
+        PipelineFrame current, previous;
+        current.pixels.resize(frames[0].size());
+        previous.pixels.resize(frames[0].size());
+        PipelineResult result;
+        std::vector<Box> boxes;
+        int64_t totalLatency = 0, maxLatency = 0;
+        int64_t start = PipelineClockUs();
+        for (int i = 0; i < options.frames; ++i) {
+            while (!capture.Capture(current)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            detector.Detect(current.view, i > 0 ? previous.view : current.view, boxes);
+            result.captureTimeUs = current.captureTimeUs;
+            result.boxes.assign(boxes.begin(), boxes.end());
+            render.Render(result);
+            int64_t latency = PipelineClockUs() - current.captureTimeUs;
+            totalLatency += latency;
+            maxLatency = latency > maxLatency ? latency : maxLatency;
+            std::swap(current, previous);
+        }
+        double seconds = (PipelineClockUs() - start) / 1e6;
+        printf("%10s %10d %10d %10.1f %12.3f %12.3f\n", "serial", options.frames, options.frames,
+               options.frames / seconds, totalLatency / 1000.0 / options.frames, maxLatency / 1000.0);
+    }
+
+    // Pipelined: capture keeps its pace and detection skips frames it cannot keep up with
+    {
+        SyntheticCapture capture(frames, options);
+        CountingRender render;
+        PipelineConfig config;
+        config.width = options.width;
+        config.height = options.height;
+        config.detector = detectorConfig;
+        FramePipeline pipeline(config, capture, render);
+        int64_t start = PipelineClockUs();
+        pipeline.Start();
+        while (pipeline.Stats().captured < static_cast<uint64_t>(options.frames)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        pipeline.Stop();
+        double seconds = (PipelineClockUs() - start) / 1e6;
+        PipelineStats stats = pipeline.Stats();
+        printf("%10s %10llu %10llu %10.1f %12.3f %12.3f\n", "pipeline", static_cast<unsigned long long>(stats.captured),
+               static_cast<unsigned long long>(stats.rendered), stats.rendered / seconds, stats.MeanLatencyUs() / 1000.0,
+               stats.maxLatencyUs / 1000.0);
+        printf("stale frames skipped: %llu, stale results skipped: %llu\n", static_cast<unsigned long long>(stats.staleFrames),
+               static_cast<unsigned long long>(stats.staleResults));
+    }
+    return 0;
+}
+
+// Function to time building a quad batch of many boxes and rasterizing it with the software backend
+static int RunRender(const BenchOptions& options) {
+    // Random boxes up to 64 pixels, like a busy frame of small detected blobs
+    std::vector<Box> boxes;
+    uint32_t state = 1;
+    auto next = [&state](int range) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<int>(state % static_cast<uint32_t>(range));
+    };
+    for (int i = 0; i < options.boxes; ++i) {
+        Box box;
+        box.left = next(options.width - 64);
+        box.top = next(options.height - 64);
+        box.right = box.left + 1 + next(64);
+        box.bottom = box.top + 1 + next(64);
+        boxes.push_back(box);
+    }
+
+    QuadBatch batch;
+    SoftwareRasterBackend raster;
+    raster.Resize(options.width, options.height);
+    double buildMs = 0.0, rasterMs = 0.0;
+    for (int i = 0; i <= options.frames; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        batch.Begin(options.width, options.height);
+        batch.AddQuads(boxes, { 1.0f, 0.0f, 0.0f, 1.0f });
+        auto built = std::chrono::steady_clock::now();
+        raster.Clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+        raster.Draw(batch);
+        auto drawn = std::chrono::steady_clock::now();
+        // The first frame grows the vertex storage and is not timed
+        if (i > 0) {
+            buildMs += std::chrono::duration<double, std::milli>(built - start).count();
+            rasterMs += std::chrono::duration<double, std::milli>(drawn - built).count();
+        }
+    }
+
+    printf("%dx%d, %d boxes, %d frames\n", options.width, options.height, options.boxes, options.frames);
+    printf("batch: %zu quads, %zu vertices, %.1f KB uploaded per frame in 1 draw call\n", batch.QuadCount(),
+           batch.VertexCount(), batch.VertexCount() * sizeof(QuadVertex) / 1024.0);
+    printf("build %.3f ms/frame, software raster %.3f ms/frame\n", buildMs / options.frames, rasterMs / options.frames);
+    return 0;
+}
+
+// Function to compare exact pixel diffing with the background model on a scene with moving
+// sprites, blinking text cursors and low-amplitude shimmer that should not count as movement
+static int RunNoise(const BenchOptions& options) {
+    SyntheticScene scene(options.width, options.height);
+    scene.AddRandomSprites(options.sprites, 200);
+    for (int i = 0; i < 4; ++i) {
+        SceneSprite cursor;
+        cursor.x = options.width / 5 * (i + 1);
+        cursor.y = options.height / 3;
+        cursor.width = 2;
+        cursor.height = 18;
+        cursor.velocityX = 0;
+        cursor.velocityY = 0;
+        cursor.color = 0xFFFFFFFFu;
+        cursor.blinkFrames = 15 + i;
+        scene.AddSprite(cursor);
+    }
+    scene.SetShimmer(options.shimmer, 6);
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < options.frames + 1; ++i) {
+        FrameView view = scene.View();
+        frames.emplace_back(view.pixels, view.pixels + static_cast<size_t>(view.rowPitch) * view.height);
+        scene.Step();
+    }
+
+    printf("%dx%d, %d frames, %d sprites, 4 blinking cursors, %d shimmering pixels per frame\n", options.width,
+           options.height, options.frames, options.sprites, options.shimmer);
+    printf("%12s %12s %12s %12s %12s\n", "mode", "ms/frame", "boxes", "tiles", "area %");
+    for (int mode = 0; mode < 2; ++mode) {
+        DetectorConfig config;
+        config.threadCount = options.threads;
+        if (mode == 1) {
+            config.mode = DetectionMode::Background;
+            config.minBoxArea = 64;
+        }
+        MotionDetector detector(config);
+        std::vector<Box> boxes;
+        // Seeds the previous-frame state or the running averages
+        detector.Detect(MakeView(frames[0], options), MakeView(frames[0], options), boxes);
+
+        size_t totalBoxes = 0, totalTiles = 0;
+        double totalArea = 0.0;
+        double elapsed = 0.0;
+        for (int i = 1; i <= options.frames; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            detector.Detect(MakeView(frames[i], options), MakeView(frames[i - 1], options), boxes);
+            elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            totalBoxes += boxes.size();
+            totalTiles += detector.Tiles().DirtyCount();
+            for (const Box& box : boxes) {
+                totalArea += static_cast<double>(box.Area());
+            }
+        }
+        printf("%12s %12.3f %12.1f %12.1f %12.1f\n", mode == 0 ? "pixel diff" : "background", elapsed / options.frames,
+               static_cast<double>(totalBoxes) / options.frames, static_cast<double>(totalTiles) / options.frames,
+               100.0 * totalArea / options.frames / (static_cast<double>(options.width) * options.height));
+    }
+    return 0;
+}
+
+// Function to time the object tracker on blobs that move at constant speed, with a pixel of
+// detection jitter and one detection in twenty missing, and count how often a blob's ID changes
+static int RunTrack(const BenchOptions& options) {
+    struct Blob {
+        float x, y, velocityX, velocityY;
+        uint32_t trackId;
+    };
+    const int blobSize = 16;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(0.0f, 1.0f);
+    std::uniform_real_distribution<float> speed(-6.0f, 6.0f);
+    std::uniform_int_distribution<int> jitter(-1, 1);
+    std::uniform_int_distribution<int> dropout(0, 19);
+    std::vector<Blob> blobs(options.blobs);
+    for (Blob& blob : blobs) {
+        blob.x = position(random) * (options.width - blobSize);
+        blob.y = position(random) * (options.height - blobSize);
+        blob.velocityX = speed(random);
+        blob.velocityY = speed(random);
+        blob.trackId = 0;
+    }
+
+    // Pre-generate the detections so the timings only cover the tracker
+    std::vector<std::vector<Box>> frames(options.frames);
+    std::vector<std::vector<int>> frameBlobs(options.frames);
+    for (int i = 0; i < options.frames; ++i) {
+        for (size_t b = 0; b < blobs.size(); ++b) {
+            Blob& blob = blobs[b];
+            if (dropout(random) != 0) {
+                int left = static_cast<int>(blob.x) + jitter(random);
+                int top = static_cast<int>(blob.y) + jitter(random);
+                frames[i].push_back({ left, top, left + blobSize, top + blobSize });
+                frameBlobs[i].push_back(static_cast<int>(b));
+            }
+            blob.x += blob.velocityX;
+            blob.y += blob.velocityY;
+            if (blob.x < 0.0f || blob.x > options.width - blobSize) blob.velocityX = -blob.velocityX;
+            if (blob.y < 0.0f || blob.y > options.height - blobSize) blob.velocityY = -blob.velocityY;
+        }
+    }
+
+    ObjectTracker tracker;
+    std::unordered_map<uint64_t, int> blobAt;
+    double elapsed = 0.0;
+    size_t candidates = 0, created = 0, idSwitches = 0;
+    for (int i = 0; i < options.frames; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        tracker.Update(frames[i]);
+        elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        candidates += tracker.Stats().candidates;
+        created += tracker.Stats().created;
+
+        // A matched track's box is the detection it was matched to, which leads back to the blob
+        blobAt.clear();
+        for (size_t d = 0; d < frames[i].size(); ++d) {
+            const Box& box = frames[i][d];
+            blobAt[(static_cast<uint64_t>(static_cast<uint32_t>(box.left)) << 32) | static_cast<uint32_t>(box.top)] = frameBlobs[i][d];
+        }
+        for (const Track& track : tracker.Tracks()) {
+            if (track.missed != 0) {
+                continue;
+            }
+            auto found = blobAt.find((static_cast<uint64_t>(static_cast<uint32_t>(track.box.left)) << 32) | static_cast<uint32_t>(track.box.top));
+            if (found == blobAt.end()) {
+                continue;
+            }
+            Blob& blob = blobs[found->second];
+            if (blob.trackId != 0 && blob.trackId != track.id) {
+                ++idSwitches;
+            }
+            blob.trackId = track.id;
+        }
+    }
+
+    printf("%dx%d, %d blobs, %d frames\n", options.width, options.height, options.blobs, options.frames);
+    printf("update %.3f ms/frame, %.1f candidate pairs per blob, %zu tracks started, %zu ID switches\n",
+           elapsed / options.frames, static_cast<double>(candidates) / std::max<size_t>(1, frames.size() * blobs.size()),
+           created, idSwitches);
+    return 0;
+}
+
+// Function to merge boxes the obvious way, comparing every pair until nothing changes, as a
+// reference for the coalescer's result and speed
+static void CoalesceReference(std::vector<Box>& boxes, int gap) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            for (size_t j = i + 1; j < boxes.size();) {
+                const Box& a = boxes[i];
+                const Box& b = boxes[j];
+                if (a.left <= b.right + gap && b.left <= a.right + gap && a.top <= b.bottom + gap && b.top <= a.bottom + gap) {
+                    boxes[i] = UnionBox(a, b);
+                    boxes[j] = boxes.back();
+                    boxes.pop_back();
+                    merged = true;
+                } else {
+                    ++j;
+                }
+            }
+        }
+    }
+}
+
+// Function to time coalescing many small boxes scattered over a few hundred blobs, with and
+// without the box budget
+static int RunCoalesce(const BenchOptions& options) {
+    std::vector<Box> input;
+    uint32_t state = 1;
+    auto next = [&state](int range) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<int>(state % static_cast<uint32_t>(range));
+    };
+    const int blobCount = 300;
+    std::vector<Box> blobs;
+    for (int i = 0; i < blobCount; ++i) {
+        Box blob;
+        blob.left = next(options.width - 128);
+        blob.top = next(options.height - 128);
+        blob.right = blob.left + 16 + next(96);
+        blob.bottom = blob.top + 16 + next(96);
+        blobs.push_back(blob);
+    }
+    for (int i = 0; i < options.boxes; ++i) {
+        const Box& blob = blobs[i % blobCount];
+        Box box;
+        box.left = blob.left + next(blob.Width());
+        box.top = blob.top + next(blob.Height());
+        box.right = box.left + 1 + next(16);
+        box.bottom = box.top + 1 + next(16);
+        input.push_back(box);
+    }
+
+    printf("%dx%d, %d boxes, gap %d, %d frames\n", options.width, options.height, options.boxes, options.gap, options.frames);
+    printf("%12s %12s %12s %12s %12s\n", "budget", "ms/frame", "boxes", "passes", "area %");
+    bool capped = false;
+    std::vector<Box> boxes;
+    for (int budget = 0; budget < 2; ++budget) {
+        CoalesceConfig config;
+        config.gap = options.gap;
+        config.maxBoxes = budget ? options.maxBoxes : 0;
+        BoxCoalescer coalescer(config);
+        double elapsed = 0.0;
+        for (int i = 0; i <= options.frames; ++i) {
+            boxes = input;
+            auto start = std::chrono::steady_clock::now();
+            coalescer.Coalesce(boxes);
+            // The first frame grows the coalescer's storage and is not timed
+            if (i > 0) {
+                elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+        double area = 0.0;
+        for (const Box& box : boxes) {
+            area += static_cast<double>(box.Area());
+        }
+        printf("%12d %12.3f %12zu %12zu %12.1f%s\n", config.maxBoxes, elapsed / std::max(1, options.frames), boxes.size(),
+               coalescer.Stats().passes, 100.0 * area / (static_cast<double>(options.width) * options.height),
+               coalescer.Stats().capped ? " (stopped at maxPasses)" : "");
+        capped = capped || coalescer.Stats().capped;
+    }
+
+    // Coalescing is order-independent, so the pairwise reference must end with the same box count
+    // once the passes are allowed to run to completion
+    CoalesceConfig config;
+    config.gap = options.gap;
+    config.maxBoxes = 0;
+    config.maxPasses = capped ? static_cast<int>(input.size()) : config.maxPasses;
+    BoxCoalescer coalescer(config);
+    boxes = input;
+    coalescer.Coalesce(boxes);
+    std::vector<Box> reference = input;
+    auto start = std::chrono::steady_clock::now();
+    CoalesceReference(reference, options.gap);
+    double referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("pairwise reference: %.3f ms, %zu boxes (%s)\n", referenceMs, reference.size(),
+           reference.size() == boxes.size() ? "match" : "MISMATCH");
+    return reference.size() == boxes.size() ? 0 : 1;
+}
+
+// Function to measure how much of a scrolling window motion estimation reports as moved rather
+// than newly drawn, and what it costs on top of detection
+static int RunScroll(const BenchOptions& options) {
+    SyntheticScene scene(options.width, options.height);
+    scene.AddRandomSprites(options.sprites, 200);
+    scene.SetScroll(options.width / 8, options.height / 8, options.width * 7 / 8, options.height * 7 / 8, options.scroll);
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < options.frames + 1; ++i) {
+        FrameView view = scene.View();
+        frames.emplace_back(view.pixels, view.pixels + static_cast<size_t>(view.rowPitch) * view.height);
+        scene.Step();
+    }
+
+    DetectorConfig config;
+    config.threadCount = options.threads;
+    MotionDetector detector(config);
+    MotionEstimator estimator(MotionConfig(), config.kernel);
+    std::vector<Box> boxes, newBoxes;
+    std::vector<MoveRect> moves;
+    double detectMs = 0.0, motionMs = 0.0;
+    size_t changedTiles = 0, movedTiles = 0, comparisons = 0, moveCount = 0;
+    double detectedArea = 0.0, newArea = 0.0;
+    for (int i = 1; i <= options.frames; ++i) {
+        FrameView current = MakeView(frames[i], options);
+        FrameView previous = MakeView(frames[i - 1], options);
+        auto start = std::chrono::steady_clock::now();
+        detector.Detect(current, previous, boxes);
+        auto detected = std::chrono::steady_clock::now();
+        estimator.Estimate(current, previous, detector.Tiles(), moves, newBoxes);
+        auto estimated = std::chrono::steady_clock::now();
+        detectMs += std::chrono::duration<double, std::milli>(detected - start).count();
+        motionMs += std::chrono::duration<double, std::milli>(estimated - detected).count();
+        changedTiles += estimator.Stats().changedTiles;
+        movedTiles += estimator.Stats().movedTiles;
+        comparisons += estimator.Stats().comparisons;
+        moveCount += moves.size();
+        for (const Box& box : boxes) {
+            detectedArea += static_cast<double>(box.Area());
+        }
+        for (const Box& box : newBoxes) {
+            newArea += static_cast<double>(box.Area());
+        }
+    }
+
+    double screen = static_cast<double>(options.width) * options.height * options.frames;
+    printf("%dx%d, %d frames, %d sprites, window scrolling %d px per frame\n", options.width, options.height,
+           options.frames, options.sprites, options.scroll);
+    printf("detect %.3f ms/frame, motion %.3f ms/frame, %.1f block comparisons per changed tile\n",
+           detectMs / options.frames, motionMs / options.frames, static_cast<double>(comparisons) / std::max<size_t>(1, changedTiles));
+    printf("%.1f%% of changed tiles moved, %.1f move rects per frame; box area %.1f%% of the screen, %.1f%% newly drawn\n",
+           100.0 * movedTiles / std::max<size_t>(1, changedTiles), static_cast<double>(moveCount) / options.frames,
+           100.0 * detectedArea / screen, 100.0 * newArea / screen);
+    return 0;
+}
+
+// Function to time each detection mode with and without a mask excluding the left `excluded`
+// percent of the screen, to show that detection time falls with the active area
+static int RunMask(const BenchOptions& options) {
+    std::vector<std::vector<uint8_t>> frames = RenderFrames(options);
+    std::vector<MaskRegion> regions(1);
+    regions[0].rule = MaskRule::Exclude;
+    regions[0].box = Box{0, 0, options.width * std::max(0, std::min(options.excluded, 100)) / 100, options.height};
+
+    printf("%dx%d, %d frames, %d sprites, left %d%% of the screen excluded\n", options.width, options.height,
+           options.frames, options.sprites, options.excluded);
+    printf("%12s %12s %12s %12s %12s\n", "mode", "full ms", "masked ms", "active %", "time %");
+    const char* names[] = {"pixel diff", "tile hash", "pyramid", "background"};
+    const DetectionMode modes[] = {DetectionMode::PixelDiff, DetectionMode::TileHash, DetectionMode::Pyramid, DetectionMode::Background};
+    for (int mode = 0; mode < 4; ++mode) {
+        double elapsed[2] = {0.0, 0.0};
+        double active = 1.0;
+        for (int masked = 0; masked < 2; ++masked) {
+            DetectorConfig config;
+            config.mode = modes[mode];
+            config.threadCount = options.threads;
+            MotionDetector detector(config);
+            if (masked) {
+                detector.SetRegions(regions);
+            }
+            std::vector<Box> boxes;
+            // Seeds the state kept about earlier frames
+            detector.Detect(MakeView(frames[0], options), MakeView(frames[0], options), boxes);
+            for (int i = 1; i <= options.frames; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                detector.Detect(MakeView(frames[i], options), MakeView(frames[i - 1], options), boxes);
+                elapsed[masked] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            if (masked) {
+                const TileMap& tiles = detector.Tiles();
+                active = static_cast<double>(detector.Regions().ActiveCount()) / (static_cast<double>(tiles.cols) * tiles.rows);
+            }
+        }
+        printf("%12s %12.3f %12.3f %12.1f %12.1f\n", names[mode], elapsed[0] / options.frames, elapsed[1] / options.frames,
+               100.0 * active, 100.0 * elapsed[1] / elapsed[0]);
+    }
+    return 0;
+}
+
+// Function to round a value in [0, 1] to the nearest half float
+static uint16_t FloatToHalf(float value) {
+    if (value < 1.0f / 16384.0f) {
+        return 0;
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    // Rebias the exponent and round the mantissa from 23 to 10 bits
+    return static_cast<uint16_t>((bits - (112u << 23) + 0x1000) >> 13);
+}
+
+// Function to re-encode a BGRA frame as 10-bit or half-float pixels whose 8-bit conversion
+// gives back the original, so every format should detect the same boxes
+static std::vector<uint8_t> ConvertFrame(const std::vector<uint8_t>& bgra, PixelFormat format) {
+    size_t count = bgra.size() / 4;
+    std::vector<uint8_t> converted(count * PixelFormatBytes(format));
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* pixel = bgra.data() + i * 4;
+        if (format == PixelFormat::RGB10A2) {
+            // Replicate the top bits into the low ones, as a display pipeline widening 8-bit content would
+            uint32_t red = (pixel[2] << 2) | (pixel[2] >> 6);
+            uint32_t green = (pixel[1] << 2) | (pixel[1] >> 6);
+            uint32_t blue = (pixel[0] << 2) | (pixel[0] >> 6);
+            uint32_t value = red | (green << 10) | (blue << 20) | (static_cast<uint32_t>(pixel[3] >> 6) << 30);
+            memcpy(converted.data() + i * 4, &value, 4);
+        } else if (format == PixelFormat::RGBA16F) {
+            uint16_t channels[4] = { FloatToHalf(pixel[2] / 255.0f), FloatToHalf(pixel[1] / 255.0f),
+                                     FloatToHalf(pixel[0] / 255.0f), FloatToHalf(pixel[3] / 255.0f) };
+            memcpy(converted.data() + i * 8, channels, 8);
+        } else {
+            memcpy(converted.data() + i * 4, pixel, 4);
+        }
+    }
+    return converted;
+}
+
+// Function to check two box lists are identical, in order
+static bool SameBoxes(const std::vector<Box>& a, const std::vector<Box>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Box& x, const Box& y) {
+        return x.left == y.left && x.top == y.top && x.right == y.right && x.bottom == y.bottom;
+    });
+}
+
+// Function to time each detection mode on the same scene captured as 8-bit, 10-bit and
+// half-float pixels, and check the wider formats find the same boxes as 8-bit BGRA
+static int RunFormats(const BenchOptions& options) {
+    std::vector<std::vector<uint8_t>> frames = RenderFrames(options);
+    const PixelFormat formats[] = {PixelFormat::BGRA8, PixelFormat::RGB10A2, PixelFormat::RGBA16F};
+    std::vector<std::vector<uint8_t>> converted[3];
+    for (int f = 0; f < 3; ++f) {
+        for (const std::vector<uint8_t>& frame : frames) {
+            converted[f].push_back(ConvertFrame(frame, formats[f]));
+        }
+    }
+    DiffKernel kernel = SelectDiffKernel();
+    printf("%dx%d, %d frames, %d sprites, %s kernels\n", options.width, options.height, options.frames, options.sprites, DiffKernelName(kernel));
+    printf("%12s %12s %12s %12s %12s\n", "mode", "bgra8 ms", "rgb10a2 ms", "rgba16f ms", "mismatches");
+    const char* names[] = {"pixel diff", "tile hash", "pyramid", "background"};
+    const DetectionMode modes[] = {DetectionMode::PixelDiff, DetectionMode::TileHash, DetectionMode::Pyramid, DetectionMode::Background};
+    for (int mode = 0; mode < 4; ++mode) {
+        double elapsed[3] = {0.0, 0.0, 0.0};
+        std::vector<std::vector<Box>> reference(options.frames + 1);
+        int mismatches = 0;
+        for (int f = 0; f < 3; ++f) {
+            DetectorConfig config;
+            config.mode = modes[mode];
+            config.kernel = kernel;
+            config.threadCount = options.threads;
+            MotionDetector detector(config);
+            auto view = [&](int i) {
+                FrameView frame = MakeView(converted[f][i], options);
+                frame.rowPitch = options.width * PixelFormatBytes(formats[f]);
+                frame.format = formats[f];
+                return frame;
+            };
+            std::vector<Box> boxes;
+            // Seeds the state kept about earlier frames
+            detector.Detect(view(0), view(0), boxes);
+            for (int i = 1; i <= options.frames; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                detector.Detect(view(i), view(i - 1), boxes);
+                elapsed[f] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (f == 0) {
+                    reference[i] = boxes;
+                } else if (!SameBoxes(boxes, reference[i])) {
+                    mismatches++;
+                }
+            }
+        }
+        printf("%12s %12.3f %12.3f %12.3f %12d\n", names[mode], elapsed[0] / options.frames, elapsed[1] / options.frames,
+               elapsed[2] / options.frames, mismatches);
+    }
+    return 0;
+}
+
+// Function to draw the overlay for a synthetic scene both ways, clearing and redrawing every quad
+// and repairing only the damaged rectangles, check the images match after every frame and
+// compare the pixels each writes
+static int RunDamage(const BenchOptions& options) {
+    std::vector<std::vector<uint8_t>> frames = RenderFrames(options);
+    DetectorConfig config;
+    config.threadCount = options.threads;
+    MotionDetector detector(config);
+    ObjectTracker tracker;
+    BoxCoalescer coalescer;
+    DamageTracker damage;
+    QuadBatch batch;
+    SoftwareRasterBackend full, repaired;
+    full.Resize(options.width, options.height);
+    repaired.Resize(options.width, options.height);
+    const QuadColor transparent = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    std::vector<Box> boxes;
+    uint64_t fullPixels = 0, repairedPixels = 0;
+    double fullMs = 0.0, repairedMs = 0.0;
+    size_t quads = 0, dirtyRects = 0, skipped = 0, fullFrames = 0;
+    int mismatches = 0;
+    for (int i = 1; i <= options.frames; ++i) {
+        detector.Detect(MakeView(frames[i], options), MakeView(frames[i - 1], options), boxes);
+        tracker.Update(boxes);
+        coalescer.Coalesce(boxes);
+        // The same quads the overlay draws: confirmed tracks, then boxes
+        batch.Begin(options.width, options.height);
+        for (const Track& track : tracker.Tracks()) {
+            if (tracker.IsConfirmed(track)) {
+                batch.AddQuad(track.box, { 0.0f, 1.0f, 0.0f, 0.25f });
+            }
+        }
+        batch.AddQuads(boxes, { 1.0f, 0.0f, 0.0f, 1.0f });
+        quads += batch.QuadCount();
+
+        full.ResetPixelsWritten();
+        auto start = std::chrono::steady_clock::now();
+        full.Clear(transparent);
+        full.Draw(batch);
+        auto drawn = std::chrono::steady_clock::now();
+        fullMs += std::chrono::duration<double, std::milli>(drawn - start).count();
+        fullPixels += full.PixelsWritten();
+
+        repaired.ResetPixelsWritten();
+        start = std::chrono::steady_clock::now();
+        DamageKind kind = damage.Update(batch, transparent);
+        if (kind == DamageKind::Full) {
+            repaired.Clear(transparent);
+            repaired.Draw(batch);
+            fullFrames++;
+        } else if (kind == DamageKind::Partial) {
+            repaired.Draw(damage.RepairBatch());
+        } else {
+            skipped++;
+        }
+        drawn = std::chrono::steady_clock::now();
+        repairedMs += std::chrono::duration<double, std::milli>(drawn - start).count();
+        repairedPixels += repaired.PixelsWritten();
+        dirtyRects += damage.Stats().dirtyRects;
+        if (full.Pixels() != repaired.Pixels()) {
+            mismatches++;
+        }
+    }
+
+    printf("%dx%d, %d frames, %d sprites, %.1f quads per frame\n", options.width, options.height, options.frames,
+           options.sprites, static_cast<double>(quads) / options.frames);
+    printf("full redraw: %.3f ms/frame, %.0f pixels written per frame\n", fullMs / options.frames,
+           static_cast<double>(fullPixels) / options.frames);
+    printf("damage tracked: %.3f ms/frame, %.0f pixels written per frame (%.2f%%), %.1f dirty rects per frame, %zu full, %zu unchanged\n",
+           repairedMs / options.frames, static_cast<double>(repairedPixels) / options.frames,
+           fullPixels ? 100.0 * repairedPixels / fullPixels : 0.0, static_cast<double>(dirtyRects) / options.frames, fullFrames, skipped);
+    printf("images %s (%d mismatched frames)\n", mismatches == 0 ? "match" : "MISMATCH", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Function to drive the capture scheduler through busy, idle, resumed and overloaded phases on a
+// manual clock, then time how fast a reported change ends a backed-off wait on the real clock
+static int RunSchedule(const BenchOptions& options) {
+    SchedulerConfig config;
+    config.targetFps = options.fps > 0 ? options.fps : 60;
+    const int64_t interval = 1000000 / config.targetFps;
+    struct Phase {
+        const char* name;
+        int64_t durationUs;
+        bool changing;
+        int64_t workUs;
+    };
+    const Phase phases[] = {
+        { "busy", 2000000, true, interval / 4 },
+        { "idle", 10000000, false, interval / 4 },
+        { "resumed", 2000000, true, interval / 4 },
+        { "overload", 1000000, true, interval * 3 / 2 },
+    };
+    const int phaseCount = static_cast<int>(sizeof(phases) / sizeof(phases[0]));
+
+    printf("target %d fps, backing off after %d idle frames to at most %d ms between frames\n", config.targetFps,
+           config.idleFrames, config.maxIntervalMs);
+    printf("%10s %10s %10s %10s %14s %14s\n", "phase", "frames", "fps", "missed", "first frame ms", "interval ms");
+    ManualSchedulerClock clock;
+    FrameScheduler scheduler(config, clock);
+    int64_t phaseStart = clock.NowUs();
+    for (int p = 0; p < phaseCount; ++p) {
+        const Phase& phase = phases[p];
+        int64_t phaseEnd = phaseStart + phase.durationUs;
+        uint64_t missedBefore = scheduler.Stats().missedDeadlines;
+        int frames = 0;
+        int64_t firstFrameUs = -1;
+        // The frame that starts past the end belongs to the next phase, so peek at the clock first
+        while (clock.NowUs() + scheduler.IntervalUs() <= phaseEnd || frames == 0) {
+            int64_t start = scheduler.WaitForNextFrame();
+            if (firstFrameUs < 0) {
+                firstFrameUs = start - phaseStart;
+            }
+            ++frames;
+            clock.Advance(phase.workUs);
+            scheduler.ReportFrame(phase.changing);
+        }
+        SchedulerStats stats = scheduler.Stats();
+        printf("%10s %10d %10.1f %10llu %14.1f %14.1f\n", phase.name, frames, frames * 1e6 / phase.durationUs,
+               static_cast<unsigned long long>(stats.missedDeadlines - missedBefore), firstFrameUs / 1000.0, stats.intervalUs / 1000.0);
+        phaseStart = phaseEnd;
+    }
+
+    // Back off fully on the steady clock, then report a change from another thread mid-wait
+    SteadySchedulerClock steadyClock;
+    SchedulerConfig wakeConfig = config;
+    wakeConfig.idleFrames = 1;
+    FrameScheduler wakeScheduler(wakeConfig, steadyClock);
+    while (wakeScheduler.IntervalUs() < static_cast<int64_t>(wakeConfig.maxIntervalMs) * 1000) {
+        wakeScheduler.WaitForNextFrame();
+        wakeScheduler.ReportFrame(false);
+    }
+    wakeScheduler.WaitForNextFrame();
+    std::atomic<int64_t> reportedUs{ 0 };
+    std::thread detect([&wakeScheduler, &steadyClock, &reportedUs] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        reportedUs = steadyClock.NowUs();
+        wakeScheduler.ReportFrame(true);
+    });
+    int64_t wokenUs = wakeScheduler.WaitForNextFrame();
+    detect.join();
+    printf("change reported during a %d ms idle wait: next frame %.3f ms later\n", wakeConfig.maxIntervalMs,
+           (wokenUs - reportedUs) / 1000.0);
+    return 0;
+}
+
+// Function to keep the boxes clear of every area in `near` and sort them, so two detectors'
+// boxes away from those areas compare equal
+static void BoxesOutside(const std::vector<Box>& boxes, const std::vector<Box>& near, std::vector<Box>& outside) {
+    outside.clear();
+    for (const Box& box : boxes) {
+        if (std::none_of(near.begin(), near.end(), [&box](const Box& area) { return BoxesIntersect(box, area); })) {
+            outside.push_back(box);
+        }
+    }
+    std::sort(outside.begin(), outside.end(), [](const Box& a, const Box& b) {
+        return a.top != b.top ? a.top < b.top : a.left != b.left ? a.left < b.left : a.right != b.right ? a.right < b.right : a.bottom < b.bottom;
+    });
+}
+
+// Frames run through both detectors before timing starts: a tile is demoted once it changed in
+// hotFrames (28) of the last 32 frames, so this covers the whole history
+static const int kSamplingWarmupFrames = 32;
+
+// Function to time detection on a screen with a video playing in its centre quarter, comparing
+// every tile every frame with demoting the video's tiles to every `sampleHot`-th frame, and check
+// that both find the same boxes away from the activity regions. Both detectors first run
+// kSamplingWarmupFrames untimed frames, so the timings show the steady state with the video
+// demoted rather than the frames before it. Slow sprites can keep tiles changing long enough to
+// be demoted too, so the check skips every activity region, not only the video.
+static int RunSampling(const BenchOptions& options) {
+    SyntheticScene scene(options.width, options.height);
+    scene.AddRandomSprites(options.sprites, 200);
+    Box video{options.width / 4, options.height / 4, options.width * 3 / 4, options.height * 3 / 4};
+    scene.SetVideo(video.left, video.top, video.right, video.bottom, true);
+    const int totalFrames = kSamplingWarmupFrames + options.frames;
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < totalFrames + 1; ++i) {
+        FrameView view = scene.View();
+        frames.emplace_back(view.pixels, view.pixels + static_cast<size_t>(view.rowPitch) * view.height);
+        scene.Step();
+    }
+
+    DetectorConfig config;
+    config.threadCount = options.threads;
+    MotionDetector full(config);
+    config.sampling.sampleInterval = options.sampleHot;
+    MotionDetector sampled(config);
+    std::vector<Box> fullBoxes, sampledBoxes, fullOutside, sampledOutside, near;
+    double elapsed[2] = {0.0, 0.0};
+    size_t boxCount[2] = {0, 0};
+    size_t skipped = 0, regions = 0, mismatches = 0;
+    uint64_t allocations = 0;
+    int demotedFrame = -1;
+    for (int i = 1; i <= totalFrames; ++i) {
+        FrameView current = MakeView(frames[i], options);
+        FrameView previous = MakeView(frames[i - 1], options);
+        bool timed = i > kSamplingWarmupFrames;
+        // Whichever detector runs second finds the frames in cache, so alternate the order
+        for (int pass = 0; pass < 2; ++pass) {
+            bool runSampled = (pass == 0) == ((i & 1) != 0);
+            MotionDetector& detector = runSampled ? sampled : full;
+            std::vector<Box>& boxes = runSampled ? sampledBoxes : fullBoxes;
+            uint64_t allocationsBefore = AllocationCount();
+            auto start = std::chrono::steady_clock::now();
+            detector.Detect(current, previous, boxes);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (timed) {
+                elapsed[runSampled] += ms;
+                boxCount[runSampled] += boxes.size();
+                allocations += runSampled ? AllocationCount() - allocationsBefore : 0;
+            }
+        }
+        if (demotedFrame < 0 && sampled.Activity().DemotedCount() != 0) {
+            demotedFrame = i;
+        }
+        if (!timed) {
+            continue;
+        }
+        skipped += sampled.Activity().SkippedCount();
+        regions += sampled.ActivityRegions().size();
+        // Boxes touching a tile next to an activity region may join its blob in one detector and
+        // not the other
+        near.clear();
+        for (const Box& region : sampled.ActivityRegions()) {
+            near.push_back(Box{region.left - config.tileSize, region.top - config.tileSize, region.right + config.tileSize, region.bottom + config.tileSize});
+        }
+        BoxesOutside(fullBoxes, near, fullOutside);
+        BoxesOutside(sampledBoxes, near, sampledOutside);
+        if (!SameBoxes(fullOutside, sampledOutside)) {
+            ++mismatches;
+        }
+    }
+
+    const TileMap& tiles = sampled.Tiles();
+    int timedFrames = std::max(options.frames, 1);
+    double tileCount = static_cast<double>(tiles.cols) * tiles.rows * timedFrames;
+    printf("%dx%d, %d frames after %d warm-up frames, %d sprites, video playing in %dx%d at %d,%d\n", options.width, options.height,
+           options.frames, kSamplingWarmupFrames, options.sprites, video.Width(), video.Height(), video.left, video.top);
+    if (demotedFrame < 0) {
+        printf("video never demoted\n");
+    } else {
+        printf("video demoted after %d frame(s)\n", demotedFrame);
+    }
+    printf("every frame:       detect %.3f ms/frame, %.1f boxes/frame\n", elapsed[0] / timedFrames,
+           static_cast<double>(boxCount[0]) / timedFrames);
+    printf("sampled every %-3d detect %.3f ms/frame (%.1f%%), %.1f boxes/frame, %.1f activity regions/frame\n",
+           sampled.Activity().Config().sampleInterval, elapsed[1] / timedFrames, 100.0 * elapsed[1] / std::max(elapsed[0], 1e-9),
+           static_cast<double>(boxCount[1]) / timedFrames, static_cast<double>(regions) / timedFrames);
+    printf("%.1f%% of tile comparisons skipped, %zu frame(s) with different boxes away from the video, %llu allocation(s) while sampling\n",
+           100.0 * skipped / tileCount, mismatches, static_cast<unsigned long long>(allocations));
+    return mismatches == 0 && allocations == 0 ? 0 : 1;
+}
+
+// Function to get the CPU time the calling thread has used in microseconds, which unlike wall time
+// does not grow while the thread is preempted; -1 where no precise per-thread clock exists
+// (Windows only counts thread time in scheduler ticks)
+static double ThreadCpuMicros() {
+#if defined(_WIN32)
+    return -1.0;
+#else
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) * 1e6 + static_cast<double>(now.tv_nsec) / 1e3;
+#endif
+}
+
+// Function to time folding each frame's tile map into a heatmap with the scalar and the selected
+// kernel, check both give the same heat, and show that exports running flat out on another thread
+// do not stall the updates: their update times are compared with those next to a thread that only
+// burns CPU, which shows what preemption alone costs, and the worst update is also timed in thread
+// CPU time, which leaves preemption out. Tile maps come from real detection of the
+// scene but are detected once up front, so only the heatmap is timed.
+static int RunHeatmap(const BenchOptions& options) {
+    SyntheticScene scene(options.width, options.height);
+    scene.AddRandomSprites(options.sprites, 200);
+    MotionDetector detector;
+    std::vector<Box> boxes;
+    std::vector<TileMap> maps;
+    FrameView first = scene.View();
+    std::vector<uint8_t> previous(first.pixels, first.pixels + static_cast<size_t>(first.rowPitch) * first.height);
+    for (int i = 0; i < options.frames; ++i) {
+        scene.Step();
+        FrameView current = scene.View();
+        detector.Detect(current, MakeView(previous, options), boxes);
+        maps.push_back(detector.Tiles());
+        previous.assign(current.pixels, current.pixels + previous.size());
+    }
+
+    // Enough passes over the frames for the per-frame cost to rise above timer resolution
+    const int passes = std::max(1, 2000 / std::max(options.frames, 1));
+    const DiffKernel kernels[2] = { DiffKernel::Scalar, SelectDiffKernel() };
+    HeatmapConfig config;
+    std::unique_ptr<Heatmap> heatmaps[2];
+    double elapsed[2] = { 0.0, 0.0 };
+    for (int k = 0; k < 2; ++k) {
+        heatmaps[k] = std::make_unique<Heatmap>(config, kernels[k]);
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const TileMap& map : maps) {
+                heatmaps[k]->Update(map);
+            }
+        }
+        elapsed[k] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        heatmaps[k]->Publish();
+    }
+    HeatmapSnapshot snapshots[2];
+    heatmaps[0]->CopySnapshot(snapshots[0]);
+    heatmaps[1]->CopySnapshot(snapshots[1]);
+    bool same = snapshots[0].heat == snapshots[1].heat;
+    const double updates = static_cast<double>(passes) * maps.size();
+    const TileMap& tiles = maps.back();
+    printf("%dx%d, %d frames, %d sprites: %dx%d tiles of %d px, mean %.1f dirty tiles/frame\n", options.width, options.height,
+           options.frames, options.sprites, tiles.cols, tiles.rows, tiles.tileSize,
+           std::accumulate(maps.begin(), maps.end(), 0.0, [](double sum, const TileMap& map) { return sum + map.DirtyCount(); }) / maps.size());
+    printf("scalar update:  %.2f us/frame\n", elapsed[0] / updates);
+    // AVX2 machines run the SSE2 heat kernel (see GetHeatRowFunc)
+    printf("%-6s update:  %.2f us/frame (%.2fx), heat %s\n", DiffKernelName(kernels[1] == DiffKernel::AVX2 ? DiffKernel::SSE2 : kernels[1]), elapsed[1] / updates,
+           elapsed[1] > 0.0 ? elapsed[0] / elapsed[1] : 0.0, same ? "identical" : "DIFFERENT");
+
+    // Publish every frame so exports and publishing collide as often as possible. With fewer cores
+    // than threads the other thread preempts the update loop for whole scheduler slices, which
+    // shows in the worst times of both the busy and the export run but is not waiting.
+    config.snapshotInterval = 1;
+    const char* const runNames[3] = { "publishing every frame alone:", "next to a busy thread:", "with exports on another thread:" };
+    double meanUs[3] = { 0.0, 0.0, 0.0 };
+    double p99Us[3] = { 0.0, 0.0, 0.0 };
+    double worstUs[3] = { 0.0, 0.0, 0.0 };
+    double p99CpuUs[3] = { 0.0, 0.0, 0.0 };
+    double worstCpuUs[3] = { 0.0, 0.0, 0.0 };
+    std::atomic<int> exports{ 0 };
+    const char* exportPath = "overlay_bench_heatmap.pgm";
+    std::vector<double> times(static_cast<size_t>(updates));
+    std::vector<double> cpuTimes(times.size());
+    for (int run = 0; run < 3; ++run) {
+        Heatmap heatmap(config);
+        heatmap.Update(maps[0]);
+        std::atomic<bool> running{ true };
+        std::thread other;
+        if (run == 1) {
+            other = std::thread([&running] {
+                volatile uint64_t spin = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    spin = spin + 1;
+                }
+            });
+        } else if (run == 2) {
+            other = std::thread([&heatmap, &running, &exports, exportPath] {
+                while (running.load(std::memory_order_relaxed)) {
+                    if (heatmap.WritePgm(exportPath)) {
+                        exports.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        size_t count = 0;
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const TileMap& map : maps) {
+                double cpuStart = ThreadCpuMicros();
+                auto start = std::chrono::steady_clock::now();
+                heatmap.Update(map);
+                times[count++] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                cpuTimes[count - 1] = ThreadCpuMicros() - cpuStart;
+            }
+        }
+        running = false;
+        if (other.joinable()) {
+            other.join();
+        }
+        meanUs[run] = std::accumulate(times.begin(), times.end(), 0.0) / updates;
+        std::sort(times.begin(), times.end());
+        p99Us[run] = times[times.size() * 99 / 100];
+        worstUs[run] = times.back();
+        std::sort(cpuTimes.begin(), cpuTimes.end());
+        p99CpuUs[run] = cpuTimes[cpuTimes.size() * 99 / 100];
+        worstCpuUs[run] = cpuTimes.back();
+    }
+    remove(exportPath);
+    for (int run = 0; run < 3; ++run) {
+        printf("%-34s update mean %.2f us, p99 %.1f us, worst %.1f us", runNames[run], meanUs[run], p99Us[run], worstUs[run]);
+        if (worstCpuUs[run] >= 0.0) {
+            printf(" (thread CPU time p99 %.1f us, worst %.1f us)", p99CpuUs[run], worstCpuUs[run]);
+        }
+        if (run == 2) {
+            printf(", %d PGM exports", exports.load());
+        }
+        printf("\n");
+    }
+    return same ? 0 : 1;
+}
+
+// Synthetic desktop workloads run by the suite. Apart from the static desktop and the whole-screen
+// change, each has many separate moving objects, so coalescing and quad batching get real work.
+enum class SuiteWorkload {
+    Static,
+    Cursor,
+    WindowDrag,
+    Scroll,
+    Video,
+    Particles,
+    FullScreen,
+};
+
+static const SuiteWorkload kSuiteWorkloads[] = { SuiteWorkload::Static, SuiteWorkload::Cursor, SuiteWorkload::WindowDrag,
+                                                 SuiteWorkload::Scroll, SuiteWorkload::Video, SuiteWorkload::Particles,
+                                                 SuiteWorkload::FullScreen };
+
+static const char* SuiteWorkloadName(SuiteWorkload workload) {
+    switch (workload) {
+    case SuiteWorkload::Static: return "static";
+    case SuiteWorkload::Cursor: return "cursor";
+    case SuiteWorkload::WindowDrag: return "window_drag";
+    case SuiteWorkload::Scroll: return "scroll";
+    case SuiteWorkload::Video: return "video";
+    case SuiteWorkload::Particles: return "particles";
+    case SuiteWorkload::FullScreen: return "full_screen";
+    }
+    return "unknown";
+}
+
+// Function to add `count` sprites of minSize to maxSize pixels scattered over the scene, moving at
+// up to maxSpeed pixels per frame on each axis; `state` seeds and advances the placement
+static void AddScattered(SyntheticScene& scene, int count, int minSize, int maxSize, int maxSpeed, uint32_t& state) {
+    auto next = [&state](int range) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<int>(state % static_cast<uint32_t>(std::max(range, 1)));
+    };
+    for (int i = 0; i < count; ++i) {
+        SceneSprite sprite;
+        sprite.width = minSize + next(maxSize - minSize + 1);
+        sprite.height = minSize + next(maxSize - minSize + 1);
+        sprite.x = next(scene.Width() - sprite.width);
+        sprite.y = next(scene.Height() - sprite.height);
+        sprite.velocityX = next(2 * maxSpeed + 1) - maxSpeed;
+        sprite.velocityY = next(2 * maxSpeed + 1) - maxSpeed;
+        sprite.color = 0xFF000000u | (static_cast<uint32_t>(next(1 << 24)));
+        scene.AddSprite(sprite);
+    }
+}
+
+// Function to set up a scene for one workload; object counts scale with the screen area
+static void SetUpWorkload(SyntheticScene& scene, SuiteWorkload workload) {
+    int width = scene.Width();
+    int height = scene.Height();
+    int scale = std::max(1, static_cast<int>(static_cast<int64_t>(width) * height / (1920 * 1080)));
+    uint32_t state = 0x9E3779B9u;
+    const SceneSprite cursor = { width / 2, height / 2, 12, 20, 3, 2, 0xFFFFFFFFu };
+    switch (workload) {
+    case SuiteWorkload::Static:
+        break;
+    case SuiteWorkload::Cursor:
+        // The pointer, blinking text carets and small busy indicators around the screen
+        scene.AddSprite(cursor);
+        for (int i = 0; i < 8 * scale; ++i) {
+            SceneSprite caret = { (i * 977) % (width - 2), (i * 563) % (height - 18), 2, 18, 0, 0, 0xFF000000u, 1 + i % 3 };
+            scene.AddSprite(caret);
+        }
+        AddScattered(scene, 16 * scale, 12, 24, 1, state);
+        break;
+    case SuiteWorkload::WindowDrag:
+        // One window dragged across small windows whose contents keep changing
+        scene.AddSprite({ width / 6, height / 6, width / 3, height / 3, 12, 6, 0xFF3060A0u });
+        AddScattered(scene, 24 * scale, 40, 160, 2, state);
+        break;
+    case SuiteWorkload::Scroll:
+        scene.SetScroll(width / 8, height / 8, width * 7 / 8, height * 7 / 8, 4);
+        scene.AddSprite(cursor);
+        AddScattered(scene, 12 * scale, 16, 48, 3, state);
+        break;
+    case SuiteWorkload::Video:
+        scene.SetVideo(width / 4, height / 4, width * 3 / 4, height * 3 / 4);
+        scene.AddSprite(cursor);
+        AddScattered(scene, 24 * scale, 16, 64, 4, state);
+        break;
+    case SuiteWorkload::Particles:
+        // Hundreds of small fast objects, mostly far enough apart to stay separate boxes
+        scene.AddSprite(cursor);
+        AddScattered(scene, 400 * scale, 4, 12, 12, state);
+        break;
+    case SuiteWorkload::FullScreen:
+        scene.SetVideo(0, 0, width, height);
+        break;
+    }
+}
+
+// Measurements of one workload at one resolution
+struct SuiteResult {
+    SuiteWorkload workload;
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    double detectMeanMs = 0.0;
+    double detectP50Ms = 0.0;
+    double detectP99Ms = 0.0;
+    double coalesceMeanUs = 0.0;
+    double verticesMeanUs = 0.0;
+    double boxesPerFrame = 0.0;
+    double coalescedPerFrame = 0.0;
+    uint64_t allocations = 0;
+    int allocatingFrames = 0;
+
+    double NsPerPixel() const { return detectMeanMs * 1e6 / (static_cast<double>(width) * height); }
+    double Fps() const { return detectMeanMs > 0.0 ? 1000.0 / detectMeanMs : 0.0; }
+};
+
+// Frames run before the suite starts timing, while buffers grow to their steady-state size
+const int kSuiteWarmupFrames = 5;
+
+// Function to run one workload through detection (diff and box extraction), coalescing and quad
+// vertex generation as the overlay does each frame. Scene generation is not timed and its
+// allocations are not counted.
+static SuiteResult RunSuiteWorkload(SuiteWorkload workload, int width, int height, const BenchOptions& options) {
+    SyntheticScene scene(width, height);
+    SetUpWorkload(scene, workload);
+    DetectorConfig config;
+    config.threadCount = options.threads;
+    MotionDetector detector(config);
+    BoxCoalescer coalescer;
+    QuadBatch batch;
+    std::vector<Box> boxes, coalesced;
+    FrameView first = scene.View();
+    std::vector<uint8_t> previous(first.pixels, first.pixels + static_cast<size_t>(first.rowPitch) * first.height);
+    FrameView previousView = first;
+    previousView.pixels = previous.data();
+
+    SuiteResult result;
+    result.workload = workload;
+    result.width = width;
+    result.height = height;
+    result.frames = options.frames;
+    std::vector<double> detectTimes;
+    detectTimes.reserve(options.frames);
+    double coalesceUs = 0.0, verticesUs = 0.0;
+    size_t boxCount = 0, coalescedCount = 0;
+    for (int i = 0; i < kSuiteWarmupFrames + options.frames; ++i) {
+        scene.Step();
+        FrameView current = scene.View();
+        bool measured = i >= kSuiteWarmupFrames;
+        uint64_t allocationsBefore = AllocationCount();
+        auto start = std::chrono::steady_clock::now();
+        detector.Detect(current, previousView, boxes);
+        auto detected = std::chrono::steady_clock::now();
+        coalescer.Reserve(detector.Tiles().dirty.size());
+        coalesced.reserve(detector.Tiles().dirty.size());
+        coalesced.assign(boxes.begin(), boxes.end());
+        coalescer.Coalesce(coalesced);
+        auto merged = std::chrono::steady_clock::now();
+        batch.Reserve(detector.Tiles().dirty.size());
+        batch.Begin(width, height);
+        batch.AddQuads(coalesced, { 1.0f, 0.0f, 0.0f, 0.5f });
+        auto built = std::chrono::steady_clock::now();
+        uint64_t allocations = AllocationCount() - allocationsBefore;
+        if (measured) {
+            detectTimes.push_back(std::chrono::duration<double, std::milli>(detected - start).count());
+            coalesceUs += std::chrono::duration<double, std::micro>(merged - detected).count();
+            verticesUs += std::chrono::duration<double, std::micro>(built - merged).count();
+            boxCount += boxes.size();
+            coalescedCount += coalesced.size();
+            result.allocations += allocations;
+            result.allocatingFrames += allocations != 0;
+        }
+        std::copy(current.pixels, current.pixels + previous.size(), previous.begin());
+    }
+
+    std::vector<double> sorted = detectTimes;
+    std::sort(sorted.begin(), sorted.end());
+    result.detectMeanMs = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    result.detectP50Ms = sorted[sorted.size() / 2];
+    result.detectP99Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+    result.coalesceMeanUs = coalesceUs / options.frames;
+    result.verticesMeanUs = verticesUs / options.frames;
+    result.boxesPerFrame = static_cast<double>(boxCount) / options.frames;
+    result.coalescedPerFrame = static_cast<double>(coalescedCount) / options.frames;
+    return result;
+}
+
+// Function to write the suite results as one JSON document, so runs of different versions can be
+// compared by a script
+static bool WriteSuiteJson(const char* path, const std::vector<SuiteResult>& results, const BenchOptions& options) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "{\"suite_version\":1,\"kernel\":\"%s\",\"threads\":%d,\"frames\":%d,\"warmup_frames\":%d,\"results\":[",
+            DiffKernelName(SelectDiffKernel()), options.threads, options.frames, kSuiteWarmupFrames);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SuiteResult& r = results[i];
+        fprintf(file,
+                "%s\n{\"workload\":\"%s\",\"width\":%d,\"height\":%d,"
+                "\"detect\":{\"mean_ms\":%.4f,\"p50_ms\":%.4f,\"p99_ms\":%.4f,\"ns_per_pixel\":%.4f,\"fps\":%.1f,\"mpixels_per_s\":%.1f},"
+                "\"coalesce\":{\"mean_us\":%.2f},\"vertices\":{\"mean_us\":%.2f},"
+                "\"boxes_per_frame\":%.2f,\"coalesced_boxes_per_frame\":%.2f,\"allocations\":%llu,\"allocating_frames\":%d}",
+                i > 0 ? "," : "", SuiteWorkloadName(r.workload), r.width, r.height, r.detectMeanMs, r.detectP50Ms, r.detectP99Ms,
+                r.NsPerPixel(), r.Fps(), r.Fps() * r.width * r.height / 1e6, r.coalesceMeanUs, r.verticesMeanUs, r.boxesPerFrame,
+                r.coalescedPerFrame, static_cast<unsigned long long>(r.allocations), r.allocatingFrames);
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+// Function to run every workload at 1080p, 1440p and 4K, print a table and optionally write JSON.
+// Fails if any frame after the warm-up allocated, since the frame loop is meant to reuse its buffers.
+static int RunSuite(const BenchOptions& options) {
+    const int resolutions[][2] = { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+    std::vector<SuiteResult> results;
+    printf("%-12s %10s %10s %10s %10s %8s %11s %10s %8s %8s %7s\n", "workload", "resolution", "detect ms", "p99 ms", "ns/pixel",
+           "fps", "coalesce us", "vertex us", "boxes", "merged", "allocs");
+    for (const int* resolution : resolutions) {
+        for (SuiteWorkload workload : kSuiteWorkloads) {
+            SuiteResult r = RunSuiteWorkload(workload, resolution[0], resolution[1], options);
+            char size[32];
+            snprintf(size, sizeof(size), "%dx%d", r.width, r.height);
+            printf("%-12s %10s %10.3f %10.3f %10.3f %8.0f %11.1f %10.1f %8.1f %8.1f %7llu\n", SuiteWorkloadName(workload), size,
+                   r.detectMeanMs, r.detectP99Ms, r.NsPerPixel(), r.Fps(), r.coalesceMeanUs, r.verticesMeanUs, r.boxesPerFrame,
+                   r.coalescedPerFrame, static_cast<unsigned long long>(r.allocations));
+            results.push_back(r);
+        }
+    }
+    if (options.jsonPath) {
+        if (!WriteSuiteJson(options.jsonPath, results, options)) {
+            fprintf(stderr, "Failed to write %s\n", options.jsonPath);
+            return 1;
+        }
+        printf("wrote %s\n", options.jsonPath);
+    }
+    bool allocated = std::any_of(results.begin(), results.end(), [](const SuiteResult& r) { return r.allocations != 0; });
+    return allocated ? 1 : 0;
+}
+
+// Function to time pyramid detection (1/4 and 1/8 scale) against full-resolution pixel diffing on
+// every suite workload at 1080p and 4K, with the share of pixels that changed per frame, and count
+// frames where the pyramid found different dirty tiles (changes that cancel out in a cell's sum).
+// The pyramid reads the current frame once for its coarse level and both frames only around
+// changed cells, so it wins when little of the screen changes and loses when much of it does.
+static int RunPyramid(const BenchOptions& options) {
+    const int resolutions[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    const int scales[] = { 4, 8 };
+    printf("%-12s %10s %9s %10s %16s %16s\n", "workload", "resolution", "changed %", "diff ms", "pyramid 4 ms", "pyramid 8 ms");
+    for (const int* resolution : resolutions) {
+        for (SuiteWorkload workload : kSuiteWorkloads) {
+            SyntheticScene scene(resolution[0], resolution[1]);
+            SetUpWorkload(scene, workload);
+            DetectorConfig config;
+            config.threadCount = options.threads;
+            std::vector<std::unique_ptr<MotionDetector>> detectors;
+            detectors.push_back(std::make_unique<MotionDetector>(config));
+            config.mode = DetectionMode::Pyramid;
+            for (int scale : scales) {
+                config.pyramidScale = scale;
+                detectors.push_back(std::make_unique<MotionDetector>(config));
+            }
+            FrameView first = scene.View();
+            std::vector<uint8_t> previous(first.pixels, first.pixels + static_cast<size_t>(first.rowPitch) * first.height);
+            FrameView previousView = first;
+            previousView.pixels = previous.data();
+            std::vector<Box> boxes;
+            double elapsed[3] = { 0.0, 0.0, 0.0 };
+            double changed = 0.0;
+            int differing[3] = { 0, 0, 0 };
+            for (int i = 0; i < kSuiteWarmupFrames + options.frames; ++i) {
+                scene.Step();
+                FrameView current = scene.View();
+                bool measured = i >= kSuiteWarmupFrames;
+                // Rotate the order so no detector always finds the frames in cache
+                for (size_t pass = 0; pass < detectors.size(); ++pass) {
+                    size_t d = (pass + i) % detectors.size();
+                    auto start = std::chrono::steady_clock::now();
+                    detectors[d]->Detect(current, previousView, boxes);
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    elapsed[d] += measured ? ms : 0.0;
+                }
+                if (measured) {
+                    changed += static_cast<double>(detectors[0]->ChangedPixels()) / (static_cast<double>(current.width) * current.height);
+                    for (size_t d = 1; d < detectors.size(); ++d) {
+                        differing[d] += detectors[d]->Tiles().dirty != detectors[0]->Tiles().dirty ? 1 : 0;
+                    }
+                }
+                std::copy(current.pixels, current.pixels + previous.size(), previous.begin());
+            }
+            int frames = std::max(options.frames, 1);
+            char size[32];
+            snprintf(size, sizeof(size), "%dx%d", resolution[0], resolution[1]);
+            printf("%-12s %10s %9.2f %10.3f %9.3f (%.2fx) %9.3f (%.2fx)\n", SuiteWorkloadName(workload), size, 100.0 * changed / frames,
+                   elapsed[0] / frames, elapsed[1] / frames, elapsed[0] / std::max(elapsed[1], 1e-9), elapsed[2] / frames,
+                   elapsed[0] / std::max(elapsed[2], 1e-9));
+            for (size_t d = 1; d < detectors.size(); ++d) {
+                if (differing[d] != 0) {
+                    printf("  pyramid %d: %d frame(s) with different dirty tiles\n", scales[d - 1], differing[d]);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s threads|record|pipeline|render|noise|track|coalesce|scroll|mask|formats|damage|schedule|sampling|heatmap|suite|pyramid [options]\n", argv[0]);
+        return 1;
+    }
+    bool record = strcmp(argv[1], "record") == 0;
+    if (record && argc < 3) {
+        fprintf(stderr, "Usage: %s record <trace> [options]\n", argv[0]);
+        return 1;
+    }
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, record ? 3 : 2, options)) {
+        return 1;
+    }
+    if (record) {
+        return RecordTrace(argv[2], options);
+    }
+    if (strcmp(argv[1], "threads") == 0) {
+        return RunThreadScaling(options);
+    }
+    if (strcmp(argv[1], "pipeline") == 0) {
+        return RunPipeline(options);
+    }
+    if (strcmp(argv[1], "render") == 0) {
+        return RunRender(options);
+    }
+    if (strcmp(argv[1], "noise") == 0) {
+        return RunNoise(options);
+    }
+    if (strcmp(argv[1], "track") == 0) {
+        return RunTrack(options);
+    }
+    if (strcmp(argv[1], "coalesce") == 0) {
+        return RunCoalesce(options);
+    }
+    if (strcmp(argv[1], "scroll") == 0) {
+        return RunScroll(options);
+    }
+    if (strcmp(argv[1], "mask") == 0) {
+        return RunMask(options);
+    }
+    if (strcmp(argv[1], "formats") == 0) {
+        return RunFormats(options);
+    }
+    if (strcmp(argv[1], "damage") == 0) {
+        return RunDamage(options);
+    }
+    if (strcmp(argv[1], "schedule") == 0) {
+        return RunSchedule(options);
+    }
+    if (strcmp(argv[1], "sampling") == 0) {
+        return RunSampling(options);
+    }
+    if (strcmp(argv[1], "heatmap") == 0) {
+        return RunHeatmap(options);
+    }
+    if (strcmp(argv[1], "suite") == 0) {
+        return RunSuite(options);
+    }
+    if (strcmp(argv[1], "pyramid") == 0) {
+        return RunPyramid(options);
+    }
+    fprintf(stderr, "Unknown benchmark %s\n", argv[1]);
+    return 1;
+}
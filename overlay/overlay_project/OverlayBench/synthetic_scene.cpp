@@ -0,0 +1,185 @@
+#include "synthetic_scene.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Small xorshift generator so scenes are identical on every platform
+static uint32_t NextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+SyntheticScene::SyntheticScene(int sceneWidth, int sceneHeight, uint32_t sceneSeed)
+    : width(sceneWidth), height(sceneHeight), seed(sceneSeed ? sceneSeed : 1) {
+    background.resize(static_cast<size_t>(width) * height);
+    pixels.resize(background.size());
+    DrawBackground();
+    pixels = background;
+}
+
+// Function to paint a desktop-like background: flat panels with some text-like noise
+void SyntheticScene::DrawBackground() {
+    uint32_t state = seed;
+    for (int y = 0; y < height; ++y) {
+        uint32_t* row = &background[static_cast<size_t>(y) * width];
+        uint32_t panel = 0xFF202020u + ((y / 120) & 3) * 0x00101010u;
+        for (int x = 0; x < width; ++x) {
+            row[x] = (NextRandom(state) & 15) == 0 ? 0xFFE0E0E0u : panel;
+        }
+    }
+}
+
+// Function to add `count` randomly placed sprites of up to maxSize pixels
+void SyntheticScene::AddRandomSprites(int count, int maxSize) {
+    uint32_t state = seed * 2654435761u + 1;
+    for (int i = 0; i < count; ++i) {
+        SceneSprite sprite;
+        sprite.width = 8 + static_cast<int>(NextRandom(state) % std::max(1, maxSize - 8));
+        sprite.height = 8 + static_cast<int>(NextRandom(state) % std::max(1, maxSize - 8));
+        sprite.x = static_cast<int>(NextRandom(state) % std::max(1, width - sprite.width));
+        sprite.y = static_cast<int>(NextRandom(state) % std::max(1, height - sprite.height));
+        sprite.velocityX = static_cast<int>(NextRandom(state) % 17) - 8;
+        sprite.velocityY = static_cast<int>(NextRandom(state) % 17) - 8;
+        sprite.color = 0xFF000000u | (NextRandom(state) & 0x00FFFFFFu);
+        sprites.push_back(sprite);
+    }
+}
+
+// Function to nudge `pixelsPerFrame` random background pixels by up to +-amplitude per channel every frame
+void SyntheticScene::SetShimmer(int pixelsPerFrame, int amplitude) {
+    shimmerPixels = pixelsPerFrame;
+    shimmerAmplitude = amplitude;
+    shimmerState = seed * 40503u + 7;
+}
+
+// Function to scroll the background inside a rectangle every frame
+void SyntheticScene::SetScroll(int left, int top, int right, int bottom, int pixelsPerFrame) {
+    scrollLeft = std::max(left, 0);
+    scrollTop = std::max(top, 0);
+    scrollRight = std::min(right, width);
+    scrollBottom = std::min(bottom, height);
+    scrollPixels = std::max(0, std::min(pixelsPerFrame, scrollBottom - scrollTop));
+    scrollState = seed * 69069u + 3;
+    // Start with a full page of text-like rows
+    for (int y = scrollTop; y < scrollBottom; ++y) {
+        uint32_t* row = &background[static_cast<size_t>(y) * width];
+        for (int x = scrollLeft; x < scrollRight; ++x) {
+            row[x] = (NextRandom(scrollState) & 15) == 0 ? 0xFF101010u : 0xFFF0F0F0u;
+        }
+        std::copy(row + scrollLeft, row + scrollRight, &pixels[static_cast<size_t>(y) * width + scrollLeft]);
+    }
+}
+
+// Function to move the scrolled rectangle's rows up and draw fresh rows below them
+void SyntheticScene::ScrollBackground() {
+    int columns = scrollRight - scrollLeft;
+    for (int y = scrollTop; y < scrollBottom; ++y) {
+        uint32_t* row = &background[static_cast<size_t>(y) * width + scrollLeft];
+        if (y + scrollPixels < scrollBottom) {
+            std::copy(row + static_cast<size_t>(scrollPixels) * width, row + static_cast<size_t>(scrollPixels) * width + columns, row);
+        } else {
+            for (int x = 0; x < columns; ++x) {
+                row[x] = (NextRandom(scrollState) & 15) == 0 ? 0xFF101010u : 0xFFF0F0F0u;
+            }
+        }
+        std::copy(row, row + columns, &pixels[static_cast<size_t>(y) * width + scrollLeft]);
+    }
+}
+
+// Function to play a video inside a rectangle every frame
+void SyntheticScene::SetVideo(int left, int top, int right, int bottom, bool onTop) {
+    video.left = std::max(left, 0);
+    video.top = std::max(top, 0);
+    video.right = std::min(right, width);
+    video.bottom = std::min(bottom, height);
+    videoOnTop = onTop;
+    videoState = seed * 1103515245u + 11;
+}
+
+// Function to draw the next video frame over the background
+void SyntheticScene::DrawVideo() {
+    for (int y = video.top; y < video.bottom; y += 8) {
+        for (int x = video.left; x < video.right; x += 8) {
+            uint32_t color = 0xFF000000u | (NextRandom(videoState) & 0x00FFFFFFu);
+            FillRect(x, y, std::min(8, video.right - x), std::min(8, video.bottom - y), color);
+        }
+    }
+}
+
+void SyntheticScene::FillRect(int x, int y, int w, int h, uint32_t color) {
+    int x0 = std::max(x, 0);
+    int y0 = std::max(y, 0);
+    int x1 = std::min(x + w, width);
+    int y1 = std::min(y + h, height);
+    // Sprites smaller than their speed can overshoot the edge entirely before bouncing
+    if (x1 <= x0) {
+        return;
+    }
+    for (int row = y0; row < y1; ++row) {
+        std::fill(&pixels[static_cast<size_t>(row) * width + x0], &pixels[static_cast<size_t>(row) * width + x1], color);
+    }
+}
+
+// Function to advance the sprites one frame and render the result into `pixels`
+void SyntheticScene::Step() {
+    // Restore the background under the last shimmer and each sprite's old position, then move and redraw
+    for (size_t offset : shimmerOffsets) {
+        pixels[offset] = background[offset];
+    }
+    shimmerOffsets.clear();
+    if (scrollPixels > 0 && scrollRight > scrollLeft) {
+        ScrollBackground();
+    }
+    for (const SceneSprite& sprite : sprites) {
+        int x0 = std::max(sprite.x, 0);
+        int x1 = std::min(sprite.x + sprite.width, width);
+        if (x1 <= x0) {
+            continue;
+        }
+        for (int row = std::max(sprite.y, 0); row < std::min(sprite.y + sprite.height, height); ++row) {
+            size_t offset = static_cast<size_t>(row) * width;
+            std::copy(&background[offset + x0], &background[offset + x1], &pixels[offset + x0]);
+        }
+    }
+    if (!video.Empty() && !videoOnTop) {
+        DrawVideo();
+    }
+    size_t pixelCount = pixels.size();
+    for (int i = 0; i < shimmerPixels; ++i) {
+        size_t offset = NextRandom(shimmerState) % pixelCount;
+        uint32_t pixel = background[offset];
+        uint32_t noise = NextRandom(shimmerState);
+        for (int channel = 0; channel < 3; ++channel) {
+            int value = static_cast<int>((pixel >> (channel * 8)) & 0xFF);
+            value += static_cast<int>((noise >> (channel * 8)) % (2 * shimmerAmplitude + 1)) - shimmerAmplitude;
+            value = std::max(0, std::min(value, 255));
+            pixel = (pixel & ~(0xFFu << (channel * 8))) | (static_cast<uint32_t>(value) << (channel * 8));
+        }
+        pixels[offset] = pixel;
+        shimmerOffsets.push_back(offset);
+    }
+    ++frame;
+    for (SceneSprite& sprite : sprites) {
+        sprite.x += sprite.velocityX;
+        sprite.y += sprite.velocityY;
+        if (sprite.x < 0 || sprite.x > width - sprite.width) sprite.velocityX = -sprite.velocityX;
+        if (sprite.y < 0 || sprite.y > height - sprite.height) sprite.velocityY = -sprite.velocityY;
+        if (sprite.blinkFrames == 0 || (frame / sprite.blinkFrames) % 2 == 0) {
+            FillRect(sprite.x, sprite.y, sprite.width, sprite.height, sprite.color);
+        }
+    }
+    if (!video.Empty() && videoOnTop) {
+        DrawVideo();
+    }
+}
+
+FrameView SyntheticScene::View() const {
+    FrameView view;
+    view.pixels = reinterpret_cast<const uint8_t*>(pixels.data());
+    view.width = width;
+    view.height = height;
+    view.rowPitch = width * 4;
+    return view;
+}
@@ -0,0 +1,78 @@
+#ifndef SYNTHETIC_SCENE_H
+#define SYNTHETIC_SCENE_H
+
+#include "box.h"
+#include "frame_diff.h"
+
+#include <cstdint>
+#include <vector>
+
+// Solid rectangle that moves by a fixed velocity every frame and bounces off the frame edges
+struct SceneSprite {
+    int x, y;
+    int width, height;
+    int velocityX, velocityY;
+    uint32_t color;
+    // When non-zero the sprite is shown for this many frames, then hidden as long (a text cursor)
+    int blinkFrames = 0;
+};
+
+// Generates deterministic BGRA frames: a static textured desktop with moving sprites drawn on top
+class SyntheticScene {
+public:
+    SyntheticScene(int width, int height, uint32_t seed = 1);
+
+    void AddSprite(const SceneSprite& sprite) { sprites.push_back(sprite); }
+
+    // Function to add `count` randomly placed sprites of up to maxSize pixels
+    void AddRandomSprites(int count, int maxSize);
+
+    // Function to nudge `pixelsPerFrame` random background pixels by up to +-amplitude per channel
+    // every frame, like video compression shimmer or font re-rendering
+    void SetShimmer(int pixelsPerFrame, int amplitude);
+
+    // Function to scroll the background inside a rectangle up by `pixelsPerFrame` rows every
+    // frame, with new text-like rows appearing at the bottom, like a scrolled browser window
+    void SetScroll(int left, int top, int right, int bottom, int pixelsPerFrame);
+
+    // Function to repaint every 8x8 block inside a rectangle with a random colour every frame,
+    // like a playing video. With `onTop` the video is drawn over the sprites, like a player
+    // window in front of everything, so every one of its tiles changes in every frame.
+    void SetVideo(int left, int top, int right, int bottom, bool onTop = false);
+
+    // Function to advance the sprites one frame and render the result into `pixels`
+    void Step();
+
+    FrameView View() const;
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+private:
+    void DrawBackground();
+    void ScrollBackground();
+    void DrawVideo();
+    void FillRect(int x, int y, int w, int h, uint32_t color);
+
+    int width;
+    int height;
+    uint32_t seed;
+    std::vector<uint32_t> background;
+    std::vector<uint32_t> pixels;
+    std::vector<SceneSprite> sprites;
+    int frame = 0;
+    int shimmerPixels = 0;
+    int shimmerAmplitude = 0;
+    uint32_t shimmerState = 0;
+    std::vector<size_t> shimmerOffsets;
+    int scrollLeft = 0;
+    int scrollTop = 0;
+    int scrollRight = 0;
+    int scrollBottom = 0;
+    int scrollPixels = 0;
+    uint32_t scrollState = 0;
+    Box video;
+    bool videoOnTop = false;
+    uint32_t videoState = 0;
+};
+
+#endif // SYNTHETIC_SCENE_H
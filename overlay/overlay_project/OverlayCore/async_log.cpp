@@ -0,0 +1,323 @@
+#include "async_log.h"
+#include "spsc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Records each thread can queue before new ones are dropped
+static const size_t kRingRecords = 4096;
+
+// Ring owned by one logging thread. When the thread exits and its records have been written, the
+// ring is handed to the next thread that registers, so rings grow with the threads alive at once
+// rather than with every thread that ever logged.
+struct LogRing {
+    LogRing() : queue(kRingRecords) {}
+
+    SpscQueue<LogRecord> queue;
+    // Guarded by the logger's mutex
+    bool inUse = true;
+};
+
+static void DefaultLogSink(LogLevel level, const char* line, size_t length) {
+    static const char* const prefixes[] = { "Debug: ", "Info: ", "Warning: ", "Error: " };
+    FILE* stream = level >= LogLevel::Warning ? stderr : stdout;
+    fputs(prefixes[static_cast<int>(level)], stream);
+    fwrite(line, 1, length, stream);
+    fputc('\n', stream);
+}
+
+class Logger {
+public:
+    ~Logger() { Stop(); }
+
+    // Function to give the calling thread a ring, reusing one whose thread has exited once the
+    // worker has drained it, so a burst of short-lived threads gets as much room as the first
+    // thread did. The mutex orders the old owner's last push before the new owner's first.
+    LogRing* RegisterThread() {
+        std::lock_guard<std::mutex> lock(mutex);
+        LogRing* ring = nullptr;
+        for (const std::unique_ptr<LogRing>& candidate : rings) {
+            // Without a producer the ring can only drain, so a stale look errs towards a new ring
+            if (!candidate->inUse && candidate->queue.Empty()) {
+                ring = candidate.get();
+                break;
+            }
+        }
+        if (!ring) {
+            rings.push_back(std::make_unique<LogRing>());
+            ring = rings.back().get();
+        }
+        ring->inUse = true;
+        if (!worker.joinable()) {
+            stopping = false;
+            worker = std::thread(&Logger::Run, this);
+        }
+        return ring;
+    }
+
+    // Function to hand back the ring of a thread that is exiting; its records are still written
+    void ReleaseThread(LogRing* ring) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ring->inUse = false;
+    }
+
+    // Function to wake the worker if it sleeps, called after every push. The fence pairs with the
+    // one in Run: either this sees the worker asleep or the worker's last look sees the record.
+    void Wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            sleeping.store(false, std::memory_order_relaxed);
+            wake.notify_one();
+        }
+    }
+
+    void Flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!worker.joinable()) {
+            return;
+        }
+        uint64_t target = ++flushRequested;
+        sleeping.store(false, std::memory_order_relaxed);
+        wake.notify_one();
+        flushDone.wait(lock, [&] { return flushCompleted >= target || !worker.joinable(); });
+    }
+
+    void Stop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!worker.joinable()) {
+            return;
+        }
+        stopping = true;
+        sleeping.store(false, std::memory_order_relaxed);
+        wake.notify_one();
+        lock.unlock();
+        worker.join();
+        lock.lock();
+        worker = std::thread();
+        flushDone.notify_all();
+    }
+
+    // Threads that logged while no worker was running register again to restart it
+    void EnsureRunning() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!worker.joinable()) {
+            stopping = false;
+            worker = std::thread(&Logger::Run, this);
+        }
+    }
+
+    bool IsRunning() const { return running.load(std::memory_order_acquire); }
+
+    std::atomic<LogSinkFunc> sink{ DefaultLogSink };
+    std::atomic<uint64_t> dropped{ 0 };
+
+private:
+    void Run() {
+        running.store(true, std::memory_order_release);
+        std::vector<LogRecord> batch;
+        std::string line;
+        uint64_t reportedDrops = 0;
+        for (;;) {
+            // Take the flush request before draining so everything submitted before it is included
+            uint64_t flushTarget;
+            bool stop;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                flushTarget = flushRequested;
+                stop = stopping;
+                for (const std::unique_ptr<LogRing>& ring : rings) {
+                    LogRecord record;
+                    while (ring->queue.TryPop(record)) {
+                        batch.push_back(record);
+                    }
+                }
+            }
+
+            // Interleave the threads' records in time order
+            std::stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) { return a.timestampUs < b.timestampUs; });
+            LogSinkFunc output = sink.load();
+            for (const LogRecord& record : batch) {
+                FormatRecord(record, line);
+                output(record.site->level, line.data(), line.size());
+            }
+            uint64_t drops = dropped.load(std::memory_order_relaxed);
+            if (drops != reportedDrops) {
+                line = std::to_string(drops - reportedDrops) + " log records dropped, a thread's log ring was full";
+                output(LogLevel::Warning, line.data(), line.size());
+                reportedDrops = drops;
+            }
+            if (!batch.empty()) {
+                fflush(stdout);
+                fflush(stderr);
+            }
+
+            bool wrote = !batch.empty();
+            batch.clear();
+            std::unique_lock<std::mutex> lock(mutex);
+            if (flushTarget > flushCompleted) {
+                flushCompleted = flushTarget;
+                flushDone.notify_all();
+            }
+            if (stop) {
+                break;
+            }
+            if (wrote || flushRequested != flushTarget) {
+                continue;
+            }
+            // Nothing was queued: announce the sleep, then look once more so a record pushed
+            // before a producer could see the announcement is not left waiting
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool queued = false;
+            for (const std::unique_ptr<LogRing>& ring : rings) {
+                queued = queued || !ring->queue.Empty();
+            }
+            if (queued || dropped.load(std::memory_order_relaxed) != reportedDrops) {
+                sleeping.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            wake.wait(lock, [&] { return !sleeping.load(std::memory_order_relaxed); });
+        }
+        running.store(false, std::memory_order_release);
+    }
+
+    static void FormatRecord(const LogRecord& record, std::string& line) {
+        line.clear();
+        const char* format = record.site->format;
+        size_t offset = 0;
+        int arg = 0;
+        for (const char* c = format; *c; ++c) {
+            if (c[0] != '{' || c[1] != '}') {
+                line.push_back(*c);
+                continue;
+            }
+            ++c;
+            if (arg >= record.argCount) {
+                line += "{}";
+                continue;
+            }
+            const uint8_t* data = record.data + offset;
+            char buffer[32];
+            switch (record.argTypes[arg++]) {
+            case kLogArgSigned: {
+                int64_t value;
+                memcpy(&value, data, sizeof(value));
+                offset += sizeof(value);
+                snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+                line += buffer;
+                break;
+            }
+            case kLogArgUnsigned: {
+                uint64_t value;
+                memcpy(&value, data, sizeof(value));
+                offset += sizeof(value);
+                snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+                line += buffer;
+                break;
+            }
+            case kLogArgDouble: {
+                double value;
+                memcpy(&value, data, sizeof(value));
+                offset += sizeof(value);
+                snprintf(buffer, sizeof(buffer), "%g", value);
+                line += buffer;
+                break;
+            }
+            case kLogArgPointer: {
+                uint64_t value;
+                memcpy(&value, data, sizeof(value));
+                offset += sizeof(value);
+                snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(value));
+                line += buffer;
+                break;
+            }
+            case kLogArgString: {
+                size_t length = data[0];
+                line.append(reinterpret_cast<const char*>(data + 1), length);
+                offset += 1 + length;
+                break;
+            }
+            default:
+                line += "...";
+                break;
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable flushDone;
+    // Signalled when a record, flush or stop arrives while the worker waits with `sleeping` set
+    std::condition_variable wake;
+    std::atomic<bool> sleeping{ false };
+    std::vector<std::unique_ptr<LogRing>> rings;
+    std::thread worker;
+    std::atomic<bool> running{ false };
+    bool stopping = false;
+    uint64_t flushRequested = 0;
+    uint64_t flushCompleted = 0;
+};
+
+static Logger& GetLogger() {
+    static Logger logger;
+    return logger;
+}
+
+// Function to replace the output of the logging thread
+void SetLogSink(LogSinkFunc sink) {
+    GetLogger().sink.store(sink ? sink : DefaultLogSink);
+}
+
+// The calling thread's ring, handed back to the logger when the thread exits. Thread storage is
+// destroyed before static storage, so the logger outlives every lease.
+struct LogRingLease {
+    ~LogRingLease() {
+        if (ring) {
+            GetLogger().ReleaseThread(ring);
+        }
+    }
+
+    LogRing* ring = nullptr;
+};
+
+// Function to push a record onto the calling thread's ring, starting the logging thread on first use
+void SubmitLogRecord(const LogRecord& record) {
+    static thread_local LogRingLease lease;
+    Logger& logger = GetLogger();
+    if (!lease.ring) {
+        lease.ring = logger.RegisterThread();
+    } else if (!logger.IsRunning()) {
+        logger.EnsureRunning();
+    }
+    if (!lease.ring->queue.TryPush(record)) {
+        logger.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    logger.Wake();
+}
+
+// Function to wait until every record submitted before the call has been written
+void FlushLog() {
+    GetLogger().Flush();
+}
+
+// Function to flush and stop the logging thread; later records start it again
+void StopLog() {
+    GetLogger().Stop();
+}
+
+// Records dropped because a thread's ring was full
+uint64_t DroppedLogRecords() {
+    return GetLogger().dropped.load(std::memory_order_relaxed);
+}
+
+// Function to read the clock used for log timestamps, in microseconds
+int64_t LogClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,192 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Asynchronous logging. A log statement copies a pointer to its static call site (level and
+// format string) and its raw arguments into a fixed-size record, and pushes the record onto
+// a lock-free ring owned by the calling thread. A background thread formats the records and
+// writes them out, so the caller never formats, allocates or waits on the console. The background
+// thread sleeps while every ring is empty; the first record after that takes a mutex to wake it.
+//
+//   OVERLAY_LOG_INFO("Captured {} frames in {} ms", frames, elapsedMs);
+//
+// Each "{}" in the format is replaced by the next argument. Integers, enums, floating point
+// values, pointers, C strings and std::string are supported; strings are copied and truncated
+// to the space left in the record. When a ring is full the record is dropped and counted.
+
+// Severity of a log record
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3
+};
+
+// Statements below this level are removed by the preprocessor, arguments included.
+// Defaults to Info when NDEBUG is defined and Debug otherwise.
+#ifndef OVERLAY_LOG_LEVEL
+#if defined(NDEBUG)
+#define OVERLAY_LOG_LEVEL 1
+#else
+#define OVERLAY_LOG_LEVEL 0
+#endif
+#endif
+
+// Static description of a log statement; records refer to it instead of copying the format
+struct LogSite {
+    LogLevel level;
+    const char* format;
+};
+
+// Fixed-size record as stored in the per-thread rings
+struct LogRecord {
+    static const int kMaxArgs = 8;
+    static const int kDataBytes = 96;
+
+    const LogSite* site;
+    int64_t timestampUs;
+    uint8_t argCount;
+    uint8_t dataBytes;
+    uint8_t argTypes[kMaxArgs];
+    uint8_t data[kDataBytes];
+};
+
+// Type tags of the encoded arguments
+enum LogArgType : uint8_t {
+    kLogArgSigned,
+    kLogArgUnsigned,
+    kLogArgDouble,
+    kLogArgPointer,
+    kLogArgString,
+    kLogArgTruncated
+};
+
+// Receives formatted lines on the logging thread; the line has no trailing newline
+typedef void (*LogSinkFunc)(LogLevel level, const char* line, size_t length);
+
+// Function to replace the output of the logging thread (default: Debug and Info to stdout,
+// Warning and Error to stderr, each line prefixed with its level as in "Info: ...")
+void SetLogSink(LogSinkFunc sink);
+
+// Function to push a record onto the calling thread's ring, starting the logging thread on first use
+void SubmitLogRecord(const LogRecord& record);
+
+// Function to wait until every record submitted before the call has been written
+void FlushLog();
+
+// Function to flush and stop the logging thread; later records start it again
+void StopLog();
+
+// Records dropped because a thread's ring was full
+uint64_t DroppedLogRecords();
+
+// Function to read the clock used for log timestamps, in microseconds
+int64_t LogClockUs();
+
+// Argument encoding, inlined into each log statement
+inline void AppendLogArg(LogRecord& record, uint8_t type, const void* bytes, size_t size) {
+    if (record.argCount >= LogRecord::kMaxArgs) {
+        return;
+    }
+    if (record.dataBytes + size > LogRecord::kDataBytes) {
+        record.argTypes[record.argCount++] = kLogArgTruncated;
+        return;
+    }
+    memcpy(record.data + record.dataBytes, bytes, size);
+    record.dataBytes = static_cast<uint8_t>(record.dataBytes + size);
+    record.argTypes[record.argCount++] = type;
+}
+
+inline void AppendLogString(LogRecord& record, const char* text, size_t length) {
+    if (record.argCount >= LogRecord::kMaxArgs) {
+        return;
+    }
+    // Strings are stored as a length byte followed by the characters that fit
+    size_t space = LogRecord::kDataBytes - record.dataBytes;
+    if (space < 1) {
+        record.argTypes[record.argCount++] = kLogArgTruncated;
+        return;
+    }
+    size_t stored = length < space - 1 ? length : space - 1;
+    stored = stored < 255 ? stored : 255;
+    record.data[record.dataBytes] = static_cast<uint8_t>(stored);
+    memcpy(record.data + record.dataBytes + 1, text, stored);
+    record.dataBytes = static_cast<uint8_t>(record.dataBytes + 1 + stored);
+    record.argTypes[record.argCount++] = kLogArgString;
+}
+
+template <typename T>
+inline void EncodeLogArg(LogRecord& record, const T& value) {
+    if constexpr (std::is_enum<T>::value) {
+        int64_t encoded = static_cast<int64_t>(value);
+        AppendLogArg(record, kLogArgSigned, &encoded, sizeof(encoded));
+    } else if constexpr (std::is_floating_point<T>::value) {
+        double encoded = static_cast<double>(value);
+        AppendLogArg(record, kLogArgDouble, &encoded, sizeof(encoded));
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        int64_t encoded = static_cast<int64_t>(value);
+        AppendLogArg(record, kLogArgSigned, &encoded, sizeof(encoded));
+    } else if constexpr (std::is_integral<T>::value) {
+        uint64_t encoded = static_cast<uint64_t>(value);
+        AppendLogArg(record, kLogArgUnsigned, &encoded, sizeof(encoded));
+    } else if constexpr (std::is_same<T, std::string>::value) {
+        AppendLogString(record, value.data(), value.size());
+    } else if constexpr (std::is_array<T>::value) {
+        AppendLogString(record, value, strlen(value));
+    } else if constexpr (std::is_convertible<T, const char*>::value) {
+        const char* text = value ? static_cast<const char*>(value) : "(null)";
+        AppendLogString(record, text, strlen(text));
+    } else {
+        static_assert(std::is_pointer<T>::value, "Unsupported log argument type");
+        uint64_t encoded = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+        AppendLogArg(record, kLogArgPointer, &encoded, sizeof(encoded));
+    }
+}
+
+template <typename... Args>
+inline void WriteLog(const LogSite& site, const Args&... args) {
+    LogRecord record;
+    record.site = &site;
+    record.timestampUs = LogClockUs();
+    record.argCount = 0;
+    record.dataBytes = 0;
+    (EncodeLogArg(record, args), ...);
+    SubmitLogRecord(record);
+}
+
+#define OVERLAY_LOG_AT(logLevel, format, ...)                               \
+    do {                                                                    \
+        static const LogSite overlayLogSite = { logLevel, format };         \
+        WriteLog(overlayLogSite, ##__VA_ARGS__);                            \
+    } while (0)
+
+#if OVERLAY_LOG_LEVEL <= 0
+#define OVERLAY_LOG_DEBUG(format, ...) OVERLAY_LOG_AT(LogLevel::Debug, format, ##__VA_ARGS__)
+#else
+#define OVERLAY_LOG_DEBUG(format, ...) ((void)0)
+#endif
+
+#if OVERLAY_LOG_LEVEL <= 1
+#define OVERLAY_LOG_INFO(format, ...) OVERLAY_LOG_AT(LogLevel::Info, format, ##__VA_ARGS__)
+#else
+#define OVERLAY_LOG_INFO(format, ...) ((void)0)
+#endif
+
+#if OVERLAY_LOG_LEVEL <= 2
+#define OVERLAY_LOG_WARNING(format, ...) OVERLAY_LOG_AT(LogLevel::Warning, format, ##__VA_ARGS__)
+#else
+#define OVERLAY_LOG_WARNING(format, ...) ((void)0)
+#endif
+
+#if OVERLAY_LOG_LEVEL <= 3
+#define OVERLAY_LOG_ERROR(format, ...) OVERLAY_LOG_AT(LogLevel::Error, format, ##__VA_ARGS__)
+#else
+#define OVERLAY_LOG_ERROR(format, ...) ((void)0)
+#endif
+
+#endif // ASYNC_LOG_H
@@ -0,0 +1,44 @@
+#include "background_model.h"
+#include "background_model_kernels.h"
+
+// Portable reference kernel
+template <class Traits>
+size_t BackgroundRowScalar(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask) {
+    ClearMaskRow(mask, width);
+    BackgroundRowTail<Traits>(current, background, 0, width, threshold, shift, mask);
+    return CountMaskRow(mask, width);
+}
+
+// Function to get a kernel's row function instantiated for one pixel format
+template <class Traits>
+static BackgroundRowFunc GetBackgroundRowFuncFor(DiffKernel kernel) {
+    if (!IsDiffKernelSupported(kernel)) {
+        return BackgroundRowScalar<Traits>;
+    }
+    switch (kernel) {
+#if defined(OVERLAY_ARCH_X86)
+    case DiffKernel::SSE2:
+        return BackgroundRowSSE2<Traits>;
+    case DiffKernel::AVX2:
+        return BackgroundRowAVX2<Traits>;
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    case DiffKernel::NEON:
+        return BackgroundRowNEON<Traits>;
+#endif
+    default:
+        return BackgroundRowScalar<Traits>;
+    }
+}
+
+// Function to get the row function for a kernel and pixel format (falls back to scalar if unsupported)
+BackgroundRowFunc GetBackgroundRowFunc(DiffKernel kernel, PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGB10A2:
+        return GetBackgroundRowFuncFor<Rgb10A2Traits>(kernel);
+    case PixelFormat::RGBA16F:
+        return GetBackgroundRowFuncFor<Rgba16FTraits>(kernel);
+    default:
+        return GetBackgroundRowFuncFor<Bgra8Traits>(kernel);
+    }
+}
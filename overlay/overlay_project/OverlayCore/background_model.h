@@ -0,0 +1,28 @@
+#ifndef BACKGROUND_MODEL_H
+#define BACKGROUND_MODEL_H
+
+#include "frame_diff.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-pixel background model: an exponential running average of each pixel's luma, stored as
+// signed 16-bit fixed point with 7 fractional bits (luma * 128, BT.601 weights 15/75/38 of 128).
+// A pixel counts as moving when its luma is more than a threshold away from the average, so
+// small re-rendering and compression noise does not register. The model replaces the copy of
+// the previous frame: 2 bytes per pixel instead of 4.
+
+// Fixed-point scale of the stored averages and thresholds
+static const int kBackgroundOne = 128;
+
+// Compares `width` pixels with their running averages in `background`, writes one bit per
+// pixel whose luma differs by more than `threshold` (in luma * 128 units) into `mask`, then moves
+// each average 1/2^shift of the way towards the new luma. Returns the number of set bits. Every
+// mask word covering the row is written, with bits past `width` cleared. shift 0 resets the
+// averages to the row. 10-bit and half-float pixels are converted to 8-bit BGRA in registers first.
+typedef size_t (*BackgroundRowFunc)(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+
+// Function to get the row function for a kernel and pixel format (falls back to scalar if unsupported)
+BackgroundRowFunc GetBackgroundRowFunc(DiffKernel kernel, PixelFormat format = PixelFormat::BGRA8);
+
+#endif // BACKGROUND_MODEL_H
@@ -0,0 +1,56 @@
+#include "background_model_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include "pixel_format_sse2.h"
+
+#include <immintrin.h>
+
+// Function to load eight pixels as 32 bytes of BGRA: one load for BGRA frames, two converted
+// halves otherwise
+template <class Traits>
+static inline __m256i LoadBgra8x8(const uint8_t* pixels) {
+    if (Traits::kFormat == PixelFormat::BGRA8) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+    }
+    __m128i low = LoadBgra8x4<Traits>(pixels);
+    __m128i high = LoadBgra8x4<Traits>(pixels + 4 * Traits::kBytesPerPixel);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+// 16 pixels per step. PMADDUBSW turns each pixel into B*15 + G*75 and R*38 + A*0, PHADDW adds
+// the pairs of two registers within each 128-bit lane, and one cross-lane permute restores the
+// pixel order.
+template <class Traits>
+size_t BackgroundRowAVX2(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask) {
+    ClearMaskRow(mask, width);
+    const __m256i weights = _mm256_setr_epi8(15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0,
+                                             15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0, 15, 75, 38, 0);
+    const __m256i limit = _mm256_set1_epi16(static_cast<int16_t>(threshold));
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* pixels = current + x * Traits::kBytesPerPixel;
+        __m256i pairs0 = _mm256_maddubs_epi16(LoadBgra8x8<Traits>(pixels), weights);
+        __m256i pairs1 = _mm256_maddubs_epi16(LoadBgra8x8<Traits>(pixels + 8 * Traits::kBytesPerPixel), weights);
+        __m256i luma = _mm256_permute4x64_epi64(_mm256_hadd_epi16(pairs0, pairs1), _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m256i average = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(background + x));
+        __m256i delta = _mm256_sub_epi16(luma, average);
+        __m256i moving = _mm256_cmpgt_epi16(_mm256_abs_epi16(delta), limit);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(background + x), _mm256_add_epi16(average, _mm256_sra_epi16(delta, shiftCount)));
+
+        __m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(moving), _mm256_extracti128_si256(moving, 1));
+        uint64_t bits = static_cast<unsigned>(_mm_movemask_epi8(packed));
+        if (bits != 0) {
+            mask[x >> 6] |= bits << (x & 63);
+        }
+    }
+    _mm256_zeroupper();
+    BackgroundRowTail<Traits>(current, background, x, width, threshold, shift, mask);
+    return CountMaskRow(mask, width);
+}
+
+template size_t BackgroundRowAVX2<Bgra8Traits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+template size_t BackgroundRowAVX2<Rgb10A2Traits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+template size_t BackgroundRowAVX2<Rgba16FTraits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+#endif
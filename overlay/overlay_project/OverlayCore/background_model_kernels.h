@@ -0,0 +1,40 @@
+#ifndef BACKGROUND_MODEL_KERNELS_H
+#define BACKGROUND_MODEL_KERNELS_H
+
+// Internal: per-ISA background model kernels behind BackgroundRowFunc, each built with its own flags
+// and instantiated for every pixel format's traits.
+
+#include "background_model.h"
+#include "cpu_features.h"
+#include "frame_diff_kernels.h"
+
+template <class Traits>
+size_t BackgroundRowScalar(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+#if defined(OVERLAY_ARCH_X86)
+template <class Traits>
+size_t BackgroundRowSSE2(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+template <class Traits>
+size_t BackgroundRowAVX2(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+template <class Traits>
+size_t BackgroundRowNEON(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+#endif
+
+// Function to update the pixels [x, width) one at a time, shared by the SIMD kernels for row tails
+template <class Traits>
+inline void BackgroundRowTail(const uint8_t* current, int16_t* background, int x, int width, int threshold, int shift, uint64_t* mask) {
+    for (; x < width; ++x) {
+        uint8_t pixel[4];
+        Traits::ToBgra8(current + x * Traits::kBytesPerPixel, pixel);
+        int luma = pixel[0] * 15 + pixel[1] * 75 + pixel[2] * 38;
+        int delta = luma - background[x];
+        if (delta > threshold || -delta > threshold) {
+            mask[x >> 6] |= 1ull << (x & 63);
+        }
+        // Arithmetic shift, matching the SIMD kernels' rounding towards minus infinity
+        background[x] = static_cast<int16_t>(background[x] + (delta >> shift));
+    }
+}
+
+#endif // BACKGROUND_MODEL_KERNELS_H
@@ -0,0 +1,65 @@
+#include "background_model_kernels.h"
+
+#if defined(OVERLAY_ARCH_NEON)
+#include "pixel_format_neon.h"
+
+// Function to load eight pixels as planar B, G, R and A bytes: VLD4 for BGRA frames, otherwise
+// two converted groups of four deinterleaved with two rounds of unzips
+template <class Traits>
+static inline uint8x8x4_t LoadBgra8Planes(const uint8_t* pixels) {
+    if (Traits::kFormat == PixelFormat::BGRA8) {
+        return vld4_u8(pixels);
+    }
+    uint8x16_t low = LoadBgra8x4<Traits>(pixels);
+    uint8x16_t high = LoadBgra8x4<Traits>(pixels + 4 * Traits::kBytesPerPixel);
+    uint8x16_t blueRed = vuzp1q_u8(low, high);
+    uint8x16_t greenAlpha = vuzp2q_u8(low, high);
+    uint8x8x4_t planes;
+    planes.val[0] = vget_low_u8(vuzp1q_u8(blueRed, blueRed));
+    planes.val[1] = vget_low_u8(vuzp1q_u8(greenAlpha, greenAlpha));
+    planes.val[2] = vget_low_u8(vuzp2q_u8(blueRed, blueRed));
+    planes.val[3] = vget_low_u8(vuzp2q_u8(greenAlpha, greenAlpha));
+    return planes;
+}
+
+// Updates eight averages against eight BGRA pixels in planar form, returns the moving
+// lanes as 0xFFFF
+static inline uint16x8_t Update8(uint8x8x4_t pixels, int16_t* background, int16x8_t threshold, int16x8_t shift) {
+    uint16x8_t luma = vmull_u8(pixels.val[0], vdup_n_u8(15));
+    luma = vmlal_u8(luma, pixels.val[1], vdup_n_u8(75));
+    luma = vmlal_u8(luma, pixels.val[2], vdup_n_u8(38));
+    int16x8_t average = vld1q_s16(background);
+    int16x8_t delta = vsubq_s16(vreinterpretq_s16_u16(luma), average);
+    vst1q_s16(background, vaddq_s16(average, vshlq_s16(delta, shift)));
+    return vcgtq_s16(vabsq_s16(delta), threshold);
+}
+
+// 16 pixels per step
+template <class Traits>
+size_t BackgroundRowNEON(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask) {
+    static const uint8_t kBitWeights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    ClearMaskRow(mask, width);
+    const int16x8_t limit = vdupq_n_s16(static_cast<int16_t>(threshold));
+    // VSHL with a negative count shifts right arithmetically
+    const int16x8_t shiftCount = vdupq_n_s16(static_cast<int16_t>(-shift));
+    const uint8x16_t bitWeights = vld1q_u8(kBitWeights);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* pixels = current + x * Traits::kBytesPerPixel;
+        uint16x8_t moving0 = Update8(LoadBgra8Planes<Traits>(pixels), background + x, limit, shiftCount);
+        uint16x8_t moving1 = Update8(LoadBgra8Planes<Traits>(pixels + 8 * Traits::kBytesPerPixel), background + x + 8, limit, shiftCount);
+        // Narrow to one byte per pixel and fold each half into a byte of the bitmask
+        uint8x16_t moving = vandq_u8(vcombine_u8(vmovn_u16(moving0), vmovn_u16(moving1)), bitWeights);
+        uint64_t bits = vaddv_u8(vget_low_u8(moving)) | (static_cast<uint64_t>(vaddv_u8(vget_high_u8(moving))) << 8);
+        if (bits != 0) {
+            mask[x >> 6] |= bits << (x & 63);
+        }
+    }
+    BackgroundRowTail<Traits>(current, background, x, width, threshold, shift, mask);
+    return CountMaskRow(mask, width);
+}
+
+template size_t BackgroundRowNEON<Bgra8Traits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+template size_t BackgroundRowNEON<Rgb10A2Traits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+template size_t BackgroundRowNEON<Rgba16FTraits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+#endif
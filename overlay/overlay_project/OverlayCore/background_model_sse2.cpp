@@ -0,0 +1,53 @@
+#include "background_model_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include "pixel_format_sse2.h"
+
+// Luma * 128 of four BGRA pixels as 32-bit lanes: PMADDWD yields B*15 + G*75 and R*38 + A*0
+// per pixel, and the two halves are regrouped with a float shuffle and added
+static inline __m128i Luma4(__m128i pixels, __m128i weights) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128 lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights));
+    __m128 hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights));
+    __m128i even = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i odd = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm_add_epi32(even, odd);
+}
+
+// Updates eight averages against eight luma values, returns the moving lanes as 0xFFFF
+static inline __m128i Update8(__m128i luma, int16_t* background, __m128i threshold, __m128i shift) {
+    __m128i average = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background));
+    __m128i delta = _mm_sub_epi16(luma, average);
+    __m128i distance = _mm_max_epi16(delta, _mm_sub_epi16(_mm_setzero_si128(), delta));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(background), _mm_add_epi16(average, _mm_sra_epi16(delta, shift)));
+    return _mm_cmpgt_epi16(distance, threshold);
+}
+
+// 16 pixels per step; luma values stay below 2^15 so they pack into signed 16-bit lanes
+template <class Traits>
+size_t BackgroundRowSSE2(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask) {
+    ClearMaskRow(mask, width);
+    const __m128i weights = _mm_setr_epi16(15, 75, 38, 0, 15, 75, 38, 0);
+    const __m128i limit = _mm_set1_epi16(static_cast<int16_t>(threshold));
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+    const int quad = 4 * Traits::kBytesPerPixel;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* pixels = current + x * Traits::kBytesPerPixel;
+        __m128i luma0 = _mm_packs_epi32(Luma4(LoadBgra8x4<Traits>(pixels), weights), Luma4(LoadBgra8x4<Traits>(pixels + quad), weights));
+        __m128i luma1 = _mm_packs_epi32(Luma4(LoadBgra8x4<Traits>(pixels + 2 * quad), weights), Luma4(LoadBgra8x4<Traits>(pixels + 3 * quad), weights));
+        __m128i moving0 = Update8(luma0, background + x, limit, shiftCount);
+        __m128i moving1 = Update8(luma1, background + x + 8, limit, shiftCount);
+        uint64_t bits = static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(moving0, moving1)));
+        if (bits != 0) {
+            mask[x >> 6] |= bits << (x & 63);
+        }
+    }
+    BackgroundRowTail<Traits>(current, background, x, width, threshold, shift, mask);
+    return CountMaskRow(mask, width);
+}
+
+template size_t BackgroundRowSSE2<Bgra8Traits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+template size_t BackgroundRowSSE2<Rgb10A2Traits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+template size_t BackgroundRowSSE2<Rgba16FTraits>(const uint8_t* current, int16_t* background, int width, int threshold, int shift, uint64_t* mask);
+#endif
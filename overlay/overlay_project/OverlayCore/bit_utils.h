@@ -0,0 +1,47 @@
+#ifndef BIT_UTILS_H
+#define BIT_UTILS_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Function to count set bits in a 64-bit word
+inline int PopCount64(uint64_t value) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt(static_cast<unsigned int>(value)) + __popcnt(static_cast<unsigned int>(value >> 32)));
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+// Function to get the index of the lowest set bit (value must be non-zero)
+inline int LowestBit64(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(value))) {
+        return static_cast<int>(index);
+    }
+    _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+    return static_cast<int>(index) + 32;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// Function to get the index of the highest set bit (value must be non-zero)
+inline int HighestBit64(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+        return static_cast<int>(index) + 32;
+    }
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+#endif // BIT_UTILS_H
@@ -0,0 +1,45 @@
+#ifndef BOX_H
+#define BOX_H
+
+#include <algorithm>
+#include <cstdint>
+
+// Axis-aligned pixel rectangle with the same layout and exclusive right/bottom edges as a Win32 RECT
+struct Box {
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+
+    int Width() const { return right - left; }
+    int Height() const { return bottom - top; }
+    int64_t Area() const { return static_cast<int64_t>(Width()) * Height(); }
+    bool Empty() const { return right <= left || bottom <= top; }
+};
+
+// Function to get the smallest box containing both boxes
+inline Box UnionBox(const Box& a, const Box& b) {
+    Box result;
+    result.left = std::min(a.left, b.left);
+    result.top = std::min(a.top, b.top);
+    result.right = std::max(a.right, b.right);
+    result.bottom = std::max(a.bottom, b.bottom);
+    return result;
+}
+
+// Function to get the part of `a` inside `b`, empty when they do not overlap
+inline Box IntersectBox(const Box& a, const Box& b) {
+    Box result;
+    result.left = std::max(a.left, b.left);
+    result.top = std::max(a.top, b.top);
+    result.right = std::min(a.right, b.right);
+    result.bottom = std::min(a.bottom, b.bottom);
+    return result;
+}
+
+// Function to check whether two boxes overlap
+inline bool BoxesIntersect(const Box& a, const Box& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+#endif // BOX_H
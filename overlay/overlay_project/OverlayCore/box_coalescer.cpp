@@ -0,0 +1,174 @@
+#include "box_coalescer.h"
+
+#include <algorithm>
+
+BoxCoalescer::BoxCoalescer(const CoalesceConfig& coalesceConfig)
+    : config(coalesceConfig) {
+    config.gap = std::max(config.gap, 0);
+    config.maxBoxes = std::max(config.maxBoxes, 0);
+    config.maxPasses = std::max(config.maxPasses, 1);
+}
+
+// Function to size the scratch for up to `count` boxes
+void BoxCoalescer::Reserve(size_t count) {
+    if (sorted.capacity() >= count) {
+        return;
+    }
+    sorted.reserve(count);
+    active.reserve(count);
+    order.reserve(count);
+    nodes.reserve(count);
+    previous.reserve(count);
+    next.reserve(count);
+    versions.reserve(count);
+    // The first candidates plus two per merge, and fewer merges than boxes
+    heap.reserve(count * 3);
+}
+
+// Function to merge every box that comes within `gap` of a cluster on the sweep line,
+// returns true if any boxes were merged
+bool BoxCoalescer::MergePass(std::vector<Box>& boxes) {
+    const int gap = config.gap;
+    sorted.assign(boxes.begin(), boxes.end());
+    std::sort(sorted.begin(), sorted.end(), [](const Box& a, const Box& b) { return a.left < b.left; });
+    boxes.clear();
+    active.clear();
+
+    bool merged = false;
+    for (const Box& box : sorted) {
+        Box cluster = box;
+        bool grew = true;
+        while (grew) {
+            grew = false;
+            // Clusters with bottom + gap >= cluster.top, in order, until one starts below the cluster
+            auto first = std::lower_bound(active.begin(), active.end(), cluster.top - gap,
+                                          [](const Box& a, int bottom) { return a.bottom < bottom; });
+            auto it = first;
+            while (it != active.end() && it->top <= cluster.bottom + gap) {
+                const Box& other = *it;
+                if (other.right + gap < cluster.left) {
+                    // Behind the sweep line, so no later box can reach it either
+                    boxes.push_back(other);
+                } else {
+                    // Every active cluster starts at or before the sweep line, so it reaches this one
+                    Box joined = UnionBox(cluster, other);
+                    grew = grew || joined.top != cluster.top || joined.bottom != cluster.bottom;
+                    cluster = joined;
+                    merged = true;
+                }
+                ++it;
+            }
+            // Every cluster visited was either emitted or absorbed
+            active.erase(first, it);
+        }
+        active.insert(std::lower_bound(active.begin(), active.end(), cluster.bottom,
+                                       [](const Box& a, int bottom) { return a.bottom < bottom; }),
+                      cluster);
+    }
+    boxes.insert(boxes.end(), active.begin(), active.end());
+    return merged;
+}
+
+// Function to spread the low 16 bits of a value to the even bits
+static uint64_t SpreadBits(uint32_t value) {
+    uint64_t x = value & 0xFFFF;
+    x = (x | (x << 8)) & 0x00FF00FFull;
+    x = (x | (x << 4)) & 0x0F0F0F0Full;
+    x = (x | (x << 2)) & 0x33333333ull;
+    x = (x | (x << 1)) & 0x55555555ull;
+    return x;
+}
+
+// Heap order: cheapest merge on top, ties broken by position so results are deterministic
+bool BoxCoalescer::CostlierThan(const MergeCandidate& a, const MergeCandidate& b) {
+    if (a.cost != b.cost) {
+        return a.cost > b.cost;
+    }
+    return a.first != b.first ? a.first > b.first : a.second > b.second;
+}
+
+void BoxCoalescer::PushCandidate(int first, int second) {
+    if (first < 0 || second < 0) {
+        return;
+    }
+    const Box& a = nodes[first];
+    const Box& b = nodes[second];
+    int64_t cost = UnionBox(a, b).Area() - a.Area() - b.Area();
+    heap.push_back({ cost, first, second, versions[first], versions[second] });
+    std::push_heap(heap.begin(), heap.end(), CostlierThan);
+}
+
+// Function to merge neighbouring boxes along a Z-order curve, cheapest first, until at most
+// maxBoxes remain
+void BoxCoalescer::MergeToBudget(std::vector<Box>& boxes) {
+    size_t count = boxes.size();
+    // Sort key: Z-order of the centre in the high bits, original index in the low bits
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t x = static_cast<uint32_t>(std::max(0, (boxes[i].left + boxes[i].right) / 2));
+        uint32_t y = static_cast<uint32_t>(std::max(0, (boxes[i].top + boxes[i].bottom) / 2));
+        order[i] = (SpreadBits(x) | (SpreadBits(y) << 1)) << 32 | i;
+    }
+    std::sort(order.begin(), order.end());
+
+    nodes.resize(count);
+    previous.resize(count);
+    next.resize(count);
+    versions.assign(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        nodes[i] = boxes[static_cast<uint32_t>(order[i])];
+        previous[i] = static_cast<int>(i) - 1;
+        next[i] = i + 1 < count ? static_cast<int>(i) + 1 : -1;
+    }
+    heap.clear();
+    for (size_t i = 0; i + 1 < count; ++i) {
+        PushCandidate(static_cast<int>(i), static_cast<int>(i) + 1);
+    }
+
+    size_t target = static_cast<size_t>(config.maxBoxes);
+    while (count > target && !heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), CostlierThan);
+        MergeCandidate candidate = heap.back();
+        heap.pop_back();
+        if (versions[candidate.first] != candidate.firstVersion || versions[candidate.second] != candidate.secondVersion) {
+            continue;
+        }
+        // Fold the second box into the first and unlink it; both slots change version
+        int first = candidate.first;
+        int second = candidate.second;
+        nodes[first] = UnionBox(nodes[first], nodes[second]);
+        versions[first]++;
+        versions[second]++;
+        next[first] = next[second];
+        if (next[second] >= 0) {
+            previous[next[second]] = first;
+        }
+        previous[second] = -2;
+        --count;
+        stats.budgetMerges++;
+        PushCandidate(previous[first], first);
+        PushCandidate(first, next[first]);
+    }
+
+    boxes.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (previous[i] != -2) {
+            boxes.push_back(nodes[i]);
+        }
+    }
+}
+
+void BoxCoalescer::Coalesce(std::vector<Box>& boxes) {
+    stats = CoalesceStats();
+    stats.input = boxes.size();
+    bool merged = true;
+    while (merged && stats.passes < static_cast<size_t>(config.maxPasses)) {
+        stats.passes++;
+        merged = MergePass(boxes);
+    }
+    stats.capped = merged;
+    if (config.maxBoxes > 0 && boxes.size() > static_cast<size_t>(config.maxBoxes)) {
+        MergeToBudget(boxes);
+    }
+    stats.output = boxes.size();
+}
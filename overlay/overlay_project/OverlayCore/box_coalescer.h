@@ -0,0 +1,93 @@
+#ifndef BOX_COALESCER_H
+#define BOX_COALESCER_H
+
+#include "box.h"
+
+#include <cstdint>
+#include <vector>
+
+// Settings for BoxCoalescer
+struct CoalesceConfig {
+    // Boxes at most this many pixels apart are merged; 0 merges overlapping and edge-adjacent boxes
+    int gap = 8;
+    // Most boxes kept per frame; beyond it the pairs that add the least area are merged (0 = no limit)
+    int maxBoxes = 256;
+    // Most sweeps per call; when the last one still merged, some boxes may be left within `gap`
+    // of each other and CoalesceStats::capped is set (at least 1)
+    int maxPasses = 8;
+};
+
+// Per-call counters
+struct CoalesceStats {
+    size_t input = 0;
+    size_t output = 0;
+    // Sweeps over the boxes, including the last one that found nothing left to merge
+    size_t passes = 0;
+    // True when the sweeps stopped at maxPasses while still merging
+    bool capped = false;
+    // Pairs merged to meet CoalesceConfig::maxBoxes
+    size_t budgetMerges = 0;
+};
+
+// Merges overlapping and nearby boxes so the overlay draws fewer, larger rectangles.
+//
+// Each pass sweeps the boxes from left to right and keeps the clusters still within `gap` of the
+// sweep line in a vector sorted by their bottom edge. Active clusters never come within `gap` of
+// each other, so their vertical extents are disjoint and the clusters a new box reaches are found
+// with one binary search plus a step per cluster it absorbs. Inserting into the vector moves up to
+// A clusters, where A, the active count, is at most frameHeight / (gap + 1), so a pass costs
+// O(n log n + n * A) rather than a tree's O(n log n); in practice A is small and the vector, unlike
+// a tree, reuses its storage every frame. Growing a cluster can make it reach a box that already
+// left the sweep, so passes repeat on the output until one merges nothing. After the first pass
+// they usually merge only a few boxes each, but a chain of boxes can take one pass per link, so
+// passes stop at maxPasses: O(maxPasses * n * (log n + A)) per call in the worst case.
+//
+// If more than maxBoxes remain, boxes are ordered along a Z-order curve of their centres and
+// neighbouring pairs are merged cheapest first, the cost being the area the union adds, using a
+// heap with lazy invalidation (O(n log n)). The merged boxes may overlap each other.
+class BoxCoalescer {
+public:
+    explicit BoxCoalescer(const CoalesceConfig& config = CoalesceConfig());
+
+    const CoalesceConfig& Config() const { return config; }
+
+    // Function to replace `boxes` with the coalesced set
+    void Coalesce(std::vector<Box>& boxes);
+
+    // Function to size the scratch for up to `count` boxes, so later calls with no more boxes than
+    // that never allocate. The detector's tile count bounds its boxes.
+    void Reserve(size_t count);
+
+    const CoalesceStats& Stats() const { return stats; }
+
+private:
+    struct MergeCandidate {
+        int64_t cost;
+        int first;
+        int second;
+        uint32_t firstVersion;
+        uint32_t secondVersion;
+    };
+
+    static bool CostlierThan(const MergeCandidate& a, const MergeCandidate& b);
+    bool MergePass(std::vector<Box>& boxes);
+    void MergeToBudget(std::vector<Box>& boxes);
+    void PushCandidate(int first, int second);
+
+    CoalesceConfig config;
+    CoalesceStats stats;
+
+    // Sweep state: active clusters sorted by bottom edge
+    std::vector<Box> sorted;
+    std::vector<Box> active;
+
+    // Budget state: boxes linked in Z-order with a version per slot to spot stale heap entries
+    std::vector<uint64_t> order;
+    std::vector<Box> nodes;
+    std::vector<int> previous;
+    std::vector<int> next;
+    std::vector<uint32_t> versions;
+    std::vector<MergeCandidate> heap;
+};
+
+#endif // BOX_COALESCER_H
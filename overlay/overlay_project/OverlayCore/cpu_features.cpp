@@ -0,0 +1,76 @@
+#include "cpu_features.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__linux__) && defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#if defined(OVERLAY_ARCH_X86)
+static void Cpuid(int leaf, int subleaf, int regs[4]) {
+#if defined(_MSC_VER)
+    __cpuidex(regs, leaf, subleaf);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    regs[0] = static_cast<int>(a);
+    regs[1] = static_cast<int>(b);
+    regs[2] = static_cast<int>(c);
+    regs[3] = static_cast<int>(d);
+#endif
+}
+
+static unsigned long long ReadXcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+static CpuFeatures QueryCpuFeatures() {
+    CpuFeatures features;
+#if defined(OVERLAY_ARCH_X86)
+    int regs[4];
+    Cpuid(0, 0, regs);
+    int maxLeaf = regs[0];
+    if (maxLeaf >= 1) {
+        Cpuid(1, 0, regs);
+        features.sse2 = (regs[3] & (1 << 26)) != 0;
+        features.sse42 = (regs[2] & (1 << 20)) != 0;
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+        bool avx = (regs[2] & (1 << 28)) != 0;
+        // AVX state must be enabled by the OS before AVX2 can be used
+        bool ymmEnabled = osxsave && avx && (ReadXcr0() & 0x6) == 0x6;
+        if (maxLeaf >= 7 && ymmEnabled) {
+            Cpuid(7, 0, regs);
+            features.avx2 = (regs[1] & (1 << 5)) != 0;
+        }
+    }
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    features.neon = true;
+#if defined(__linux__) && defined(__aarch64__)
+    features.armCrc32 = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#elif defined(_M_ARM64) || defined(__APPLE__)
+    features.armCrc32 = true;
+#endif
+#endif
+    return features;
+}
+
+// Function to query the running CPU once and cache the result
+const CpuFeatures& GetCpuFeatures() {
+    static const CpuFeatures features = QueryCpuFeatures();
+    return features;
+}
@@ -0,0 +1,25 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Target architecture detection shared by the SIMD kernels
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OVERLAY_ARCH_X86 1
+#endif
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define OVERLAY_ARCH_NEON 1
+#endif
+
+// Instruction set extensions available on the running CPU
+struct CpuFeatures {
+    bool sse2 = false;
+    bool sse42 = false;
+    bool avx2 = false;
+    bool neon = false;
+    bool armCrc32 = false;
+};
+
+// Function to query the running CPU once and cache the result
+const CpuFeatures& GetCpuFeatures();
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,110 @@
+#include "damage_tracker.h"
+
+#include <algorithm>
+#include <tuple>
+
+DamageTracker::DamageTracker(const DamageConfig& damageConfig)
+    : config(damageConfig), coalescer(CoalesceConfig{ std::max(damageConfig.gap, 0), std::max(damageConfig.maxRects, 1) }) {}
+
+// Function to order quads by box, then colour
+bool DamageTracker::QuadLess(const Quad& a, const Quad& b) {
+    return std::tie(a.box.left, a.box.top, a.box.right, a.box.bottom, a.color.r, a.color.g, a.color.b, a.color.a) <
+           std::tie(b.box.left, b.box.top, b.box.right, b.box.bottom, b.color.r, b.color.g, b.color.b, b.color.a);
+}
+
+// Function to compare the frame's batch with the previous frame's and build the repair batch
+DamageKind DamageTracker::Update(const QuadBatch& batch, const QuadColor& clearColor) {
+    const std::vector<Quad>& current = batch.Quads();
+    stats = DamageStats();
+    stats.quads = current.size();
+    dirty.clear();
+    repair.Begin(batch.TargetWidth(), batch.TargetHeight());
+    bool full = !valid || batch.TargetWidth() != width || batch.TargetHeight() != height;
+
+    if (!full) {
+        // Sort both frames' quads, keeping equal quads in drawing order so duplicates pair up in order
+        auto sortQuads = [](const std::vector<Quad>& quads, std::vector<SortedQuad>& sorted) {
+            sorted.resize(quads.size());
+            for (size_t i = 0; i < quads.size(); ++i) {
+                sorted[i] = SortedQuad{ &quads[i], static_cast<int>(i) };
+            }
+            std::sort(sorted.begin(), sorted.end(), [](const SortedQuad& a, const SortedQuad& b) {
+                return QuadLess(*a.quad, *b.quad) || (!QuadLess(*b.quad, *a.quad) && a.index < b.index);
+            });
+        };
+        sortQuads(previous, sortedPrevious);
+        sortQuads(current, sortedCurrent);
+
+        // Merge the sorted lists; quads on only one side are damage
+        matched.assign(current.size(), -1);
+        size_t p = 0, c = 0;
+        while (p < sortedPrevious.size() || c < sortedCurrent.size()) {
+            if (c == sortedCurrent.size() || (p < sortedPrevious.size() && QuadLess(*sortedPrevious[p].quad, *sortedCurrent[c].quad))) {
+                dirty.push_back(sortedPrevious[p++].quad->box);
+            } else if (p == sortedPrevious.size() || QuadLess(*sortedCurrent[c].quad, *sortedPrevious[p].quad)) {
+                dirty.push_back(sortedCurrent[c++].quad->box);
+            } else {
+                matched[sortedCurrent[c++].index] = sortedPrevious[p++].index;
+            }
+        }
+        // Without blending the last quad drawn over a pixel wins, so a matched quad that is now
+        // drawn before one it used to follow may change what shows where they overlap
+        int latest = -1;
+        for (size_t i = 0; i < current.size(); ++i) {
+            if (matched[i] < 0) {
+                continue;
+            }
+            if (matched[i] < latest) {
+                dirty.push_back(current[i].box);
+            }
+            latest = std::max(latest, matched[i]);
+        }
+        stats.changedQuads = dirty.size();
+
+        // Clip to the target and merge into a few rectangles
+        size_t kept = 0;
+        for (const Box& box : dirty) {
+            Box clipped = { std::max(box.left, 0), std::max(box.top, 0), std::min(box.right, batch.TargetWidth()),
+                            std::min(box.bottom, batch.TargetHeight()) };
+            if (!clipped.Empty()) {
+                dirty[kept++] = clipped;
+            }
+        }
+        dirty.resize(kept);
+        coalescer.Coalesce(dirty);
+        for (const Box& box : dirty) {
+            stats.dirtyPixels += box.Area();
+        }
+        int64_t targetPixels = static_cast<int64_t>(batch.TargetWidth()) * batch.TargetHeight();
+        full = stats.dirtyPixels * 100 > targetPixels * config.fullRedrawPercent;
+    }
+
+    previous.assign(current.begin(), current.end());
+    width = batch.TargetWidth();
+    height = batch.TargetHeight();
+    valid = true;
+    if (full) {
+        dirty.assign(1, Box{ 0, 0, width, height });
+        stats.dirtyRects = 1;
+        stats.dirtyPixels = static_cast<int64_t>(width) * height;
+        return DamageKind::Full;
+    }
+    stats.dirtyRects = dirty.size();
+    if (dirty.empty()) {
+        return DamageKind::None;
+    }
+
+    // Each rectangle is cleared and repainted on its own, so rectangles merged to meet the budget
+    // may overlap without harm
+    for (const Box& rect : dirty) {
+        repair.AddQuad(rect, clearColor);
+        for (const Quad& quad : current) {
+            if (BoxesIntersect(quad.box, rect)) {
+                Box clipped = { std::max(quad.box.left, rect.left), std::max(quad.box.top, rect.top), std::min(quad.box.right, rect.right),
+                                std::min(quad.box.bottom, rect.bottom) };
+                repair.AddQuad(clipped, quad.color);
+            }
+        }
+    }
+    return DamageKind::Partial;
+}
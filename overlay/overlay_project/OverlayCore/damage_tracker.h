@@ -0,0 +1,87 @@
+#ifndef DAMAGE_TRACKER_H
+#define DAMAGE_TRACKER_H
+
+#include "box.h"
+#include "box_coalescer.h"
+#include "quad_batch.h"
+
+#include <cstdint>
+#include <vector>
+
+// Settings for DamageTracker
+struct DamageConfig {
+    // Damaged areas at most this many pixels apart are repaired as one rectangle
+    int gap = 16;
+    // Most dirty rectangles per frame; beyond it the cheapest pairs are merged
+    int maxRects = 16;
+    // Above this percentage of the target the whole target is redrawn instead
+    int fullRedrawPercent = 50;
+};
+
+// How a frame has to be drawn
+enum class DamageKind {
+    // Nothing changed; the previous image can stay on screen
+    None,
+    // Draw RepairBatch() and present DirtyRects()
+    Partial,
+    // Clear the target and draw the whole batch
+    Full
+};
+
+// Per-frame counters
+struct DamageStats {
+    size_t quads = 0;
+    // Quads added, removed, changed or reordered since the previous frame
+    size_t changedQuads = 0;
+    size_t dirtyRects = 0;
+    int64_t dirtyPixels = 0;
+};
+
+// Finds what changed between the quads drawn in consecutive frames so only those parts of the
+// render target are redrawn. Quads are matched by box and colour after sorting, O(n log n); the
+// boxes of unmatched quads, and of matched quads whose drawing order changed, are coalesced into
+// a few dirty rectangles. The repair batch clears each rectangle and redraws every quad that
+// reaches into it, clipped to it. Quad edges are whole pixels, so the clipped quads cover exactly
+// the pixels the full quads cover inside the rectangle and the image matches a full redraw.
+class DamageTracker {
+public:
+    explicit DamageTracker(const DamageConfig& config = DamageConfig());
+
+    const DamageConfig& Config() const { return config; }
+
+    // Function to compare the frame's batch with the previous frame's and build the repair batch
+    DamageKind Update(const QuadBatch& batch, const QuadColor& clearColor);
+
+    // Function to make the next frame a full redraw, e.g. after the target was resized or lost
+    void Invalidate() { valid = false; }
+
+    // Rectangles to present after a partial redraw, clipped to the target
+    const std::vector<Box>& DirtyRects() const { return dirty; }
+    const QuadBatch& RepairBatch() const { return repair; }
+    const DamageStats& Stats() const { return stats; }
+
+private:
+    struct SortedQuad {
+        const Quad* quad;
+        int index;
+    };
+
+    static bool QuadLess(const Quad& a, const Quad& b);
+
+    DamageConfig config;
+    BoxCoalescer coalescer;
+    DamageStats stats;
+    bool valid = false;
+    int width = 0;
+    int height = 0;
+
+    std::vector<Quad> previous;
+    std::vector<SortedQuad> sortedPrevious;
+    std::vector<SortedQuad> sortedCurrent;
+    // For each current quad, the index of the previous quad it matched, or -1
+    std::vector<int> matched;
+    std::vector<Box> dirty;
+    QuadBatch repair;
+};
+
+#endif // DAMAGE_TRACKER_H
@@ -0,0 +1,154 @@
+#include "event_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Function to get the slot for a record
+static size_t SlotOffset(const EventRingHeader& header, uint64_t record) {
+    return sizeof(EventRingHeader) + static_cast<size_t>(record % header.slotCount) * header.slotBytes;
+}
+
+// Function to create the shared memory region `name`, returns false if it cannot be created
+bool EventRingWriter::Open(const char* name, const EventRingConfig& config) {
+    Close();
+    int slotCount = std::max(config.slotCount, 2);
+    int maxBoxes = std::max(config.maxBoxes, 0);
+    int maxTracks = std::max(config.maxTracks, 0);
+    size_t slotBytes = sizeof(EventSlotHeader) + maxBoxes * sizeof(EventBox) + maxTracks * sizeof(EventTrack);
+    // Whole cache lines, so the writer never shares a line with a reader's slot
+    slotBytes = (slotBytes + 63) & ~static_cast<size_t>(63);
+    if (!memory.Create(name, sizeof(EventRingHeader) + slotCount * slotBytes)) {
+        return false;
+    }
+    // The region starts zero-filled: nothing published and every slot empty
+    header = reinterpret_cast<EventRingHeader*>(memory.Data());
+    header->version = kEventRingVersion;
+    header->slotCount = static_cast<uint32_t>(slotCount);
+    header->slotBytes = static_cast<uint32_t>(slotBytes);
+    header->maxBoxes = static_cast<uint32_t>(maxBoxes);
+    header->maxTracks = static_cast<uint32_t>(maxTracks);
+    // Readers check the magic first, so it goes in after the rest of the header
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, kEventRingMagic, sizeof(kEventRingMagic));
+    nextRecord = 0;
+    return true;
+}
+
+void EventRingWriter::Close() {
+    memory.Close();
+    header = nullptr;
+    nextRecord = 0;
+}
+
+// Function to publish one frame's boxes and tracks from display output `output` as the next record
+void EventRingWriter::Publish(uint64_t frameIndex, int64_t captureTimeUs, int64_t detectTimeUs, const std::vector<Box>& boxes,
+                              const std::vector<Track>& tracks, uint32_t output) {
+    if (!header) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(publishing);
+    uint64_t recordNumber = nextRecord.load(std::memory_order_relaxed);
+    uint8_t* slot = memory.Data() + SlotOffset(*header, recordNumber);
+    EventSlotHeader* record = reinterpret_cast<EventSlotHeader*>(slot);
+    // Odd while the record is being written; the fence keeps the payload stores after it
+    record->sequence.store(2 * recordNumber + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t boxCount = static_cast<uint32_t>(std::min<size_t>(boxes.size(), header->maxBoxes));
+    uint32_t trackCount = static_cast<uint32_t>(std::min<size_t>(tracks.size(), header->maxTracks));
+    record->frameIndex = frameIndex;
+    record->captureTimeUs = captureTimeUs;
+    record->detectTimeUs = detectTimeUs;
+    record->boxCount = boxCount;
+    record->trackCount = trackCount;
+    record->flags = boxCount < boxes.size() || trackCount < tracks.size() ? kEventFrameTruncated : 0;
+    record->output = output;
+    EventBox* outBoxes = reinterpret_cast<EventBox*>(slot + sizeof(EventSlotHeader));
+    for (uint32_t i = 0; i < boxCount; ++i) {
+        outBoxes[i] = EventBox{ boxes[i].left, boxes[i].top, boxes[i].right, boxes[i].bottom };
+    }
+    EventTrack* outTracks = reinterpret_cast<EventTrack*>(slot + sizeof(EventSlotHeader) + header->maxBoxes * sizeof(EventBox));
+    for (uint32_t i = 0; i < trackCount; ++i) {
+        const Track& track = tracks[i];
+        outTracks[i] = EventTrack{ track.id, static_cast<uint32_t>(track.age),
+                                   EventBox{ track.box.left, track.box.top, track.box.right, track.box.bottom },
+                                   track.velocityX, track.velocityY };
+    }
+
+    record->sequence.store(2 * recordNumber + 2, std::memory_order_release);
+    nextRecord.store(recordNumber + 1, std::memory_order_relaxed);
+    header->published.store(recordNumber + 1, std::memory_order_release);
+}
+
+// Function to map the ring `name` and start after the records already published, returns
+// false if it does not exist or has an unknown layout
+bool EventRingReader::Open(const char* name) {
+    Close();
+    header = nullptr;
+    nextRecord = 0;
+    dropped = 0;
+    if (!memory.Open(name)) {
+        return false;
+    }
+    const EventRingHeader* candidate = reinterpret_cast<const EventRingHeader*>(memory.Data());
+    bool valid = memory.Size() >= sizeof(EventRingHeader) && memcmp(candidate->magic, kEventRingMagic, sizeof(kEventRingMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && candidate->version == kEventRingVersion && candidate->slotCount >= 2 &&
+            candidate->slotBytes >= sizeof(EventSlotHeader) + candidate->maxBoxes * sizeof(EventBox) + candidate->maxTracks * sizeof(EventTrack) &&
+            memory.Size() >= sizeof(EventRingHeader) + static_cast<size_t>(candidate->slotCount) * candidate->slotBytes;
+    if (!valid) {
+        memory.Close();
+        return false;
+    }
+    header = candidate;
+    nextRecord = header->published.load(std::memory_order_acquire);
+    return true;
+}
+
+// Function to start from the oldest record still in the ring instead
+void EventRingReader::Rewind() {
+    uint64_t published = header->published.load(std::memory_order_acquire);
+    nextRecord = published > header->slotCount ? published - header->slotCount : 0;
+}
+
+// Function to copy the next record into `frame`
+EventReadStatus EventRingReader::Next(EventFrame& frame) {
+    for (;;) {
+        uint64_t published = header->published.load(std::memory_order_acquire);
+        if (nextRecord >= published) {
+            return EventReadStatus::Empty;
+        }
+        // Records more than a ring behind are gone already
+        if (published - nextRecord > header->slotCount) {
+            dropped += published - header->slotCount - nextRecord;
+            nextRecord = published - header->slotCount;
+        }
+        const uint8_t* slot = memory.Data() + SlotOffset(*header, nextRecord);
+        const EventSlotHeader* record = reinterpret_cast<const EventSlotHeader*>(slot);
+        const uint64_t complete = 2 * nextRecord + 2;
+        if (record->sequence.load(std::memory_order_acquire) == complete) {
+            // Counts are clamped before the sequence check, which may yet reject them
+            uint32_t boxCount = std::min(record->boxCount, header->maxBoxes);
+            uint32_t trackCount = std::min(record->trackCount, header->maxTracks);
+            frame.frameIndex = record->frameIndex;
+            frame.output = record->output;
+            frame.captureTimeUs = record->captureTimeUs;
+            frame.detectTimeUs = record->detectTimeUs;
+            frame.truncated = (record->flags & kEventFrameTruncated) != 0;
+            frame.boxes.resize(boxCount);
+            std::copy_n(reinterpret_cast<const EventBox*>(slot + sizeof(EventSlotHeader)), boxCount, frame.boxes.begin());
+            frame.tracks.resize(trackCount);
+            std::copy_n(reinterpret_cast<const EventTrack*>(slot + sizeof(EventSlotHeader) + header->maxBoxes * sizeof(EventBox)), trackCount,
+                        frame.tracks.begin());
+            // Keeps the copies above before the second sequence load
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (record->sequence.load(std::memory_order_relaxed) == complete) {
+                frame.sequence = nextRecord++;
+                return EventReadStatus::Ok;
+            }
+        }
+        // The writer reused the slot for a later record while it was being read
+        ++dropped;
+        ++nextRecord;
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include "box.h"
+#include "object_tracker.h"
+#include "shared_memory.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Detection results published to a named shared memory region for other processes, little endian.
+//
+//   EventRingHeader (64 bytes)
+//   slotCount x slot of slotBytes (a multiple of 64):
+//     { EventSlotHeader (48 bytes), boxCount x EventBox (16 bytes), trackCount x EventTrack (32 bytes) }
+//
+// There is one writing process and any number of readers, none of which the writer waits for;
+// threads of the writing process, such as the pipelines of several outputs, take turns. Record n
+// (counting from 0) goes to slot n % slotCount. Each slot is a sequence lock: the writer sets
+// `sequence` to 2n + 1, writes the record, then sets it to 2n + 2 and bumps `published` to n + 1.
+// A reader copies the slot out and keeps the copy only if `sequence` read 2n + 2 both before and
+// after; otherwise the writer lapped it and it skips ahead. Readers only need loads from the
+// mapping: no locks, no syscalls, and a slow reader loses old records instead of holding up the
+// detector.
+const char kEventRingMagic[8] = { 'O', 'V', 'L', 'E', 'V', 'E', 'N', 'T' };
+const uint32_t kEventRingVersion = 1;
+// Set in EventSlotHeader::flags when a frame had more boxes or tracks than a slot holds
+const uint32_t kEventFrameTruncated = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "event rings need lock-free 64-bit atomics");
+
+struct EventRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotBytes;
+    uint32_t maxBoxes;
+    uint32_t maxTracks;
+    uint32_t reserved0;
+    // Records completely written so far
+    std::atomic<uint64_t> published;
+    uint64_t reserved[3];
+};
+
+struct EventSlotHeader {
+    std::atomic<uint64_t> sequence;
+    uint64_t frameIndex;
+    // PipelineClockUs() when the frame was captured and when its detection finished
+    int64_t captureTimeUs;
+    int64_t detectTimeUs;
+    uint32_t boxCount;
+    uint32_t trackCount;
+    uint32_t flags;
+    // Display output the frame came from, 0 with a single output
+    uint32_t output;
+};
+
+// Box with exclusive right and bottom edges, as Box
+struct EventBox {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+};
+
+// Confirmed object track
+struct EventTrack {
+    uint32_t id;
+    // Frames since the track started
+    uint32_t age;
+    EventBox box;
+    // Pixels per frame
+    float velocityX;
+    float velocityY;
+};
+
+static_assert(sizeof(EventRingHeader) == 64, "EventRingHeader layout");
+static_assert(sizeof(EventSlotHeader) == 48, "EventSlotHeader layout");
+static_assert(sizeof(EventBox) == 16, "EventBox layout");
+static_assert(sizeof(EventTrack) == 32, "EventTrack layout");
+
+// Settings for EventRingWriter
+struct EventRingConfig {
+    // Records kept in the ring; a reader that falls further behind loses the oldest ones
+    int slotCount = 64;
+    // Boxes and tracks stored per record; extra ones are dropped and the record marked truncated
+    int maxBoxes = 256;
+    int maxTracks = 256;
+};
+
+// One record as copied out by EventRingReader
+struct EventFrame {
+    uint64_t sequence = 0;
+    uint64_t frameIndex = 0;
+    uint32_t output = 0;
+    int64_t captureTimeUs = 0;
+    int64_t detectTimeUs = 0;
+    bool truncated = false;
+    std::vector<EventBox> boxes;
+    std::vector<EventTrack> tracks;
+};
+
+// Creates an event ring and publishes records to it. Publish never allocates, and only waits
+// while another thread of the process is publishing.
+class EventRingWriter {
+public:
+    EventRingWriter() = default;
+    ~EventRingWriter() { Close(); }
+
+    EventRingWriter(const EventRingWriter&) = delete;
+    EventRingWriter& operator=(const EventRingWriter&) = delete;
+
+    // Function to create the shared memory region `name`, returns false if it cannot be created
+    bool Open(const char* name, const EventRingConfig& config = EventRingConfig());
+    void Close();
+
+    bool IsOpen() const { return memory.IsOpen(); }
+    uint64_t Published() const { return nextRecord.load(std::memory_order_relaxed); }
+
+    // Function to publish one frame's boxes and tracks from display output `output` as the next record
+    void Publish(uint64_t frameIndex, int64_t captureTimeUs, int64_t detectTimeUs, const std::vector<Box>& boxes,
+                 const std::vector<Track>& tracks, uint32_t output = 0);
+
+private:
+    SharedMemory memory;
+    EventRingHeader* header = nullptr;
+    // Held for the whole of a Publish, which only copies into the mapping
+    std::mutex publishing;
+    std::atomic<uint64_t> nextRecord{ 0 };
+};
+
+// Result of EventRingReader::Next
+enum class EventReadStatus {
+    // A record was copied out
+    Ok,
+    // The reader has seen every published record
+    Empty
+};
+
+// Reads an event ring published by another process, oldest unread record first
+class EventRingReader {
+public:
+    // Function to map the ring `name` and start after the records already published, returns
+    // false if it does not exist or has an unknown layout
+    bool Open(const char* name);
+    void Close() { memory.Close(); }
+
+    bool IsOpen() const { return memory.IsOpen(); }
+    // Records the writer overwrote before this reader got to them
+    uint64_t Dropped() const { return dropped; }
+    const EventRingHeader& Header() const { return *header; }
+
+    // Function to start from the oldest record still in the ring instead
+    void Rewind();
+
+    // Function to copy the next record into `frame`
+    EventReadStatus Next(EventFrame& frame);
+
+private:
+    SharedMemory memory;
+    const EventRingHeader* header = nullptr;
+    uint64_t nextRecord = 0;
+    uint64_t dropped = 0;
+};
+
+#endif // EVENT_RING_H
@@ -0,0 +1,36 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(size_t initialBytes)
+    : block(new uint8_t[std::max<size_t>(initialBytes, 64)]), blockSize(std::max<size_t>(initialBytes, 64)) {}
+
+// Function to start a new frame, releasing everything allocated during the last one
+void FrameArena::Reset() {
+    size_t frameBytes = used + spillBytes;
+    peakBytes = std::max(peakBytes, frameBytes);
+    if (!spills.empty()) {
+        // Half again as much so a slightly busier frame does not spill right away
+        spills.clear();
+        blockSize = frameBytes + frameBytes / 2;
+        block.reset(new uint8_t[blockSize]);
+    }
+    used = 0;
+    spillBytes = 0;
+}
+
+// Function to get `bytes` of storage aligned to `alignment`, valid until the next Reset
+void* FrameArena::AllocateBytes(size_t bytes, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+    uintptr_t aligned = (base + used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    size_t offset = static_cast<size_t>(aligned - base);
+    if (offset + bytes <= blockSize) {
+        used = offset + bytes;
+        return block.get() + offset;
+    }
+    size_t spillSize = bytes + alignment;
+    spills.emplace_back(new uint8_t[spillSize]);
+    spillBytes += spillSize;
+    uintptr_t spill = reinterpret_cast<uintptr_t>(spills.back().get());
+    return reinterpret_cast<void*>((spill + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+}
@@ -0,0 +1,52 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for scratch memory that only lives until the next frame. Allocations are carved
+// out of one block and all released together by Reset. A frame that needs more than the block
+// spills into extra heap blocks, and the next Reset replaces them with one block big enough for
+// that frame, so once the busiest frame has been seen the arena stops touching the heap.
+// Not thread-safe; each thread that needs scratch keeps its own arena.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialBytes = 4096);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Function to start a new frame, releasing everything allocated during the last one
+    void Reset();
+
+    // Function to get uninitialised storage for `count` values, valid until the next Reset.
+    // Destructors never run, so only trivially destructible types are allowed.
+    template <typename T>
+    T* Allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        return static_cast<T*>(AllocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    // Function to get `bytes` of storage aligned to `alignment` (a power of two), valid until the next Reset
+    void* AllocateBytes(size_t bytes, size_t alignment);
+
+    // Size of the main block in bytes
+    size_t Capacity() const { return blockSize; }
+
+    // Most bytes any frame so far has used, including alignment padding
+    size_t PeakBytes() const { return peakBytes; }
+
+private:
+    std::unique_ptr<uint8_t[]> block;
+    size_t blockSize = 0;
+    size_t used = 0;
+    // Heap blocks of the current frame that did not fit the main block
+    std::vector<std::unique_ptr<uint8_t[]>> spills;
+    size_t spillBytes = 0;
+    size_t peakBytes = 0;
+};
+
+#endif // FRAME_ARENA_H
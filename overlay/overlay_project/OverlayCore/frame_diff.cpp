@@ -0,0 +1,122 @@
+#include "frame_diff.h"
+#include "frame_diff_kernels.h"
+
+void ChangeMask::Resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    wordsPerRow = (newWidth + 63) >> 6;
+    bits.resize(static_cast<size_t>(wordsPerRow) * newHeight);
+}
+
+// Portable reference kernel. Compares 64 bits per load: two 4-byte pixels, split only when the
+// pair differs, or one 8-byte pixel.
+template <class Traits>
+size_t DiffRowScalar(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask) {
+    ClearMaskRow(mask, width);
+    const int bytes = Traits::kBytesPerPixel;
+    const int pixels = 8 / bytes;
+    int x = 0;
+    for (; x + pixels <= width; x += pixels) {
+        uint64_t a, b;
+        memcpy(&a, current + x * bytes, 8);
+        memcpy(&b, previous + x * bytes, 8);
+        uint64_t diff = a ^ b;
+        if (diff != 0) {
+            uint64_t bits = pixels == 1 ? 1ull : ((diff & 0xFFFFFFFFull) != 0 ? 1ull : 0ull) | ((diff >> 32) != 0 ? 2ull : 0ull);
+            mask[x >> 6] |= bits << (x & 63);
+        }
+    }
+    DiffRowTail<Traits>(current, previous, x, width, mask);
+    return CountMaskRow(mask, width);
+}
+
+// Function to check whether a kernel was compiled in and runs on this CPU
+bool IsDiffKernelSupported(DiffKernel kernel) {
+    const CpuFeatures& cpu = GetCpuFeatures();
+    switch (kernel) {
+    case DiffKernel::Scalar:
+        return true;
+#if defined(OVERLAY_ARCH_X86)
+    case DiffKernel::SSE2:
+        return cpu.sse2;
+    case DiffKernel::AVX2:
+        return cpu.avx2;
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    case DiffKernel::NEON:
+        return cpu.neon;
+#endif
+    default:
+        (void)cpu;
+        return false;
+    }
+}
+
+// Function to pick the widest supported kernel for this CPU
+DiffKernel SelectDiffKernel() {
+    if (IsDiffKernelSupported(DiffKernel::AVX2)) return DiffKernel::AVX2;
+    if (IsDiffKernelSupported(DiffKernel::NEON)) return DiffKernel::NEON;
+    if (IsDiffKernelSupported(DiffKernel::SSE2)) return DiffKernel::SSE2;
+    return DiffKernel::Scalar;
+}
+
+// Function to get a kernel's row function instantiated for one pixel format
+template <class Traits>
+static DiffRowFunc GetDiffRowFuncFor(DiffKernel kernel) {
+    if (!IsDiffKernelSupported(kernel)) {
+        return DiffRowScalar<Traits>;
+    }
+    switch (kernel) {
+#if defined(OVERLAY_ARCH_X86)
+    case DiffKernel::SSE2:
+        return DiffRowSSE2<Traits>;
+    case DiffKernel::AVX2:
+        return DiffRowAVX2<Traits>;
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    case DiffKernel::NEON:
+        return DiffRowNEON<Traits>;
+#endif
+    default:
+        return DiffRowScalar<Traits>;
+    }
+}
+
+// Function to get the row function implementing a kernel for a pixel format (falls back to scalar if unsupported)
+DiffRowFunc GetDiffRowFunc(DiffKernel kernel, PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGB10A2:
+        return GetDiffRowFuncFor<Rgb10A2Traits>(kernel);
+    case PixelFormat::RGBA16F:
+        return GetDiffRowFuncFor<Rgba16FTraits>(kernel);
+    default:
+        return GetDiffRowFuncFor<Bgra8Traits>(kernel);
+    }
+}
+
+// Function to get a printable kernel name
+const char* DiffKernelName(DiffKernel kernel) {
+    switch (kernel) {
+    case DiffKernel::Scalar: return "scalar";
+    case DiffKernel::SSE2: return "sse2";
+    case DiffKernel::AVX2: return "avx2";
+    case DiffKernel::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+// Function to diff two equally sized frames into `mask`, returns the number of changed pixels
+size_t DiffFrames(const FrameView& current, const FrameView& previous, ChangeMask& mask, DiffKernel kernel) {
+    mask.Resize(current.width, current.height);
+    DiffRowFunc diffRow = GetDiffRowFunc(kernel, current.format);
+    size_t changed = 0;
+    for (int y = 0; y < current.height; ++y) {
+        changed += diffRow(current.Row(y), previous.Row(y), current.width, mask.Row(y));
+    }
+    return changed;
+}
+
+size_t DiffFrames(const FrameView& current, const FrameView& previous, ChangeMask& mask) {
+    static const DiffKernel bestKernel = SelectDiffKernel();
+    return DiffFrames(current, previous, mask, bestKernel);
+}
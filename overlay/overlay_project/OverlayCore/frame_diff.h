@@ -0,0 +1,72 @@
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include "pixel_format.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Read-only view of a mapped frame, laid out like D3D11_MAPPED_SUBRESOURCE
+struct FrameView {
+    const uint8_t* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int rowPitch = 0;
+    PixelFormat format = PixelFormat::BGRA8;
+
+    const uint8_t* Row(int y) const { return pixels + static_cast<size_t>(y) * rowPitch; }
+    int BytesPerPixel() const { return PixelFormatBytes(format); }
+
+    // Function to get a view of pixel columns [left, right) of the frame
+    FrameView Columns(int left, int right) const {
+        FrameView view = *this;
+        view.pixels = pixels + static_cast<size_t>(left) * BytesPerPixel();
+        view.width = right - left;
+        return view;
+    }
+};
+
+// One bit per pixel, set where the two frames differ. Rows are padded to whole 64-bit words.
+struct ChangeMask {
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+
+    void Resize(int newWidth, int newHeight);
+    uint64_t* Row(int y) { return bits.data() + static_cast<size_t>(y) * wordsPerRow; }
+    const uint64_t* Row(int y) const { return bits.data() + static_cast<size_t>(y) * wordsPerRow; }
+    bool Test(int x, int y) const { return (Row(y)[x >> 6] >> (x & 63)) & 1; }
+};
+
+// Available implementations of the row diff kernel
+enum class DiffKernel {
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+// Compares `width` pixels, writes one change bit per pixel into `mask` and returns the changed pixel count.
+// A pixel changed if any of its bytes did. Every word covering the row is written, with bits past `width` cleared.
+typedef size_t (*DiffRowFunc)(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+
+// Function to check whether a kernel was compiled in and runs on this CPU
+bool IsDiffKernelSupported(DiffKernel kernel);
+
+// Function to pick the widest supported kernel for this CPU
+DiffKernel SelectDiffKernel();
+
+// Function to get the row function implementing a kernel for a pixel format (falls back to scalar
+// if the kernel is unsupported)
+DiffRowFunc GetDiffRowFunc(DiffKernel kernel, PixelFormat format = PixelFormat::BGRA8);
+
+// Function to get a printable kernel name
+const char* DiffKernelName(DiffKernel kernel);
+
+// Function to diff two equally sized frames into `mask`, returns the number of changed pixels
+size_t DiffFrames(const FrameView& current, const FrameView& previous, ChangeMask& mask, DiffKernel kernel);
+size_t DiffFrames(const FrameView& current, const FrameView& previous, ChangeMask& mask);
+
+#endif // FRAME_DIFF_H
@@ -0,0 +1,44 @@
+#include "frame_diff_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include <immintrin.h>
+
+// Returns a mask with a bit set for each pixel of a 32-byte compare that differs: eight 4-byte
+// pixels or four 8-byte pixels
+template <int kBytesPerPixel>
+static inline unsigned DiffMask32(const uint8_t* current, const uint8_t* previous) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous));
+    if (kBytesPerPixel == 8) {
+        return ~static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)))) & 0xF;
+    }
+    return ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))) & 0xFF;
+}
+
+// 16 pixels (64 or 128 bytes) per step as 32-byte compares
+template <class Traits>
+size_t DiffRowAVX2(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask) {
+    const int bytes = Traits::kBytesPerPixel;
+    const int lanes = 32 / bytes;
+    ClearMaskRow(mask, width);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* a = current + x * bytes;
+        const uint8_t* b = previous + x * bytes;
+        uint64_t bits = 0;
+        for (int i = 0; i < 16 / lanes; ++i) {
+            bits |= static_cast<uint64_t>(DiffMask32<bytes>(a + i * 32, b + i * 32)) << (i * lanes);
+        }
+        if (bits != 0) {
+            mask[x >> 6] |= bits << (x & 63);
+        }
+    }
+    _mm256_zeroupper();
+    DiffRowTail<Traits>(current, previous, x, width, mask);
+    return CountMaskRow(mask, width);
+}
+
+template size_t DiffRowAVX2<Bgra8Traits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+template size_t DiffRowAVX2<Rgb10A2Traits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+template size_t DiffRowAVX2<Rgba16FTraits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+#endif
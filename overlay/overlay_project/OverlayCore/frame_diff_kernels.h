@@ -0,0 +1,53 @@
+#ifndef FRAME_DIFF_KERNELS_H
+#define FRAME_DIFF_KERNELS_H
+
+// Internal: per-ISA row kernels behind DiffRowFunc. Each lives in its own translation
+// unit so it can be compiled with the matching instruction set flags, and is instantiated
+// there for every pixel format's traits.
+
+#include "bit_utils.h"
+#include "cpu_features.h"
+#include "frame_diff.h"
+
+#include <cstring>
+
+template <class Traits>
+size_t DiffRowScalar(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+#if defined(OVERLAY_ARCH_X86)
+template <class Traits>
+size_t DiffRowSSE2(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+template <class Traits>
+size_t DiffRowAVX2(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+template <class Traits>
+size_t DiffRowNEON(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+#endif
+
+// Function to clear the mask words covering a row before the kernels OR bits into them
+inline void ClearMaskRow(uint64_t* mask, int width) {
+    memset(mask, 0, static_cast<size_t>((width + 63) >> 6) * sizeof(uint64_t));
+}
+
+// Function to compare the pixels [x, width) one at a time, shared by the SIMD kernels for row tails
+template <class Traits>
+inline void DiffRowTail(const uint8_t* current, const uint8_t* previous, int x, int width, uint64_t* mask) {
+    const int bytes = Traits::kBytesPerPixel;
+    for (; x < width; ++x) {
+        if (memcmp(current + x * bytes, previous + x * bytes, bytes) != 0) {
+            mask[x >> 6] |= 1ull << (x & 63);
+        }
+    }
+}
+
+// Function to count the change bits of a finished row
+inline size_t CountMaskRow(const uint64_t* mask, int width) {
+    size_t count = 0;
+    int words = (width + 63) >> 6;
+    for (int i = 0; i < words; ++i) {
+        count += PopCount64(mask[i]);
+    }
+    return count;
+}
+
+#endif // FRAME_DIFF_KERNELS_H
@@ -0,0 +1,57 @@
+#include "frame_diff_kernels.h"
+
+#if defined(OVERLAY_ARCH_NEON)
+#include <arm_neon.h>
+
+// Narrows eight all-ones/all-zero 32-bit lane results to one byte each and folds the ones that
+// are zero (changed pixels) into a bitmask
+static inline unsigned ChangedBits8(uint32x4_t eq0, uint32x4_t eq1) {
+    static const uint8_t kBitWeights[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x8_t eq = vmovn_u16(vcombine_u16(vmovn_u32(eq0), vmovn_u32(eq1)));
+    return vaddv_u8(vand_u8(vmvn_u8(eq), vld1_u8(kBitWeights)));
+}
+
+// Returns an 8-bit mask with a bit set for each of eight pixels that differs
+template <int kBytesPerPixel>
+static inline unsigned DiffMask8(const uint8_t* current, const uint8_t* previous) {
+    if (kBytesPerPixel == 8) {
+        // 64-bit lane compares narrowed to 32 bits, two pixels per load
+        uint32x4_t eq[2];
+        for (int i = 0; i < 2; ++i) {
+            const uint8_t* a = current + i * 32;
+            const uint8_t* b = previous + i * 32;
+            uint32x2_t low = vmovn_u64(vceqq_u64(vld1q_u64(reinterpret_cast<const uint64_t*>(a)), vld1q_u64(reinterpret_cast<const uint64_t*>(b))));
+            uint32x2_t high = vmovn_u64(vceqq_u64(vld1q_u64(reinterpret_cast<const uint64_t*>(a + 16)), vld1q_u64(reinterpret_cast<const uint64_t*>(b + 16))));
+            eq[i] = vcombine_u32(low, high);
+        }
+        return ChangedBits8(eq[0], eq[1]);
+    }
+    uint32x4_t eq0 = vceqq_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(current)),
+                               vld1q_u32(reinterpret_cast<const uint32_t*>(previous)));
+    uint32x4_t eq1 = vceqq_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(current + 16)),
+                               vld1q_u32(reinterpret_cast<const uint32_t*>(previous + 16)));
+    return ChangedBits8(eq0, eq1);
+}
+
+// 16 pixels (64 or 128 bytes) per step as two groups of eight
+template <class Traits>
+size_t DiffRowNEON(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask) {
+    const int bytes = Traits::kBytesPerPixel;
+    ClearMaskRow(mask, width);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* a = current + x * bytes;
+        const uint8_t* b = previous + x * bytes;
+        uint64_t bits = DiffMask8<bytes>(a, b) | (static_cast<uint64_t>(DiffMask8<bytes>(a + 8 * bytes, b + 8 * bytes)) << 8);
+        if (bits != 0) {
+            mask[x >> 6] |= bits << (x & 63);
+        }
+    }
+    DiffRowTail<Traits>(current, previous, x, width, mask);
+    return CountMaskRow(mask, width);
+}
+
+template size_t DiffRowNEON<Bgra8Traits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+template size_t DiffRowNEON<Rgb10A2Traits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+template size_t DiffRowNEON<Rgba16FTraits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+#endif
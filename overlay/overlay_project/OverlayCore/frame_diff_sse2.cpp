@@ -0,0 +1,45 @@
+#include "frame_diff_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include <emmintrin.h>
+
+// Returns a mask with a bit set for each pixel of a 16-byte compare that differs: four 4-byte
+// pixels, or two 8-byte pixels whose halves are ANDed before the 64-bit sign bits are taken
+template <int kBytesPerPixel>
+static inline unsigned DiffMask16(const uint8_t* current, const uint8_t* previous) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous));
+    __m128i equal = _mm_cmpeq_epi32(a, b);
+    if (kBytesPerPixel == 8) {
+        equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+        return ~static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(equal))) & 0x3;
+    }
+    return ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(equal))) & 0xF;
+}
+
+// 16 pixels (64 or 128 bytes) per step as 16-byte compares
+template <class Traits>
+size_t DiffRowSSE2(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask) {
+    const int bytes = Traits::kBytesPerPixel;
+    const int lanes = 16 / bytes;
+    ClearMaskRow(mask, width);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* a = current + x * bytes;
+        const uint8_t* b = previous + x * bytes;
+        uint64_t bits = 0;
+        for (int i = 0; i < 16 / lanes; ++i) {
+            bits |= static_cast<uint64_t>(DiffMask16<bytes>(a + i * 16, b + i * 16)) << (i * lanes);
+        }
+        if (bits != 0) {
+            mask[x >> 6] |= bits << (x & 63);
+        }
+    }
+    DiffRowTail<Traits>(current, previous, x, width, mask);
+    return CountMaskRow(mask, width);
+}
+
+template size_t DiffRowSSE2<Bgra8Traits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+template size_t DiffRowSSE2<Rgb10A2Traits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+template size_t DiffRowSSE2<Rgba16FTraits>(const uint8_t* current, const uint8_t* previous, int width, uint64_t* mask);
+#endif
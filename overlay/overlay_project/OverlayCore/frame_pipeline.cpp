@@ -0,0 +1,307 @@
+#include "frame_pipeline.h"
+#include "metrics.h"
+
+#include <chrono>
+
+// Function to read the clock shared by all pipeline stages, in microseconds
+int64_t PipelineClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Function to move boxes, moves, tracks and activity regions from output pixels to virtual desktop coordinates
+static void OffsetResults(int dx, int dy, std::vector<Box>& boxes, std::vector<MoveRect>& moves, std::vector<Track>& tracks, std::vector<Box>& activity) {
+    auto offset = [dx, dy](Box& box) {
+        box.left += dx;
+        box.top += dy;
+        box.right += dx;
+        box.bottom += dy;
+    };
+    for (Box& box : boxes) {
+        offset(box);
+    }
+    for (MoveRect& move : moves) {
+        offset(move.box);
+    }
+    for (Track& track : tracks) {
+        offset(track.box);
+        track.centerX += dx;
+        track.centerY += dy;
+    }
+    for (Box& box : activity) {
+        offset(box);
+    }
+}
+
+// Function to wait for work without locks: yield for a while, then sleep briefly
+static void Backoff(int& idleRounds) {
+    if (idleRounds < 64) {
+        ++idleRounds;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+// Function to empty a slot queue; only while no stage thread is running
+static void DrainSlots(SpscQueue<int>& queue) {
+    int slot;
+    while (queue.TryPop(slot)) {
+    }
+}
+
+FramePipeline::FramePipeline(const PipelineConfig& config, CaptureStage& capture, RenderStage& render, DetectListener* listener)
+    : config(config), capture(capture), render(render), listener(listener), detector(config.detector), tracker(config.tracker),
+      motionEstimator(config.motion, config.detector.kernel), coalescer(config.coalesce), freeFrames(kFrameSlots), capturedFrames(1), freeResults(kResultSlots), readyResults(1) {}
+
+FramePipeline::~FramePipeline() {
+    Stop();
+}
+
+// Function to allocate the frame and result rings and start the stage threads
+void FramePipeline::Start() {
+    if (IsRunning()) {
+        return;
+    }
+    // A restart finds the last run's slots spread over the queues and the exited threads' locals;
+    // all of them are free again, so empty the queues before handing every slot out once
+    DrainSlots(freeFrames);
+    DrainSlots(capturedFrames);
+    DrainSlots(freeResults);
+    DrainSlots(readyResults);
+    size_t frameBytes = static_cast<size_t>(config.width) * config.height * PixelFormatBytes(config.format);
+    frames.resize(kFrameSlots);
+    for (int i = 0; i < kFrameSlots; ++i) {
+        frames[i].pixels.resize(frameBytes);
+        freeFrames.TryPush(i);
+    }
+    results.resize(kResultSlots);
+    for (int i = 0; i < kResultSlots; ++i) {
+        freeResults.TryPush(i);
+    }
+    tracker.Reset();
+    scheduler.reset();
+    if (config.schedule.targetFps > 0) {
+        scheduler = std::make_unique<FrameScheduler>(config.schedule, *schedulerClock);
+    }
+
+    running = true;
+    threads.emplace_back(&FramePipeline::CaptureLoop, this);
+    threads.emplace_back(&FramePipeline::DetectLoop, this);
+    threads.emplace_back(&FramePipeline::RenderLoop, this);
+}
+
+// Function to stop and join the stage threads; stages are not called after it returns
+void FramePipeline::Stop() {
+    running = false;
+    if (scheduler) {
+        scheduler->Interrupt();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+PipelineStats FramePipeline::Stats() const {
+    PipelineStats stats;
+    stats.captured = captured.load(std::memory_order_relaxed);
+    stats.detected = detected.load(std::memory_order_relaxed);
+    stats.rendered = rendered.load(std::memory_order_relaxed);
+    stats.staleFrames = staleFrames.load(std::memory_order_relaxed);
+    stats.staleResults = staleResults.load(std::memory_order_relaxed);
+    stats.totalLatencyUs = totalLatencyUs.load(std::memory_order_relaxed);
+    stats.maxLatencyUs = maxLatencyUs.load(std::memory_order_relaxed);
+    if (scheduler) {
+        SchedulerStats schedule = scheduler->Stats();
+        stats.missedDeadlines = schedule.missedDeadlines;
+        stats.scheduleWakeups = schedule.wakeups;
+        stats.frameIntervalUs = schedule.intervalUs;
+    }
+    return stats;
+}
+
+void FramePipeline::CaptureLoop() {
+    int slot = -1;
+    bool waiting = false;
+    uint64_t nextIndex = 0;
+    int idleRounds = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        // Hand over a frame the detect stage was too busy to take last time
+        if (waiting && capturedFrames.TryPush(slot)) {
+            slot = -1;
+            waiting = false;
+        }
+        if (slot < 0 && !freeFrames.TryPop(slot)) {
+            slot = -1;
+            Backoff(idleRounds);
+            continue;
+        }
+        if (scheduler) {
+            scheduler->WaitForNextFrame();
+            if (!running.load(std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        if (!capture.Capture(frames[slot])) {
+            // Nothing new from the source counts as a frame without change
+            if (scheduler) {
+                scheduler->ReportFrame(false);
+            } else {
+                Backoff(idleRounds);
+            }
+            continue;
+        }
+        idleRounds = 0;
+        captured.fetch_add(1, std::memory_order_relaxed);
+        if (waiting) {
+            staleFrames.fetch_add(1, std::memory_order_relaxed);
+            OVERLAY_METRICS_COUNT(CounterMetric::DroppedFrames, 1);
+        }
+        frames[slot].index = nextIndex++;
+        waiting = !capturedFrames.TryPush(slot);
+        if (!waiting) {
+            slot = -1;
+        }
+    }
+}
+
+void FramePipeline::DetectLoop() {
+    // Pixel diffing, pyramid refinement and motion estimation keep the previous frame's buffer;
+    // tile hashing and the background model only need their own state
+    const DetectorConfig& detectorConfig = detector.Config();
+    bool keepPrevious = detectorConfig.mode == DetectionMode::PixelDiff || detectorConfig.mode == DetectionMode::Pyramid ||
+                        detectorConfig.verifyHashes || config.estimateMotion;
+    int previousSlot = -1;
+    int resultSlot = -1;
+    bool waiting = false;
+    std::vector<Box> boxes;
+    std::vector<MoveRect> moves;
+    std::vector<Track> confirmed;
+    confirmed.reserve(tracker.Config().maxTracks);
+    std::vector<Box> activity;
+    int idleRounds = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        if (waiting && readyResults.TryPush(resultSlot)) {
+            resultSlot = -1;
+            waiting = false;
+        }
+        int slot;
+        if (!capturedFrames.TryPop(slot)) {
+            Backoff(idleRounds);
+            continue;
+        }
+        idleRounds = 0;
+
+        const PipelineFrame& frame = frames[slot];
+        bool havePrevious = previousSlot >= 0 && frames[previousSlot].view.width == frame.view.width &&
+                            frames[previousSlot].view.height == frame.view.height;
+        if (!keepPrevious) {
+            detector.Detect(frame.view, boxes);
+        } else if (havePrevious) {
+            detector.Detect(frame.view, frames[previousSlot].view, boxes);
+        } else {
+            // Nothing to compare the first frame against
+            detector.Detect(frame.view, frame.view, boxes);
+        }
+        detected.fetch_add(1, std::memory_order_relaxed);
+        if (heatmap) {
+            heatmap->Update(detector.Tiles(), &detector.Activity());
+        }
+        confirmed.clear();
+        if (config.trackObjects) {
+            OVERLAY_METRICS_SCOPE(StageMetric::Track);
+            tracker.SetFrameSize(frame.view.width, frame.view.height);
+            tracker.Update(boxes);
+            for (const Track& track : tracker.Tracks()) {
+                if (tracker.IsConfirmed(track)) {
+                    confirmed.push_back(track);
+                }
+            }
+        }
+        moves.clear();
+        if (config.estimateMotion && havePrevious) {
+            OVERLAY_METRICS_SCOPE(StageMetric::Motion);
+            motionEstimator.Estimate(frame.view, frames[previousSlot].view, detector.Tiles(), moves, boxes);
+        }
+        if (scheduler) {
+            scheduler->ReportFrame(!boxes.empty() || !moves.empty());
+        }
+        if (config.coalesceBoxes) {
+            OVERLAY_METRICS_SCOPE(StageMetric::Coalesce);
+            coalescer.Reserve(detector.Tiles().dirty.size());
+            coalescer.Coalesce(boxes);
+            if (coalescer.Stats().capped) {
+                OVERLAY_METRICS_COUNT(CounterMetric::CappedCoalesces, 1);
+            }
+        }
+        if (listener) {
+            listener->OnFrameDetected(frame, detector);
+        }
+        activity.assign(detector.ActivityRegions().begin(), detector.ActivityRegions().end());
+        if (config.originX != 0 || config.originY != 0) {
+            OffsetResults(config.originX, config.originY, boxes, moves, confirmed, activity);
+        }
+        int64_t detectTimeUs = PipelineClockUs();
+        if (events) {
+            events->Publish(frame.index, frame.captureTimeUs, detectTimeUs, boxes, confirmed, config.outputIndex);
+        }
+
+        // Publish the result, replacing one the render stage has not picked up yet
+        if (resultSlot < 0) {
+            freeResults.TryPop(resultSlot);
+        } else {
+            staleResults.fetch_add(1, std::memory_order_relaxed);
+            OVERLAY_METRICS_COUNT(CounterMetric::DroppedFrames, 1);
+        }
+        if (resultSlot >= 0) {
+            PipelineResult& result = results[resultSlot];
+            result.frameIndex = frame.index;
+            result.captureTimeUs = frame.captureTimeUs;
+            result.detectTimeUs = detectTimeUs;
+            result.changedPixels = detector.ChangedPixels();
+            result.boxes.assign(boxes.begin(), boxes.end());
+            result.moves.assign(moves.begin(), moves.end());
+            result.tracks.assign(confirmed.begin(), confirmed.end());
+            result.activity.assign(activity.begin(), activity.end());
+            waiting = !readyResults.TryPush(resultSlot);
+            if (!waiting) {
+                resultSlot = -1;
+            }
+        }
+
+        if (keepPrevious) {
+            if (previousSlot >= 0) {
+                freeFrames.TryPush(previousSlot);
+            }
+            previousSlot = slot;
+        } else {
+            freeFrames.TryPush(slot);
+        }
+    }
+}
+
+void FramePipeline::RenderLoop() {
+    int idleRounds = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        int slot;
+        if (!readyResults.TryPop(slot)) {
+            Backoff(idleRounds);
+            continue;
+        }
+        idleRounds = 0;
+
+        const PipelineResult& result = results[slot];
+        {
+            OVERLAY_METRICS_SCOPE(StageMetric::Render);
+            render.Render(result);
+        }
+        int64_t latencyUs = PipelineClockUs() - result.captureTimeUs;
+        freeResults.TryPush(slot);
+
+        rendered.fetch_add(1, std::memory_order_relaxed);
+        totalLatencyUs.fetch_add(latencyUs, std::memory_order_relaxed);
+        if (latencyUs > maxLatencyUs.load(std::memory_order_relaxed)) {
+            maxLatencyUs.store(latencyUs, std::memory_order_relaxed);
+        }
+    }
+}
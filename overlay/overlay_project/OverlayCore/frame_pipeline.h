@@ -0,0 +1,219 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "box.h"
+#include "box_coalescer.h"
+#include "event_ring.h"
+#include "frame_scheduler.h"
+#include "heatmap.h"
+#include "motion_detector.h"
+#include "motion_estimator.h"
+#include "object_tracker.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Function to read the clock shared by all pipeline stages, in microseconds
+int64_t PipelineClockUs();
+
+// Reusable frame buffer owned by the pipeline
+struct PipelineFrame {
+    // Sized once for the configured frame size; capture stages fill it in place
+    std::vector<uint8_t> pixels;
+    // View of the captured image, normally pointing into `pixels`
+    FrameView view;
+    uint64_t index = 0;
+    // PipelineClockUs() when the image was captured, set by the capture stage
+    int64_t captureTimeUs = 0;
+};
+
+// Detection output handed from the detect stage to the render stage
+// End of one output's part of a merged result in each of its lists: that output's items are the
+// ones from the previous entry's ends up to these
+struct MergedOutputEnd {
+    size_t output = 0;
+    size_t boxes = 0;
+    size_t moves = 0;
+    size_t tracks = 0;
+    size_t activity = 0;
+};
+
+struct PipelineResult {
+    uint64_t frameIndex = 0;
+    int64_t captureTimeUs = 0;
+    int64_t detectTimeUs = 0;
+    size_t changedPixels = 0;
+    // Detected boxes, coalesced when PipelineConfig::coalesceBoxes is set. With
+    // PipelineConfig::estimateMotion they only cover newly drawn content.
+    std::vector<Box> boxes;
+    // Regions that moved since the previous frame, when PipelineConfig::estimateMotion is set
+    std::vector<MoveRect> moves;
+    // Confirmed object tracks after this frame, when PipelineConfig::trackObjects is set
+    std::vector<Track> tracks;
+    // Groups of tiles demoted for changing in most frames, when DetectorConfig::sampling is
+    // enabled; their changes are not in `boxes`
+    std::vector<Box> activity;
+    // Results merged by MultiOutputPipeline only: one entry per output that had a result, in
+    // output order, so each item can be traced back to the output that found it
+    std::vector<MergedOutputEnd> outputEnds;
+};
+
+// Produces frames; runs on the pipeline's capture thread
+class CaptureStage {
+public:
+    virtual ~CaptureStage() {}
+
+    // Function to write the next frame into `frame` and set its view and capture time.
+    // Returns false, leaving `frame` untouched, when no new frame is available yet.
+    virtual bool Capture(PipelineFrame& frame) = 0;
+};
+
+// Consumes detection results; runs on the pipeline's render thread
+class RenderStage {
+public:
+    virtual ~RenderStage() {}
+
+    virtual void Render(const PipelineResult& result) = 0;
+};
+
+// Optional hook called on the detect thread after each frame, e.g. to record it
+class DetectListener {
+public:
+    virtual ~DetectListener() {}
+
+    virtual void OnFrameDetected(const PipelineFrame& frame, const MotionDetector& detector) = 0;
+};
+
+// Settings for FramePipeline
+struct PipelineConfig {
+    int width = 0;
+    int height = 0;
+    // Format of the captured pixels; frame buffers are sized for it
+    PixelFormat format = PixelFormat::BGRA8;
+    // Position of the captured output on the virtual desktop and its index among the outputs.
+    // Detection works in output pixels; boxes, moves and tracks are offset by the origin before
+    // they reach the render stage and the event ring.
+    int originX = 0;
+    int originY = 0;
+    uint32_t outputIndex = 0;
+    DetectorConfig detector;
+    // Associate each frame's boxes into object tracks on the detect thread
+    bool trackObjects = false;
+    TrackerConfig tracker;
+    // Split changed tiles into moved and newly drawn content; keeps the previous frame in every mode
+    bool estimateMotion = false;
+    MotionConfig motion;
+    // Merge overlapping and nearby boxes before handing them to the render stage; tracking
+    // still sees the boxes as detected
+    bool coalesceBoxes = false;
+    CoalesceConfig coalesce;
+    // Capture pacing; with targetFps set the capture thread sleeps between frames, backs off while
+    // detection finds nothing and the capture stage is only polled when a frame is due
+    SchedulerConfig schedule;
+};
+
+// Counters read while the pipeline runs
+struct PipelineStats {
+    uint64_t captured = 0;
+    uint64_t detected = 0;
+    uint64_t rendered = 0;
+    // Captured frames replaced by a newer one before detection picked them up
+    uint64_t staleFrames = 0;
+    // Results replaced by a newer one before the render stage picked them up
+    uint64_t staleResults = 0;
+    // Capture to end of render, over rendered frames
+    int64_t totalLatencyUs = 0;
+    int64_t maxLatencyUs = 0;
+    // Capture pacing, when PipelineConfig::schedule.targetFps is set
+    uint64_t missedDeadlines = 0;
+    uint64_t scheduleWakeups = 0;
+    int64_t frameIntervalUs = 0;
+
+    double MeanLatencyUs() const { return rendered ? static_cast<double>(totalLatencyUs) / rendered : 0.0; }
+};
+
+// Runs capture, detection and rendering on three threads connected by lock-free single
+// producer, single consumer queues. Frame buffers and results live in fixed rings allocated
+// by Start and are passed between stages by index, so frames are never copied or allocated
+// after start-up. Each hand-off holds at most one waiting item: when the next stage is still
+// busy, the producer overwrites its waiting item with a newer one, so a slow stage skips
+// stale frames instead of building up latency.
+class FramePipeline {
+public:
+    FramePipeline(const PipelineConfig& config, CaptureStage& capture, RenderStage& render, DetectListener* listener = nullptr);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // Function to allocate the frame and result rings and start the stage threads
+    void Start();
+
+    // Function to stop and join the stage threads; stages are not called after it returns
+    void Stop();
+
+    bool IsRunning() const { return !threads.empty(); }
+    // The detector is used by the detect thread; only its Config() may be read while running
+    const MotionDetector& Detector() const { return detector; }
+    // Function to replace the detector's include and exclude regions; safe while running
+    void SetRegions(const std::vector<MaskRegion>& regions) { detector.SetRegions(regions); }
+    // Function to publish every detected frame's boxes and confirmed tracks to an event ring,
+    // including frames the render stage skips; call before Start
+    void SetEventRing(EventRingWriter* ring) { events = ring; }
+    // Function to fold every detected frame's changed tiles into a heatmap, including frames the
+    // render stage skips; call before Start. The heatmap can be exported from any thread.
+    void SetHeatmap(Heatmap* map) { heatmap = map; }
+    // Function to pace capture with another clock than the steady clock, e.g. a ManualSchedulerClock
+    // in tests; call before Start
+    void SetSchedulerClock(SchedulerClock* clock) { schedulerClock = clock ? clock : &steadyClock; }
+    PipelineStats Stats() const;
+
+private:
+    // Frame buffers: one being captured, one waiting, one being detected and the previous frame
+    static const int kFrameSlots = 4;
+    // Results: one being filled, one waiting and one being rendered
+    static const int kResultSlots = 3;
+
+    void CaptureLoop();
+    void DetectLoop();
+    void RenderLoop();
+
+    PipelineConfig config;
+    CaptureStage& capture;
+    RenderStage& render;
+    DetectListener* listener;
+    EventRingWriter* events = nullptr;
+    Heatmap* heatmap = nullptr;
+    MotionDetector detector;
+    ObjectTracker tracker;
+    MotionEstimator motionEstimator;
+    BoxCoalescer coalescer;
+    SteadySchedulerClock steadyClock;
+    SchedulerClock* schedulerClock = &steadyClock;
+    // Created by Start when capture is paced
+    std::unique_ptr<FrameScheduler> scheduler;
+
+    std::vector<PipelineFrame> frames;
+    std::vector<PipelineResult> results;
+    SpscQueue<int> freeFrames;
+    SpscQueue<int> capturedFrames;
+    SpscQueue<int> freeResults;
+    SpscQueue<int> readyResults;
+
+    std::atomic<bool> running{ false };
+    std::vector<std::thread> threads;
+
+    std::atomic<uint64_t> captured{ 0 };
+    std::atomic<uint64_t> detected{ 0 };
+    std::atomic<uint64_t> rendered{ 0 };
+    std::atomic<uint64_t> staleFrames{ 0 };
+    std::atomic<uint64_t> staleResults{ 0 };
+    std::atomic<int64_t> totalLatencyUs{ 0 };
+    std::atomic<int64_t> maxLatencyUs{ 0 };
+};
+
+#endif // FRAME_PIPELINE_H
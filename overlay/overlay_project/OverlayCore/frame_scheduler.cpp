@@ -0,0 +1,110 @@
+#include "frame_scheduler.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <chrono>
+
+int64_t SteadySchedulerClock::NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Function to block until `deadlineUs`, returning early if Interrupt is called meanwhile
+void SteadySchedulerClock::SleepUntil(int64_t deadlineUs) {
+    std::chrono::steady_clock::time_point deadline{ std::chrono::microseconds(deadlineUs) };
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.wait_until(lock, deadline, [this] { return interrupted; });
+    interrupted = false;
+}
+
+// Function to end the current or next SleepUntil early
+void SteadySchedulerClock::Interrupt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        interrupted = true;
+    }
+    wake.notify_one();
+}
+
+// Function to jump to `deadlineUs` unless an interrupt is pending
+void ManualSchedulerClock::SleepUntil(int64_t deadlineUs) {
+    if (interrupted.exchange(false)) {
+        return;
+    }
+    int64_t current = now.load();
+    while (current < deadlineUs && !now.compare_exchange_weak(current, deadlineUs)) {
+    }
+}
+
+FrameScheduler::FrameScheduler(const SchedulerConfig& schedulerConfig, SchedulerClock& clock)
+    : config(schedulerConfig), clock(clock) {
+    config.targetFps = std::max(config.targetFps, 1);
+    config.idleFrames = std::max(config.idleFrames, 1);
+    targetIntervalUs = 1000000 / config.targetFps;
+    maxIntervalUs = std::max<int64_t>(static_cast<int64_t>(config.maxIntervalMs) * 1000, targetIntervalUs);
+}
+
+// Function to get the interval the next frame is scheduled at
+int64_t FrameScheduler::IntervalUs() const {
+    int idle = idleStreak.load(std::memory_order_relaxed);
+    int64_t interval = targetIntervalUs;
+    for (int run = idle / config.idleFrames; run > 0 && interval < maxIntervalUs; --run) {
+        interval *= 2;
+    }
+    return std::min(interval, maxIntervalUs);
+}
+
+// Function to wait until the next frame is due, returns the time it starts
+int64_t FrameScheduler::WaitForNextFrame() {
+    frames.fetch_add(1, std::memory_order_relaxed);
+    int64_t now = clock.NowUs();
+    if (!started) {
+        started = true;
+        deadlineUs = now;
+        return now;
+    }
+    int64_t interval = IntervalUs();
+    deadlineUs += interval;
+    if (now > deadlineUs) {
+        int64_t lateness = now - deadlineUs;
+        missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+        OVERLAY_METRICS_COUNT(CounterMetric::MissedDeadlines, 1);
+        if (lateness > maxLatenessUs.load(std::memory_order_relaxed)) {
+            maxLatenessUs.store(lateness, std::memory_order_relaxed);
+        }
+        deadlineUs = now;
+        return now;
+    }
+
+    backedOff.store(interval > targetIntervalUs, std::memory_order_relaxed);
+    clock.SleepUntil(deadlineUs);
+    backedOff.store(false, std::memory_order_relaxed);
+    now = clock.NowUs();
+    if (now < deadlineUs) {
+        // Woken by a change (or a stop); later frames follow on from here
+        wakeups.fetch_add(1, std::memory_order_relaxed);
+        deadlineUs = now;
+    }
+    return now;
+}
+
+// Function to report whether a frame showed any change
+void FrameScheduler::ReportFrame(bool changed) {
+    if (!changed) {
+        idleStreak.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    idleStreak.store(0, std::memory_order_relaxed);
+    if (backedOff.load(std::memory_order_relaxed)) {
+        clock.Interrupt();
+    }
+}
+
+SchedulerStats FrameScheduler::Stats() const {
+    SchedulerStats stats;
+    stats.frames = frames.load(std::memory_order_relaxed);
+    stats.missedDeadlines = missedDeadlines.load(std::memory_order_relaxed);
+    stats.maxLatenessUs = maxLatenessUs.load(std::memory_order_relaxed);
+    stats.wakeups = wakeups.load(std::memory_order_relaxed);
+    stats.intervalUs = IntervalUs();
+    return stats;
+}
@@ -0,0 +1,125 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Time source and sleep primitive for FrameScheduler, so pacing can be tested with a fake clock
+class SchedulerClock {
+public:
+    virtual ~SchedulerClock() {}
+
+    // Function to read the current time in microseconds
+    virtual int64_t NowUs() = 0;
+
+    // Function to block until `deadlineUs`, returning early if Interrupt is called meanwhile or
+    // was called since the last sleep
+    virtual void SleepUntil(int64_t deadlineUs) = 0;
+
+    // Function to end the current or next SleepUntil early; safe from any thread
+    virtual void Interrupt() = 0;
+};
+
+// Steady clock on the same time base as PipelineClockUs
+class SteadySchedulerClock : public SchedulerClock {
+public:
+    int64_t NowUs() override;
+    void SleepUntil(int64_t deadlineUs) override;
+    void Interrupt() override;
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool interrupted = false;
+};
+
+// Clock that only moves when told to. SleepUntil jumps straight to the deadline, so a schedule of
+// any length runs instantly; Advance stands in for time spent working.
+class ManualSchedulerClock : public SchedulerClock {
+public:
+    explicit ManualSchedulerClock(int64_t startUs = 0) : now(startUs) {}
+
+    int64_t NowUs() override { return now.load(); }
+    void SleepUntil(int64_t deadlineUs) override;
+    void Interrupt() override { interrupted = true; }
+
+    // Function to move the clock forward
+    void Advance(int64_t us) { now += us; }
+
+private:
+    std::atomic<int64_t> now;
+    std::atomic<bool> interrupted{ false };
+};
+
+// Settings for FrameScheduler
+struct SchedulerConfig {
+    // Frames per second while the screen is changing; 0 leaves pacing to the capture stage
+    int targetFps = 0;
+    // Consecutive frames without changes after which the rate halves, and halves again after
+    // each further run of as many
+    int idleFrames = 30;
+    // Longest interval between frames while idle, in milliseconds
+    int maxIntervalMs = 250;
+};
+
+// Counters read while the scheduler runs
+struct SchedulerStats {
+    uint64_t frames = 0;
+    // Frames whose deadline had already passed when they were scheduled because the frame before
+    // them overran
+    uint64_t missedDeadlines = 0;
+    int64_t maxLatenessUs = 0;
+    // Backed-off waits cut short because a change was reported
+    uint64_t wakeups = 0;
+    // Interval the next frame is scheduled at
+    int64_t intervalUs = 0;
+};
+
+// Paces a capture loop. Frames are due at fixed deadlines 1/targetFps apart, so time spent
+// capturing does not add up into drift, and the loop sleeps rather than polls in between. After
+// idleFrames frames in a row without a change the interval doubles, up to maxIntervalMs, and a
+// reported change returns it to the target at once, cutting a backed-off wait short. A frame that
+// starts after its deadline counts as missed and the schedule restarts from it rather than
+// bursting to catch up.
+class FrameScheduler {
+public:
+    FrameScheduler(const SchedulerConfig& config, SchedulerClock& clock);
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Function to wait until the next frame is due, returns the time it starts (loop thread only)
+    int64_t WaitForNextFrame();
+
+    // Function to report whether a frame showed any change; safe from any thread
+    void ReportFrame(bool changed);
+
+    // Function to end the current wait early without reporting a change, e.g. when stopping
+    void Interrupt() { clock.Interrupt(); }
+
+    // Function to get the interval the next frame is scheduled at
+    int64_t IntervalUs() const;
+
+    SchedulerStats Stats() const;
+
+private:
+    SchedulerConfig config;
+    SchedulerClock& clock;
+    int64_t targetIntervalUs;
+    int64_t maxIntervalUs;
+    int64_t deadlineUs = 0;
+    bool started = false;
+
+    std::atomic<int> idleStreak{ 0 };
+    // Set while the loop sleeps at a backed-off interval, so only those waits are cut short
+    std::atomic<bool> backedOff{ false };
+
+    std::atomic<uint64_t> frames{ 0 };
+    std::atomic<uint64_t> missedDeadlines{ 0 };
+    std::atomic<int64_t> maxLatenessUs{ 0 };
+    std::atomic<uint64_t> wakeups{ 0 };
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,27 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include "frame_diff.h"
+
+#include <cstdint>
+
+// One captured desktop frame
+struct Frame {
+    FrameView view;
+    uint64_t index = 0;
+    // Capture time in microseconds relative to the first frame of the source
+    int64_t timestampUs = 0;
+};
+
+// Producer of consecutive frames (desktop capture, recorded trace, synthetic scene).
+// A returned view stays valid until NextFrame has been called twice more, so callers
+// can diff the current frame against the previous one without copying either.
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Function to fetch the next frame, returns false at the end of the source or on error
+    virtual bool NextFrame(Frame& frame) = 0;
+};
+
+#endif // FRAME_SOURCE_H
@@ -0,0 +1,393 @@
+#include "frame_trace.h"
+#include "tile_hash.h"
+#include "trace_codec.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+
+TraceWriter::~TraceWriter() {
+    Close();
+}
+
+bool TraceWriter::WriteBytes(const void* data, size_t size) {
+    if (fwrite(data, 1, size, file) != size) {
+        return false;
+    }
+    offset += size;
+    return true;
+}
+
+// Function to create a trace for frames of the given size, replacing any existing file
+bool TraceWriter::Open(const char* path, int frameWidth, int frameHeight, const TraceWriterOptions& writerOptions) {
+    Close();
+    file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    options = writerOptions;
+    options.keyframeInterval = std::max(1, options.keyframeInterval);
+    width = frameWidth;
+    height = frameHeight;
+    frameCount = 0;
+    offset = 0;
+    index.clear();
+    hashesValid = false;
+
+    TraceHeader header = {};
+    memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+    header.version = kTraceVersionRaw;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    if (options.encoding == TraceEncoding::DeltaTiles) {
+        header.version = kTraceVersionDelta;
+        header.tileSize = static_cast<uint32_t>(options.tileSize);
+        header.keyframeInterval = static_cast<uint32_t>(options.keyframeInterval);
+        cols = (width + options.tileSize - 1) / options.tileSize;
+        rows = (height + options.tileSize - 1) / options.tileSize;
+        tileHashes.assign(static_cast<size_t>(cols) * rows, 0);
+        rowHashes.resize(cols);
+        tilePixels.resize(static_cast<size_t>(options.tileSize) * options.tileSize);
+    }
+    if (!WriteBytes(&header, sizeof(header))) {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// Function to append a frame; it must match the size given to Open
+bool TraceWriter::WriteFrame(const FrameView& frame, int64_t timestampUs, const TileMap* changedTiles) {
+    if (!file || frame.width != width || frame.height != height) {
+        return false;
+    }
+    bool ok = options.encoding == TraceEncoding::DeltaTiles
+        ? WriteDeltaFrame(frame, timestampUs, changedTiles)
+        : WriteRawFrame(frame, timestampUs);
+    if (ok) {
+        ++frameCount;
+    }
+    return ok;
+}
+
+bool TraceWriter::WriteRawFrame(const FrameView& frame, int64_t timestampUs) {
+    TraceFrameHeader frameHeader = {};
+    frameHeader.timestampUs = timestampUs;
+    if (!WriteBytes(&frameHeader, sizeof(frameHeader))) {
+        return false;
+    }
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    for (int y = 0; y < height; ++y) {
+        if (!WriteBytes(frame.Row(y), rowBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to append one tile record (index, size, RLE pixels) to the frame payload
+void TraceWriter::EncodeTile(const FrameView& frame, int tileIndex) {
+    const int tileSize = options.tileSize;
+    int left = (tileIndex % cols) * tileSize;
+    int top = (tileIndex / cols) * tileSize;
+    int tileWidth = std::min(tileSize, width - left);
+    int tileHeight = std::min(tileSize, height - top);
+    for (int y = 0; y < tileHeight; ++y) {
+        memcpy(&tilePixels[static_cast<size_t>(y) * tileWidth], frame.Row(top + y) + static_cast<size_t>(left) * 4, static_cast<size_t>(tileWidth) * 4);
+    }
+
+    size_t count = static_cast<size_t>(tileWidth) * tileHeight;
+    size_t start = payload.size();
+    payload.resize(start + 8 + RleMaxEncodedSize(count));
+    uint32_t encodedBytes = static_cast<uint32_t>(RleEncodePixels(tilePixels.data(), count, &payload[start + 8]));
+    uint32_t tileHeader[2] = { static_cast<uint32_t>(tileIndex), encodedBytes };
+    memcpy(&payload[start], tileHeader, sizeof(tileHeader));
+    payload.resize(start + 8 + encodedBytes);
+    ++payloadTiles;
+}
+
+bool TraceWriter::WriteDeltaFrame(const FrameView& frame, int64_t timestampUs, const TileMap* changedTiles) {
+    bool keyframe = frameCount % static_cast<uint32_t>(options.keyframeInterval) == 0;
+    bool useTileMap = changedTiles && changedTiles->tileSize == options.tileSize
+        && changedTiles->width == width && changedTiles->height == height;
+    payload.clear();
+    payloadTiles = 0;
+
+    if (useTileMap) {
+        // The detector already knows which tiles changed; the stored hashes go stale
+        for (int i = 0; i < cols * rows; ++i) {
+            if (keyframe || changedTiles->dirty[i]) {
+                EncodeTile(frame, i);
+            }
+        }
+        hashesValid = false;
+    } else {
+        for (int ty = 0; ty < rows; ++ty) {
+            HashTileRow(frame, options.tileSize, ty, rowHashes.data());
+            uint32_t* stored = &tileHashes[static_cast<size_t>(ty) * cols];
+            for (int tx = 0; tx < cols; ++tx) {
+                if (keyframe || !hashesValid || rowHashes[tx] != stored[tx]) {
+                    EncodeTile(frame, ty * cols + tx);
+                }
+                stored[tx] = rowHashes[tx];
+            }
+        }
+        hashesValid = true;
+    }
+
+    TraceIndexEntry entry = {};
+    entry.offset = offset;
+    entry.timestampUs = timestampUs;
+    entry.flags = keyframe ? kTraceFrameKeyframe : 0;
+
+    TraceDeltaFrameHeader frameHeader = {};
+    frameHeader.timestampUs = timestampUs;
+    frameHeader.flags = entry.flags;
+    frameHeader.tileCount = payloadTiles;
+    frameHeader.payloadBytes = static_cast<uint32_t>(payload.size());
+    if (!WriteBytes(&frameHeader, sizeof(frameHeader)) || !WriteBytes(payload.data(), payload.size())) {
+        return false;
+    }
+    index.push_back(entry);
+    return true;
+}
+
+// Function to write the index and final frame count and close the file
+bool TraceWriter::Close() {
+    if (!file) {
+        return true;
+    }
+    bool ok = true;
+    uint64_t indexOffset = 0;
+    if (options.encoding == TraceEncoding::DeltaTiles) {
+        indexOffset = offset;
+        ok = index.empty() || WriteBytes(index.data(), index.size() * sizeof(TraceIndexEntry));
+    }
+    ok = ok && fseek(file, offsetof(TraceHeader, frameCount), SEEK_SET) == 0
+        && fwrite(&frameCount, sizeof(frameCount), 1, file) == 1;
+    if (ok && options.encoding == TraceEncoding::DeltaTiles) {
+        ok = fseek(file, offsetof(TraceHeader, indexOffset), SEEK_SET) == 0
+            && fwrite(&indexOffset, sizeof(indexOffset), 1, file) == 1;
+    }
+    ok = fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+// Function to map and validate a trace file
+bool ReplayFrameSource::Open(const char* path) {
+    nextIndex = 0;
+    clockStarted = false;
+    needsResync = true;
+    if (!file.Open(path) || file.Size() < sizeof(TraceHeader)) {
+        return false;
+    }
+    memcpy(&header, file.Data(), sizeof(header));
+    bool valid = memcmp(header.magic, kTraceMagic, sizeof(header.magic)) == 0
+        && (header.version == kTraceVersionRaw || header.version == kTraceVersionDelta)
+        && header.pixelFormat == 0 && header.width != 0 && header.height != 0;
+    if (valid && header.version == kTraceVersionRaw) {
+        frameStride = sizeof(TraceFrameHeader) + static_cast<size_t>(header.width) * header.height * 4;
+        // Trust the file size over the header so traces from an interrupted recording still replay
+        size_t framesInFile = (file.Size() - sizeof(TraceHeader)) / frameStride;
+        frameCount = header.frameCount == 0 || header.frameCount > framesInFile
+            ? static_cast<uint32_t>(framesInFile) : header.frameCount;
+    } else if (valid) {
+        valid = header.tileSize > 0 && LoadIndex();
+        if (valid) {
+            cols = static_cast<int>((header.width + header.tileSize - 1) / header.tileSize);
+            rows = static_cast<int>((header.height + header.tileSize - 1) / header.tileSize);
+            size_t frameBytes = static_cast<size_t>(header.width) * header.height * 4;
+            buffers[0].assign(frameBytes, 0);
+            buffers[1].assign(frameBytes, 0);
+            tilePixels.resize(static_cast<size_t>(header.tileSize) * header.tileSize);
+            // Room for every tile, so busy frames do not grow the change lists mid-replay
+            frontChanged.reserve(static_cast<size_t>(cols) * rows);
+            decodeChanged.reserve(static_cast<size_t>(cols) * rows);
+        }
+    }
+    if (!valid) {
+        file.Close();
+    }
+    return valid;
+}
+
+// Function to read the keyframe index, or rebuild it by walking the frame records if the
+// recording was interrupted before the index was written
+bool ReplayFrameSource::LoadIndex() {
+    const uint8_t* data = file.Data();
+    size_t size = file.Size();
+    index.clear();
+    if (header.indexOffset != 0 && header.frameCount != 0
+        && header.indexOffset + static_cast<uint64_t>(header.frameCount) * sizeof(TraceIndexEntry) <= size) {
+        index.resize(header.frameCount);
+        memcpy(index.data(), data + header.indexOffset, index.size() * sizeof(TraceIndexEntry));
+    } else {
+        size_t offset = sizeof(TraceHeader);
+        while (offset + sizeof(TraceDeltaFrameHeader) <= size) {
+            TraceDeltaFrameHeader frameHeader;
+            memcpy(&frameHeader, data + offset, sizeof(frameHeader));
+            size_t next = offset + sizeof(frameHeader) + frameHeader.payloadBytes;
+            if (next > size) {
+                break;
+            }
+            TraceIndexEntry entry = {};
+            entry.offset = offset;
+            entry.timestampUs = frameHeader.timestampUs;
+            entry.flags = frameHeader.flags;
+            index.push_back(entry);
+            offset = next;
+        }
+    }
+    frameCount = static_cast<uint32_t>(index.size());
+    return true;
+}
+
+// Function to make the next NextFrame call return frame `index`
+bool ReplayFrameSource::Seek(uint32_t frameIndex) {
+    if (frameIndex >= frameCount) {
+        return false;
+    }
+    nextIndex = frameIndex;
+    needsResync = true;
+    clockStarted = false;
+    return true;
+}
+
+void ReplayFrameSource::WaitForTimestamp(int64_t timestampUs) {
+    if (pacing != ReplayPacing::Recorded) {
+        return;
+    }
+    if (!clockStarted) {
+        clockStarted = true;
+        startTime = std::chrono::steady_clock::now();
+        startTimestampUs = timestampUs;
+        return;
+    }
+    std::this_thread::sleep_until(startTime + std::chrono::microseconds(timestampUs - startTimestampUs));
+}
+
+// Function to decode the tiles of delta frame `frameIndex` over `pixels`, optionally listing them
+bool ReplayFrameSource::ApplyDeltaFrame(uint32_t frameIndex, uint8_t* pixels, std::vector<uint32_t>* changed) {
+    const TraceIndexEntry& entry = index[frameIndex];
+    if (entry.offset + sizeof(TraceDeltaFrameHeader) > file.Size()) {
+        return false;
+    }
+    const uint8_t* record = file.Data() + entry.offset;
+    TraceDeltaFrameHeader frameHeader;
+    memcpy(&frameHeader, record, sizeof(frameHeader));
+    const uint8_t* cursor = record + sizeof(frameHeader);
+    const uint8_t* end = cursor + frameHeader.payloadBytes;
+    if (end > file.Data() + file.Size()) {
+        return false;
+    }
+
+    const int tileSize = static_cast<int>(header.tileSize);
+    const size_t pitch = static_cast<size_t>(header.width) * 4;
+    for (uint32_t t = 0; t < frameHeader.tileCount; ++t) {
+        uint32_t tileHeader[2];
+        if (end - cursor < 8) {
+            return false;
+        }
+        memcpy(tileHeader, cursor, sizeof(tileHeader));
+        cursor += 8;
+        uint32_t tileIndex = tileHeader[0];
+        if (tileIndex >= static_cast<uint32_t>(cols * rows) || tileHeader[1] > static_cast<size_t>(end - cursor)) {
+            return false;
+        }
+        int left = static_cast<int>(tileIndex % cols) * tileSize;
+        int top = static_cast<int>(tileIndex / cols) * tileSize;
+        int tileWidth = std::min(tileSize, Width() - left);
+        int tileHeight = std::min(tileSize, Height() - top);
+        if (!RleDecodePixels(cursor, tileHeader[1], tilePixels.data(), static_cast<size_t>(tileWidth) * tileHeight)) {
+            return false;
+        }
+        cursor += tileHeader[1];
+        for (int y = 0; y < tileHeight; ++y) {
+            memcpy(pixels + (top + y) * pitch + static_cast<size_t>(left) * 4, &tilePixels[static_cast<size_t>(y) * tileWidth], static_cast<size_t>(tileWidth) * 4);
+        }
+        if (changed) {
+            changed->push_back(tileIndex);
+        }
+    }
+    return true;
+}
+
+// Function to rebuild delta frame `frameIndex` into the back buffer and make it the front one
+bool ReplayFrameSource::DecodeDeltaFrame(uint32_t frameIndex) {
+    int back = 1 - front;
+    uint8_t* target = buffers[back].data();
+    const uint8_t* source = buffers[front].data();
+
+    if (needsResync) {
+        // Random access: replay from the closest keyframe at or before the requested frame
+        uint32_t keyframe = frameIndex;
+        while (keyframe > 0 && !(index[keyframe].flags & kTraceFrameKeyframe)) {
+            --keyframe;
+        }
+        for (uint32_t i = keyframe; i <= frameIndex; ++i) {
+            if (!ApplyDeltaFrame(i, target, nullptr)) {
+                return false;
+            }
+        }
+        needsResync = false;
+        backStale = true;
+        frontChanged.clear();
+    } else {
+        // The back buffer still holds the frame before the front one; bring it up to date
+        // with the tiles that changed in the front frame, then apply this frame's tiles
+        if (backStale) {
+            memcpy(target, source, buffers[back].size());
+        } else {
+            const int tileSize = static_cast<int>(header.tileSize);
+            const size_t pitch = static_cast<size_t>(header.width) * 4;
+            for (uint32_t tileIndex : frontChanged) {
+                int left = static_cast<int>(tileIndex % cols) * tileSize;
+                int top = static_cast<int>(tileIndex / cols) * tileSize;
+                size_t bytes = static_cast<size_t>(std::min(tileSize, Width() - left)) * 4;
+                for (int y = top; y < std::min(top + tileSize, Height()); ++y) {
+                    memcpy(target + y * pitch + static_cast<size_t>(left) * 4, source + y * pitch + static_cast<size_t>(left) * 4, bytes);
+                }
+            }
+        }
+        decodeChanged.clear();
+        if (!ApplyDeltaFrame(frameIndex, target, &decodeChanged)) {
+            needsResync = true;
+            return false;
+        }
+        frontChanged.swap(decodeChanged);
+        backStale = false;
+    }
+    front = back;
+    return true;
+}
+
+bool ReplayFrameSource::NextFrame(Frame& frame) {
+    if (!file.IsOpen() || nextIndex >= frameCount) {
+        return false;
+    }
+    frame.view.width = Width();
+    frame.view.height = Height();
+    frame.view.rowPitch = Width() * 4;
+    frame.index = nextIndex;
+
+    if (header.version == kTraceVersionRaw) {
+        const uint8_t* record = file.Data() + sizeof(TraceHeader) + frameStride * nextIndex;
+        TraceFrameHeader frameHeader;
+        memcpy(&frameHeader, record, sizeof(frameHeader));
+        WaitForTimestamp(frameHeader.timestampUs);
+        frame.view.pixels = record + sizeof(TraceFrameHeader);
+        frame.timestampUs = frameHeader.timestampUs;
+    } else {
+        WaitForTimestamp(index[nextIndex].timestampUs);
+        if (!DecodeDeltaFrame(nextIndex)) {
+            return false;
+        }
+        frame.view.pixels = buffers[front].data();
+        frame.timestampUs = index[nextIndex].timestampUs;
+    }
+    ++nextIndex;
+    return true;
+}
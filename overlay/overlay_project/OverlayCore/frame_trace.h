@@ -0,0 +1,190 @@
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include "frame_source.h"
+#include "mapped_file.h"
+#include "tile_map.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Trace files start with a 64-byte TraceHeader, little endian. Two encodings exist.
+//
+// Version 1, raw:
+//   frameCount x { TraceFrameHeader (16 bytes), width * height * 4 bytes of BGRA, rows tightly packed }
+//   Frames have a fixed stride, so frame i starts at sizeof(TraceHeader) + i * stride.
+//
+// Version 2, delta-compressed tiles:
+//   frameCount x { TraceDeltaFrameHeader (24 bytes), payloadBytes of tile records }
+//   TraceIndexEntry x frameCount, starting at header.indexOffset
+//
+//   A tile record is { uint32 tileIndex, uint32 encodedBytes, encodedBytes of RLE pixels (trace_codec.h) }
+//   covering the tile's pixels row by row. Keyframes carry every tile, other frames only the tiles
+//   that changed since the previous frame. The index lets readers seek to the nearest keyframe.
+//
+// A frameCount of 0 means the writer did not finish; readers then recover the frames from the file.
+const char kTraceMagic[8] = { 'O', 'V', 'L', 'T', 'R', 'A', 'C', 'E' };
+const uint32_t kTraceVersionRaw = 1;
+const uint32_t kTraceVersionDelta = 2;
+const uint32_t kTraceFrameKeyframe = 1;
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelFormat;  // 0 = BGRA8
+    uint32_t frameCount;
+    uint32_t tileSize;          // version 2
+    uint32_t keyframeInterval;  // version 2
+    uint32_t reserved0;
+    uint64_t indexOffset;       // version 2
+    uint32_t reserved[4];
+};
+
+struct TraceFrameHeader {
+    int64_t timestampUs;
+    uint64_t reserved;
+};
+
+struct TraceDeltaFrameHeader {
+    int64_t timestampUs;
+    uint32_t flags;
+    uint32_t tileCount;
+    uint32_t payloadBytes;
+    uint32_t reserved;
+};
+
+struct TraceIndexEntry {
+    uint64_t offset;
+    int64_t timestampUs;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TraceHeader) == 64, "TraceHeader layout changed");
+static_assert(sizeof(TraceFrameHeader) == 16, "TraceFrameHeader layout changed");
+static_assert(sizeof(TraceDeltaFrameHeader) == 24, "TraceDeltaFrameHeader layout changed");
+static_assert(sizeof(TraceIndexEntry) == 24, "TraceIndexEntry layout changed");
+
+// Frame storage used by a trace
+enum class TraceEncoding {
+    Raw,
+    DeltaTiles
+};
+
+struct TraceWriterOptions {
+    TraceEncoding encoding = TraceEncoding::Raw;
+    // DeltaTiles only: tile grid, which should match the detector's so its change map can be reused
+    int tileSize = 16;
+    // DeltaTiles only: a full frame is stored every this many frames
+    int keyframeInterval = 300;
+};
+
+// Appends frames to a trace file
+class TraceWriter {
+public:
+    ~TraceWriter();
+
+    // Function to create a trace for frames of the given size, replacing any existing file
+    bool Open(const char* path, int width, int height, const TraceWriterOptions& options = TraceWriterOptions());
+
+    // Function to append a frame; it must match the size given to Open. For delta traces,
+    // `changedTiles` may be an exact change map: every tile whose pixels differ from the last
+    // written frame is marked (a MotionDetector's tiles when TilesAreExact). Only those tiles are
+    // encoded, so a missed change stays in the trace until the next keyframe. Without it, changes
+    // are found from tile hashes.
+    bool WriteFrame(const FrameView& frame, int64_t timestampUs, const TileMap* changedTiles = nullptr);
+
+    // Function to write the index and final frame count and close the file
+    bool Close();
+
+    bool IsOpen() const { return file != nullptr; }
+    uint32_t FrameCount() const { return frameCount; }
+    uint64_t BytesWritten() const { return offset; }
+
+private:
+    bool WriteBytes(const void* data, size_t size);
+    bool WriteRawFrame(const FrameView& frame, int64_t timestampUs);
+    bool WriteDeltaFrame(const FrameView& frame, int64_t timestampUs, const TileMap* changedTiles);
+    void EncodeTile(const FrameView& frame, int tileIndex);
+
+    FILE* file = nullptr;
+    TraceWriterOptions options;
+    int width = 0;
+    int height = 0;
+    int cols = 0;
+    int rows = 0;
+    uint32_t frameCount = 0;
+    uint64_t offset = 0;
+
+    std::vector<TraceIndexEntry> index;
+    std::vector<uint32_t> tileHashes;
+    std::vector<uint32_t> rowHashes;
+    bool hashesValid = false;
+    std::vector<uint32_t> tilePixels;
+    std::vector<uint8_t> payload;
+    uint32_t payloadTiles = 0;
+};
+
+// How fast a replay hands out frames
+enum class ReplayPacing {
+    // As fast as the consumer asks for them
+    FullSpeed,
+    // Sleep so frames are returned at their recorded timestamps
+    Recorded
+};
+
+// Replays a trace file from a memory mapping. Raw frames are returned straight from the mapping;
+// delta frames are rebuilt into two alternating buffers by copying only the tiles that differ.
+class ReplayFrameSource : public FrameSource {
+public:
+    // Function to map and validate a trace file
+    bool Open(const char* path);
+
+    void SetPacing(ReplayPacing newPacing) { pacing = newPacing; }
+
+    // Function to make the next NextFrame call return frame `index`
+    bool Seek(uint32_t index);
+
+    bool NextFrame(Frame& frame) override;
+
+    int Width() const { return static_cast<int>(header.width); }
+    int Height() const { return static_cast<int>(header.height); }
+    uint32_t FrameCount() const { return frameCount; }
+    TraceEncoding Encoding() const { return header.version == kTraceVersionDelta ? TraceEncoding::DeltaTiles : TraceEncoding::Raw; }
+
+private:
+    bool LoadIndex();
+    bool ApplyDeltaFrame(uint32_t index, uint8_t* pixels, std::vector<uint32_t>* changed);
+    bool DecodeDeltaFrame(uint32_t index);
+    void WaitForTimestamp(int64_t timestampUs);
+
+    MappedFile file;
+    TraceHeader header = {};
+    uint32_t frameCount = 0;
+    uint32_t nextIndex = 0;
+    ReplayPacing pacing = ReplayPacing::FullSpeed;
+    bool clockStarted = false;
+    std::chrono::steady_clock::time_point startTime;
+    int64_t startTimestampUs = 0;
+
+    // Raw traces
+    size_t frameStride = 0;
+
+    // Delta traces
+    int cols = 0;
+    int rows = 0;
+    std::vector<TraceIndexEntry> index;
+    std::vector<uint8_t> buffers[2];
+    int front = 0;
+    bool needsResync = true;
+    bool backStale = true;
+    std::vector<uint32_t> frontChanged;
+    std::vector<uint32_t> decodeChanged;
+    std::vector<uint32_t> tilePixels;
+};
+
+#endif // FRAME_TRACE_H
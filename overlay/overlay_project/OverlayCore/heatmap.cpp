@@ -0,0 +1,168 @@
+#include "heatmap.h"
+#include "heatmap_kernels.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+// Portable reference kernel; the decay is rounded up so a quiet tile always fades back to zero
+// instead of stalling below 2^shift
+void HeatRowScalar(uint32_t* heat, const uint8_t* changed, size_t count, int shift, uint32_t gain) {
+    const uint32_t round = (1u << shift) - 1;
+    for (size_t i = 0; i < count; ++i) {
+        heat[i] = heat[i] - ((heat[i] + round) >> shift) + (changed[i] ? gain : 0);
+    }
+}
+
+// Function to get the heat update function for a kernel (falls back to scalar if unsupported)
+HeatRowFunc GetHeatRowFunc(DiffKernel kernel) {
+    if (!IsDiffKernelSupported(kernel)) {
+        return HeatRowScalar;
+    }
+    switch (kernel) {
+#if defined(OVERLAY_ARCH_X86)
+    // The tile grid is small enough to stay in L1, so AVX2 would gain little over SSE2
+    case DiffKernel::SSE2:
+    case DiffKernel::AVX2:
+        return HeatRowSSE2;
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    case DiffKernel::NEON:
+        return HeatRowNEON;
+#endif
+    default:
+        return HeatRowScalar;
+    }
+}
+
+Heatmap::Heatmap(const HeatmapConfig& heatmapConfig, DiffKernel kernel)
+    : config(heatmapConfig), heatRow(GetHeatRowFunc(kernel)) {
+    config.decayShift = std::max(8, std::min(config.decayShift, 24));
+    config.snapshotInterval = std::max(1, config.snapshotInterval);
+    // Heat never exceeds gain << shift, so adding the rounding term stays below 2^32
+    gain = (0xFFFFFFFFu >> config.decayShift) - 1;
+}
+
+// Function to fold one detected frame into the heat
+void Heatmap::Update(const TileMap& tiles, const TileActivity* activity) {
+    if (tiles.cols != cols || tiles.rows != rows || tiles.tileSize != tileSize) {
+        cols = tiles.cols;
+        rows = tiles.rows;
+        tileSize = tiles.tileSize;
+        frames = 0;
+        heat.assign(tiles.dirty.size(), 0);
+        changed.assign(tiles.dirty.size(), 0);
+        // Size all three snapshots up front so steady-state publishing never allocates. With
+        // exporters locked out no other thread owns a buffer, so only a grid change waits for an
+        // export in progress.
+        std::lock_guard<std::mutex> lock(exportMutex);
+        for (HeatmapSnapshot& snapshot : snapshots) {
+            snapshot.heat.reserve(heat.size());
+        }
+    }
+    const uint8_t* flags = tiles.dirty.data();
+    if (activity && activity->DemotedCount() != 0 && activity->Demoted().size() == tiles.dirty.size()) {
+        const std::vector<uint8_t>& demoted = activity->Demoted();
+        for (size_t i = 0; i < changed.size(); ++i) {
+            changed[i] = tiles.dirty[i] | demoted[i];
+        }
+        flags = changed.data();
+    }
+    heatRow(heat.data(), flags, heat.size(), config.decayShift, gain);
+    ++frames;
+    if (frames % config.snapshotInterval == 0) {
+        Publish();
+    }
+}
+
+// Function to copy the heat into the detect thread's snapshot and exchange it for the middle
+// one, which becomes the next to fill whether or not an exporter took it
+void Heatmap::Publish() {
+    if (frames == 0) {
+        return;
+    }
+    HeatmapSnapshot& snapshot = snapshots[back];
+    snapshot.cols = cols;
+    snapshot.rows = rows;
+    snapshot.tileSize = tileSize;
+    snapshot.frames = frames;
+    snapshot.heat.assign(heat.begin(), heat.end());
+    back = middle.exchange(back | kFreshSnapshot, std::memory_order_acq_rel) & ~kFreshSnapshot;
+}
+
+// Function to copy the latest published snapshot, taking the middle buffer first if the detect
+// thread published since the last export
+bool Heatmap::CopySnapshot(HeatmapSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(exportMutex);
+    if (middle.load(std::memory_order_relaxed) & kFreshSnapshot) {
+        front = middle.exchange(front, std::memory_order_acq_rel) & ~kFreshSnapshot;
+    }
+    // Publish skips frame 0, so a snapshot that never held heat has no frames
+    if (snapshots[front].frames == 0) {
+        return false;
+    }
+    snapshot = snapshots[front];
+    return true;
+}
+
+// Function to write the latest snapshot as an 8-bit binary PGM image with one pixel per tile
+bool Heatmap::WritePgm(const char* path) {
+    // The file is written from a copy so concurrent exports only wait out the copy
+    HeatmapSnapshot snapshot;
+    if (!CopySnapshot(snapshot)) {
+        return false;
+    }
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    uint32_t hottest = 0;
+    for (uint32_t value : snapshot.heat) {
+        hottest = std::max(hottest, value);
+    }
+    std::vector<uint8_t> pixels(snapshot.heat.size(), 0);
+    if (hottest != 0) {
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = static_cast<uint8_t>((static_cast<uint64_t>(snapshot.heat[i]) * 255 + hottest / 2) / hottest);
+        }
+    }
+    bool ok = fprintf(file, "P5\n%d %d\n255\n", snapshot.cols, snapshot.rows) > 0 &&
+              fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+    return fclose(file) == 0 && ok;
+}
+
+// Function to write the latest snapshot in the binary heatmap format
+bool Heatmap::WriteBinary(const char* path) {
+    HeatmapSnapshot snapshot;
+    if (!CopySnapshot(snapshot)) {
+        return false;
+    }
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    HeatmapFileHeader header = {};
+    memcpy(header.magic, kHeatmapMagic, sizeof(header.magic));
+    header.version = kHeatmapVersion;
+    header.cols = static_cast<uint32_t>(snapshot.cols);
+    header.rows = static_cast<uint32_t>(snapshot.rows);
+    header.tileSize = static_cast<uint32_t>(snapshot.tileSize);
+    header.decayShift = static_cast<uint32_t>(config.decayShift);
+    header.frames = snapshot.frames;
+    std::vector<uint16_t> values(snapshot.heat.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<uint16_t>(snapshot.heat[i] >> 16);
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(values.data(), sizeof(uint16_t), values.size(), file) == values.size();
+    return fclose(file) == 0 && ok;
+}
+
+// Function to write a PGM image if `path` ends in .pgm, the binary format otherwise
+bool Heatmap::Write(const char* path) {
+    size_t length = strlen(path);
+    bool pgm = length >= 4 && path[length - 4] == '.' && tolower(static_cast<unsigned char>(path[length - 3])) == 'p' &&
+               tolower(static_cast<unsigned char>(path[length - 2])) == 'g' && tolower(static_cast<unsigned char>(path[length - 1])) == 'm';
+    return pgm ? WritePgm(path) : WriteBinary(path);
+}
@@ -0,0 +1,115 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "frame_diff.h"
+#include "tile_activity.h"
+#include "tile_map.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Heatmap files written by Heatmap::WriteBinary start with a 40-byte HeatmapFileHeader, little
+// endian, followed by cols * rows uint16 heat values in row-major tile order. A value is the
+// tile's heat >> 16: 65535 for a tile that changed in every recent frame, 0 for one that never did.
+const char kHeatmapMagic[8] = { 'O', 'V', 'L', 'H', 'E', 'A', 'T', 'M' };
+const uint32_t kHeatmapVersion = 1;
+
+struct HeatmapFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t tileSize;
+    uint32_t decayShift;
+    uint32_t reserved;
+    uint64_t frames;
+};
+
+// Settings for Heatmap
+struct HeatmapConfig {
+    // Every frame each tile's heat loses 1/2^decayShift of itself, so a change is remembered for
+    // about 2^decayShift frames: 65536 by default, about 18 minutes at 60 fps (8 to 24)
+    int decayShift = 16;
+    // Frames between the snapshots handed to exporters
+    int snapshotInterval = 30;
+};
+
+// Copy of the heat of every tile at one frame
+struct HeatmapSnapshot {
+    int cols = 0;
+    int rows = 0;
+    int tileSize = 0;
+    // Frames accumulated when the snapshot was taken
+    uint64_t frames = 0;
+    // Per tile, the exponentially weighted share of recent frames it changed in, as 0.32 fixed point
+    std::vector<uint32_t> heat;
+};
+
+// Decays `count` heat values by 1/2^shift, rounded up, and adds `gain` to those whose `changed` flag is non-zero
+typedef void (*HeatRowFunc)(uint32_t* heat, const uint8_t* changed, size_t count, int shift, uint32_t gain);
+
+// Function to get the heat update function for a kernel (falls back to scalar if unsupported)
+HeatRowFunc GetHeatRowFunc(DiffKernel kernel);
+
+// Accumulates where on screen changes happen over long runs. Each frame every tile's heat decays
+// exponentially and the tiles the detector marked dirty gain a fixed amount, in 32-bit fixed point
+// with SIMD kernels, so the cost per frame is one pass over the tile grid. The detect thread
+// updates the heat; every snapshotInterval frames it copies it into the buffer it owns of three
+// snapshot buffers and publishes it with one atomic index exchange. Exporters take the latest
+// published buffer the same way, so the detect thread never takes a lock or waits for an export
+// (only a change of tile grid locks out exporters while the buffers are resized).
+class Heatmap {
+public:
+    explicit Heatmap(const HeatmapConfig& config = HeatmapConfig(), DiffKernel kernel = SelectDiffKernel());
+
+    const HeatmapConfig& Config() const { return config; }
+
+    // Function to fold one detected frame into the heat; tiles demoted by `activity` count as
+    // changed. Restarts from zero when the tile grid changes size. Detect thread only.
+    void Update(const TileMap& tiles, const TileActivity* activity = nullptr);
+
+    // Function to hand the current heat to exporters now rather than at the next interval, e.g.
+    // once the last frame was detected. Detect thread only.
+    void Publish();
+
+    // Function to copy the latest published snapshot; safe from any thread. Returns false if
+    // none has been published yet.
+    bool CopySnapshot(HeatmapSnapshot& snapshot);
+
+    // Function to write the latest snapshot as an 8-bit binary PGM image with one pixel per tile,
+    // scaled so the hottest tile is white; safe from any thread
+    bool WritePgm(const char* path);
+
+    // Function to write the latest snapshot in the binary format above; safe from any thread
+    bool WriteBinary(const char* path);
+
+    // Function to write a PGM image if `path` ends in .pgm, the binary format otherwise
+    bool Write(const char* path);
+
+private:
+    HeatmapConfig config;
+    HeatRowFunc heatRow;
+    uint32_t gain = 0;
+    int cols = 0;
+    int rows = 0;
+    int tileSize = 0;
+    uint64_t frames = 0;
+    std::vector<uint32_t> heat;
+    // Dirty tiles merged with the demoted ones, when tiles are demoted
+    std::vector<uint8_t> changed;
+
+    // Triple buffer: the detect thread fills snapshots[back] and exchanges it for the one in
+    // `middle`, marked fresh; an exporter holding the mutex exchanges snapshots[front] for a
+    // fresh middle one. Each buffer has one owner at a time, so only the index exchange is shared.
+    static const int kFreshSnapshot = 4;
+    std::mutex exportMutex;
+    HeatmapSnapshot snapshots[3];
+    int back = 0;
+    std::atomic<int> middle{ 1 };
+    // Guarded by exportMutex
+    int front = 2;
+};
+
+#endif // HEATMAP_H
@@ -0,0 +1,17 @@
+#ifndef HEATMAP_KERNELS_H
+#define HEATMAP_KERNELS_H
+
+// Internal: per-ISA heat update kernels behind HeatRowFunc, each built with its own flags.
+
+#include "cpu_features.h"
+#include "heatmap.h"
+
+void HeatRowScalar(uint32_t* heat, const uint8_t* changed, size_t count, int shift, uint32_t gain);
+#if defined(OVERLAY_ARCH_X86)
+void HeatRowSSE2(uint32_t* heat, const uint8_t* changed, size_t count, int shift, uint32_t gain);
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+void HeatRowNEON(uint32_t* heat, const uint8_t* changed, size_t count, int shift, uint32_t gain);
+#endif
+
+#endif // HEATMAP_KERNELS_H
@@ -0,0 +1,31 @@
+#include "heatmap_kernels.h"
+
+#if defined(OVERLAY_ARCH_NEON)
+#include <arm_neon.h>
+
+// Sixteen tiles per step: VTST turns the change flags into 0xFF bytes, sign extension widens
+// them to 32-bit lane masks, and a negative VSHL count shifts right by a runtime amount
+void HeatRowNEON(uint32_t* heat, const uint8_t* changed, size_t count, int shift, uint32_t gain) {
+    const uint32x4_t gains = vdupq_n_u32(gain);
+    const uint32x4_t round = vdupq_n_u32((1u << shift) - 1);
+    const int32x4_t shiftRight = vdupq_n_s32(-shift);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t flags = vld1q_u8(changed + i);
+        int8x16_t set = vreinterpretq_s8_u8(vtstq_u8(flags, flags));
+        int16x8_t setLow = vmovl_s8(vget_low_s8(set));
+        int16x8_t setHigh = vmovl_s8(vget_high_s8(set));
+        uint32x4_t masks[4] = { vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(setLow))), vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(setLow))),
+                                vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(setHigh))), vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(setHigh))) };
+        for (int j = 0; j < 4; ++j) {
+            uint32_t* lane = heat + i + j * 4;
+            uint32x4_t value = vld1q_u32(lane);
+            value = vsubq_u32(value, vshlq_u32(vaddq_u32(value, round), shiftRight));
+            value = vaddq_u32(value, vandq_u32(masks[j], gains));
+            vst1q_u32(lane, value);
+        }
+    }
+    HeatRowScalar(heat + i, changed + i, count - i, shift, gain);
+}
+
+#endif
@@ -0,0 +1,31 @@
+#include "heatmap_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include <emmintrin.h>
+
+// Sixteen tiles per step: the change flags are compared with zero and widened to 32-bit lane
+// masks by unpacking them with themselves, so the gain is added without branches
+void HeatRowSSE2(uint32_t* heat, const uint8_t* changed, size_t count, int shift, uint32_t gain) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i gains = _mm_set1_epi32(static_cast<int>(gain));
+    const __m128i round = _mm_set1_epi32((1 << shift) - 1);
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i quiet = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(changed + i)), zero);
+        __m128i quietLow = _mm_unpacklo_epi8(quiet, quiet);
+        __m128i quietHigh = _mm_unpackhi_epi8(quiet, quiet);
+        __m128i masks[4] = { _mm_unpacklo_epi16(quietLow, quietLow), _mm_unpackhi_epi16(quietLow, quietLow),
+                             _mm_unpacklo_epi16(quietHigh, quietHigh), _mm_unpackhi_epi16(quietHigh, quietHigh) };
+        for (int j = 0; j < 4; ++j) {
+            __m128i* lane = reinterpret_cast<__m128i*>(heat + i + j * 4);
+            __m128i value = _mm_loadu_si128(lane);
+            value = _mm_sub_epi32(value, _mm_srl_epi32(_mm_add_epi32(value, round), shiftCount));
+            value = _mm_add_epi32(value, _mm_andnot_si128(masks[j], gains));
+            _mm_storeu_si128(lane, value);
+        }
+    }
+    HeatRowScalar(heat + i, changed + i, count - i, shift, gain);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "luma_pyramid.h"
+#include "luma_pyramid_kernels.h"
+
+#include <algorithm>
+
+// Function to sum every BGRA byte of a block of `columns` pixels by `rows` rows
+template <class Traits>
+static uint16_t BlockSum(const uint8_t* pixels, int rowPitch, int rows, int columns) {
+    uint32_t sum = 0;
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * rowPitch;
+        for (int x = 0; x < columns; ++x) {
+            uint8_t bgra[4];
+            Traits::ToBgra8(row + x * Traits::kBytesPerPixel, bgra);
+            sum += bgra[0] + bgra[1] + bgra[2] + bgra[3];
+        }
+    }
+    return static_cast<uint16_t>(sum);
+}
+
+template <class Traits>
+void LumaCellRowScalar(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums) {
+    for (int cx = 0; cx < cells; ++cx) {
+        sums[cx] = BlockSum<Traits>(pixels + static_cast<size_t>(cx) * cellSize * Traits::kBytesPerPixel, rowPitch, rows, cellSize);
+    }
+}
+
+// Function to get the fastest cell row implementation for one pixel format
+template <class Traits>
+static LumaCellRowFunc GetLumaCellRowFuncFor() {
+    const CpuFeatures& cpu = GetCpuFeatures();
+#if defined(OVERLAY_ARCH_X86)
+    if (cpu.sse2) return LumaCellRowSSE2<Traits>;
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    if (cpu.neon) return LumaCellRowNEON<Traits>;
+#endif
+    (void)cpu;
+    return LumaCellRowScalar<Traits>;
+}
+
+// Function to get the fastest cell row implementation for this CPU and a pixel format
+LumaCellRowFunc GetLumaCellRowFunc(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGB10A2:
+        return GetLumaCellRowFuncFor<Rgb10A2Traits>();
+    case PixelFormat::RGBA16F:
+        return GetLumaCellRowFuncFor<Rgba16FTraits>();
+    default:
+        return GetLumaCellRowFuncFor<Bgra8Traits>();
+    }
+}
+
+// Function to downsample cell row `cy` of a frame into sums[0..cols)
+void DownsampleLumaRow(const FrameView& frame, int cellSize, int cy, uint16_t* sums) {
+    typedef uint16_t (*BlockSumFunc)(const uint8_t* pixels, int rowPitch, int rows, int columns);
+    // Indexed by PixelFormat
+    static const LumaCellRowFunc cellRows[] = { GetLumaCellRowFunc(PixelFormat::BGRA8), GetLumaCellRowFunc(PixelFormat::RGB10A2),
+                                                GetLumaCellRowFunc(PixelFormat::RGBA16F) };
+    static const BlockSumFunc blockSums[] = { BlockSum<Bgra8Traits>, BlockSum<Rgb10A2Traits>, BlockSum<Rgba16FTraits> };
+    int format = static_cast<int>(frame.format);
+    int top = cy * cellSize;
+    int rows = std::min(cellSize, frame.height - top);
+    int wholeCells = frame.width / cellSize;
+    const uint8_t* pixels = frame.Row(top);
+    cellRows[format](pixels, frame.rowPitch, rows, wholeCells, cellSize, sums);
+    int remainder = frame.width - wholeCells * cellSize;
+    if (remainder > 0) {
+        sums[wholeCells] = blockSums[format](pixels + static_cast<size_t>(wholeCells) * cellSize * frame.BytesPerPixel(), frame.rowPitch, rows, remainder);
+    }
+}
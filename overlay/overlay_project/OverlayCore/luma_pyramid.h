@@ -0,0 +1,28 @@
+#ifndef LUMA_PYRAMID_H
+#define LUMA_PYRAMID_H
+
+#include "frame_diff.h"
+
+#include <cstdint>
+
+// Coarse level of a frame: every cellSize x cellSize block of pixels is box-filtered into one
+// 16-bit sample. The luma proxy is the plain sum of every channel byte in the cell, which the SIMD
+// kernels get from one sum-of-absolute-differences instruction per four pixels; BT.601-weighted
+// luma needs widening multiplies and made the coarse pass slower than diffing two full frames.
+// A sum changes whenever a single byte in the cell does, unless other changes cancel it out.
+// A 4x4 level is 1/32 and an 8x8 level 1/128 of the frame's bytes. 10-bit and half-float pixels
+// are converted to 8-bit BGRA in registers first, so samples and thresholds mean the same in every
+// format; changes below the 8-bit precision are not seen at the coarse level.
+
+// Sums `cells` whole cells of cellSize pixels across `rows` pixel rows (1..cellSize) starting at
+// `pixels`, writing one sample per cell. cellSize must be 4 or 8.
+typedef void (*LumaCellRowFunc)(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+
+// Function to get the fastest cell row implementation for this CPU and a pixel format
+LumaCellRowFunc GetLumaCellRowFunc(PixelFormat format = PixelFormat::BGRA8);
+
+// Function to downsample cell row `cy` of a frame into sums[0..cols), where the last column and
+// the last row may cover fewer pixels than a whole cell. Uses the kernel for the frame's format.
+void DownsampleLumaRow(const FrameView& frame, int cellSize, int cy, uint16_t* sums);
+
+#endif // LUMA_PYRAMID_H
@@ -0,0 +1,21 @@
+#ifndef LUMA_PYRAMID_KERNELS_H
+#define LUMA_PYRAMID_KERNELS_H
+
+// Internal: per-ISA box filter kernels behind LumaCellRowFunc, each built with its own flags and
+// instantiated for every pixel format's traits.
+
+#include "cpu_features.h"
+#include "luma_pyramid.h"
+
+template <class Traits>
+void LumaCellRowScalar(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+#if defined(OVERLAY_ARCH_X86)
+template <class Traits>
+void LumaCellRowSSE2(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+template <class Traits>
+void LumaCellRowNEON(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+#endif
+
+#endif // LUMA_PYRAMID_KERNELS_H
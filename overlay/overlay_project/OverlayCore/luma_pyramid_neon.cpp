@@ -0,0 +1,28 @@
+#include "luma_pyramid_kernels.h"
+
+#if defined(OVERLAY_ARCH_NEON)
+#include "pixel_format_neon.h"
+
+// Pairwise-adds every four pixels, converted to 16 BGRA bytes, into 16-bit lanes, which cannot
+// overflow for an 8x8 cell, then reduces the lanes once per cell
+template <class Traits>
+void LumaCellRowNEON(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums) {
+    const int bytes = Traits::kBytesPerPixel;
+    const int strips = cellSize / 4;
+    for (int cx = 0; cx < cells; ++cx) {
+        const uint8_t* cell = pixels + static_cast<size_t>(cx) * cellSize * bytes;
+        uint16x8_t sum = vdupq_n_u16(0);
+        for (int y = 0; y < rows; ++y) {
+            const uint8_t* row = cell + static_cast<size_t>(y) * rowPitch;
+            for (int s = 0; s < strips; ++s) {
+                sum = vpadalq_u8(sum, LoadBgra8x4<Traits>(row + s * 4 * bytes));
+            }
+        }
+        sums[cx] = vaddvq_u16(sum);
+    }
+}
+
+template void LumaCellRowNEON<Bgra8Traits>(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+template void LumaCellRowNEON<Rgb10A2Traits>(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+template void LumaCellRowNEON<Rgba16FTraits>(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+#endif
@@ -0,0 +1,57 @@
+#include "luma_pyramid_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include "pixel_format_sse2.h"
+
+// PSADBW against zero adds each group of eight bytes into a 64-bit lane, so every four pixels
+// (one 16-byte load for BGRA) cost one instruction; the two lanes are folded once per cell.
+// Full-height cells use compile-time sizes so the row and strip loops unroll.
+template <class Traits, int kCellSize, int kRows>
+static void LumaCellRowFixed(const uint8_t* pixels, int rowPitch, int cells, uint16_t* sums) {
+    const int bytes = Traits::kBytesPerPixel;
+    const __m128i zero = _mm_setzero_si128();
+    for (int cx = 0; cx < cells; ++cx) {
+        const uint8_t* cell = pixels + static_cast<size_t>(cx) * kCellSize * bytes;
+        __m128i sum = zero;
+        for (int y = 0; y < kRows; ++y) {
+            const uint8_t* row = cell + static_cast<size_t>(y) * rowPitch;
+            for (int s = 0; s < kCellSize / 4; ++s) {
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(LoadBgra8x4<Traits>(row + s * 4 * bytes), zero));
+            }
+        }
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+        sums[cx] = static_cast<uint16_t>(_mm_cvtsi128_si32(sum));
+    }
+}
+
+template <class Traits>
+void LumaCellRowSSE2(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums) {
+    if (cellSize == 4 && rows == 4) {
+        LumaCellRowFixed<Traits, 4, 4>(pixels, rowPitch, cells, sums);
+        return;
+    }
+    if (cellSize == 8 && rows == 8) {
+        LumaCellRowFixed<Traits, 8, 8>(pixels, rowPitch, cells, sums);
+        return;
+    }
+    const int bytes = Traits::kBytesPerPixel;
+    const __m128i zero = _mm_setzero_si128();
+    const int strips = cellSize / 4;
+    for (int cx = 0; cx < cells; ++cx) {
+        const uint8_t* cell = pixels + static_cast<size_t>(cx) * cellSize * bytes;
+        __m128i sum = zero;
+        for (int y = 0; y < rows; ++y) {
+            const uint8_t* row = cell + static_cast<size_t>(y) * rowPitch;
+            for (int s = 0; s < strips; ++s) {
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(LoadBgra8x4<Traits>(row + s * 4 * bytes), zero));
+            }
+        }
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+        sums[cx] = static_cast<uint16_t>(_mm_cvtsi128_si32(sum));
+    }
+}
+
+template void LumaCellRowSSE2<Bgra8Traits>(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+template void LumaCellRowSSE2<Rgb10A2Traits>(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+template void LumaCellRowSSE2<Rgba16FTraits>(const uint8_t* pixels, int rowPitch, int rows, int cells, int cellSize, uint16_t* sums);
+#endif
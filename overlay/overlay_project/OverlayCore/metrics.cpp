@@ -0,0 +1,194 @@
+#include "metrics.h"
+#include "bit_utils.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+static const char* const kStageNames[] = { "capture", "readback", "detect", "diff", "extract", "track", "motion", "coalesce", "render", "present" };
+static const char* const kCounterNames[] = { "frames", "changed_tiles", "boxes", "dropped_frames", "dirty_pixels", "missed_deadlines", "skipped_tiles", "capped_coalesces" };
+
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == static_cast<size_t>(StageMetric::Count), "Stage names out of date");
+static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == static_cast<size_t>(CounterMetric::Count), "Counter names out of date");
+
+// Function to get the JSON key of a metric
+const char* StageMetricName(StageMetric stage) {
+    return kStageNames[static_cast<int>(stage)];
+}
+
+const char* CounterMetricName(CounterMetric counter) {
+    return kCounterNames[static_cast<int>(counter)];
+}
+
+int LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < 2 * kSubBuckets) {
+        return static_cast<int>(value);
+    }
+    // Keep the top kSubBucketBits + 1 bits: the leading one selects the octave, the rest the sub-bucket
+    int shift = HighestBit64(value) - kSubBucketBits;
+    return shift * kSubBuckets + static_cast<int>(value >> shift);
+}
+
+// Largest value that falls into a bucket
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+    if (index < 2 * kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / kSubBuckets - 1;
+    uint64_t lower = static_cast<uint64_t>(index % kSubBuckets + kSubBuckets) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+// Function to add the current bucket counts to `totals` (sized to kBucketCount)
+void LatencyHistogram::ReadCounts(std::vector<uint64_t>& totals) const {
+    totals.resize(kBucketCount);
+    for (int i = 0; i < kBucketCount; ++i) {
+        totals[i] += counts[i].load(std::memory_order_relaxed);
+    }
+}
+
+// Function to find the value at quantile q (0..1) from bucket counts
+uint64_t HistogramQuantile(const std::vector<uint64_t>& counts, double q) {
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return LatencyHistogram::BucketUpperBound(static_cast<int>(i));
+        }
+    }
+    return LatencyHistogram::BucketUpperBound(static_cast<int>(counts.size()) - 1);
+}
+
+// Process-wide metrics. Histograms and counters only ever grow; snapshots report the
+// difference from the totals seen by the previous snapshot.
+struct MetricsState {
+    LatencyHistogram stages[static_cast<int>(StageMetric::Count)];
+    std::atomic<uint64_t> stageSums[static_cast<int>(StageMetric::Count)] = {};
+    std::atomic<uint64_t> counters[static_cast<int>(CounterMetric::Count)] = {};
+
+    // Snapshot state, guarded by snapshotMutex
+    std::mutex snapshotMutex;
+    std::vector<uint64_t> lastCounts[static_cast<int>(StageMetric::Count)];
+    uint64_t lastSums[static_cast<int>(StageMetric::Count)] = {};
+    uint64_t lastCounters[static_cast<int>(CounterMetric::Count)] = {};
+    uint64_t lastSnapshotNs = MetricsClockNs();
+    std::vector<uint64_t> current;
+    std::vector<uint64_t> delta;
+
+    // Export thread
+    std::mutex exportMutex;
+    std::condition_variable exportWake;
+    std::thread exportThread;
+    FILE* exportFile = nullptr;
+    bool exportStopping = false;
+};
+
+static MetricsState& GetMetrics() {
+    static MetricsState state;
+    return state;
+}
+
+// Function to record the duration of one stage execution
+void RecordStageTime(StageMetric stage, uint64_t nanoseconds) {
+    MetricsState& state = GetMetrics();
+    state.stages[static_cast<int>(stage)].Record(nanoseconds);
+    state.stageSums[static_cast<int>(stage)].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+// Function to add to a counter
+void AddCounter(CounterMetric counter, uint64_t value) {
+    GetMetrics().counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+// Function to write one JSON line of per-stage percentiles and counter increments since the previous snapshot
+void WriteMetricsSnapshot(FILE* file) {
+    MetricsState& state = GetMetrics();
+    std::lock_guard<std::mutex> lock(state.snapshotMutex);
+    uint64_t now = MetricsClockNs();
+    std::string line = "{\"interval_ms\":" + std::to_string((now - state.lastSnapshotNs) / 1000000) + ",\"stages\":{";
+    state.lastSnapshotNs = now;
+
+    char buffer[192];
+    for (int s = 0; s < static_cast<int>(StageMetric::Count); ++s) {
+        state.current.assign(LatencyHistogram::kBucketCount, 0);
+        state.stages[s].ReadCounts(state.current);
+        std::vector<uint64_t>& last = state.lastCounts[s];
+        last.resize(LatencyHistogram::kBucketCount);
+        state.delta.resize(LatencyHistogram::kBucketCount);
+        uint64_t count = 0;
+        for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+            state.delta[i] = state.current[i] - last[i];
+            count += state.delta[i];
+        }
+        last.swap(state.current);
+        uint64_t sum = state.stageSums[s].load(std::memory_order_relaxed);
+        uint64_t intervalSum = sum - state.lastSums[s];
+        state.lastSums[s] = sum;
+        uint64_t maxValue = state.stages[s].TakeMax();
+        // Bucket upper bounds can overshoot the largest value actually seen
+        uint64_t p50 = std::min(HistogramQuantile(state.delta, 0.5), maxValue);
+        uint64_t p99 = std::min(HistogramQuantile(state.delta, 0.99), maxValue);
+
+        snprintf(buffer, sizeof(buffer), "%s\"%s\":{\"count\":%llu,\"mean_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}",
+                 s > 0 ? "," : "", kStageNames[s], static_cast<unsigned long long>(count),
+                 count ? intervalSum / 1000.0 / count : 0.0, p50 / 1000.0, p99 / 1000.0, maxValue / 1000.0);
+        line += buffer;
+    }
+    line += "},\"counters\":{";
+    for (int c = 0; c < static_cast<int>(CounterMetric::Count); ++c) {
+        uint64_t value = state.counters[c].load(std::memory_order_relaxed);
+        snprintf(buffer, sizeof(buffer), "%s\"%s\":%llu", c > 0 ? "," : "", kCounterNames[c],
+                 static_cast<unsigned long long>(value - state.lastCounters[c]));
+        state.lastCounters[c] = value;
+        line += buffer;
+    }
+    line += "}}\n";
+    fputs(line.c_str(), file);
+    fflush(file);
+}
+
+// Function to start a background thread that writes a snapshot to `path` every intervalMs
+bool StartMetricsExport(const char* path, int intervalMs) {
+    StopMetricsExport();
+    MetricsState& state = GetMetrics();
+    std::lock_guard<std::mutex> lock(state.exportMutex);
+    state.exportFile = fopen(path, "w");
+    if (!state.exportFile) {
+        return false;
+    }
+    state.exportStopping = false;
+    state.exportThread = std::thread([&state, intervalMs] {
+        std::unique_lock<std::mutex> lock(state.exportMutex);
+        while (!state.exportStopping) {
+            state.exportWake.wait_for(lock, std::chrono::milliseconds(intervalMs), [&state] { return state.exportStopping; });
+            WriteMetricsSnapshot(state.exportFile);
+        }
+    });
+    return true;
+}
+
+// Function to write a last snapshot and stop the export thread
+void StopMetricsExport() {
+    MetricsState& state = GetMetrics();
+    {
+        std::lock_guard<std::mutex> lock(state.exportMutex);
+        if (!state.exportThread.joinable()) {
+            return;
+        }
+        state.exportStopping = true;
+        state.exportWake.notify_all();
+    }
+    state.exportThread.join();
+    fclose(state.exportFile);
+    state.exportFile = nullptr;
+}
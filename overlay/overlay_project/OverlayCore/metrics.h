@@ -0,0 +1,146 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Stage timers and counters for the frame loop. Recording is a few relaxed atomic adds, so it
+// can stay on in release builds; building with OVERLAY_ENABLE_METRICS=0 removes the
+// OVERLAY_METRICS_* statements entirely.
+#ifndef OVERLAY_ENABLE_METRICS
+#define OVERLAY_ENABLE_METRICS 1
+#endif
+
+// Timed stages of a frame
+enum class StageMetric {
+    // Waiting for and acquiring a desktop frame
+    Capture,
+    // Copying a captured frame to CPU memory (staging copy, map and read)
+    Readback,
+    // Whole MotionDetector::Detect call
+    Detect,
+    // Pixel diff or tile hashing, thread time summed over bands
+    Diff,
+    // Labelling dirty tiles and merging blobs into boxes, thread time summed over bands
+    Extract,
+    // Associating the frame's boxes with object tracks
+    Track,
+    // Splitting changed tiles into moved and newly drawn content
+    Motion,
+    // Merging overlapping and nearby boxes before they are drawn
+    Coalesce,
+    // Building and drawing the overlay for one result, including Present
+    Render,
+    // swapChain->Present alone
+    Present,
+    Count
+};
+
+// Counted events
+enum class CounterMetric {
+    Frames,
+    ChangedTiles,
+    Boxes,
+    // Frames or results skipped by the pipeline because a newer one was ready
+    DroppedFrames,
+    // Overlay pixels repainted, after damage tracking
+    DirtyPixels,
+    // Frames the capture scheduler started after their deadline
+    MissedDeadlines,
+    // Demoted tiles left out of a frame's comparison (tile_activity.h)
+    SkippedTiles,
+    // Coalesce calls that stopped at CoalesceConfig::maxPasses while still merging
+    CappedCoalesces,
+    Count
+};
+
+// Function to get the JSON key of a metric
+const char* StageMetricName(StageMetric stage);
+const char* CounterMetricName(CounterMetric counter);
+
+// Lock-free log-linear histogram in the style of HdrHistogram. Values below 32 have their own
+// bucket; above that each power of two is split into 16 buckets, so a bucket's width is at most
+// 1/16 of its values (about 6% relative error) from nanoseconds up to the full 64-bit range.
+class LatencyHistogram {
+public:
+    static const int kSubBucketBits = 4;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+    static const int kBucketCount = (65 - kSubBucketBits) * kSubBuckets;
+
+    void Record(uint64_t value) {
+        counts[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t seen = maxValue.load(std::memory_order_relaxed);
+        while (value > seen && !maxValue.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Function to add the current bucket counts to `totals` (sized to kBucketCount)
+    void ReadCounts(std::vector<uint64_t>& totals) const;
+
+    // Function to return the largest value recorded since the last call and start over
+    uint64_t TakeMax() { return maxValue.exchange(0, std::memory_order_relaxed); }
+
+    static int BucketIndex(uint64_t value);
+    // Largest value that falls into a bucket
+    static uint64_t BucketUpperBound(int index);
+
+private:
+    std::atomic<uint64_t> counts[kBucketCount] = {};
+    std::atomic<uint64_t> maxValue{ 0 };
+};
+
+// Function to find the value at quantile q (0..1) from bucket counts, reported as the
+// upper bound of the bucket it falls into
+uint64_t HistogramQuantile(const std::vector<uint64_t>& counts, double q);
+
+// Function to record the duration of one stage execution
+void RecordStageTime(StageMetric stage, uint64_t nanoseconds);
+
+// Function to add to a counter
+void AddCounter(CounterMetric counter, uint64_t value);
+
+// Function to read the clock used by stage timers, in nanoseconds
+inline uint64_t MetricsClockNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Records the time from construction to destruction as one execution of a stage
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(StageMetric stage) : stage(stage), start(MetricsClockNs()) {}
+    ~ScopedStageTimer() { RecordStageTime(stage, MetricsClockNs() - start); }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    StageMetric stage;
+    uint64_t start;
+};
+
+// Function to write one JSON line with, per stage, the count, mean, p50, p99 and max in
+// microseconds since the previous snapshot, and the counters' increments over the same interval
+void WriteMetricsSnapshot(FILE* file);
+
+// Function to start a background thread that writes a snapshot to `path` every intervalMs
+bool StartMetricsExport(const char* path, int intervalMs);
+
+// Function to write a last snapshot and stop the export thread
+void StopMetricsExport();
+
+#if OVERLAY_ENABLE_METRICS
+#define OVERLAY_METRICS_CONCAT_INNER(a, b) a##b
+#define OVERLAY_METRICS_CONCAT(a, b) OVERLAY_METRICS_CONCAT_INNER(a, b)
+#define OVERLAY_METRICS_SCOPE(stage) ScopedStageTimer OVERLAY_METRICS_CONCAT(overlayStageTimer, __LINE__)(stage)
+#define OVERLAY_METRICS_TIME(stage, nanoseconds) RecordStageTime(stage, nanoseconds)
+#define OVERLAY_METRICS_COUNT(counter, value) AddCounter(counter, value)
+#else
+#define OVERLAY_METRICS_SCOPE(stage) ((void)0)
+#define OVERLAY_METRICS_TIME(stage, nanoseconds) ((void)0)
+#define OVERLAY_METRICS_COUNT(counter, value) ((void)0)
+#endif
+
+#endif // METRICS_H
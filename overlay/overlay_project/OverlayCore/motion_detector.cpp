@@ -0,0 +1,488 @@
+#include "motion_detector.h"
+#include "bit_utils.h"
+#include "luma_pyramid.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Function to clear the bits of mask words [firstWord, lastWord) outside the active tiles and
+// return how many set bits were cleared
+static size_t KeepActiveBits(uint64_t* maskRow, const uint64_t* keep, int firstWord, int lastWord) {
+    size_t cleared = 0;
+    for (int word = firstWord; word < lastWord; ++word) {
+        if (keep[word] != ~0ull) {
+            cleared += PopCount64(maskRow[word] & ~keep[word]);
+            maskRow[word] &= keep[word];
+        }
+    }
+    return cleared;
+}
+
+MotionDetector::MotionDetector(const DetectorConfig& detectorConfig)
+    : config(detectorConfig), activity(detectorConfig.sampling) {
+    pool = std::make_unique<ThreadPool>(config.threadCount);
+    config.threadCount = pool->ThreadCount();
+    diffRow = GetDiffRowFunc(config.kernel, pixelFormat);
+    backgroundRow = GetBackgroundRowFunc(config.kernel, pixelFormat);
+    tiles.tileSize = config.tileSize;
+    // Cells must nest inside tiles so bands, which own whole tile rows, own whole cell rows
+    coarseScale = config.pyramidScale <= 4 || config.tileSize < 8 ? 4 : 8;
+}
+
+// Function to split the frame into bands of whole tile rows, reusing state when the size is unchanged
+void MotionDetector::PrepareBands(int width, int height) {
+    if (tiles.width == width && tiles.height == height && !bands.empty()) {
+        return;
+    }
+    tiles.Resize(width, height, config.tileSize);
+    if (activity.Enabled()) {
+        activity.Resize(width, height, config.tileSize);
+        sampleMask.Reserve(width, height, config.tileSize);
+    }
+    // The full-resolution change mask is only needed when pixels are actually compared
+    if (config.mode != DetectionMode::TileHash || config.verifyHashes) {
+        mask.Resize(width, height);
+    }
+    if (config.mode == DetectionMode::TileHash) {
+        tileHashes.assign(tiles.dirty.size(), 0);
+        hashesValid = false;
+    }
+    if (config.mode == DetectionMode::Pyramid) {
+        coarseCols = (width + coarseScale - 1) / coarseScale;
+        coarseLuma.assign(static_cast<size_t>(coarseCols) * ((height + coarseScale - 1) / coarseScale), 0);
+        coarseValid = false;
+    }
+    if (config.mode == DetectionMode::Background) {
+        backgroundModel.assign(static_cast<size_t>(width) * height, 0);
+        backgroundValid = false;
+    }
+
+    int bandCount = config.bandCount > 0 ? config.bandCount : config.threadCount * 4;
+    bandCount = std::max(1, std::min(bandCount, tiles.rows));
+    bands.clear();
+    bands.resize(bandCount);
+    for (int i = 0; i < bandCount; ++i) {
+        bands[i].firstTileRow = tiles.rows * i / bandCount;
+        bands[i].lastTileRow = tiles.rows * (i + 1) / bandCount;
+        if (config.mode == DetectionMode::TileHash) {
+            bands[i].rowHashes.resize(tiles.cols);
+        }
+        if (config.mode == DetectionMode::Pyramid) {
+            bands[i].rowLuma.resize(coarseCols);
+            bands[i].refineWords.resize(mask.wordsPerRow);
+        }
+    }
+}
+
+// Function to diff pixel rows [firstRow, lastRow) into the mask and mark their tiles
+void MotionDetector::DiffBandRows(Band& band, int firstRow, int lastRow) {
+    size_t changed = 0;
+    for (int y = firstRow; y < lastRow; ++y) {
+        changed += diffRow(currentFrame.Row(y), previousFrame.Row(y), mask.width, mask.Row(y));
+    }
+    if (changed != 0) {
+        MarkDirtyTileRows(mask, firstRow, lastRow, tiles);
+    }
+    band.changedPixels += changed;
+}
+
+// Function to compare each tile's CRC with the one stored for the last frame, then store the new ones
+void MotionDetector::HashBand(Band& band) {
+    const int tileSize = tiles.tileSize;
+    const bool verify = config.verifyHashes && previousFrame.pixels != nullptr && hashesValid;
+    for (int ty = band.firstTileRow; ty < band.lastTileRow; ++ty) {
+        uint32_t* hashes = band.rowHashes.data();
+        uint32_t* stored = &tileHashes[static_cast<size_t>(ty) * tiles.cols];
+        int top = ty * tileSize;
+        int bottom = std::min(top + tileSize, tiles.height);
+        if (masked) {
+            // Hash, compare and store the runs of active tiles only
+            int runCount = 0;
+            const TileRun* runs = frameMask->RowRuns(ty, runCount);
+            for (int i = 0; i < runCount; ++i) {
+                int right = std::min(runs[i].last * tileSize, tiles.width);
+                HashTileRow(currentFrame.Columns(runs[i].first * tileSize, right), tileSize, ty, hashes + runs[i].first);
+            }
+            if (verify) {
+                DiffWordRuns(band, top, bottom, frameMask->RowWords(ty), frameMask->RowKeepBits(ty));
+            }
+            for (int i = 0; i < runCount; ++i) {
+                for (int tx = runs[i].first; tx < runs[i].last; ++tx) {
+                    if (!verify && hashesValid && hashes[tx] != stored[tx]) {
+                        int left = tx * tileSize;
+                        tiles.MarkPixels(tiles.Index(tx, ty), left, top, std::min(left + tileSize, tiles.width), bottom);
+                    }
+                    stored[tx] = hashes[tx];
+                }
+            }
+            continue;
+        }
+        HashTileRow(currentFrame, tileSize, ty, hashes);
+
+        if (verify) {
+            // Exact pass: catches collisions in unchanged hashes and gives tight bounds
+            DiffBandRows(band, top, bottom);
+        } else if (hashesValid) {
+            for (int tx = 0; tx < tiles.cols; ++tx) {
+                if (hashes[tx] != stored[tx]) {
+                    int left = tx * tileSize;
+                    tiles.MarkPixels(tiles.Index(tx, ty), left, top, std::min(left + tileSize, tiles.width), bottom);
+                }
+            }
+        }
+        std::copy(hashes, hashes + tiles.cols, stored);
+    }
+}
+
+// Function to compare pixel rows [top, bottom) exactly, but only inside the 64-pixel mask words
+// flagged in `refine`, and mark their tiles. Unflagged words are cleared; with `keep`, so are
+// the bits of pixels outside the active tiles.
+void MotionDetector::DiffWordRuns(Band& band, int top, int bottom, const uint8_t* refine, const uint64_t* keep) {
+    const int words = mask.wordsPerRow;
+    size_t changed = 0;
+    for (int y = top; y < bottom; ++y) {
+        uint64_t* maskRow = mask.Row(y);
+        const uint8_t* current = currentFrame.Row(y);
+        const uint8_t* previous = previousFrame.Row(y);
+        int word = 0;
+        while (word < words) {
+            if (!refine[word]) {
+                maskRow[word++] = 0;
+                continue;
+            }
+            // Diff the whole run of flagged words at once; the kernel writes exactly those words
+            int end = word + 1;
+            while (end < words && refine[end]) {
+                ++end;
+            }
+            int left = word * 64;
+            int right = std::min(end * 64, mask.width);
+            size_t offset = static_cast<size_t>(left) * currentFrame.BytesPerPixel();
+            changed += diffRow(current + offset, previous + offset, right - left, maskRow + word);
+            if (keep) {
+                changed -= KeepActiveBits(maskRow, keep, word, end);
+            }
+            word = end;
+        }
+    }
+    if (changed != 0) {
+        MarkDirtyTileRows(mask, top, bottom, tiles);
+    }
+    band.changedPixels += changed;
+}
+
+// Function to downsample the band to coarse cell sums, compare them with the last frame's and
+// refine the cells that changed, then store the new sums
+void MotionDetector::PyramidBand(Band& band) {
+    const int scale = coarseScale;
+    // Samples add four channel bytes per pixel; edge cells with fewer pixels get the same limit
+    const int threshold = config.pyramidThreshold * scale * scale * 4;
+    const bool refine = previousFrame.pixels != nullptr;
+    int firstCellRow = band.firstTileRow * tiles.tileSize / scale;
+    int lastCellRow = (std::min(band.lastTileRow * tiles.tileSize, tiles.height) + scale - 1) / scale;
+    // Without a mask the whole row is one run of cells
+    TileRun wholeRow;
+    wholeRow.first = 0;
+    wholeRow.last = coarseCols;
+    for (int cy = firstCellRow; cy < lastCellRow; ++cy) {
+        uint16_t* luma = band.rowLuma.data();
+        uint16_t* stored = &coarseLuma[static_cast<size_t>(cy) * coarseCols];
+        int top = cy * scale;
+        int bottom = std::min(top + scale, tiles.height);
+        int ty = top / tiles.tileSize;
+
+        // Cells nest inside tiles, so each run of active tiles is a run of whole cells
+        int runCount = 1;
+        const TileRun* runs = &wholeRow;
+        if (masked) {
+            runs = frameMask->RowRuns(ty, runCount);
+        }
+        bool anyChanged = false;
+        if (refine && coarseValid) {
+            std::fill(band.refineWords.begin(), band.refineWords.end(), static_cast<uint8_t>(0));
+        }
+        for (int i = 0; i < runCount; ++i) {
+            int firstCell = runs[i].first;
+            int lastCell = runs[i].last;
+            if (masked) {
+                firstCell = runs[i].first * tiles.tileSize / scale;
+                lastCell = std::min((runs[i].last * tiles.tileSize + scale - 1) / scale, coarseCols);
+                DownsampleLumaRow(currentFrame.Columns(firstCell * scale, std::min(lastCell * scale, tiles.width)), scale, cy, luma + firstCell);
+            } else {
+                DownsampleLumaRow(currentFrame, scale, cy, luma);
+            }
+            for (int cx = firstCell; coarseValid && cx < lastCell; ++cx) {
+                if (std::abs(luma[cx] - stored[cx]) <= threshold) {
+                    continue;
+                }
+                anyChanged = true;
+                int left = cx * scale;
+                if (refine) {
+                    band.refineWords[left >> 6] = 1;
+                } else {
+                    tiles.MarkPixels(tiles.Index(left / tiles.tileSize, ty), left, top, std::min(left + scale, tiles.width), bottom);
+                }
+            }
+            std::copy(luma + firstCell, luma + lastCell, stored + firstCell);
+        }
+        if (refine && anyChanged) {
+            DiffWordRuns(band, top, bottom, band.refineWords.data(), masked ? frameMask->RowKeepBits(ty) : nullptr);
+        }
+    }
+}
+
+// Function to compare the band's pixels with their running averages and update them. The first
+// frame only initialises the averages.
+void MotionDetector::BackgroundBand(Band& band) {
+    const int threshold = std::max(0, std::min(config.backgroundThreshold, 255)) * kBackgroundOne;
+    const int shift = backgroundValid ? std::max(0, std::min(config.backgroundShift, 8)) : 0;
+    int top = band.firstTileRow * tiles.tileSize;
+    int bottom = std::min(band.lastTileRow * tiles.tileSize, tiles.height);
+    size_t changed = 0;
+    for (int y = top; y < bottom; ++y) {
+        int16_t* averages = &backgroundModel[static_cast<size_t>(y) * tiles.width];
+        uint64_t* maskRow = mask.Row(y);
+        if (!masked) {
+            changed += backgroundRow(currentFrame.Row(y), averages, tiles.width, threshold, shift, maskRow);
+            continue;
+        }
+        // Update only the mask words that overlap active tiles, like DiffWordRuns
+        int ty = y / tiles.tileSize;
+        const uint8_t* active = frameMask->RowWords(ty);
+        const uint64_t* keep = frameMask->RowKeepBits(ty);
+        int word = 0;
+        while (word < mask.wordsPerRow) {
+            if (!active[word]) {
+                maskRow[word++] = 0;
+                continue;
+            }
+            int end = word + 1;
+            while (end < mask.wordsPerRow && active[end]) {
+                ++end;
+            }
+            int left = word * 64;
+            int right = std::min(end * 64, tiles.width);
+            changed += backgroundRow(currentFrame.Row(y) + static_cast<size_t>(left) * currentFrame.BytesPerPixel(), averages + left, right - left, threshold, shift, maskRow + word);
+            changed -= KeepActiveBits(maskRow, keep, word, end);
+            word = end;
+        }
+    }
+    if (backgroundValid && changed != 0) {
+        MarkDirtyTileRows(mask, top, bottom, tiles);
+        band.changedPixels += changed;
+    }
+}
+
+// Function to diff, tile and label one band. Bands own disjoint rows of the mask and tile map.
+void MotionDetector::DetectBand(Band& band) {
+#if OVERLAY_ENABLE_METRICS
+    uint64_t start = MetricsClockNs();
+#endif
+    band.changedPixels = 0;
+    tiles.ClearRows(band.firstTileRow, band.lastTileRow);
+    if (config.mode == DetectionMode::TileHash) {
+        HashBand(band);
+    } else if (config.mode == DetectionMode::Pyramid) {
+        PyramidBand(band);
+    } else if (config.mode == DetectionMode::Background) {
+        BackgroundBand(band);
+    } else if (masked) {
+        for (int ty = band.firstTileRow; ty < band.lastTileRow; ++ty) {
+            int top = ty * tiles.tileSize;
+            int bottom = std::min(top + tiles.tileSize, tiles.height);
+            int runCount = 0;
+            const TileRun* runs = frameMask->RowRuns(ty, runCount);
+            if (runCount == 1 && runs[0].first == 0 && runs[0].last == tiles.cols) {
+                // Rows without inactive tiles take the unmasked path
+                DiffBandRows(band, top, bottom);
+            } else {
+                DiffWordRuns(band, top, bottom, frameMask->RowWords(ty), frameMask->RowKeepBits(ty));
+            }
+        }
+    } else {
+        DiffBandRows(band, band.firstTileRow * tiles.tileSize, std::min(band.lastTileRow * tiles.tileSize, tiles.height));
+    }
+    if (activity.Enabled()) {
+        band.activityChanged = activity.UpdateRows(tiles, masked ? frameMask : nullptr, band.firstTileRow, band.lastTileRow);
+    }
+#if OVERLAY_ENABLE_METRICS
+    uint64_t diffed = MetricsClockNs();
+#endif
+    band.extractor.ExtractRows(tiles, band.firstTileRow, band.lastTileRow, band.boxes);
+#if OVERLAY_ENABLE_METRICS
+    band.diffNs = diffed - start;
+    band.extractNs = MetricsClockNs() - diffed;
+#endif
+}
+
+int MotionDetector::FindMerged(int index) {
+    while (mergeParent[index] != index) {
+        mergeParent[index] = mergeParent[mergeParent[index]];
+        index = mergeParent[index];
+    }
+    return index;
+}
+
+// Function to join per-band blobs that touch across band seams and emit the final boxes
+void MotionDetector::MergeBands(std::vector<Box>& boxes) {
+    int* bandOffsets = scratch.Allocate<int>(bands.size());
+    int total = 0;
+    for (size_t i = 0; i < bands.size(); ++i) {
+        bandOffsets[i] = total;
+        total += static_cast<int>(bands[i].boxes.size());
+    }
+    mergeParent = scratch.Allocate<int>(total);
+    for (int i = 0; i < total; ++i) {
+        mergeParent[i] = i;
+    }
+
+    // Tiles on either side of a seam are 8-connected if they are in adjacent columns
+    for (size_t i = 1; i < bands.size(); ++i) {
+        Band& upper = bands[i - 1];
+        Band& lower = bands[i];
+        if (upper.boxes.empty() || lower.boxes.empty()) {
+            continue;
+        }
+        int upperRow = upper.lastTileRow - 1;
+        int lowerRow = lower.firstTileRow;
+        for (int tx = 0; tx < tiles.cols; ++tx) {
+            int lowerBox = lower.extractor.BoxIndexAt(tx, lowerRow);
+            if (lowerBox < 0) {
+                continue;
+            }
+            for (int nx = std::max(tx - 1, 0); nx <= std::min(tx + 1, tiles.cols - 1); ++nx) {
+                int upperBox = upper.extractor.BoxIndexAt(nx, upperRow);
+                if (upperBox < 0) {
+                    continue;
+                }
+                int a = FindMerged(bandOffsets[i - 1] + upperBox);
+                int b = FindMerged(bandOffsets[i] + lowerBox);
+                if (a != b) {
+                    mergeParent[std::max(a, b)] = std::min(a, b);
+                }
+            }
+        }
+    }
+
+    // Every tile can be its own blob, so the caller's vector never has to grow after the first frame
+    boxes.clear();
+    boxes.reserve(static_cast<size_t>(tiles.cols) * tiles.rows);
+    int* mergeOutput = scratch.Allocate<int>(total);
+    std::fill(mergeOutput, mergeOutput + total, -1);
+    for (size_t i = 0; i < bands.size(); ++i) {
+        for (size_t j = 0; j < bands[i].boxes.size(); ++j) {
+            int root = FindMerged(bandOffsets[i] + static_cast<int>(j));
+            const Box& box = bands[i].boxes[j];
+            if (mergeOutput[root] < 0) {
+                mergeOutput[root] = static_cast<int>(boxes.size());
+                boxes.push_back(box);
+            } else {
+                Box& merged = boxes[mergeOutput[root]];
+                merged = UnionBox(merged, box);
+            }
+        }
+    }
+}
+
+// Function to replace the include and exclude regions before the next frame
+void MotionDetector::SetRegions(const std::vector<MaskRegion>& regions) {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    pendingRegions = regions;
+    regionsChanged = true;
+}
+
+// Function to compile the regions when they changed or the frame size did. Tiles that become
+// active have no state about earlier frames, so the state restarts for the whole frame.
+void MotionDetector::UpdateRegions(int width, int height) {
+    bool resized = regionMask.Width() != width || regionMask.Height() != height;
+    if (!regionsChanged.exchange(false) && !resized) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        regionMask.Compile(pendingRegions, width, height, config.tileSize);
+    }
+    hashesValid = false;
+    coarseValid = false;
+    backgroundValid = false;
+}
+
+// Function to switch the kernels to another pixel format, once per frame rather than per row. Hashes
+// and averages of the old format are not comparable with the new one, so the state restarts.
+void MotionDetector::UpdateFormat(PixelFormat format) {
+    if (format == pixelFormat) {
+        return;
+    }
+    pixelFormat = format;
+    diffRow = GetDiffRowFunc(config.kernel, format);
+    backgroundRow = GetBackgroundRowFunc(config.kernel, format);
+    hashesValid = false;
+    coarseValid = false;
+    backgroundValid = false;
+}
+
+// Function to detect changed regions between two frames, writing one box per blob into `boxes`
+void MotionDetector::Detect(const FrameView& current, const FrameView& previous, std::vector<Box>& boxes) {
+    OVERLAY_METRICS_SCOPE(StageMetric::Detect);
+    scratch.Reset();
+    PrepareBands(current.width, current.height);
+    UpdateRegions(current.width, current.height);
+    UpdateFormat(current.format);
+    frameMask = &regionMask;
+    size_t demotedBefore = activity.Enabled() ? activity.DemotedCount() : 0;
+    if (activity.Enabled() && activity.BeginFrame(regionMask, sampleMask)) {
+        frameMask = &sampleMask;
+    }
+    masked = !frameMask->AllActive();
+    currentFrame = current;
+    previousFrame = previous;
+
+    pool->ParallelFor(static_cast<int>(bands.size()), [this](int index) { DetectBand(bands[index]); });
+
+    changedPixels = 0;
+    bool activityChanged = false;
+    for (const Band& band : bands) {
+        changedPixels += band.changedPixels;
+        activityChanged |= band.activityChanged;
+    }
+    if (activity.Enabled()) {
+        activity.EndFrame(activityChanged);
+    }
+    // A tile demoted during the frame, or still demoted from earlier ones, had its change dropped,
+    // and masked-out tiles are never compared. A frame compared with itself (the pipeline's first)
+    // says nothing about the frame before.
+    exactTiles = config.mode == DetectionMode::PixelDiff && previous.pixels != nullptr && previous.pixels != current.pixels &&
+                 regionMask.AllActive() && demotedBefore == 0 && activity.DemotedCount() == 0;
+    if (config.mode == DetectionMode::TileHash) {
+        hashesValid = true;
+    }
+    if (config.mode == DetectionMode::Pyramid) {
+        coarseValid = true;
+    }
+    if (config.mode == DetectionMode::Background) {
+        backgroundValid = true;
+    }
+#if OVERLAY_ENABLE_METRICS
+    uint64_t mergeStart = MetricsClockNs();
+#endif
+    MergeBands(boxes);
+    if (config.minBoxArea > 0) {
+        const int64_t minArea = config.minBoxArea;
+        boxes.erase(std::remove_if(boxes.begin(), boxes.end(), [minArea](const Box& box) { return box.Area() < minArea; }), boxes.end());
+    }
+#if OVERLAY_ENABLE_METRICS
+    uint64_t diffNs = 0;
+    uint64_t extractNs = MetricsClockNs() - mergeStart;
+    for (const Band& band : bands) {
+        diffNs += band.diffNs;
+        extractNs += band.extractNs;
+    }
+    RecordStageTime(StageMetric::Diff, diffNs);
+    RecordStageTime(StageMetric::Extract, extractNs);
+    AddCounter(CounterMetric::Frames, 1);
+    AddCounter(CounterMetric::ChangedTiles, tiles.DirtyCount());
+    AddCounter(CounterMetric::Boxes, boxes.size());
+    AddCounter(CounterMetric::SkippedTiles, activity.SkippedCount());
+#endif
+}
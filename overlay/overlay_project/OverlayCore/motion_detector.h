@@ -0,0 +1,185 @@
+#ifndef MOTION_DETECTOR_H
+#define MOTION_DETECTOR_H
+
+#include "background_model.h"
+#include "box.h"
+#include "frame_arena.h"
+#include "frame_diff.h"
+#include "region_mask.h"
+#include "thread_pool.h"
+#include "tile_activity.h"
+#include "tile_hash.h"
+#include "tile_map.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// How consecutive frames are compared
+enum class DetectionMode {
+    // Exact per-pixel comparison against the previous frame
+    PixelDiff,
+    // Compare per-tile CRC32C signatures of the last frame; no previous frame copy is needed
+    TileHash,
+    // Compare a 1/4 or 1/8 scale image of channel-byte sums with the last frame's, then compare
+    // full-resolution pixels only around the coarse cells that changed. Faster than PixelDiff when
+    // little of the screen changes; slower once a few percent of it does (overlay_bench pyramid).
+    // Changes that leave a cell's byte sum unchanged (edits that cancel out, sub-threshold edits)
+    // are missed, as is the first frame, so recordings compare tile hashes instead of using the
+    // tile map.
+    Pyramid,
+    // Compare each pixel's luma with a running average of its past values; changes smaller than
+    // backgroundThreshold (anti-aliasing, video shimmer) are ignored. No previous frame is needed.
+    // Its tile map is therefore not an exact change map, and recordings compare tile hashes.
+    Background
+};
+
+// Settings for MotionDetector
+struct DetectorConfig {
+    DetectionMode mode = DetectionMode::PixelDiff;
+    // TileHash mode only: when a previous frame is passed, tiles whose hash did not change are
+    // compared exactly so a CRC collision cannot hide a change, and changed tiles get tight bounds
+    bool verifyHashes = false;
+    int tileSize = 16;
+    // Pyramid mode only: pixels per side of a coarse cell (4 or 8, at most tileSize)
+    int pyramidScale = 8;
+    // Pyramid mode only: a cell is refined when its average channel value moved by more than this;
+    // 0 refines any cell whose byte sum changed at all
+    int pyramidThreshold = 0;
+    // Background mode only: luma difference (0..255) from the average that counts as movement
+    int backgroundThreshold = 24;
+    // Background mode only: each frame moves the average 1/2^n of the way to the new luma, so
+    // content that stops changing fades into the background within a few frames
+    int backgroundShift = 2;
+    // Boxes covering fewer pixels than this are dropped, e.g. a blinking text cursor (0 keeps all)
+    int minBoxArea = 0;
+    // Threads used for detection including the caller; 0 picks the hardware concurrency
+    int threadCount = 1;
+    // Horizontal bands per frame; 0 picks four per thread so idle workers have something to steal
+    int bandCount = 0;
+    // Demotion of tiles that change in most frames; off by default
+    TileSamplingConfig sampling;
+    DiffKernel kernel = SelectDiffKernel();
+};
+
+// Change detection between consecutive frames. The frame is split into horizontal bands
+// aligned to tile rows; each band diffs its rows, marks its tiles and labels its own blobs
+// on the thread pool, then a final pass joins blobs that touch across band seams.
+class MotionDetector {
+public:
+    explicit MotionDetector(const DetectorConfig& config = DetectorConfig());
+
+    const DetectorConfig& Config() const { return config; }
+
+    // Function to detect changed regions between two frames, writing one box per blob into `boxes`.
+    // In TileHash mode `previous` is only read for hash verification and may be empty. In Pyramid
+    // mode it is only read inside changed cells; without it the boxes snap to the cell grid.
+    // Background mode never reads it.
+    void Detect(const FrameView& current, const FrameView& previous, std::vector<Box>& boxes);
+
+    // Function to detect changes against the state kept about earlier frames (TileHash, Pyramid
+    // and Background modes)
+    void Detect(const FrameView& current, std::vector<Box>& boxes) { Detect(current, FrameView(), boxes); }
+
+    // Function to replace the include and exclude regions; safe to call from any thread, and takes
+    // effect at the start of the next Detect. Pixels of inactive tiles are never read, and the
+    // state kept about earlier frames restarts whenever the regions change.
+    void SetRegions(const std::vector<MaskRegion>& regions);
+
+    // Regions compiled for the last frame
+    const RegionMask& Regions() const { return regionMask; }
+
+    // Groups of tiles demoted for changing in most frames; their changes are left out of the boxes
+    const std::vector<Box>& ActivityRegions() const { return activity.Regions(); }
+    const TileActivity& Activity() const { return activity; }
+
+    const ChangeMask& Mask() const { return mask; }
+    const TileMap& Tiles() const { return tiles; }
+    // Whether Tiles() of the last frame marks exactly the tiles whose pixels differ from
+    // `previous`, so it can stand in for a full comparison (TraceWriter::WriteFrame). Only pixel
+    // diffing against a distinct previous frame without a mask qualifies: the other modes mark
+    // nothing until their state about earlier frames is rebuilt, masked-out tiles are never
+    // compared, and while hot tiles are demoted their changes are left out and the ones not
+    // sampled are not compared at all.
+    bool TilesAreExact() const { return exactTiles; }
+    // Changed pixel count of the last frame; not measured in TileHash mode without verification,
+    // and in Pyramid mode only counted inside the refined cells
+    size_t ChangedPixels() const { return changedPixels; }
+
+    // Bytes of state kept about the previous frame (tile hashes in TileHash mode, the coarse
+    // cell sums in Pyramid mode, the running averages in Background mode)
+    size_t HashTableBytes() const {
+        return tileHashes.size() * sizeof(uint32_t) + coarseLuma.size() * sizeof(uint16_t) + backgroundModel.size() * sizeof(int16_t);
+    }
+
+private:
+    struct Band {
+        int firstTileRow = 0;
+        int lastTileRow = 0;
+        size_t changedPixels = 0;
+        // Thread time spent diffing and extracting boxes in the last frame, for metrics
+        uint64_t diffNs = 0;
+        uint64_t extractNs = 0;
+        // Whether a tile of the band was demoted or promoted in the last frame
+        bool activityChanged = false;
+        BoxExtractor extractor;
+        std::vector<Box> boxes;
+        std::vector<uint32_t> rowHashes;
+        std::vector<uint16_t> rowLuma;
+        std::vector<uint8_t> refineWords;
+    };
+
+    void PrepareBands(int width, int height);
+    void DetectBand(Band& band);
+    void DiffBandRows(Band& band, int firstRow, int lastRow);
+    void HashBand(Band& band);
+    void PyramidBand(Band& band);
+    void DiffWordRuns(Band& band, int top, int bottom, const uint8_t* words, const uint64_t* keep);
+    void BackgroundBand(Band& band);
+    void UpdateRegions(int width, int height);
+    void UpdateFormat(PixelFormat format);
+    void MergeBands(std::vector<Box>& boxes);
+    int FindMerged(int index);
+
+    DetectorConfig config;
+    std::unique_ptr<ThreadPool> pool;
+    // Kernels instantiated for the format of the frames being compared
+    PixelFormat pixelFormat = PixelFormat::BGRA8;
+    DiffRowFunc diffRow;
+    BackgroundRowFunc backgroundRow;
+
+    ChangeMask mask;
+    TileMap tiles;
+    bool exactTiles = false;
+    std::vector<Band> bands;
+    size_t changedPixels = 0;
+    FrameView currentFrame;
+    FrameView previousFrame;
+    std::vector<uint32_t> tileHashes;
+    bool hashesValid = false;
+    int coarseScale = 8;
+    int coarseCols = 0;
+    std::vector<uint16_t> coarseLuma;
+    bool coarseValid = false;
+    std::vector<int16_t> backgroundModel;
+    bool backgroundValid = false;
+
+    RegionMask regionMask;
+    // Region mask with the demoted tiles that are not sampled this frame removed
+    TileActivity activity;
+    RegionMask sampleMask;
+    // Mask the bands compare under: regionMask, or sampleMask while tiles are demoted
+    const RegionMask* frameMask = &regionMask;
+    // Whether some tiles are inactive, so the bands take the masked paths
+    bool masked = false;
+    std::mutex regionsMutex;
+    std::vector<MaskRegion> pendingRegions;
+    std::atomic<bool> regionsChanged{false};
+
+    // Scratch for joining the bands, released at the start of each Detect
+    FrameArena scratch;
+    int* mergeParent = nullptr;
+};
+
+#endif // MOTION_DETECTOR_H
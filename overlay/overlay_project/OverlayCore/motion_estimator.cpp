@@ -0,0 +1,254 @@
+#include "motion_estimator.h"
+#include "motion_estimator_kernels.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Portable reference kernel
+uint32_t BlockSadScalar(const uint8_t* current, int currentPitch, const uint8_t* previous, int previousPitch,
+                        int rowBytes, int rows, uint32_t limit) {
+    uint32_t total = 0;
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < rowBytes; ++x) {
+            total += static_cast<uint32_t>(std::abs(current[x] - previous[x]));
+        }
+        if (total > limit) {
+            return total;
+        }
+        current += currentPitch;
+        previous += previousPitch;
+    }
+    return total;
+}
+
+// Function to get the SAD function for a kernel (falls back to scalar if unsupported)
+BlockSadFunc GetBlockSadFunc(DiffKernel kernel) {
+    if (!IsDiffKernelSupported(kernel)) {
+        return BlockSadScalar;
+    }
+    switch (kernel) {
+#if defined(OVERLAY_ARCH_X86)
+    // A 16-pixel tile row is only two AVX2 loads, and the comparisons are bound by reading the
+    // tiles' scattered rows, so AVX2 uses the SSE2 kernel
+    case DiffKernel::SSE2:
+    case DiffKernel::AVX2:
+        return BlockSadSSE2;
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    case DiffKernel::NEON:
+        return BlockSadNEON;
+#endif
+    default:
+        return BlockSadScalar;
+    }
+}
+
+MotionEstimator::MotionEstimator(const MotionConfig& motionConfig, DiffKernel kernel)
+    : config(motionConfig), blockSad(GetBlockSadFunc(kernel)) {
+    config.searchRange = std::max(config.searchRange, 0);
+    config.maxMeanDifference = std::max(config.maxMeanDifference, 0);
+    config.searchBudget = std::max(config.searchBudget, 0);
+}
+
+// Function to compare a tile with the previous frame's pixels (dx, dy) back, returns true if they match
+bool MotionEstimator::TryShift(const FrameView& current, const FrameView& previous, int left, int top, int size, int dx, int dy) {
+    int sourceLeft = left - dx;
+    int sourceTop = top - dy;
+    if ((dx == 0 && dy == 0) || sourceLeft < 0 || sourceTop < 0 || sourceLeft + size > previous.width ||
+        sourceTop + size > previous.height) {
+        return false;
+    }
+    stats.comparisons++;
+    const int bytes = current.BytesPerPixel();
+    uint32_t sad = blockSad(current.Row(top) + static_cast<size_t>(left) * bytes, current.rowPitch,
+                            previous.Row(sourceTop) + static_cast<size_t>(sourceLeft) * bytes, previous.rowPitch, size * bytes, size, sadLimit);
+    return sad <= sadLimit;
+}
+
+// Function to try every shift along the vertical, then the horizontal axis, nearest first
+bool MotionEstimator::SearchAxes(const FrameView& current, const FrameView& previous, int left, int top, int size, Shift& found) {
+    for (int distance = 1; distance <= config.searchRange; ++distance) {
+        const int candidates[4][2] = { { 0, -distance }, { 0, distance }, { -distance, 0 }, { distance, 0 } };
+        for (const auto& candidate : candidates) {
+            if (TryShift(current, previous, left, top, size, candidate[0], candidate[1])) {
+                found.dx = candidate[0];
+                found.dy = candidate[1];
+                found.valid = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Function to move a shift to the front of the recently found shifts
+void MotionEstimator::RememberShift(const Shift& shift) {
+    int position = kRecentShifts - 1;
+    for (int i = 0; i < kRecentShifts; ++i) {
+        if (recent[i].valid && recent[i].dx == shift.dx && recent[i].dy == shift.dy) {
+            position = i;
+            break;
+        }
+    }
+    for (int i = position; i > 0; --i) {
+        recent[i] = recent[i - 1];
+    }
+    recent[0] = shift;
+}
+
+// Function to join runs of tiles with the same shift along each tile row, then stack runs with
+// the same columns and shift from consecutive rows into rectangles
+void MotionEstimator::GroupMoves(const TileMap& tiles, std::vector<MoveRect>& moves) {
+    const int size = tiles.tileSize;
+    // At most one rectangle per tile, and half a row of runs per row, so later frames never grow them
+    moves.clear();
+    moves.reserve(static_cast<size_t>(tiles.cols) * tiles.rows);
+    openRects.clear();
+    openRects.reserve(tiles.cols);
+    rowRects.reserve(tiles.cols);
+    for (int ty = 0; ty < tiles.rows; ++ty) {
+        rowRects.clear();
+        for (int tx = 0; tx < tiles.cols;) {
+            const Shift& shift = shifts[tiles.Index(tx, ty)];
+            if (!shift.valid) {
+                ++tx;
+                continue;
+            }
+            int end = tx + 1;
+            while (end < tiles.cols) {
+                const Shift& next = shifts[tiles.Index(end, ty)];
+                if (!next.valid || next.dx != shift.dx || next.dy != shift.dy) {
+                    break;
+                }
+                ++end;
+            }
+            MoveRect run;
+            run.box = { tx * size, ty * size, end * size, (ty + 1) * size };
+            run.dx = shift.dx;
+            run.dy = shift.dy;
+            rowRects.push_back(run);
+            tx = end;
+        }
+
+        // Both lists are ordered by left edge; open rectangles that do not continue are finished
+        size_t open = 0;
+        for (MoveRect& run : rowRects) {
+            while (open < openRects.size() && openRects[open].box.left < run.box.left) {
+                moves.push_back(openRects[open++]);
+            }
+            if (open < openRects.size()) {
+                const MoveRect& above = openRects[open];
+                if (above.box.left == run.box.left && above.box.right == run.box.right && above.dx == run.dx && above.dy == run.dy) {
+                    run.box.top = above.box.top;
+                    ++open;
+                }
+            }
+        }
+        while (open < openRects.size()) {
+            moves.push_back(openRects[open++]);
+        }
+        openRects.swap(rowRects);
+    }
+    moves.insert(moves.end(), openRects.begin(), openRects.end());
+}
+
+// Function to try the shifts found around a tile, for it last frame and most recently anywhere;
+// records the first that matches
+bool MotionEstimator::TryCandidates(const FrameView& current, const FrameView& previous, const TileMap& tiles, int tx, int ty) {
+    int index = tiles.Index(tx, ty);
+    Shift candidates[5 + kRecentShifts];
+    int count = 0;
+    if (tx > 0) candidates[count++] = shifts[index - 1];
+    if (ty > 0) candidates[count++] = shifts[index - tiles.cols];
+    if (tx + 1 < tiles.cols) candidates[count++] = shifts[index + 1];
+    if (ty + 1 < tiles.rows) candidates[count++] = shifts[index + tiles.cols];
+    candidates[count++] = lastShifts[index];
+    for (const Shift& shift : recent) {
+        candidates[count++] = shift;
+    }
+    const int size = tiles.tileSize;
+    for (int i = 0; i < count; ++i) {
+        const Shift& candidate = candidates[i];
+        bool repeated = false;
+        for (int j = 0; j < i && !repeated; ++j) {
+            repeated = candidates[j].valid && candidates[j].dx == candidate.dx && candidates[j].dy == candidate.dy;
+        }
+        if (candidate.valid && !repeated && TryShift(current, previous, tx * size, ty * size, size, candidate.dx, candidate.dy)) {
+            shifts[index] = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MotionEstimator::Estimate(const FrameView& current, const FrameView& previous, const TileMap& tiles,
+                               std::vector<MoveRect>& moves, std::vector<Box>& dirty) {
+    stats = MotionStats();
+    const int size = tiles.tileSize;
+    // The tolerance is per byte of the raw pixels, so half-float frames effectively need exact matches
+    sadLimit = static_cast<uint32_t>(config.maxMeanDifference) * size * size * current.BytesPerPixel();
+    size_t tileCount = static_cast<size_t>(tiles.cols) * tiles.rows;
+    if (lastShifts.size() != tileCount) {
+        lastShifts.assign(tileCount, Shift());
+    }
+    shifts.assign(tileCount, Shift());
+    if (newTiles.width != tiles.width || newTiles.height != tiles.height || newTiles.tileSize != size) {
+        newTiles.Resize(tiles.width, tiles.height, size);
+    } else {
+        newTiles.Clear();
+    }
+
+    // Cheap candidates for every whole changed tile; partial tiles at the right and bottom
+    // edges are always reported as newly drawn
+    bool comparable = previous.pixels && previous.width == current.width && previous.height == current.height;
+    unmatched.clear();
+    for (int ty = 0; ty < tiles.rows; ++ty) {
+        for (int tx = 0; tx < tiles.cols; ++tx) {
+            int index = tiles.Index(tx, ty);
+            if (!tiles.dirty[index]) {
+                continue;
+            }
+            stats.changedTiles++;
+            bool whole = (tx + 1) * size <= current.width && (ty + 1) * size <= current.height;
+            if (!comparable || !whole) {
+                newTiles.dirty[index] = 1;
+                newTiles.bounds[index] = tiles.bounds[index];
+            } else if (TryCandidates(current, previous, tiles, tx, ty)) {
+                RememberShift(shifts[index]);
+            } else {
+                unmatched.push_back(index);
+            }
+        }
+    }
+
+    // Full searches on tiles spread evenly over the unmatched ones, so a region's border tiles
+    // cannot use up the budget, then one more round of candidates with the shifts they found.
+    // The step rounds up so the searches never exceed the budget.
+    if (!unmatched.empty() && config.searchBudget > 0) {
+        const size_t budget = static_cast<size_t>(config.searchBudget);
+        size_t step = (unmatched.size() + budget - 1) / budget;
+        for (size_t i = 0; i < unmatched.size(); i += step) {
+            int index = unmatched[i];
+            stats.searches++;
+            if (SearchAxes(current, previous, (index % tiles.cols) * size, (index / tiles.cols) * size, size, shifts[index])) {
+                RememberShift(shifts[index]);
+            }
+        }
+        for (int index : unmatched) {
+            if (!shifts[index].valid && TryCandidates(current, previous, tiles, index % tiles.cols, index / tiles.cols)) {
+                RememberShift(shifts[index]);
+            }
+        }
+    }
+    for (int index : unmatched) {
+        if (!shifts[index].valid) {
+            newTiles.dirty[index] = 1;
+            newTiles.bounds[index] = tiles.bounds[index];
+        }
+    }
+    stats.movedTiles = stats.changedTiles - newTiles.DirtyCount();
+
+    extractor.Extract(newTiles, dirty);
+    GroupMoves(tiles, moves);
+    lastShifts.swap(shifts);
+}
@@ -0,0 +1,105 @@
+#ifndef MOTION_ESTIMATOR_H
+#define MOTION_ESTIMATOR_H
+
+#include "box.h"
+#include "frame_diff.h"
+#include "tile_map.h"
+
+#include <cstdint>
+#include <vector>
+
+// Region of the current frame whose content is the previous frame's shifted by (dx, dy):
+// current(x, y) matches previous(x - dx, y - dy) everywhere inside `box`
+struct MoveRect {
+    Box box;
+    int dx = 0;
+    int dy = 0;
+};
+
+// Settings for MotionEstimator
+struct MotionConfig {
+    // Largest shift searched along each axis, in pixels
+    int searchRange = 128;
+    // Largest mean absolute difference per byte that still counts as the same content
+    // (0 requires an exact copy, as for scrolled or dragged windows)
+    int maxMeanDifference = 0;
+    // Tiles per frame allowed a full axis search after the cheap candidates failed; bounds the
+    // cost on frames where nothing moved, such as video
+    int searchBudget = 32;
+};
+
+// Per-frame counters
+struct MotionStats {
+    size_t changedTiles = 0;
+    size_t movedTiles = 0;
+    // Block comparisons started, and tiles that went through a full axis search
+    size_t comparisons = 0;
+    size_t searches = 0;
+};
+
+// Sum of absolute differences between two blocks of `rows` rows of `rowBytes` bytes each.
+// rowBytes must be a multiple of 16, which tile rows of 8 or more pixels are. Stops early,
+// returning a partial sum above `limit`, once the sum of the finished rows exceeds it.
+typedef uint32_t (*BlockSadFunc)(const uint8_t* current, int currentPitch, const uint8_t* previous, int previousPitch,
+                                 int rowBytes, int rows, uint32_t limit);
+
+// Function to get the SAD function for a kernel (falls back to scalar if unsupported)
+BlockSadFunc GetBlockSadFunc(DiffKernel kernel);
+
+// Splits the changed tiles of a frame into content that moved and content that was newly drawn.
+// Each whole changed tile is compared with the previous frame at a few candidate shifts: the
+// shifts found for its neighbours this frame, for the same tile last frame, and the shifts most
+// recently found anywhere. A scrolled or dragged region therefore costs about one block
+// comparison per tile once one of its tiles is found. Up to searchBudget of the tiles that
+// match none of them, spread over the frame, are searched along both axes out to searchRange,
+// nearest shifts first, and the rest retry the candidates with what those searches found.
+// Tiles that moved by the same shift are grouped into rectangles; the rest are labelled into
+// boxes like detected blobs.
+class MotionEstimator {
+public:
+    explicit MotionEstimator(const MotionConfig& config = MotionConfig(), DiffKernel kernel = SelectDiffKernel());
+
+    const MotionConfig& Config() const { return config; }
+
+    // Function to classify the dirty tiles of `tiles` (from diffing `current` with `previous`),
+    // writing moved regions into `moves` and boxes around newly drawn content into `dirty`
+    void Estimate(const FrameView& current, const FrameView& previous, const TileMap& tiles,
+                  std::vector<MoveRect>& moves, std::vector<Box>& dirty);
+
+    const MotionStats& Stats() const { return stats; }
+
+private:
+    struct Shift {
+        int dx = 0;
+        int dy = 0;
+        bool valid = false;
+    };
+
+    bool TryShift(const FrameView& current, const FrameView& previous, int left, int top, int size, int dx, int dy);
+    bool TryCandidates(const FrameView& current, const FrameView& previous, const TileMap& tiles, int tx, int ty);
+    bool SearchAxes(const FrameView& current, const FrameView& previous, int left, int top, int size, Shift& found);
+    void RememberShift(const Shift& shift);
+    void GroupMoves(const TileMap& tiles, std::vector<MoveRect>& moves);
+
+    MotionConfig config;
+    BlockSadFunc blockSad;
+    MotionStats stats;
+    uint32_t sadLimit = 0;
+
+    // Shift found for each tile this frame and last frame
+    std::vector<Shift> shifts;
+    std::vector<Shift> lastShifts;
+    // Most recently found distinct shifts, newest first
+    static const int kRecentShifts = 4;
+    Shift recent[kRecentShifts];
+    // Changed tiles no candidate matched
+    std::vector<int> unmatched;
+
+    TileMap newTiles;
+    BoxExtractor extractor;
+    // Open rectangles of the previous tile row while grouping moved tiles
+    std::vector<MoveRect> openRects;
+    std::vector<MoveRect> rowRects;
+};
+
+#endif // MOTION_ESTIMATOR_H
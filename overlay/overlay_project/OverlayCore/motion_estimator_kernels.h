@@ -0,0 +1,20 @@
+#ifndef MOTION_ESTIMATOR_KERNELS_H
+#define MOTION_ESTIMATOR_KERNELS_H
+
+// Internal: per-ISA block SAD kernels behind BlockSadFunc, each built with its own flags.
+
+#include "cpu_features.h"
+#include "motion_estimator.h"
+
+uint32_t BlockSadScalar(const uint8_t* current, int currentPitch, const uint8_t* previous, int previousPitch,
+                        int rowBytes, int rows, uint32_t limit);
+#if defined(OVERLAY_ARCH_X86)
+uint32_t BlockSadSSE2(const uint8_t* current, int currentPitch, const uint8_t* previous, int previousPitch,
+                      int rowBytes, int rows, uint32_t limit);
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+uint32_t BlockSadNEON(const uint8_t* current, int currentPitch, const uint8_t* previous, int previousPitch,
+                      int rowBytes, int rows, uint32_t limit);
+#endif
+
+#endif // MOTION_ESTIMATOR_KERNELS_H
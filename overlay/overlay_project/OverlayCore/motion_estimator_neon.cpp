@@ -0,0 +1,25 @@
+#include "motion_estimator_kernels.h"
+
+#if defined(OVERLAY_ARCH_NEON)
+#include <arm_neon.h>
+
+// VABD and a pairwise accumulate into 16-bit lanes, which hold a row of up to 64 pixels
+// (16 steps of at most 510 per lane), widened once per row
+uint32_t BlockSadNEON(const uint8_t* current, int currentPitch, const uint8_t* previous, int previousPitch,
+                      int rowBytes, int rows, uint32_t limit) {
+    uint32_t total = 0;
+    for (int y = 0; y < rows; ++y) {
+        uint16x8_t sum = vdupq_n_u16(0);
+        for (int x = 0; x < rowBytes; x += 16) {
+            sum = vpadalq_u8(sum, vabdq_u8(vld1q_u8(current + x), vld1q_u8(previous + x)));
+        }
+        total += vaddvq_u32(vpaddlq_u16(sum));
+        if (total > limit) {
+            return total;
+        }
+        current += currentPitch;
+        previous += previousPitch;
+    }
+    return total;
+}
+#endif
@@ -0,0 +1,26 @@
+#include "motion_estimator_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include <emmintrin.h>
+
+// PSADBW sums the absolute differences of 16 bytes into two 64-bit lanes
+uint32_t BlockSadSSE2(const uint8_t* current, int currentPitch, const uint8_t* previous, int previousPitch,
+                      int rowBytes, int rows, uint32_t limit) {
+    uint32_t total = 0;
+    for (int y = 0; y < rows; ++y) {
+        __m128i sum = _mm_setzero_si128();
+        for (int x = 0; x < rowBytes; x += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + x));
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(a, b));
+        }
+        total += static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_add_epi64(sum, _mm_srli_si128(sum, 8))));
+        if (total > limit) {
+            return total;
+        }
+        current += currentPitch;
+        previous += previousPitch;
+    }
+    return total;
+}
+#endif
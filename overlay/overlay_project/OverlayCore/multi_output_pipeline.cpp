@@ -0,0 +1,206 @@
+#include "multi_output_pipeline.h"
+#include "metrics.h"
+
+#include <algorithm>
+
+MultiOutputPipeline::MultiOutputPipeline(const PipelineConfig& config, const std::vector<OutputConfig>& outputConfigs, RenderStage& render)
+    : render(render) {
+    uint32_t outputCount = static_cast<uint32_t>(outputConfigs.size());
+    for (uint32_t i = 0; i < outputCount; ++i) {
+        const OutputConfig& outputConfig = outputConfigs[i];
+        PipelineConfig pipelineConfig = config;
+        pipelineConfig.width = outputConfig.bounds.Width();
+        pipelineConfig.height = outputConfig.bounds.Height();
+        pipelineConfig.format = outputConfig.format;
+        pipelineConfig.originX = outputConfig.bounds.left;
+        pipelineConfig.originY = outputConfig.bounds.top;
+        pipelineConfig.outputIndex = i;
+        // Interleaved ID sequences keep track IDs unique across outputs
+        pipelineConfig.tracker.firstId = config.tracker.firstId + i;
+        pipelineConfig.tracker.idStep = std::max(config.tracker.idStep, 1u) * outputCount;
+
+        std::unique_ptr<OutputState> output = std::make_unique<OutputState>();
+        output->bounds = outputConfig.bounds;
+        output->mailbox = std::make_unique<OutputMailbox>(*this, i);
+        output->pipeline = std::make_unique<FramePipeline>(pipelineConfig, *outputConfig.capture, *output->mailbox, outputConfig.listener);
+        outputs.push_back(std::move(output));
+    }
+    merged.outputEnds.reserve(outputCount);
+}
+
+MultiOutputPipeline::~MultiOutputPipeline() {
+    Stop();
+}
+
+// Function to start every output's pipeline and the merge thread
+void MultiOutputPipeline::Start() {
+    if (IsRunning()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+        changed = false;
+        for (std::unique_ptr<OutputState>& output : outputs) {
+            output->hasResult = false;
+            output->pending = false;
+        }
+    }
+    mergeThread = std::thread(&MultiOutputPipeline::MergeLoop, this);
+    for (std::unique_ptr<OutputState>& output : outputs) {
+        output->pipeline->Start();
+    }
+}
+
+// Function to stop every output's pipeline and the merge thread; the render stage is not called
+// after it returns
+void MultiOutputPipeline::Stop() {
+    // Output pipelines first, so nothing is delivered once the merge thread is gone
+    for (std::unique_ptr<OutputState>& output : outputs) {
+        output->pipeline->Stop();
+    }
+    if (!mergeThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    resultReady.notify_one();
+    mergeThread.join();
+}
+
+// Function to replace the include and exclude regions, given in the shared coordinate space;
+// each output gets the parts that fall on it. Safe while running.
+void MultiOutputPipeline::SetRegions(const std::vector<MaskRegion>& regions) {
+    bool anyInclude = std::any_of(regions.begin(), regions.end(), [](const MaskRegion& region) { return region.rule == MaskRule::Include; });
+    std::vector<MaskRegion> outputRegions;
+    for (std::unique_ptr<OutputState>& output : outputs) {
+        const Box& bounds = output->bounds;
+        outputRegions.clear();
+        bool outputInclude = false;
+        for (const MaskRegion& region : regions) {
+            Box clipped = IntersectBox(region.box, bounds);
+            if (clipped.Empty()) {
+                continue;
+            }
+            MaskRegion local;
+            local.rule = region.rule;
+            local.box = { clipped.left - bounds.left, clipped.top - bounds.top, clipped.right - bounds.left, clipped.bottom - bounds.top };
+            outputRegions.push_back(local);
+            outputInclude |= region.rule == MaskRule::Include;
+        }
+        // Include regions elsewhere mean nothing on this output is watched
+        if (anyInclude && !outputInclude) {
+            MaskRegion everything;
+            everything.rule = MaskRule::Exclude;
+            everything.box = { 0, 0, bounds.Width(), bounds.Height() };
+            outputRegions.push_back(everything);
+        }
+        output->pipeline->SetRegions(outputRegions);
+    }
+}
+
+// Function to publish every output's detected frames to one event ring; call before Start
+void MultiOutputPipeline::SetEventRing(EventRingWriter* ring) {
+    for (std::unique_ptr<OutputState>& output : outputs) {
+        output->pipeline->SetEventRing(ring);
+    }
+}
+
+PipelineStats MultiOutputPipeline::Stats() const {
+    PipelineStats stats;
+    for (const std::unique_ptr<OutputState>& output : outputs) {
+        PipelineStats outputStats = output->pipeline->Stats();
+        stats.captured += outputStats.captured;
+        stats.detected += outputStats.detected;
+        stats.staleFrames += outputStats.staleFrames;
+        stats.staleResults += outputStats.staleResults;
+        stats.missedDeadlines += outputStats.missedDeadlines;
+        stats.scheduleWakeups += outputStats.scheduleWakeups;
+        // The busiest output's interval
+        if (outputStats.frameIntervalUs > 0 && (stats.frameIntervalUs == 0 || outputStats.frameIntervalUs < stats.frameIntervalUs)) {
+            stats.frameIntervalUs = outputStats.frameIntervalUs;
+        }
+    }
+    stats.staleResults += staleResults.load(std::memory_order_relaxed);
+    stats.rendered = rendered.load(std::memory_order_relaxed);
+    stats.totalLatencyUs = totalLatencyUs.load(std::memory_order_relaxed);
+    stats.maxLatencyUs = maxLatencyUs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Function to keep an output's latest result for the merge thread, runs on the output's render thread
+void MultiOutputPipeline::Deliver(size_t index, const PipelineResult& result) {
+    OutputState& output = *outputs[index];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (output.pending) {
+            staleResults.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Copies into the vectors' existing storage once they have grown
+        output.latest = result;
+        output.hasResult = true;
+        output.pending = true;
+        changed = true;
+    }
+    resultReady.notify_one();
+}
+
+void MultiOutputPipeline::MergeLoop() {
+    uint64_t nextIndex = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            resultReady.wait(lock, [this] { return changed || stopping; });
+            if (stopping) {
+                return;
+            }
+            changed = false;
+            // Every output's latest result, so a quiet output keeps showing what it found last
+            merged.frameIndex = nextIndex++;
+            merged.captureTimeUs = 0;
+            merged.detectTimeUs = 0;
+            merged.changedPixels = 0;
+            merged.boxes.clear();
+            merged.moves.clear();
+            merged.tracks.clear();
+            merged.activity.clear();
+            merged.outputEnds.clear();
+            for (size_t i = 0; i < outputs.size(); ++i) {
+                OutputState& output = *outputs[i];
+                if (!output.hasResult) {
+                    continue;
+                }
+                const PipelineResult& latest = output.latest;
+                merged.captureTimeUs = std::max(merged.captureTimeUs, latest.captureTimeUs);
+                merged.detectTimeUs = std::max(merged.detectTimeUs, latest.detectTimeUs);
+                merged.changedPixels += latest.changedPixels;
+                merged.boxes.insert(merged.boxes.end(), latest.boxes.begin(), latest.boxes.end());
+                merged.moves.insert(merged.moves.end(), latest.moves.begin(), latest.moves.end());
+                merged.tracks.insert(merged.tracks.end(), latest.tracks.begin(), latest.tracks.end());
+                merged.activity.insert(merged.activity.end(), latest.activity.begin(), latest.activity.end());
+                MergedOutputEnd end;
+                end.output = i;
+                end.boxes = merged.boxes.size();
+                end.moves = merged.moves.size();
+                end.tracks = merged.tracks.size();
+                end.activity = merged.activity.size();
+                merged.outputEnds.push_back(end);
+                output.pending = false;
+            }
+        }
+
+        {
+            OVERLAY_METRICS_SCOPE(StageMetric::Render);
+            render.Render(merged);
+        }
+        // Latency of the newest output result in the merge
+        int64_t latencyUs = PipelineClockUs() - merged.captureTimeUs;
+        rendered.fetch_add(1, std::memory_order_relaxed);
+        totalLatencyUs.fetch_add(latencyUs, std::memory_order_relaxed);
+        if (latencyUs > maxLatencyUs.load(std::memory_order_relaxed)) {
+            maxLatencyUs.store(latencyUs, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef MULTI_OUTPUT_PIPELINE_H
+#define MULTI_OUTPUT_PIPELINE_H
+
+#include "frame_pipeline.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One display output watched by a MultiOutputPipeline
+struct OutputConfig {
+    CaptureStage* capture = nullptr;
+    // Where the output sits in the shared coordinate space; its size is the captured frame size
+    Box bounds;
+    PixelFormat format = PixelFormat::BGRA8;
+    // Optional hook on this output's detect thread, e.g. to record it
+    DetectListener* listener = nullptr;
+};
+
+// Watches several display outputs at once. Every output runs its own FramePipeline, so each has
+// its own capture, detect and render threads, frame ring, detector, tracker and scheduler, and
+// outputs never wait for each other. Results are moved into the shared coordinate space by the
+// output's origin; a merge thread combines the latest result of every output into one and hands
+// it to the render stage. Track IDs of output i are i + 1, i + 1 + n, ... so they stay unique.
+class MultiOutputPipeline {
+public:
+    // `config` holds the detection, tracking and pacing settings used for every output; its size,
+    // format and origin are taken from each output instead
+    MultiOutputPipeline(const PipelineConfig& config, const std::vector<OutputConfig>& outputs, RenderStage& render);
+    ~MultiOutputPipeline();
+
+    MultiOutputPipeline(const MultiOutputPipeline&) = delete;
+    MultiOutputPipeline& operator=(const MultiOutputPipeline&) = delete;
+
+    // Function to start every output's pipeline and the merge thread
+    void Start();
+
+    // Function to stop every output's pipeline and the merge thread; the render stage is not
+    // called after it returns
+    void Stop();
+
+    bool IsRunning() const { return mergeThread.joinable(); }
+    size_t OutputCount() const { return outputs.size(); }
+    const Box& OutputBounds(size_t output) const { return outputs[output]->bounds; }
+    // The pipeline of one output, for its detector settings and stats
+    const FramePipeline& Output(size_t output) const { return *outputs[output]->pipeline; }
+
+    // Function to replace the include and exclude regions, given in the shared coordinate space;
+    // each output gets the parts that fall on it. Safe while running.
+    void SetRegions(const std::vector<MaskRegion>& regions);
+    // Function to publish every output's detected frames to one event ring; call before Start
+    void SetEventRing(EventRingWriter* ring);
+    // Function to accumulate one output's changed tiles into a heatmap, in that output's tile
+    // grid; call before Start
+    void SetHeatmap(size_t output, Heatmap* heatmap) { outputs[output]->pipeline->SetHeatmap(heatmap); }
+    // Counters summed over the outputs; rendered frames and latency are those of merged results
+    PipelineStats Stats() const;
+
+private:
+    // Render stage of one output's pipeline: keeps its latest result for the merge thread
+    class OutputMailbox : public RenderStage {
+    public:
+        explicit OutputMailbox(MultiOutputPipeline& owner, size_t index) : owner(owner), index(index) {}
+        void Render(const PipelineResult& result) override { owner.Deliver(index, result); }
+
+    private:
+        MultiOutputPipeline& owner;
+        size_t index;
+    };
+
+    struct OutputState {
+        Box bounds;
+        std::unique_ptr<OutputMailbox> mailbox;
+        std::unique_ptr<FramePipeline> pipeline;
+        // Latest result, guarded by `mutex`; pending until the merge thread has taken it
+        PipelineResult latest;
+        bool hasResult = false;
+        bool pending = false;
+    };
+
+    void Deliver(size_t output, const PipelineResult& result);
+    void MergeLoop();
+
+    RenderStage& render;
+    std::vector<std::unique_ptr<OutputState>> outputs;
+    std::thread mergeThread;
+
+    // Guards every output's latest result and `changed`; held only to copy results in and out
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    bool changed = false;
+    bool stopping = false;
+
+    // Merged result, only touched by the merge thread
+    PipelineResult merged;
+    // Output results replaced by a newer one before the merge thread took them
+    std::atomic<uint64_t> staleResults{ 0 };
+    std::atomic<uint64_t> rendered{ 0 };
+    std::atomic<int64_t> totalLatencyUs{ 0 };
+    std::atomic<int64_t> maxLatencyUs{ 0 };
+};
+
+#endif // MULTI_OUTPUT_PIPELINE_H
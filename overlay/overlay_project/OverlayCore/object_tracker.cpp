@@ -0,0 +1,193 @@
+#include "object_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+ObjectTracker::ObjectTracker(const TrackerConfig& trackerConfig)
+    : config(trackerConfig), nextId(trackerConfig.firstId) {
+    config.idStep = std::max(config.idStep, 1u);
+    config.maxDistance = std::max(config.maxDistance, 1.0f);
+    config.velocitySmoothing = std::max(0.0f, std::min(config.velocitySmoothing, 1.0f));
+    config.maxTracks = std::max(config.maxTracks, 1);
+    // Cells at least maxDistance wide keep every match within the 3x3 neighbourhood
+    cellSize = config.maxDistance;
+    // maxTracks bounds the live tracks, so they never grow past this; a frame rarely has more
+    // candidate pairs than tracks
+    tracks.reserve(config.maxTracks);
+    candidates.reserve(config.maxTracks);
+}
+
+void ObjectTracker::Reset() {
+    tracks.clear();
+    stats = TrackerStats();
+}
+
+int ObjectTracker::CellCoordinate(float position) const {
+    return static_cast<int>(std::floor(position / cellSize));
+}
+
+size_t ObjectTracker::Bucket(int cellX, int cellY) const {
+    uint32_t hash = static_cast<uint32_t>(cellX) * 73856093u ^ static_cast<uint32_t>(cellY) * 19349663u;
+    return hash & bucketMask;
+}
+
+// Function to hash every track's predicted centre into the grid
+void ObjectTracker::BuildGrid() {
+    size_t bucketCount = 64;
+    while (bucketCount < tracks.size() * 2) {
+        bucketCount *= 2;
+    }
+    bucketMask = bucketCount - 1;
+    bucketHeads = scratch.Allocate<int>(bucketCount);
+    std::fill(bucketHeads, bucketHeads + bucketCount, -1);
+    nextInBucket = scratch.Allocate<int>(tracks.size());
+    predictedX = scratch.Allocate<float>(tracks.size());
+    predictedY = scratch.Allocate<float>(tracks.size());
+    trackCellX = scratch.Allocate<int>(tracks.size());
+    trackCellY = scratch.Allocate<int>(tracks.size());
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        const Track& track = tracks[i];
+        predictedX[i] = track.centerX + track.velocityX;
+        predictedY[i] = track.centerY + track.velocityY;
+        trackCellX[i] = CellCoordinate(predictedX[i]);
+        trackCellY[i] = CellCoordinate(predictedY[i]);
+        size_t bucket = Bucket(trackCellX[i], trackCellY[i]);
+        nextInBucket[i] = bucketHeads[bucket];
+        bucketHeads[bucket] = static_cast<int>(i);
+    }
+}
+
+// Function to collect every box-track pair within maxDistance from the 3x3 cells around each box
+void ObjectTracker::FindCandidates(const std::vector<Box>& boxes) {
+    const float maxDistanceSquared = config.maxDistance * config.maxDistance;
+    candidates.clear();
+    for (size_t b = 0; b < boxes.size(); ++b) {
+        float x = (boxes[b].left + boxes[b].right) * 0.5f;
+        float y = (boxes[b].top + boxes[b].bottom) * 0.5f;
+        int cellX = CellCoordinate(x);
+        int cellY = CellCoordinate(y);
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                size_t bucket = Bucket(cellX + dx, cellY + dy);
+                for (int t = bucketHeads[bucket]; t >= 0; t = nextInBucket[t]) {
+                    // Buckets can hold other cells' tracks, or be reached from two neighbouring
+                    // cells; only the centre's own cell may contribute the pair
+                    if (trackCellX[t] != cellX + dx || trackCellY[t] != cellY + dy) {
+                        continue;
+                    }
+                    float ex = predictedX[t] - x;
+                    float ey = predictedY[t] - y;
+                    float distanceSquared = ex * ex + ey * ey;
+                    if (distanceSquared <= maxDistanceSquared) {
+                        candidates.push_back({ distanceSquared, static_cast<int>(b), t });
+                    }
+                }
+            }
+        }
+    }
+    stats.candidates = candidates.size();
+}
+
+// Function to match this frame's boxes to the tracks and update them
+void ObjectTracker::Update(const std::vector<Box>& boxes) {
+    stats = TrackerStats();
+    scratch.Reset();
+    BuildGrid();
+    FindCandidates(boxes);
+
+    // Closest pairs first; ties keep the box order so results do not depend on the sort
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.distanceSquared != b.distanceSquared) {
+            return a.distanceSquared < b.distanceSquared;
+        }
+        return a.box != b.box ? a.box < b.box : a.track < b.track;
+    });
+    boxTrack = scratch.Allocate<int>(boxes.size());
+    std::fill(boxTrack, boxTrack + boxes.size(), -1);
+    trackMatched = scratch.Allocate<uint8_t>(tracks.size());
+    std::fill(trackMatched, trackMatched + tracks.size(), 0);
+    for (const Candidate& candidate : candidates) {
+        if (boxTrack[candidate.box] >= 0 || trackMatched[candidate.track]) {
+            continue;
+        }
+        boxTrack[candidate.box] = candidate.track;
+        trackMatched[candidate.track] = 1;
+    }
+
+    // Matched tracks take the box and fold the measured motion into their velocity
+    const float smoothing = config.velocitySmoothing;
+    for (size_t b = 0; b < boxes.size(); ++b) {
+        int t = boxTrack[b];
+        if (t < 0) {
+            continue;
+        }
+        Track& track = tracks[t];
+        float x = (boxes[b].left + boxes[b].right) * 0.5f;
+        float y = (boxes[b].top + boxes[b].bottom) * 0.5f;
+        // The last measured centre is missed + 1 frames old; coasting moved the estimate meanwhile
+        float lastX = track.centerX - track.velocityX * track.missed;
+        float lastY = track.centerY - track.velocityY * track.missed;
+        float measuredX = (x - lastX) / (track.missed + 1);
+        float measuredY = (y - lastY) / (track.missed + 1);
+        float weight = track.hits == 1 ? 1.0f : smoothing;
+        track.velocityX += (measuredX - track.velocityX) * weight;
+        track.velocityY += (measuredY - track.velocityY) * weight;
+        track.centerX = x;
+        track.centerY = y;
+        track.box = boxes[b];
+        track.hits++;
+        track.missed = 0;
+        stats.matched++;
+    }
+
+    // Unmatched tracks coast along their velocity until they have been missing too long or leave the frame
+    size_t kept = 0;
+    for (size_t t = 0; t < tracks.size(); ++t) {
+        Track& track = tracks[t];
+        track.age++;
+        if (!trackMatched[t]) {
+            track.missed++;
+            if (track.missed > config.maxMissedFrames) {
+                stats.dropped++;
+                continue;
+            }
+            int shiftX = static_cast<int>(std::lround(track.centerX + track.velocityX)) - static_cast<int>(std::lround(track.centerX));
+            int shiftY = static_cast<int>(std::lround(track.centerY + track.velocityY)) - static_cast<int>(std::lround(track.centerY));
+            track.centerX += track.velocityX;
+            track.centerY += track.velocityY;
+            if (frameWidth > 0 && (track.centerX < 0.0f || track.centerX >= frameWidth || track.centerY < 0.0f || track.centerY >= frameHeight)) {
+                stats.dropped++;
+                continue;
+            }
+            track.box.left += shiftX;
+            track.box.right += shiftX;
+            track.box.top += shiftY;
+            track.box.bottom += shiftY;
+        }
+        if (kept != t) {
+            tracks[kept] = track;
+        }
+        ++kept;
+    }
+    tracks.resize(kept);
+
+    // Unmatched boxes start new tracks while there is room
+    for (size_t b = 0; b < boxes.size(); ++b) {
+        if (boxTrack[b] >= 0) {
+            continue;
+        }
+        if (tracks.size() >= static_cast<size_t>(config.maxTracks)) {
+            stats.rejected++;
+            continue;
+        }
+        Track track;
+        track.id = nextId;
+        nextId += config.idStep;
+        track.box = boxes[b];
+        track.centerX = (boxes[b].left + boxes[b].right) * 0.5f;
+        track.centerY = (boxes[b].top + boxes[b].bottom) * 0.5f;
+        track.hits = 1;
+        tracks.push_back(track);
+        stats.created++;
+    }
+}
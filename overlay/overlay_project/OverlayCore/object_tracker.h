@@ -0,0 +1,123 @@
+#ifndef OBJECT_TRACKER_H
+#define OBJECT_TRACKER_H
+
+#include "box.h"
+#include "frame_arena.h"
+
+#include <cstdint>
+#include <vector>
+
+// Object followed across frames
+struct Track {
+    uint32_t id = 0;
+    // Latest estimate: the matched box, or the predicted box while the track is coasting
+    Box box;
+    // Box centre and its velocity in pixels per frame, smoothed over the matches
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    float velocityX = 0.0f;
+    float velocityY = 0.0f;
+    // Frames since the track started, frames it was matched in, and consecutive frames without a match
+    int age = 0;
+    int hits = 0;
+    int missed = 0;
+};
+
+// Settings for ObjectTracker
+struct TrackerConfig {
+    // A detection is matched to a track whose predicted centre is at most this many pixels away
+    float maxDistance = 48.0f;
+    // Weight of each new velocity measurement against the smoothed velocity (0..1]
+    float velocitySmoothing = 0.5f;
+    // Frames a track keeps moving along its prediction without a match before it is dropped
+    int maxMissedFrames = 5;
+    // Matches before a track is reported as confirmed, so one-frame noise does not get an ID
+    int minHits = 2;
+    // Upper bound on live tracks; detections beyond it start no track, which bounds the work per frame
+    int maxTracks = 8192;
+    // Track IDs are firstId, firstId + idStep, ...; trackers of different outputs use interleaved
+    // sequences so their IDs never collide
+    uint32_t firstId = 1;
+    uint32_t idStep = 1;
+};
+
+// Per-update counters
+struct TrackerStats {
+    size_t matched = 0;
+    size_t created = 0;
+    size_t dropped = 0;
+    // Detections that found no track and could not start one because maxTracks was reached
+    size_t rejected = 0;
+    // Detection-track pairs within maxDistance that were ranked for assignment
+    size_t candidates = 0;
+};
+
+// Associates each frame's detected boxes with persistent tracks. Track predictions are bucketed
+// into a spatial hash grid whose cells are maxDistance wide, so each detection only looks at the
+// tracks in its own and the eight neighbouring cells and association costs O(n) for n boxes
+// instead of comparing every pair. Candidate pairs are then assigned greedily, closest first.
+// Tracks and candidates are kept between updates and the rest of the matching state comes from a
+// frame arena, so steady-state frames do not allocate.
+class ObjectTracker {
+public:
+    explicit ObjectTracker(const TrackerConfig& config = TrackerConfig());
+
+    const TrackerConfig& Config() const { return config; }
+
+    // Function to match this frame's boxes to the tracks, advance unmatched tracks along their
+    // velocity and start tracks for unmatched boxes
+    void Update(const std::vector<Box>& boxes);
+
+    // Function to drop every track
+    void Reset();
+
+    // Function to set the size of the frames the boxes come from. A coasting track whose predicted
+    // centre leaves the frame is dropped, since its object went off screen; 0 leaves tracks unbounded.
+    void SetFrameSize(int width, int height) {
+        frameWidth = width;
+        frameHeight = height;
+    }
+
+    // Live tracks, including unconfirmed and coasting ones
+    const std::vector<Track>& Tracks() const { return tracks; }
+    bool IsConfirmed(const Track& track) const { return track.hits >= config.minHits; }
+    const TrackerStats& Stats() const { return stats; }
+
+private:
+    struct Candidate {
+        float distanceSquared;
+        int box;
+        int track;
+    };
+
+    int CellCoordinate(float position) const;
+    size_t Bucket(int cellX, int cellY) const;
+    void BuildGrid();
+    void FindCandidates(const std::vector<Box>& boxes);
+
+    TrackerConfig config;
+    int frameWidth = 0;
+    int frameHeight = 0;
+    float cellSize;
+    uint32_t nextId;
+    std::vector<Track> tracks;
+    TrackerStats stats;
+
+    // Matching state of one update, released at the start of the next
+    FrameArena scratch;
+
+    // Spatial hash of predicted track centres: bucket heads and a next link per track
+    size_t bucketMask = 0;
+    int* bucketHeads = nullptr;
+    int* nextInBucket = nullptr;
+    float* predictedX = nullptr;
+    float* predictedY = nullptr;
+    int* trackCellX = nullptr;
+    int* trackCellY = nullptr;
+
+    std::vector<Candidate> candidates;
+    int* boxTrack = nullptr;
+    uint8_t* trackMatched = nullptr;
+};
+
+#endif // OBJECT_TRACKER_H
@@ -0,0 +1,86 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+
+// Layout of the pixels in a captured frame. HDR desktops are duplicated as 10-bit or half-float
+// surfaces instead of 8-bit BGRA.
+enum class PixelFormat {
+    // DXGI_FORMAT_B8G8R8A8_UNORM
+    BGRA8,
+    // DXGI_FORMAT_R10G10B10A2_UNORM: red in bits 0-9, green 10-19, blue 20-29, alpha 30-31
+    RGB10A2,
+    // DXGI_FORMAT_R16G16B16A16_FLOAT: linear scRGB, 1.0 is SDR white
+    RGBA16F
+};
+
+// Compile-time description of each format. The kernels are templates over these traits and are
+// instantiated once per format, so the format is picked once per frame rather than per pixel.
+// Change detection compares the raw bytes; luma-based modes first convert pixels to 8-bit BGRA
+// (ToBgra8), which the SIMD kernels do in registers.
+struct Bgra8Traits {
+    static const PixelFormat kFormat = PixelFormat::BGRA8;
+    static const int kBytesPerPixel = 4;
+
+    static void ToBgra8(const uint8_t* pixel, uint8_t* bgra) { memcpy(bgra, pixel, 4); }
+};
+
+struct Rgb10A2Traits {
+    static const PixelFormat kFormat = PixelFormat::RGB10A2;
+    static const int kBytesPerPixel = 4;
+
+    // Keeps the top 8 bits of each colour channel and spreads the 2-bit alpha over 0..255
+    static void ToBgra8(const uint8_t* pixel, uint8_t* bgra) {
+        uint32_t value;
+        memcpy(&value, pixel, 4);
+        bgra[0] = static_cast<uint8_t>(value >> 22);
+        bgra[1] = static_cast<uint8_t>(value >> 12);
+        bgra[2] = static_cast<uint8_t>(value >> 2);
+        bgra[3] = static_cast<uint8_t>((value >> 30) * 85);
+    }
+};
+
+struct Rgba16FTraits {
+    static const PixelFormat kFormat = PixelFormat::RGBA16F;
+    static const int kBytesPerPixel = 8;
+
+    // Clamps a half float to [0, 1] and scales it to 0..255. Normal halves are widened by moving
+    // the exponent bias; zero and subnormals come out below 1/255 and round to 0.
+    static uint8_t HalfToUnorm8(uint16_t half) {
+        if (half & 0x8000) {
+            return 0;
+        }
+        uint32_t bits = (static_cast<uint32_t>(half) << 13) + (112u << 23);
+        float value;
+        memcpy(&value, &bits, 4);
+        value = value < 1.0f ? value : 1.0f;
+        return static_cast<uint8_t>(value * 255.0f + 0.5f);
+    }
+
+    static void ToBgra8(const uint8_t* pixel, uint8_t* bgra) {
+        uint16_t channels[4];
+        memcpy(channels, pixel, 8);
+        bgra[0] = HalfToUnorm8(channels[2]);
+        bgra[1] = HalfToUnorm8(channels[1]);
+        bgra[2] = HalfToUnorm8(channels[0]);
+        bgra[3] = HalfToUnorm8(channels[3]);
+    }
+};
+
+// Function to get the size of one pixel in bytes
+inline int PixelFormatBytes(PixelFormat format) {
+    return format == PixelFormat::RGBA16F ? Rgba16FTraits::kBytesPerPixel : Bgra8Traits::kBytesPerPixel;
+}
+
+// Function to get a printable format name
+inline const char* PixelFormatName(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::BGRA8: return "bgra8";
+    case PixelFormat::RGB10A2: return "rgb10a2";
+    case PixelFormat::RGBA16F: return "rgba16f";
+    }
+    return "unknown";
+}
+
+#endif // PIXEL_FORMAT_H
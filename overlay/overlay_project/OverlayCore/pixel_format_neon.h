@@ -0,0 +1,56 @@
+#ifndef PIXEL_FORMAT_NEON_H
+#define PIXEL_FORMAT_NEON_H
+
+// Internal: NEON conversion of four pixels of any format to 8-bit BGRA in one register, shared by
+// the ARM kernels.
+
+#include "pixel_format.h"
+
+#include <arm_neon.h>
+
+// Function to convert four half floats to 0..255 with the same bit manipulation as
+// Rgba16FTraits::HalfToUnorm8, so infinities and NaNs also agree with the scalar path
+static inline uint32x4_t HalfToUnorm8x4(uint16x4_t halves) {
+    uint32x4_t wide = vmovl_u16(halves);
+    uint32x4_t magnitude = vshlq_n_u32(vandq_u32(wide, vdupq_n_u32(0x7FFF)), 13);
+    float32x4_t value = vreinterpretq_f32_u32(vaddq_u32(magnitude, vdupq_n_u32(112u << 23)));
+    value = vminq_f32(value, vdupq_n_f32(1.0f));
+    uint32x4_t result = vcvtq_u32_f32(vmlaq_n_f32(vdupq_n_f32(0.5f), value, 255.0f));
+    uint32x4_t positive = vceqq_u32(vandq_u32(wide, vdupq_n_u32(0x8000)), vdupq_n_u32(0));
+    return vandq_u32(result, positive);
+}
+
+// Function to load four pixels starting at `pixels` as 16 bytes of BGRA
+template <class Traits>
+static inline uint8x16_t LoadBgra8x4(const uint8_t* pixels);
+
+template <>
+inline uint8x16_t LoadBgra8x4<Bgra8Traits>(const uint8_t* pixels) {
+    return vld1q_u8(pixels);
+}
+
+template <>
+inline uint8x16_t LoadBgra8x4<Rgb10A2Traits>(const uint8_t* pixels) {
+    const uint32x4_t byteMask = vdupq_n_u32(0xFF);
+    uint32x4_t value = vld1q_u32(reinterpret_cast<const uint32_t*>(pixels));
+    uint32x4_t blue = vandq_u32(vshrq_n_u32(value, 22), byteMask);
+    uint32x4_t green = vandq_u32(vshrq_n_u32(value, 12), byteMask);
+    uint32x4_t red = vandq_u32(vshrq_n_u32(value, 2), byteMask);
+    uint32x4_t alpha = vmulq_n_u32(vshrq_n_u32(value, 30), 85);
+    uint32x4_t bgra = vorrq_u32(vorrq_u32(blue, vshlq_n_u32(green, 8)), vorrq_u32(vshlq_n_u32(red, 16), vshlq_n_u32(alpha, 24)));
+    return vreinterpretq_u8_u32(bgra);
+}
+
+template <>
+inline uint8x16_t LoadBgra8x4<Rgba16FTraits>(const uint8_t* pixels) {
+    // Swaps red and blue within each pixel
+    static const uint8_t kToBgra[16] = { 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 };
+    uint16x8_t first = vld1q_u16(reinterpret_cast<const uint16_t*>(pixels));
+    uint16x8_t second = vld1q_u16(reinterpret_cast<const uint16_t*>(pixels + 16));
+    uint16x8_t low = vcombine_u16(vmovn_u32(HalfToUnorm8x4(vget_low_u16(first))), vmovn_u32(HalfToUnorm8x4(vget_high_u16(first))));
+    uint16x8_t high = vcombine_u16(vmovn_u32(HalfToUnorm8x4(vget_low_u16(second))), vmovn_u32(HalfToUnorm8x4(vget_high_u16(second))));
+    uint8x16_t rgba = vcombine_u8(vmovn_u16(low), vmovn_u16(high));
+    return vqtbl1q_u8(rgba, vld1q_u8(kToBgra));
+}
+
+#endif // PIXEL_FORMAT_NEON_H
@@ -0,0 +1,55 @@
+#ifndef PIXEL_FORMAT_SSE2_H
+#define PIXEL_FORMAT_SSE2_H
+
+// Internal: SSE2 conversion of four pixels of any format to 8-bit BGRA in one register, shared by
+// the x86 kernels. Static so each translation unit keeps a copy built with its own flags.
+
+#include "pixel_format.h"
+
+#include <emmintrin.h>
+
+// Function to convert four half floats, zero-extended into 32-bit lanes, to 0..255 like
+// Rgba16FTraits::HalfToUnorm8
+static inline __m128i HalfToUnorm8x4(__m128i halves) {
+    __m128i magnitude = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x7FFF)), 13);
+    __m128 value = _mm_castsi128_ps(_mm_add_epi32(magnitude, _mm_set1_epi32(112 << 23)));
+    __m128i positive = _mm_cmpeq_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), _mm_setzero_si128());
+    value = _mm_and_ps(_mm_min_ps(value, _mm_set1_ps(1.0f)), _mm_castsi128_ps(positive));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+// Function to load four pixels starting at `pixels` as 16 bytes of BGRA
+template <class Traits>
+static inline __m128i LoadBgra8x4(const uint8_t* pixels);
+
+template <>
+inline __m128i LoadBgra8x4<Bgra8Traits>(const uint8_t* pixels) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+}
+
+template <>
+inline __m128i LoadBgra8x4<Rgb10A2Traits>(const uint8_t* pixels) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+    __m128i blue = _mm_and_si128(_mm_srli_epi32(value, 22), byteMask);
+    __m128i green = _mm_and_si128(_mm_srli_epi32(value, 12), byteMask);
+    __m128i red = _mm_and_si128(_mm_srli_epi32(value, 2), byteMask);
+    // The alpha lanes hold 0..3, so a 16-bit multiply by 85 cannot carry into the upper half
+    __m128i alpha = _mm_mullo_epi16(_mm_srli_epi32(value, 30), _mm_set1_epi32(85));
+    return _mm_or_si128(_mm_or_si128(blue, _mm_slli_epi32(green, 8)), _mm_or_si128(_mm_slli_epi32(red, 16), _mm_slli_epi32(alpha, 24)));
+}
+
+template <>
+inline __m128i LoadBgra8x4<Rgba16FTraits>(const uint8_t* pixels) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+    __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 16));
+    // One pixel per register as R, G, B, A lanes, reordered to B, G, R, A
+    __m128i p0 = _mm_shuffle_epi32(HalfToUnorm8x4(_mm_unpacklo_epi16(first, zero)), _MM_SHUFFLE(3, 0, 1, 2));
+    __m128i p1 = _mm_shuffle_epi32(HalfToUnorm8x4(_mm_unpackhi_epi16(first, zero)), _MM_SHUFFLE(3, 0, 1, 2));
+    __m128i p2 = _mm_shuffle_epi32(HalfToUnorm8x4(_mm_unpacklo_epi16(second, zero)), _MM_SHUFFLE(3, 0, 1, 2));
+    __m128i p3 = _mm_shuffle_epi32(HalfToUnorm8x4(_mm_unpackhi_epi16(second, zero)), _MM_SHUFFLE(3, 0, 1, 2));
+    return _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+}
+
+#endif // PIXEL_FORMAT_SSE2_H
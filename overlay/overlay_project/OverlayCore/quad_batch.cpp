@@ -0,0 +1,169 @@
+#include "quad_batch.h"
+
+#include <algorithm>
+
+// Function to start a new frame for a render target of the given size in pixels
+void QuadBatch::Begin(int targetWidth, int targetHeight) {
+    vertices.clear();
+    quads.clear();
+    width = targetWidth;
+    height = targetHeight;
+    scaleX = targetWidth > 0 ? 2.0f / targetWidth : 0.0f;
+    scaleY = targetHeight > 0 ? 2.0f / targetHeight : 0.0f;
+}
+
+// Function to add a solid quad covering `box` (pixel coordinates, right/bottom exclusive)
+void QuadBatch::AddQuad(const Box& box, const QuadColor& color) {
+    // Pixel edges to clip space: x from -1 at the left edge, y from +1 at the top edge
+    float left = box.left * scaleX - 1.0f;
+    float right = box.right * scaleX - 1.0f;
+    float top = 1.0f - box.top * scaleY;
+    float bottom = 1.0f - box.bottom * scaleY;
+    QuadVertex topLeft = { left, top, 0.0f, color.r, color.g, color.b, color.a };
+    QuadVertex topRight = { right, top, 0.0f, color.r, color.g, color.b, color.a };
+    QuadVertex bottomLeft = { left, bottom, 0.0f, color.r, color.g, color.b, color.a };
+    QuadVertex bottomRight = { right, bottom, 0.0f, color.r, color.g, color.b, color.a };
+
+    // Two clockwise triangles sharing the top-right to bottom-left diagonal
+    quads.push_back(Quad{ box, color });
+    vertices.push_back(topLeft);
+    vertices.push_back(topRight);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(topRight);
+    vertices.push_back(bottomRight);
+}
+
+// Function to add one solid quad per box
+void QuadBatch::AddQuads(const std::vector<Box>& boxes, const QuadColor& color) {
+    // Grow geometrically, so a slowly rising box count does not reallocate every frame
+    size_t needed = quads.size() + boxes.size();
+    if (needed > quads.capacity()) {
+        Reserve(std::max(needed, quads.capacity() * 2));
+    }
+    for (const Box& box : boxes) {
+        AddQuad(box, color);
+    }
+}
+
+// Function to size the batch for `quadCount` quads
+void QuadBatch::Reserve(size_t quadCount) {
+    vertices.reserve(quadCount * kVerticesPerQuad);
+    quads.reserve(quadCount);
+}
+
+// Function to pack a colour into a BGRA8 pixel
+uint32_t PackBgra(const QuadColor& color) {
+    auto channel = [](float value) {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return static_cast<uint32_t>(value * 255.0f + 0.5f);
+    };
+    return channel(color.b) | (channel(color.g) << 8) | (channel(color.r) << 16) | (channel(color.a) << 24);
+}
+
+// Function to size the render target, clearing it to transparent black
+void SoftwareRasterBackend::Resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    pixels.assign(static_cast<size_t>(width) * height, 0);
+}
+
+void SoftwareRasterBackend::Clear(const QuadColor& color) {
+    std::fill(pixels.begin(), pixels.end(), PackBgra(color));
+    pixelsWritten += pixels.size();
+}
+
+bool SoftwareRasterBackend::Draw(const QuadBatch& batch) {
+    if (batch.TargetWidth() != width || batch.TargetHeight() != height) {
+        return false;
+    }
+    const QuadVertex* vertices = batch.Vertices();
+    for (size_t i = 0; i + 2 < batch.VertexCount(); i += 3) {
+        DrawTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+    }
+    return true;
+}
+
+FrameView SoftwareRasterBackend::View() const {
+    FrameView view;
+    view.pixels = reinterpret_cast<const uint8_t*>(pixels.data());
+    view.width = width;
+    view.height = height;
+    view.rowPitch = width * 4;
+    return view;
+}
+
+// Vertex positions are snapped to 1/256 pixel like Direct3D's rasterizer, so edge tests are exact
+static const int kSubpixelBits = 8;
+static const int64_t kSubpixelOne = 1 << kSubpixelBits;
+
+struct FixedVertex {
+    int64_t x, y;
+};
+
+static int64_t Orient(const FixedVertex& a, const FixedVertex& b, int64_t x, int64_t y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+// Function to apply the top-left rule: samples exactly on an edge belong to the triangle only
+// if it is a top edge (horizontal, above the interior) or a left edge
+static int64_t EdgeBias(const FixedVertex& a, const FixedVertex& b) {
+    bool topLeft = (b.y == a.y && b.x > a.x) || b.y < a.y;
+    return topLeft ? 0 : -1;
+}
+
+void SoftwareRasterBackend::DrawTriangle(const QuadVertex& v0, const QuadVertex& v1, const QuadVertex& v2) {
+    // Clip space to fixed-point pixel coordinates
+    float halfWidth = width * 0.5f * kSubpixelOne;
+    float halfHeight = height * 0.5f * kSubpixelOne;
+    auto toFixed = [&](const QuadVertex& v) {
+        FixedVertex p = { static_cast<int64_t>((v.x + 1.0f) * halfWidth + 0.5f), static_cast<int64_t>((1.0f - v.y) * halfHeight + 0.5f) };
+        return p;
+    };
+    FixedVertex a = toFixed(v0);
+    FixedVertex b = toFixed(v1);
+    FixedVertex c = toFixed(v2);
+    int64_t area = Orient(a, b, c.x, c.y);
+    if (area == 0) {
+        return;
+    }
+    if (area < 0) {
+        std::swap(b, c);
+    }
+
+    int64_t minX = std::max<int64_t>(0, std::min({ a.x, b.x, c.x }) >> kSubpixelBits);
+    int64_t minY = std::max<int64_t>(0, std::min({ a.y, b.y, c.y }) >> kSubpixelBits);
+    int64_t maxX = std::min<int64_t>(width - 1, std::max({ a.x, b.x, c.x }) >> kSubpixelBits);
+    int64_t maxY = std::min<int64_t>(height - 1, std::max({ a.y, b.y, c.y }) >> kSubpixelBits);
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    // Edge values at the first sample (pixel centre) and their steps per pixel
+    int64_t sampleX = (minX << kSubpixelBits) + kSubpixelOne / 2;
+    int64_t sampleY = (minY << kSubpixelBits) + kSubpixelOne / 2;
+    int64_t row0 = Orient(b, c, sampleX, sampleY) + EdgeBias(b, c);
+    int64_t row1 = Orient(c, a, sampleX, sampleY) + EdgeBias(c, a);
+    int64_t row2 = Orient(a, b, sampleX, sampleY) + EdgeBias(a, b);
+    int64_t stepX0 = -(c.y - b.y) * kSubpixelOne, stepY0 = (c.x - b.x) * kSubpixelOne;
+    int64_t stepX1 = -(a.y - c.y) * kSubpixelOne, stepY1 = (a.x - c.x) * kSubpixelOne;
+    int64_t stepX2 = -(b.y - a.y) * kSubpixelOne, stepY2 = (b.x - a.x) * kSubpixelOne;
+
+    uint32_t color = PackBgra({ v0.r, v0.g, v0.b, v0.a });
+    for (int64_t y = minY; y <= maxY; ++y) {
+        int64_t w0 = row0, w1 = row1, w2 = row2;
+        uint32_t* row = pixels.data() + y * width;
+        for (int64_t x = minX; x <= maxX; ++x) {
+            if ((w0 | w1 | w2) >= 0) {
+                row[x] = color;
+                ++pixelsWritten;
+            }
+            w0 += stepX0;
+            w1 += stepX1;
+            w2 += stepX2;
+        }
+        row0 += stepY0;
+        row1 += stepY1;
+        row2 += stepY2;
+    }
+}
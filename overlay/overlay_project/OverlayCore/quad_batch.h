@@ -0,0 +1,109 @@
+#ifndef QUAD_BATCH_H
+#define QUAD_BATCH_H
+
+#include "box.h"
+#include "frame_diff.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// RGBA colour with components in [0, 1]
+struct QuadColor {
+    float r, g, b, a;
+};
+
+// Vertex written by QuadBatch: clip-space position and colour, laid out like the overlay's
+// POSITION (R32G32B32_FLOAT) and COLOR (R32G32B32A32_FLOAT) input layout
+struct QuadVertex {
+    float x, y, z;
+    float r, g, b, a;
+};
+
+static_assert(sizeof(QuadVertex) == 28, "QuadVertex must match the shader input layout");
+
+// A quad as it was added to a batch, kept next to its vertices for damage tracking
+struct Quad {
+    Box box;
+    QuadColor color;
+};
+
+// Collects every quad drawn in a frame into one CPU-side triangle list (six vertices per quad),
+// so a backend can upload and draw the whole frame at once. The vertex storage is kept across
+// frames and only grows.
+class QuadBatch {
+public:
+    static const int kVerticesPerQuad = 6;
+
+    // Function to start a new frame for a render target of the given size in pixels
+    void Begin(int targetWidth, int targetHeight);
+
+    // Function to add a solid quad covering `box` (pixel coordinates, right/bottom exclusive)
+    void AddQuad(const Box& box, const QuadColor& color);
+
+    // Function to add one solid quad per box
+    void AddQuads(const std::vector<Box>& boxes, const QuadColor& color);
+
+    // Function to size the batch for `quadCount` quads, so frames with no more never allocate
+    void Reserve(size_t quadCount);
+
+    const QuadVertex* Vertices() const { return vertices.data(); }
+    // The quads in drawing order
+    const std::vector<Quad>& Quads() const { return quads; }
+    size_t VertexCount() const { return vertices.size(); }
+    size_t QuadCount() const { return vertices.size() / kVerticesPerQuad; }
+    int TargetWidth() const { return width; }
+    int TargetHeight() const { return height; }
+
+private:
+    std::vector<QuadVertex> vertices;
+    std::vector<Quad> quads;
+    int width = 0;
+    int height = 0;
+    float scaleX = 0.0f;
+    float scaleY = 0.0f;
+};
+
+// Draws batches onto a render target. A backend submits each batch as a single draw.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+
+    // Function to fill the whole render target with one colour
+    virtual void Clear(const QuadColor& color) = 0;
+
+    // Function to draw every quad in the batch over the current target contents
+    virtual bool Draw(const QuadBatch& batch) = 0;
+};
+
+// Rasterizes batches on the CPU into a BGRA image, using the same pixel-centre coverage rules
+// as Direct3D and no blending. Used to test and benchmark batches without a GPU.
+class SoftwareRasterBackend : public RenderBackend {
+public:
+    // Function to size the render target, clearing it to transparent black
+    void Resize(int newWidth, int newHeight);
+
+    void Clear(const QuadColor& color) override;
+    // Fails if the batch was built for a different target size
+    bool Draw(const QuadBatch& batch) override;
+
+    // The rendered image; valid until the next Resize
+    FrameView View() const;
+    const std::vector<uint32_t>& Pixels() const { return pixels; }
+    // Pixels written by Clear and Draw since the last reset, to measure redraw cost
+    uint64_t PixelsWritten() const { return pixelsWritten; }
+    void ResetPixelsWritten() { pixelsWritten = 0; }
+
+private:
+    void DrawTriangle(const QuadVertex& v0, const QuadVertex& v1, const QuadVertex& v2);
+
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+    uint64_t pixelsWritten = 0;
+};
+
+// Function to pack a colour into a BGRA8 pixel
+uint32_t PackBgra(const QuadColor& color);
+
+#endif // QUAD_BATCH_H
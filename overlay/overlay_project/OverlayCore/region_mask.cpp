@@ -0,0 +1,154 @@
+#include "region_mask.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// Function to set the frame and tile size
+void RegionMask::Resize(int frameWidth, int frameHeight, int newTileSize) {
+    width = frameWidth;
+    height = frameHeight;
+    tileSize = newTileSize;
+    cols = (width + tileSize - 1) / tileSize;
+    rows = (height + tileSize - 1) / tileSize;
+    wordsPerRow = (width + 63) / 64;
+}
+
+// Function to compile `regions` for a frame; an empty list activates every tile
+void RegionMask::Compile(const std::vector<MaskRegion>& regions, int frameWidth, int frameHeight, int newTileSize) {
+    Resize(frameWidth, frameHeight, newTileSize);
+
+    // Tile flags: 1 active, 0 inactive; exclusions are applied after inclusions
+    std::vector<uint8_t>& active = tileFlags;
+    active.assign(static_cast<size_t>(cols) * rows, 1);
+    bool hasInclude = false;
+    for (const MaskRegion& region : regions) {
+        hasInclude = hasInclude || region.rule == MaskRule::Include;
+    }
+    if (hasInclude) {
+        std::fill(active.begin(), active.end(), static_cast<uint8_t>(0));
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+        MaskRule rule = pass == 0 ? MaskRule::Include : MaskRule::Exclude;
+        for (const MaskRegion& region : regions) {
+            if (region.rule != rule) {
+                continue;
+            }
+            // Every tile the rectangle touches, clipped to the frame
+            int left = std::max(region.box.left, 0);
+            int top = std::max(region.box.top, 0);
+            int right = std::min(region.box.right, width);
+            int bottom = std::min(region.box.bottom, height);
+            if (right <= left || bottom <= top) {
+                continue;
+            }
+            for (int ty = top / tileSize; ty <= (bottom - 1) / tileSize; ++ty) {
+                for (int tx = left / tileSize; tx <= (right - 1) / tileSize; ++tx) {
+                    active[static_cast<size_t>(ty) * cols + tx] = rule == MaskRule::Include ? 1 : 0;
+                }
+            }
+        }
+    }
+
+    Build(active.data());
+}
+
+// Function to compile from one flag per tile instead, non-zero for active
+void RegionMask::CompileTiles(const std::vector<uint8_t>& activeTiles, int frameWidth, int frameHeight, int newTileSize) {
+    Resize(frameWidth, frameHeight, newTileSize);
+    Build(activeTiles.data());
+}
+
+// Function to size the storage for a frame up front
+void RegionMask::Reserve(int frameWidth, int frameHeight, int newTileSize) {
+    size_t tileCols = (frameWidth + newTileSize - 1) / newTileSize;
+    size_t tileRows = (frameHeight + newTileSize - 1) / newTileSize;
+    size_t maskWords = tileRows * ((frameWidth + 63) / 64);
+    tileFlags.reserve(tileCols * tileRows);
+    tileBits.reserve((tileCols * tileRows + 63) / 64);
+    runs.reserve(tileRows * ((tileCols + 1) / 2));
+    runStart.reserve(tileRows + 1);
+    words.reserve(maskWords);
+    keepBits.reserve(maskWords);
+}
+
+// Function to derive the tile bits, runs and mask words from the tile flags
+void RegionMask::Build(const uint8_t* active) {
+    size_t tileCount = static_cast<size_t>(cols) * rows;
+    tileBits.assign((tileCount + 63) / 64, 0);
+    // At most every other tile starts a run
+    runs.reserve(static_cast<size_t>(rows) * ((cols + 1) / 2));
+    runs.clear();
+    runStart.assign(rows + 1, 0);
+    words.assign(static_cast<size_t>(rows) * wordsPerRow, 0);
+    keepBits.assign(static_cast<size_t>(rows) * wordsPerRow, 0);
+    activeCount = 0;
+    for (int ty = 0; ty < rows; ++ty) {
+        runStart[ty] = static_cast<int>(runs.size());
+        uint8_t* rowWords = &words[static_cast<size_t>(ty) * wordsPerRow];
+        uint64_t* rowKeep = &keepBits[static_cast<size_t>(ty) * wordsPerRow];
+        for (int tx = 0; tx < cols;) {
+            if (!active[static_cast<size_t>(ty) * cols + tx]) {
+                ++tx;
+                continue;
+            }
+            TileRun run;
+            run.first = tx;
+            while (tx < cols && active[static_cast<size_t>(ty) * cols + tx]) {
+                size_t index = static_cast<size_t>(ty) * cols + tx;
+                tileBits[index >> 6] |= 1ull << (index & 63);
+                ++tx;
+            }
+            run.last = tx;
+            runs.push_back(run);
+            activeCount += run.last - run.first;
+
+            // Mask bits of the run's pixels, and the words they fall into
+            int right = std::min(run.last * tileSize, width);
+            for (int x = run.first * tileSize; x < right;) {
+                int bit = x & 63;
+                int span = std::min(64 - bit, right - x);
+                rowKeep[x >> 6] |= span == 64 ? ~0ull : ((1ull << span) - 1) << bit;
+                rowWords[x >> 6] = 1;
+                x += span;
+            }
+        }
+    }
+    runStart[rows] = static_cast<int>(runs.size());
+    allActive = activeCount == tileCount;
+}
+
+// Function to read regions from a text file, one "include|exclude left top right bottom" per line
+bool LoadMaskRegions(const char* path, std::vector<MaskRegion>& regions) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    std::vector<MaskRegion> loaded;
+    char line[256];
+    bool valid = true;
+    while (valid && fgets(line, sizeof(line), file)) {
+        char rule[16];
+        MaskRegion region;
+        const char* text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0') {
+            continue;
+        }
+        if (sscanf(text, "%15s %d %d %d %d", rule, &region.box.left, &region.box.top, &region.box.right, &region.box.bottom) != 5) {
+            valid = false;
+        } else if (strcmp(rule, "include") == 0) {
+            region.rule = MaskRule::Include;
+            loaded.push_back(region);
+        } else if (strcmp(rule, "exclude") == 0) {
+            region.rule = MaskRule::Exclude;
+            loaded.push_back(region);
+        } else {
+            valid = false;
+        }
+    }
+    fclose(file);
+    if (valid) {
+        regions.swap(loaded);
+    }
+    return valid;
+}
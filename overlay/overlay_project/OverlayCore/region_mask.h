@@ -0,0 +1,95 @@
+#ifndef REGION_MASK_H
+#define REGION_MASK_H
+
+#include "box.h"
+
+#include <cstdint>
+#include <vector>
+
+// Whether a region limits detection to itself or removes itself from detection
+enum class MaskRule {
+    Include,
+    Exclude
+};
+
+// Screen rectangle in frame pixels with its rule
+struct MaskRegion {
+    MaskRule rule = MaskRule::Exclude;
+    Box box;
+};
+
+// Run of active tiles [first, last) within one tile row
+struct TileRun {
+    int first = 0;
+    int last = 0;
+};
+
+// Include and exclude rectangles compiled for one frame size and tile size. A tile is active when
+// it touches an include region, or there are none, and touches no exclude region; rounding out
+// to whole tiles means a masked clock or video never leaks into neighbouring tiles. Besides one
+// bit per tile, each tile row keeps its runs of active tiles, a flag per 64-pixel change mask
+// word that overlaps an active tile, and the mask bits of the active tiles' pixels, so the
+// detector can skip inactive tiles before reading their pixels.
+class RegionMask {
+public:
+    // Function to compile `regions` for a frame; an empty list activates every tile
+    void Compile(const std::vector<MaskRegion>& regions, int frameWidth, int frameHeight, int newTileSize);
+
+    // Function to compile from one flag per tile in row-major order instead, non-zero for active.
+    // Reuses the mask's storage, so recompiling for the same frame size does not allocate.
+    void CompileTiles(const std::vector<uint8_t>& activeTiles, int frameWidth, int frameHeight, int newTileSize);
+
+    // Function to size the storage for a frame up front, so the first compile for that frame size
+    // does not allocate either
+    void Reserve(int frameWidth, int frameHeight, int newTileSize);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int TileSize() const { return tileSize; }
+    // True when every tile is active, so the detector can ignore the mask
+    bool AllActive() const { return allActive; }
+    size_t ActiveCount() const { return activeCount; }
+
+    bool IsActive(int tx, int ty) const {
+        size_t index = static_cast<size_t>(ty) * cols + tx;
+        return (tileBits[index >> 6] >> (index & 63)) & 1;
+    }
+
+    // Function to get the runs of active tiles in tile row `ty`
+    const TileRun* RowRuns(int ty, int& count) const {
+        count = runStart[ty + 1] - runStart[ty];
+        return runs.data() + runStart[ty];
+    }
+
+    // Per 64-pixel mask word of tile row `ty`: non-zero if the word overlaps an active tile
+    const uint8_t* RowWords(int ty) const { return words.data() + static_cast<size_t>(ty) * wordsPerRow; }
+
+    // Change mask bits of the active tiles' pixels in tile row `ty`
+    const uint64_t* RowKeepBits(int ty) const { return keepBits.data() + static_cast<size_t>(ty) * wordsPerRow; }
+
+private:
+    void Resize(int frameWidth, int frameHeight, int newTileSize);
+    void Build(const uint8_t* active);
+
+    int width = 0;
+    int height = 0;
+    int tileSize = 0;
+    int cols = 0;
+    int rows = 0;
+    int wordsPerRow = 0;
+    bool allActive = true;
+    size_t activeCount = 0;
+    std::vector<uint8_t> tileFlags;
+    std::vector<uint64_t> tileBits;
+    std::vector<TileRun> runs;
+    std::vector<int> runStart;
+    std::vector<uint8_t> words;
+    std::vector<uint64_t> keepBits;
+};
+
+// Function to read regions from a text file with one "include|exclude left top right bottom"
+// line per rectangle (right and bottom exclusive); blank lines and lines starting with # are
+// skipped. Returns false if the file cannot be read or a line is malformed.
+bool LoadMaskRegions(const char* path, std::vector<MaskRegion>& regions);
+
+#endif // REGION_MASK_H
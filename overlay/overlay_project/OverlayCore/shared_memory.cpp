@@ -0,0 +1,147 @@
+#include "shared_memory.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SharedMemory::~SharedMemory() {
+    Close();
+}
+
+#if defined(_WIN32)
+// Function to create (or replace) a zero-filled region of `size` bytes, mapped read-write
+bool SharedMemory::Create(const char* name, size_t size) {
+    Close();
+    objectName = std::string("Local\\") + name;
+    unsigned long long bytes = size;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(bytes >> 32),
+                                        static_cast<DWORD>(bytes), objectName.c_str());
+    if (!mapping) {
+        return false;
+    }
+    // Another overlay still holds the name; its mapping may be smaller than ours
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(mapping);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+    data = static_cast<uint8_t*>(view);
+    this->size = size;
+    owner = true;
+    return true;
+}
+
+// Function to map an existing region read-only
+bool SharedMemory::Open(const char* name) {
+    Close();
+    objectName = std::string("Local\\") + name;
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, objectName.c_str());
+    if (!mapping) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    // Paging-file mappings do not report their size; the view covers whole pages of it
+    MEMORY_BASIC_INFORMATION info;
+    if (VirtualQuery(view, &info, sizeof(info)) == 0) {
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+    data = static_cast<uint8_t*>(view);
+    size = info.RegionSize;
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (data) {
+        UnmapViewOfFile(data);
+        CloseHandle(mappingHandle);
+    }
+    data = nullptr;
+    size = 0;
+    owner = false;
+    mappingHandle = nullptr;
+}
+#else
+// Function to turn a name into a POSIX shm object name, which must start with a slash
+static std::string ShmName(const char* name) {
+    return name[0] == '/' ? std::string(name) : std::string("/") + name;
+}
+
+// Function to create (or replace) a zero-filled region of `size` bytes, mapped read-write
+bool SharedMemory::Create(const char* name, size_t size) {
+    Close();
+    objectName = ShmName(name);
+    // A region left behind by a crashed writer is replaced; readers still mapping it keep the old one
+    shm_unlink(objectName.c_str());
+    int fd = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(objectName.c_str());
+        return false;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        shm_unlink(objectName.c_str());
+        return false;
+    }
+    data = static_cast<uint8_t*>(view);
+    this->size = size;
+    owner = true;
+    return true;
+}
+
+// Function to map an existing region read-only
+bool SharedMemory::Open(const char* name) {
+    Close();
+    objectName = ShmName(name);
+    int fd = shm_open(objectName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data = static_cast<uint8_t*>(view);
+    size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (data) {
+        munmap(data, size);
+        if (owner) {
+            shm_unlink(objectName.c_str());
+        }
+    }
+    data = nullptr;
+    size = 0;
+    owner = false;
+}
+#endif
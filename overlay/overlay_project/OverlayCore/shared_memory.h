@@ -0,0 +1,39 @@
+#ifndef SHARED_MEMORY_H
+#define SHARED_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Named shared memory region: a POSIX shm object (/dev/shm/<name>) or a Windows paging-file
+// mapping (Local\<name>). The creator owns the name and removes it on Close; other processes open
+// it read-only.
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Function to create (or replace) a zero-filled region of `size` bytes, mapped read-write
+    bool Create(const char* name, size_t size);
+    // Function to map an existing region read-only
+    bool Open(const char* name);
+    void Close();
+
+    bool IsOpen() const { return data != nullptr; }
+    uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    bool owner = false;
+    std::string objectName;
+#if defined(_WIN32)
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif // SHARED_MEMORY_H
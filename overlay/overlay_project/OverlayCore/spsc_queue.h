@@ -0,0 +1,73 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Storage is allocated once by the constructor; pushes and pops never allocate.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : slots(RoundUpPowerOfTwo(capacity + 1)), indexMask(slots.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Function to append a value, returns false if the queue is full (producer only)
+    bool TryPush(const T& value) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & indexMask;
+        if (next == cachedHead) {
+            cachedHead = headIndex.load(std::memory_order_acquire);
+            if (next == cachedHead) {
+                return false;
+            }
+        }
+        slots[tail] = value;
+        tailIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Function to remove the oldest value, returns false if the queue is empty (consumer only)
+    bool TryPop(T& value) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tailIndex.load(std::memory_order_acquire);
+            if (head == cachedTail) {
+                return false;
+            }
+        }
+        value = slots[head];
+        headIndex.store((head + 1) & indexMask, std::memory_order_release);
+        return true;
+    }
+
+    // Function to check for queued values (consumer only)
+    bool Empty() const {
+        return headIndex.load(std::memory_order_relaxed) == tailIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t RoundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<T> slots;
+    const size_t indexMask;
+
+    // Producer and consumer indices live on separate cache lines, each with a cached copy
+    // of the other side's index so most operations touch only their own line
+    alignas(64) std::atomic<size_t> headIndex{ 0 };
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tailIndex{ 0 };
+    size_t cachedHead = 0;
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,130 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+// threadCount includes the calling thread; 0 picks the hardware concurrency
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    // Worker 0 is whichever thread calls ParallelFor
+    for (int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Function to run task(i) for every i in [0, count) and wait until all have finished
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& task) {
+    if (count <= 0) {
+        return;
+    }
+    if (threads.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    // Deal out equal contiguous slices; stealing evens out bands that turn out to be expensive
+    job = &task;
+    remaining.store(count, std::memory_order_relaxed);
+    int workers = ThreadCount();
+    for (int i = 0; i < workers; ++i) {
+        std::lock_guard<std::mutex> lock(queues[i]->mutex);
+        queues[i]->begin = static_cast<int>(static_cast<int64_t>(count) * i / workers);
+        queues[i]->end = static_cast<int>(static_cast<int64_t>(count) * (i + 1) / workers);
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        ++generation;
+    }
+    jobReady.notify_all();
+
+    RunTasks(0);
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobDone.wait(lock, [this] { return remaining.load(std::memory_order_acquire) == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::WorkerLoop(int worker) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        RunTasks(worker);
+    }
+}
+
+void ThreadPool::RunTasks(int worker) {
+    int index;
+    for (;;) {
+        if (!PopTask(worker, index)) {
+            if (!StealTasks(worker)) {
+                return;
+            }
+            continue;
+        }
+        (*job)(index);
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            jobDone.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::PopTask(int worker, int& index) {
+    TaskQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin >= queue.end) {
+        return false;
+    }
+    index = queue.begin++;
+    return true;
+}
+
+// Function to move the back half of the first non-empty victim queue into this worker's queue
+bool ThreadPool::StealTasks(int worker) {
+    int workers = ThreadCount();
+    for (int offset = 1; offset < workers; ++offset) {
+        TaskQueue& victim = *queues[(worker + offset) % workers];
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            int available = victim.end - victim.begin;
+            if (available <= 0) {
+                continue;
+            }
+            int take = (available + 1) / 2;
+            end = victim.end;
+            begin = end - take;
+            victim.end = begin;
+        }
+        TaskQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads with per-worker work-stealing queues.
+// Threads are created once and parked between jobs, so per-frame jobs cost no thread creation.
+class ThreadPool {
+public:
+    // threadCount includes the calling thread; 0 picks the hardware concurrency
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int ThreadCount() const { return static_cast<int>(queues.size()); }
+
+    // Function to run task(i) for every i in [0, count) and wait until all have finished.
+    // The calling thread takes part; idle workers steal from the back of busy workers' queues.
+    void ParallelFor(int count, const std::function<void(int)>& task);
+
+private:
+    // Contiguous range of task indices. The owner pops from the front, thieves take the back half.
+    struct TaskQueue {
+        std::mutex mutex;
+        int begin = 0;
+        int end = 0;
+    };
+
+    void WorkerLoop(int worker);
+    void RunTasks(int worker);
+    bool PopTask(int worker, int& index);
+    bool StealTasks(int worker);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    const std::function<void(int)>* job = nullptr;
+    std::atomic<int> remaining{ 0 };
+};
+
+#endif // THREAD_POOL_H
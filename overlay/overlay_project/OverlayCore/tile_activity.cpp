@@ -0,0 +1,108 @@
+#include "tile_activity.h"
+#include "bit_utils.h"
+
+#include <algorithm>
+
+TileActivity::TileActivity(const TileSamplingConfig& samplingConfig)
+    : config(samplingConfig) {
+    config.sampleInterval = std::max(config.sampleInterval, 0);
+    config.hotFrames = std::max(1, std::min(config.hotFrames, 32));
+    config.quietSamples = std::max(1, std::min(config.quietSamples, 255));
+}
+
+// Function to size the statistics for a frame's tile grid, forgetting every tile's history
+void TileActivity::Resize(int frameWidth, int frameHeight, int tileSize) {
+    demotedTiles.Resize(frameWidth, frameHeight, tileSize);
+    size_t tileCount = demotedTiles.dirty.size();
+    history.assign(tileCount, 0);
+    demoted.assign(tileCount, 0);
+    quiet.assign(tileCount, 0);
+    frameTiles.assign(tileCount, 1);
+    regions.clear();
+    regions.reserve(tileCount);
+    extractor.Reserve(tileCount);
+    demotedCount = 0;
+    skippedCount = 0;
+}
+
+// Function to start the next frame, compiling the tiles compared in it into `frameMask`
+bool TileActivity::BeginFrame(const RegionMask& regionMask, RegionMask& frameMask) {
+    skippedCount = 0;
+    if (demotedCount == 0) {
+        return false;
+    }
+    const TileMap& grid = demotedTiles;
+    bool allActive = regionMask.AllActive();
+    for (int ty = 0; ty < grid.rows; ++ty) {
+        // Each tile row is sampled in a different frame of the interval
+        bool sampled = (frame + ty) % config.sampleInterval == 0;
+        for (int tx = 0; tx < grid.cols; ++tx) {
+            int index = grid.Index(tx, ty);
+            bool active = allActive || regionMask.IsActive(tx, ty);
+            if (active && demoted[index] && !sampled) {
+                active = false;
+                ++skippedCount;
+            }
+            frameTiles[index] = active ? 1 : 0;
+        }
+    }
+    frameMask.CompileTiles(frameTiles, grid.width, grid.height, grid.tileSize);
+    return true;
+}
+
+// Function to fold the comparison of tile rows [firstRow, lastRow) into the statistics
+bool TileActivity::UpdateRows(TileMap& tiles, const RegionMask* compared, int firstRow, int lastRow) {
+    bool changed = false;
+    for (int ty = firstRow; ty < lastRow; ++ty) {
+        for (int tx = 0; tx < tiles.cols; ++tx) {
+            if (compared && !compared->IsActive(tx, ty)) {
+                continue;
+            }
+            int index = tiles.Index(tx, ty);
+            bool dirty = tiles.dirty[index] != 0;
+            if (demoted[index]) {
+                // Sampled this frame; demoted tiles are reported as regions, never as boxes
+                tiles.dirty[index] = 0;
+                quiet[index] = dirty ? 0 : static_cast<uint8_t>(quiet[index] + 1);
+                if (quiet[index] >= config.quietSamples) {
+                    demoted[index] = 0;
+                    history[index] = 0;
+                    changed = true;
+                }
+                continue;
+            }
+            history[index] = (history[index] << 1) | (dirty ? 1u : 0u);
+            if (dirty && PopCount64(history[index]) >= config.hotFrames) {
+                demoted[index] = 1;
+                quiet[index] = 0;
+                tiles.dirty[index] = 0;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+// Function to finish the frame, rebuilding the activity regions when `changed`
+void TileActivity::EndFrame(bool changed) {
+    ++frame;
+    if (!changed) {
+        return;
+    }
+    TileMap& grid = demotedTiles;
+    grid.Clear();
+    demotedCount = 0;
+    for (int ty = 0; ty < grid.rows; ++ty) {
+        for (int tx = 0; tx < grid.cols; ++tx) {
+            int index = grid.Index(tx, ty);
+            if (!demoted[index]) {
+                continue;
+            }
+            ++demotedCount;
+            int left = tx * grid.tileSize;
+            int top = ty * grid.tileSize;
+            grid.MarkPixels(index, left, top, std::min(left + grid.tileSize, grid.width), std::min(top + grid.tileSize, grid.height));
+        }
+    }
+    extractor.Extract(grid, regions);
+}
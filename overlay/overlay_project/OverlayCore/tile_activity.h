@@ -0,0 +1,78 @@
+#ifndef TILE_ACTIVITY_H
+#define TILE_ACTIVITY_H
+
+#include "box.h"
+#include "region_mask.h"
+#include "tile_map.h"
+
+#include <cstdint>
+#include <vector>
+
+// Settings for TileActivity
+struct TileSamplingConfig {
+    // Frames between comparisons of a demoted tile; 0 compares every tile in every frame
+    int sampleInterval = 0;
+    // A tile is demoted when it changed in at least this many of the last 32 frames it was
+    // compared in, e.g. a playing video or an animated ad
+    int hotFrames = 28;
+    // A demoted tile is promoted back after this many samples in a row without a change
+    int quietSamples = 2;
+};
+
+// Per-tile change statistics that demote tiles changing in most frames to a lower sampling rate.
+// Each tile keeps a 32-frame history of whether it changed. Demoted tiles are only compared in
+// every sampleInterval-th frame, staggered by tile row so the saved work is spread evenly, and are
+// left out of the boxes: 8-connected groups of them are reported as persistent activity regions
+// instead. A demoted tile that shows no change in quietSamples samples is compared every frame
+// again, so transient motion elsewhere keeps full responsiveness.
+class TileActivity {
+public:
+    explicit TileActivity(const TileSamplingConfig& config = TileSamplingConfig());
+
+    const TileSamplingConfig& Config() const { return config; }
+    bool Enabled() const { return config.sampleInterval > 0; }
+
+    // Function to size the statistics for a frame's tile grid, forgetting every tile's history
+    void Resize(int frameWidth, int frameHeight, int tileSize);
+
+    // Function to start the next frame: compile into `frameMask` the tiles of `regions` that are
+    // compared in it, leaving out demoted tiles that are not sampled. Returns false, leaving
+    // `frameMask` untouched, when no tile is demoted.
+    bool BeginFrame(const RegionMask& regions, RegionMask& frameMask);
+
+    // Function to fold the comparison of tile rows [firstRow, lastRow) into the statistics and
+    // clear demoted tiles from `tiles` so they are not boxed. `compared` is the mask the rows
+    // were compared under, or nullptr when every tile was. Bands may call this concurrently for
+    // disjoint rows. Returns true if a tile was demoted or promoted.
+    bool UpdateRows(TileMap& tiles, const RegionMask* compared, int firstRow, int lastRow);
+
+    // Function to finish the frame, rebuilding the activity regions when `changed`
+    void EndFrame(bool changed);
+
+    // Boxes around the groups of demoted tiles, snapped to the tile grid
+    const std::vector<Box>& Regions() const { return regions; }
+    size_t DemotedCount() const { return demotedCount; }
+    // One flag per tile in row-major order, non-zero while the tile is demoted
+    const std::vector<uint8_t>& Demoted() const { return demoted; }
+    // Demoted tiles left out of the current frame's comparison
+    size_t SkippedCount() const { return skippedCount; }
+
+private:
+    TileSamplingConfig config;
+    uint64_t frame = 0;
+    // Per tile: change history (bit 0 is the latest compared frame), demoted flag and quiet samples
+    std::vector<uint32_t> history;
+    std::vector<uint8_t> demoted;
+    std::vector<uint8_t> quiet;
+    size_t demotedCount = 0;
+    size_t skippedCount = 0;
+
+    // Tile flags of the frame mask, kept between frames
+    std::vector<uint8_t> frameTiles;
+    // Demoted tiles as a tile map, labelled into the regions
+    TileMap demotedTiles;
+    BoxExtractor extractor;
+    std::vector<Box> regions;
+};
+
+#endif // TILE_ACTIVITY_H
@@ -0,0 +1,99 @@
+#include "tile_hash.h"
+#include "tile_hash_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Slicing-by-8 lookup tables for the reflected CRC32C polynomial
+struct Crc32cTables {
+    uint32_t table[8][256];
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int slice = 1; slice < 8; ++slice) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+static const Crc32cTables& GetCrc32cTables() {
+    static const Crc32cTables tables;
+    return tables;
+}
+
+uint32_t Crc32cTable(uint32_t crc, const uint8_t* data, size_t size) {
+    const Crc32cTables& tables = GetCrc32cTables();
+    while (size >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, data, 4);
+        memcpy(&hi, data + 4, 4);
+        lo ^= crc;
+        crc = tables.table[7][lo & 0xFF] ^ tables.table[6][(lo >> 8) & 0xFF]
+            ^ tables.table[5][(lo >> 16) & 0xFF] ^ tables.table[4][lo >> 24]
+            ^ tables.table[3][hi & 0xFF] ^ tables.table[2][(hi >> 8) & 0xFF]
+            ^ tables.table[1][(hi >> 16) & 0xFF] ^ tables.table[0][hi >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ tables.table[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+void TileRowCrcTable(const uint8_t* row, int width, int tileSize, uint32_t* crcs) {
+    for (int x = 0, tx = 0; x < width; x += tileSize, ++tx) {
+        int pixels = std::min(tileSize, width - x);
+        crcs[tx] = Crc32cTable(crcs[tx], row + static_cast<size_t>(x) * 4, static_cast<size_t>(pixels) * 4);
+    }
+}
+
+// CRC32C over `size` bytes, continuing from `crc`
+uint32_t Crc32c(uint32_t crc, const uint8_t* data, size_t size) {
+    const CpuFeatures& cpu = GetCpuFeatures();
+#if defined(OVERLAY_ARCH_X86)
+    if (cpu.sse42) return Crc32cSSE42(crc, data, size);
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    if (cpu.armCrc32) return Crc32cArm(crc, data, size);
+#endif
+    (void)cpu;
+    return Crc32cTable(crc, data, size);
+}
+
+// Function to get the fastest tile row CRC implementation for this CPU
+TileRowCrcFunc GetTileRowCrcFunc() {
+    const CpuFeatures& cpu = GetCpuFeatures();
+#if defined(OVERLAY_ARCH_X86)
+    if (cpu.sse42) return TileRowCrcSSE42;
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+    if (cpu.armCrc32) return TileRowCrcArm;
+#endif
+    (void)cpu;
+    return TileRowCrcTable;
+}
+
+// Function to hash every tile in tile row `ty` of a frame into hashes[0..cols)
+void HashTileRow(const FrameView& frame, int tileSize, int ty, uint32_t* hashes) {
+    static const TileRowCrcFunc tileRowCrc = GetTileRowCrcFunc();
+    int cols = (frame.width + tileSize - 1) / tileSize;
+    std::fill(hashes, hashes + cols, 0xFFFFFFFFu);
+    int firstRow = ty * tileSize;
+    int lastRow = std::min(firstRow + tileSize, frame.height);
+    // The CRC kernels step in 4-byte units, so wider pixels count as several units
+    int units = frame.BytesPerPixel() / 4;
+    // Walk the pixel rows in memory order; the per-tile CRC chains are independent,
+    // so consecutive tiles overlap in the pipeline
+    for (int y = firstRow; y < lastRow; ++y) {
+        tileRowCrc(frame.Row(y), frame.width * units, tileSize * units, hashes);
+    }
+}
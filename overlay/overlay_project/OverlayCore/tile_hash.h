@@ -0,0 +1,23 @@
+#ifndef TILE_HASH_H
+#define TILE_HASH_H
+
+#include "frame_diff.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C (Castagnoli) over `size` bytes, continuing from `crc`. Uses the SSE4.2 or ARMv8 CRC
+// instructions when the CPU has them and a slicing-by-8 table otherwise.
+uint32_t Crc32c(uint32_t crc, const uint8_t* data, size_t size);
+
+// Folds one row of 4-byte pixels into per-tile CRCs: crcs[tx] is extended with the
+// tileSize pixels of that row belonging to tile column tx (fewer for the last column).
+typedef void (*TileRowCrcFunc)(const uint8_t* row, int width, int tileSize, uint32_t* crcs);
+
+// Function to get the fastest tile row CRC implementation for this CPU
+TileRowCrcFunc GetTileRowCrcFunc();
+
+// Function to hash every tile in tile row `ty` of a frame into hashes[0..cols)
+void HashTileRow(const FrameView& frame, int tileSize, int ty, uint32_t* hashes);
+
+#endif // TILE_HASH_H
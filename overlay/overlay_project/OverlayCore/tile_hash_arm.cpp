@@ -0,0 +1,32 @@
+#include "tile_hash_kernels.h"
+
+#if defined(OVERLAY_ARCH_NEON)
+#include <arm_acle.h>
+
+#include <algorithm>
+#include <cstring>
+
+uint32_t Crc32cArm(uint32_t crc, const uint8_t* data, size_t size) {
+    for (; size >= 8; size -= 8, data += 8) {
+        uint64_t value;
+        memcpy(&value, data, 8);
+        crc = __crc32cd(crc, value);
+    }
+    for (; size >= 4; size -= 4, data += 4) {
+        uint32_t value;
+        memcpy(&value, data, 4);
+        crc = __crc32cw(crc, value);
+    }
+    while (size-- > 0) {
+        crc = __crc32cb(crc, *data++);
+    }
+    return crc;
+}
+
+void TileRowCrcArm(const uint8_t* row, int width, int tileSize, uint32_t* crcs) {
+    for (int x = 0, tx = 0; x < width; x += tileSize, ++tx) {
+        int pixels = std::min(tileSize, width - x);
+        crcs[tx] = Crc32cArm(crcs[tx], row + static_cast<size_t>(x) * 4, static_cast<size_t>(pixels) * 4);
+    }
+}
+#endif
@@ -0,0 +1,22 @@
+#ifndef TILE_HASH_KERNELS_H
+#define TILE_HASH_KERNELS_H
+
+// Internal: per-ISA CRC32C kernels behind TileRowCrcFunc, each built with its own flags.
+
+#include "cpu_features.h"
+
+#include <cstddef>
+#include <cstdint>
+
+uint32_t Crc32cTable(uint32_t crc, const uint8_t* data, size_t size);
+void TileRowCrcTable(const uint8_t* row, int width, int tileSize, uint32_t* crcs);
+#if defined(OVERLAY_ARCH_X86)
+uint32_t Crc32cSSE42(uint32_t crc, const uint8_t* data, size_t size);
+void TileRowCrcSSE42(const uint8_t* row, int width, int tileSize, uint32_t* crcs);
+#endif
+#if defined(OVERLAY_ARCH_NEON)
+uint32_t Crc32cArm(uint32_t crc, const uint8_t* data, size_t size);
+void TileRowCrcArm(const uint8_t* row, int width, int tileSize, uint32_t* crcs);
+#endif
+
+#endif // TILE_HASH_KERNELS_H
@@ -0,0 +1,36 @@
+#include "tile_hash_kernels.h"
+
+#if defined(OVERLAY_ARCH_X86)
+#include <nmmintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+uint32_t Crc32cSSE42(uint32_t crc, const uint8_t* data, size_t size) {
+#if defined(_M_X64) || defined(__x86_64__)
+    uint64_t crc64 = crc;
+    for (; size >= 8; size -= 8, data += 8) {
+        uint64_t value;
+        memcpy(&value, data, 8);
+        crc64 = _mm_crc32_u64(crc64, value);
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    for (; size >= 4; size -= 4, data += 4) {
+        uint32_t value;
+        memcpy(&value, data, 4);
+        crc = _mm_crc32_u32(crc, value);
+    }
+    while (size-- > 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+
+void TileRowCrcSSE42(const uint8_t* row, int width, int tileSize, uint32_t* crcs) {
+    for (int x = 0, tx = 0; x < width; x += tileSize, ++tx) {
+        int pixels = std::min(tileSize, width - x);
+        crcs[tx] = Crc32cSSE42(crcs[tx], row + static_cast<size_t>(x) * 4, static_cast<size_t>(pixels) * 4);
+    }
+}
+#endif
@@ -0,0 +1,189 @@
+#include "tile_map.h"
+#include "bit_utils.h"
+
+#include <cstring>
+
+// Function to size the grid for a frame. tileSize must be a power of two between 8 and 64.
+void TileMap::Resize(int frameWidth, int frameHeight, int newTileSize) {
+    tileSize = newTileSize;
+    width = frameWidth;
+    height = frameHeight;
+    cols = (frameWidth + tileSize - 1) / tileSize;
+    rows = (frameHeight + tileSize - 1) / tileSize;
+    dirty.assign(static_cast<size_t>(cols) * rows, 0);
+    bounds.resize(static_cast<size_t>(cols) * rows);
+}
+
+void TileMap::Clear() {
+    std::fill(dirty.begin(), dirty.end(), static_cast<uint8_t>(0));
+}
+
+void TileMap::ClearRows(int firstTileRow, int lastTileRow) {
+    std::fill(dirty.begin() + static_cast<size_t>(firstTileRow) * cols, dirty.begin() + static_cast<size_t>(lastTileRow) * cols, static_cast<uint8_t>(0));
+}
+
+size_t TileMap::DirtyCount() const {
+    size_t count = 0;
+    for (uint8_t flag : dirty) {
+        count += flag;
+    }
+    return count;
+}
+
+// Function to grow a tile's bounds to cover a pixel span, initialising them on first use
+void TileMap::MarkPixels(int index, int left, int top, int right, int bottom) {
+    Box& box = bounds[index];
+    if (!dirty[index]) {
+        dirty[index] = 1;
+        box.left = left;
+        box.top = top;
+        box.right = right;
+        box.bottom = bottom;
+        return;
+    }
+    box.left = std::min(box.left, left);
+    box.top = std::min(box.top, top);
+    box.right = std::max(box.right, right);
+    box.bottom = std::max(box.bottom, bottom);
+}
+
+// Function to fold mask rows [firstRow, lastRow) into an already cleared map
+void MarkDirtyTileRows(const ChangeMask& mask, int firstRow, int lastRow, TileMap& tiles) {
+    const int tileSize = tiles.tileSize;
+    const int tilesPerWord = 64 / tileSize;
+    const uint64_t chunkMask = tileSize == 64 ? ~0ull : (1ull << tileSize) - 1;
+
+    for (int y = firstRow; y < lastRow; ++y) {
+        const uint64_t* row = mask.Row(y);
+        int rowBase = (y / tileSize) * tiles.cols;
+        for (int word = 0; word < mask.wordsPerRow; ++word) {
+            uint64_t bits = row[word];
+            if (bits == 0) {
+                continue;
+            }
+            // Each word covers a whole number of tiles, so split it into per-tile chunks
+            for (int k = 0; k < tilesPerWord; ++k) {
+                uint64_t chunk = (bits >> (k * tileSize)) & chunkMask;
+                if (chunk == 0) {
+                    continue;
+                }
+                int tx = word * tilesPerWord + k;
+                int x0 = tx * tileSize;
+                tiles.MarkPixels(rowBase + tx, x0 + LowestBit64(chunk), y, x0 + HighestBit64(chunk) + 1, y + 1);
+            }
+        }
+    }
+}
+
+// Function to fold a change mask into dirty tiles, clearing the map first
+void MarkDirtyTiles(const ChangeMask& mask, TileMap& tiles) {
+    if (tiles.width != mask.width || tiles.height != mask.height) {
+        tiles.Resize(mask.width, mask.height, tiles.tileSize);
+    } else {
+        tiles.Clear();
+    }
+    MarkDirtyTileRows(mask, 0, mask.height, tiles);
+}
+
+int BoxExtractor::Find(int label) {
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+    return label;
+}
+
+void BoxExtractor::Union(int a, int b) {
+    a = Find(a);
+    b = Find(b);
+    if (a < b) {
+        parent[b] = a;
+    } else if (b < a) {
+        parent[a] = b;
+    }
+}
+
+// Function to extract one box per connected blob of dirty tiles into `boxes` (cleared first)
+void BoxExtractor::Extract(const TileMap& tiles, std::vector<Box>& boxes) {
+    ExtractRows(tiles, 0, tiles.rows, boxes);
+}
+
+// Function to size the scratch buffers for `tileCount` tiles up front
+void BoxExtractor::Reserve(size_t tileCount) {
+    labels.reserve(tileCount);
+    parent.reserve(tileCount);
+    labelBounds.reserve(tileCount);
+    labelOutput.reserve(tileCount);
+}
+
+// Function to extract blobs from tile rows [firstRow, lastRow) only, as one band of a larger frame
+void BoxExtractor::ExtractRows(const TileMap& tiles, int firstRow, int lastRow, std::vector<Box>& boxes) {
+    boxes.clear();
+    const int cols = tiles.cols;
+    labelCols = cols;
+    labelFirstRow = firstRow;
+    size_t tileCount = static_cast<size_t>(lastRow - firstRow) * cols;
+    labels.assign(tileCount, -1);
+    parent.clear();
+    labelBounds.clear();
+    // Every dirty tile can start a label and a box, so sizing for all of them up front keeps
+    // busier frames from growing the buffers later
+    parent.reserve(tileCount);
+    labelBounds.reserve(tileCount);
+    labelOutput.reserve(tileCount);
+    boxes.reserve(tileCount);
+
+    // First pass: label each dirty tile from its already visited neighbours (W, NW, N, NE)
+    for (int ty = firstRow; ty < lastRow; ++ty) {
+        const uint8_t* dirtyRow = &tiles.dirty[static_cast<size_t>(ty) * cols];
+        int* labelRow = &labels[static_cast<size_t>(ty - firstRow) * cols];
+        const int* labelAbove = ty > firstRow ? labelRow - cols : nullptr;
+        for (int tx = 0; tx < cols; ++tx) {
+            if (!dirtyRow[tx]) {
+                continue;
+            }
+            int label = tx > 0 ? labelRow[tx - 1] : -1;
+            if (labelAbove) {
+                for (int nx = std::max(tx - 1, 0); nx <= std::min(tx + 1, cols - 1); ++nx) {
+                    int neighbourLabel = labelAbove[nx];
+                    if (neighbourLabel < 0) {
+                        continue;
+                    }
+                    if (label < 0) {
+                        label = neighbourLabel;
+                    } else if (neighbourLabel != label) {
+                        Union(label, neighbourLabel);
+                    }
+                }
+            }
+            const Box& tileBounds = tiles.bounds[static_cast<size_t>(ty) * cols + tx];
+            if (label < 0) {
+                label = static_cast<int>(parent.size());
+                parent.push_back(label);
+                labelBounds.push_back(tileBounds);
+            } else {
+                labelBounds[label] = UnionBox(labelBounds[label], tileBounds);
+            }
+            labelRow[tx] = label;
+        }
+    }
+
+    // Second pass: fold every label's bounds into its root and emit one box per root
+    labelOutput.assign(parent.size(), -1);
+    for (int label = 0; label < static_cast<int>(parent.size()); ++label) {
+        int root = Find(label);
+        if (labelOutput[root] < 0) {
+            labelOutput[root] = static_cast<int>(boxes.size());
+            boxes.push_back(labelBounds[label]);
+        } else {
+            Box& box = boxes[labelOutput[root]];
+            box = UnionBox(box, labelBounds[label]);
+        }
+    }
+}
+
+// Function to get the index into the last extracted boxes of the blob covering a tile
+int BoxExtractor::BoxIndexAt(int tx, int ty) {
+    int label = labels[static_cast<size_t>(ty - labelFirstRow) * labelCols + tx];
+    return label < 0 ? -1 : labelOutput[Find(label)];
+}
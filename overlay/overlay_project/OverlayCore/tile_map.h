@@ -0,0 +1,67 @@
+#ifndef TILE_MAP_H
+#define TILE_MAP_H
+
+#include "box.h"
+#include "frame_diff.h"
+
+#include <vector>
+
+// Coarse grid of square tiles over a frame. Each dirty tile also keeps the tight pixel
+// bounds of the changes inside it so blob boxes do not snap to the grid.
+struct TileMap {
+    int tileSize = 16;
+    int width = 0;
+    int height = 0;
+    int cols = 0;
+    int rows = 0;
+    std::vector<uint8_t> dirty;
+    std::vector<Box> bounds;
+
+    // Function to size the grid for a frame. tileSize must be a power of two between 8 and 64.
+    void Resize(int frameWidth, int frameHeight, int newTileSize);
+    void Clear();
+    void ClearRows(int firstTileRow, int lastTileRow);
+    size_t DirtyCount() const;
+
+    int Index(int tx, int ty) const { return ty * cols + tx; }
+    bool IsDirty(int tx, int ty) const { return dirty[Index(tx, ty)] != 0; }
+    void MarkPixels(int index, int left, int top, int right, int bottom);
+};
+
+// Function to fold a change mask into dirty tiles, clearing the map first
+void MarkDirtyTiles(const ChangeMask& mask, TileMap& tiles);
+
+// Function to fold mask rows [firstRow, lastRow) into an already cleared map
+void MarkDirtyTileRows(const ChangeMask& mask, int firstRow, int lastRow, TileMap& tiles);
+
+// Labels 8-connected groups of dirty tiles and emits one tight bounding box per group.
+// Scratch buffers are kept between calls so steady-state frames do not allocate.
+class BoxExtractor {
+public:
+    // Function to extract one box per connected blob of dirty tiles into `boxes` (cleared first)
+    void Extract(const TileMap& tiles, std::vector<Box>& boxes);
+
+    // Function to extract blobs from tile rows [firstRow, lastRow) only, as one band of a larger frame
+    void ExtractRows(const TileMap& tiles, int firstRow, int lastRow, std::vector<Box>& boxes);
+
+    // Function to size the scratch buffers for `tileCount` tiles up front, so the first
+    // extraction of a grid that size does not allocate
+    void Reserve(size_t tileCount);
+
+    // Function to get the index into the last extracted boxes of the blob covering a tile,
+    // or -1 if the tile is clean. The tile must lie in the rows of the last extraction.
+    int BoxIndexAt(int tx, int ty);
+
+private:
+    int Find(int label);
+    void Union(int a, int b);
+
+    int labelCols = 0;
+    int labelFirstRow = 0;
+    std::vector<int> labels;
+    std::vector<int> parent;
+    std::vector<Box> labelBounds;
+    std::vector<int> labelOutput;
+};
+
+#endif // TILE_MAP_H
@@ -0,0 +1,67 @@
+#include "trace_codec.h"
+
+#include <cstring>
+
+// Function to encode `count` pixels into `out`, returns the number of bytes written
+size_t RleEncodePixels(const uint32_t* pixels, size_t count, uint8_t* out) {
+    uint8_t* start = out;
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && run < 129 && pixels[i + run] == pixels[i]) {
+            ++run;
+        }
+        if (run >= 2) {
+            *out++ = static_cast<uint8_t>(126 + run);
+            memcpy(out, &pixels[i], 4);
+            out += 4;
+            i += run;
+            continue;
+        }
+        // Gather literals until the next repeat starts or the packet is full
+        size_t literalStart = i;
+        size_t literals = 0;
+        while (i < count && literals < 128 && !(i + 1 < count && pixels[i] == pixels[i + 1])) {
+            ++i;
+            ++literals;
+        }
+        *out++ = static_cast<uint8_t>(literals - 1);
+        memcpy(out, &pixels[literalStart], literals * 4);
+        out += literals * 4;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+// Function to decode exactly `count` pixels, returns false if the stream is malformed
+bool RleDecodePixels(const uint8_t* in, size_t size, uint32_t* pixels, size_t count) {
+    const uint8_t* end = in + size;
+    size_t written = 0;
+    while (written < count) {
+        if (in >= end) {
+            return false;
+        }
+        uint8_t control = *in++;
+        if (control < 128) {
+            size_t literals = static_cast<size_t>(control) + 1;
+            if (literals > count - written || static_cast<size_t>(end - in) < literals * 4) {
+                return false;
+            }
+            memcpy(&pixels[written], in, literals * 4);
+            in += literals * 4;
+            written += literals;
+        } else {
+            size_t run = static_cast<size_t>(control) - 126;
+            if (run > count - written || end - in < 4) {
+                return false;
+            }
+            uint32_t value;
+            memcpy(&value, in, 4);
+            in += 4;
+            for (size_t k = 0; k < run; ++k) {
+                pixels[written + k] = value;
+            }
+            written += run;
+        }
+    }
+    return in == end;
+}
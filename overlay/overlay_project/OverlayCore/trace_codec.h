@@ -0,0 +1,24 @@
+#ifndef TRACE_CODEC_H
+#define TRACE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Run-length coding of 32-bit pixels used for tiles in delta-compressed traces.
+// The stream is a sequence of packets, each starting with a control byte c:
+//   c < 128   : c + 1 literal pixels follow (4 bytes each)
+//   c >= 128  : one pixel follows, repeated c - 126 times (2..129)
+
+// Function to get the worst-case encoded size of `count` pixels
+inline size_t RleMaxEncodedSize(size_t count) {
+    return count * 4 + (count + 127) / 128;
+}
+
+// Function to encode `count` pixels into `out`, which must hold RleMaxEncodedSize(count) bytes.
+// Returns the number of bytes written.
+size_t RleEncodePixels(const uint32_t* pixels, size_t count, uint8_t* out);
+
+// Function to decode exactly `count` pixels, returns false if the stream is malformed
+bool RleDecodePixels(const uint8_t* in, size_t size, uint32_t* pixels, size_t count);
+
+#endif // TRACE_CODEC_H
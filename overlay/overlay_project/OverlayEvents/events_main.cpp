@@ -0,0 +1,128 @@
+// Reference reader for the shared memory motion event ring (event_ring.h).
+//
+//   overlay_events <name> [--from-start] [--count N] [--timeout-ms N] [--delay-ms N] [--quiet]
+//
+// Prints each frame's boxes and confirmed tracks as the overlay or overlay_replay --events
+// publishes them, then a summary. Reading never blocks the writer: a reader that falls more than
+// a ring behind reports the records it missed as dropped.
+// --from-start begins with the oldest record still in the ring instead of the next new one.
+// --count stops after N records, --timeout-ms after N ms without a new record (2000 by default).
+// --delay-ms sleeps after every record to simulate a slow consumer.
+
+#include "event_ring.h"
+#include "frame_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct EventsOptions {
+    const char* name = nullptr;
+    bool fromStart = false;
+    long long count = 0;
+    int timeoutMs = 2000;
+    int delayMs = 0;
+    bool quiet = false;
+};
+
+static bool ParseOptions(int argc, char** argv, EventsOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--from-start") == 0) {
+            options.fromStart = true;
+        } else if (strcmp(arg, "--count") == 0 && hasValue) {
+            options.count = atoll(argv[++i]);
+        } else if (strcmp(arg, "--timeout-ms") == 0 && hasValue) {
+            options.timeoutMs = atoi(argv[++i]);
+        } else if (strcmp(arg, "--delay-ms") == 0 && hasValue) {
+            options.delayMs = atoi(argv[++i]);
+        } else if (strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+        } else if (arg[0] != '-' && !options.name) {
+            options.name = arg;
+        } else {
+            fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+            return false;
+        }
+    }
+    return options.name != nullptr;
+}
+
+int main(int argc, char** argv) {
+    EventsOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s <name> [--from-start] [--count N] [--timeout-ms N] [--delay-ms N] [--quiet]\n", argv[0]);
+        return 1;
+    }
+
+    // The writer may not have started yet
+    EventRingReader reader;
+    auto waitStart = std::chrono::steady_clock::now();
+    while (!reader.Open(options.name)) {
+        if (std::chrono::steady_clock::now() - waitStart > std::chrono::milliseconds(options.timeoutMs)) {
+            fprintf(stderr, "No event ring named %s\n", options.name);
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const EventRingHeader& header = reader.Header();
+    printf("%s: %u slots of %u bytes, up to %u boxes and %u tracks per frame\n", options.name, header.slotCount,
+           header.slotBytes, header.maxBoxes, header.maxTracks);
+    if (options.fromStart) {
+        reader.Rewind();
+    }
+
+    EventFrame frame;
+    frame.boxes.reserve(header.maxBoxes);
+    frame.tracks.reserve(header.maxTracks);
+    long long received = 0;
+    long long truncated = 0;
+    uint64_t lastFrameIndex = 0;
+    // Publish to read, on the shared steady clock
+    std::vector<int64_t> latencies;
+    auto lastRecord = std::chrono::steady_clock::now();
+    while (options.count == 0 || received < options.count) {
+        if (reader.Next(frame) == EventReadStatus::Empty) {
+            if (std::chrono::steady_clock::now() - lastRecord > std::chrono::milliseconds(options.timeoutMs)) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+        latencies.push_back(PipelineClockUs() - frame.detectTimeUs);
+        lastRecord = std::chrono::steady_clock::now();
+        ++received;
+        truncated += frame.truncated ? 1 : 0;
+        lastFrameIndex = frame.frameIndex;
+        if (!options.quiet) {
+            printf("record %llu output %u frame %llu detect=%.3fms boxes=%zu tracks=%zu%s\n",
+                   static_cast<unsigned long long>(frame.sequence), frame.output, static_cast<unsigned long long>(frame.frameIndex), (frame.detectTimeUs - frame.captureTimeUs) / 1000.0,
+                   frame.boxes.size(), frame.tracks.size(), frame.truncated ? " truncated" : "");
+            for (const EventBox& box : frame.boxes) {
+                printf("  box %d,%d %dx%d\n", box.left, box.top, box.right - box.left, box.bottom - box.top);
+            }
+            for (const EventTrack& track : frame.tracks) {
+                printf("  track %u %d,%d %dx%d v=%.1f,%.1f\n", track.id, track.box.left, track.box.top, track.box.right - track.box.left,
+                       track.box.bottom - track.box.top, track.velocityX, track.velocityY);
+            }
+        }
+        if (options.delayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.delayMs));
+        }
+    }
+
+    printf("received=%lld dropped=%llu truncated=%lld last frame=%llu\n", received, static_cast<unsigned long long>(reader.Dropped()),
+           truncated, static_cast<unsigned long long>(lastFrameIndex));
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        printf("publish to read latency: p50=%.1fus p99=%.1fus max=%.1fus\n", static_cast<double>(latencies[latencies.size() / 2]),
+               static_cast<double>(latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)]),
+               static_cast<double>(latencies.back()));
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+#ifndef ALLOC_HOOK_H
+#define ALLOC_HOOK_H
+
+#include <cstdint>
+
+// Test hook for overlay_replay and overlay_bench: alloc_hook.cpp replaces the global operator new
+// and delete to count heap allocations made through them by every thread. It is only linked into
+// those tools, so the overlay itself keeps the standard allocator.
+
+// Function to get the number of allocations made since the program started
+uint64_t AllocationCount();
+
+#endif // ALLOC_HOOK_H
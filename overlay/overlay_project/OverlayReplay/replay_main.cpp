@@ -0,0 +1,634 @@
+// Headless replay of a recorded frame trace through the detection core.
+//
+//   overlay_replay <trace> [<trace> ...] [--threads N] [--tile-size N] [--hash-tiles] [--verify-hashes]
+//                          [--pyramid 4|8] [--pyramid-threshold N] [--background N] [--min-box-area N] [--compare]
+//                          [--motion] [--mask <path>] [--events <name>] [--sample-hot N] [--heatmap <path>]
+//                          [--realtime] [--quiet] [--metrics <path>] [--metrics-interval-ms N] [--check-allocs N]
+//
+// Prints one line per frame with the detection result and time, then a summary.
+// --metrics writes stage timing and counter snapshots as JSON lines while the trace replays.
+// --compare also runs full-resolution pixel diffing on every frame and reports how many of its
+// changed pixels fall outside the selected mode's boxes, and how much faster the mode was.
+// --motion splits each frame's changed tiles into regions that moved and newly drawn content.
+// --mask reads include/exclude rectangles (see region_mask.h); --compare uses the same mask.
+// --events tracks the boxes and publishes every frame to a shared memory event ring (see
+// event_ring.h), as the overlay does; read it with overlay_events.
+// --sample-hot N compares tiles that change in most frames only every Nth frame and reports them
+// as activity regions instead of boxes (see tile_activity.h); --compare counts changes inside the
+// activity regions as covered.
+// --heatmap accumulates a motion heatmap over the run and writes it at the end (see heatmap.h):
+// a PGM image if the path ends in .pgm, the binary heatmap format otherwise. With several traces
+// each output gets its own file, named with "-<output>" before the extension.
+// --check-allocs counts heap allocations (see alloc_hook.h) in each frame after the first N
+// frames of warm-up and fails the run if any frame made one, since the steady-state frame loop
+// is meant to reuse its buffers. It also turns on motion estimation, tracking, coalescing and,
+// unless --sample-hot is given, hot tile sampling every 8th frame as in the overlay, so every
+// stage the overlay's detect thread runs is checked.
+//
+// With several traces, each stands for one display output: they are placed side by side on a
+// shared desktop and replayed concurrently through a MultiOutputPipeline, one pipeline per
+// output, with tracking on. Prints per-output counters and fails if a merged box, move or activity
+// region does not lie inside the output it came from, or a track's centre is off its output.
+
+#include "alloc_hook.h"
+#include "bit_utils.h"
+#include "box_coalescer.h"
+#include "event_ring.h"
+#include "frame_pipeline.h"
+#include "frame_trace.h"
+#include "heatmap.h"
+#include "metrics.h"
+#include "motion_detector.h"
+#include "motion_estimator.h"
+#include "multi_output_pipeline.h"
+#include "object_tracker.h"
+#include "region_mask.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReplayOptions {
+    // One trace per display output
+    std::vector<const char*> tracePaths;
+    DetectorConfig detector;
+    ReplayPacing pacing = ReplayPacing::FullSpeed;
+    bool quiet = false;
+    bool compare = false;
+    bool motion = false;
+    const char* maskPath = nullptr;
+    const char* eventsName = nullptr;
+    const char* heatmapPath = nullptr;
+    const char* metricsPath = nullptr;
+    int metricsIntervalMs = 1000;
+    // --sample-hot interval, -1 when not given
+    int sampleHot = -1;
+    // Warm-up frames before --check-allocs starts counting, -1 when off
+    int checkAllocsAfter = -1;
+};
+
+static bool ParseOptions(int argc, char** argv, ReplayOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--threads") == 0 && hasValue) {
+            options.detector.threadCount = atoi(argv[++i]);
+        } else if (strcmp(arg, "--tile-size") == 0 && hasValue) {
+            options.detector.tileSize = atoi(argv[++i]);
+        } else if (strcmp(arg, "--hash-tiles") == 0) {
+            options.detector.mode = DetectionMode::TileHash;
+        } else if (strcmp(arg, "--verify-hashes") == 0) {
+            options.detector.verifyHashes = true;
+        } else if (strcmp(arg, "--pyramid") == 0 && hasValue) {
+            options.detector.mode = DetectionMode::Pyramid;
+            options.detector.pyramidScale = atoi(argv[++i]);
+        } else if (strcmp(arg, "--pyramid-threshold") == 0 && hasValue) {
+            options.detector.pyramidThreshold = atoi(argv[++i]);
+        } else if (strcmp(arg, "--background") == 0 && hasValue) {
+            options.detector.mode = DetectionMode::Background;
+            options.detector.backgroundThreshold = atoi(argv[++i]);
+        } else if (strcmp(arg, "--min-box-area") == 0 && hasValue) {
+            options.detector.minBoxArea = atoi(argv[++i]);
+        } else if (strcmp(arg, "--compare") == 0) {
+            options.compare = true;
+        } else if (strcmp(arg, "--motion") == 0) {
+            options.motion = true;
+        } else if (strcmp(arg, "--mask") == 0 && hasValue) {
+            options.maskPath = argv[++i];
+        } else if (strcmp(arg, "--events") == 0 && hasValue) {
+            options.eventsName = argv[++i];
+        } else if (strcmp(arg, "--sample-hot") == 0 && hasValue) {
+            options.sampleHot = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(arg, "--heatmap") == 0 && hasValue) {
+            options.heatmapPath = argv[++i];
+        } else if (strcmp(arg, "--realtime") == 0) {
+            options.pacing = ReplayPacing::Recorded;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+        } else if (strcmp(arg, "--metrics") == 0 && hasValue) {
+            options.metricsPath = argv[++i];
+        } else if (strcmp(arg, "--metrics-interval-ms") == 0 && hasValue) {
+            options.metricsIntervalMs = atoi(argv[++i]);
+        } else if (strcmp(arg, "--check-allocs") == 0 && hasValue) {
+            options.checkAllocsAfter = std::max(0, atoi(argv[++i]));
+        } else if (arg[0] != '-') {
+            options.tracePaths.push_back(arg);
+        } else {
+            fprintf(stderr, "Unknown or incomplete option %s\n", arg);
+            return false;
+        }
+    }
+    if (options.checkAllocsAfter >= 0) {
+        options.motion = true;
+    }
+    // Like the overlay, --check-allocs samples hot tiles every 8th frame unless told otherwise
+    if (options.sampleHot < 0) {
+        options.sampleHot = options.checkAllocsAfter >= 0 ? 8 : 0;
+    }
+    options.detector.sampling.sampleInterval = options.sampleHot;
+    return !options.tracePaths.empty();
+}
+
+// Function to count the set bits of a change mask that lie outside every box
+static size_t CountUncovered(const ChangeMask& mask, const std::vector<Box>& boxes, std::vector<uint64_t>& scratch) {
+    scratch = mask.bits;
+    for (const Box& box : boxes) {
+        for (int y = box.top; y < box.bottom; ++y) {
+            uint64_t* row = scratch.data() + static_cast<size_t>(y) * mask.wordsPerRow;
+            for (int x = box.left; x < box.right;) {
+                int bit = x & 63;
+                int span = std::min(64 - bit, box.right - x);
+                uint64_t bits = span == 64 ? ~0ull : ((1ull << span) - 1) << bit;
+                row[x >> 6] &= ~bits;
+                x += span;
+            }
+        }
+    }
+    size_t count = 0;
+    for (uint64_t word : scratch) {
+        count += PopCount64(word);
+    }
+    return count;
+}
+
+// Function to run the full-resolution reference detector on a frame, returns its time in ms
+static double RunReference(MotionDetector& reference, const Frame& current, const Frame& previous, std::vector<Box>& boxes) {
+    auto start = std::chrono::steady_clock::now();
+    reference.Detect(current.view, previous.view, boxes);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Pipeline stage replaying one output's trace
+class TraceCapture : public CaptureStage {
+public:
+    explicit TraceCapture(ReplayFrameSource& source) : source(source) {}
+
+    bool Capture(PipelineFrame& frame) override {
+        Frame next;
+        if (finished.load(std::memory_order_relaxed) || !source.NextFrame(next)) {
+            finished.store(true, std::memory_order_release);
+            return false;
+        }
+        size_t rowBytes = static_cast<size_t>(next.view.width) * next.view.BytesPerPixel();
+        for (int y = 0; y < next.view.height; ++y) {
+            memcpy(frame.pixels.data() + y * rowBytes, next.view.Row(y), rowBytes);
+        }
+        frame.view = { frame.pixels.data(), next.view.width, next.view.height, static_cast<int>(rowBytes), next.view.format };
+        frame.captureTimeUs = PipelineClockUs();
+        return true;
+    }
+
+    bool Finished() const { return finished.load(std::memory_order_acquire); }
+
+private:
+    ReplayFrameSource& source;
+    std::atomic<bool> finished{ false };
+};
+
+// Render stage checking that every part of a merged result stays on the output it came from:
+// boxes, moves and activity regions must lie inside that output, and track centres on it
+class OutputCheck : public RenderStage {
+public:
+    explicit OutputCheck(const std::vector<Box>& bounds) : bounds(bounds) {}
+
+    void Render(const PipelineResult& result) override {
+        ++results;
+        MergedOutputEnd begin;
+        for (const MergedOutputEnd& end : result.outputEnds) {
+            const Box& own = bounds[end.output];
+            for (size_t i = begin.boxes; i < end.boxes; ++i) {
+                boxes++;
+                outside += Inside(result.boxes[i], own) ? 0 : 1;
+            }
+            for (size_t i = begin.moves; i < end.moves; ++i) {
+                moves++;
+                outside += Inside(result.moves[i].box, own) ? 0 : 1;
+            }
+            for (size_t i = begin.activity; i < end.activity; ++i) {
+                outside += Inside(result.activity[i], own) ? 0 : 1;
+            }
+            for (size_t i = begin.tracks; i < end.tracks; ++i) {
+                const Track& track = result.tracks[i];
+                tracks++;
+                bool onOwn = track.centerX >= own.left && track.centerX < own.right && track.centerY >= own.top && track.centerY < own.bottom;
+                misplacedTracks += onOwn ? 0 : 1;
+            }
+            begin = end;
+        }
+    }
+
+    uint64_t results = 0;
+    uint64_t boxes = 0;
+    uint64_t moves = 0;
+    uint64_t tracks = 0;
+    uint64_t outside = 0;
+    uint64_t misplacedTracks = 0;
+
+private:
+    static bool Inside(const Box& box, const Box& output) {
+        return box.left >= output.left && box.top >= output.top && box.right <= output.right && box.bottom <= output.bottom;
+    }
+
+    const std::vector<Box>& bounds;
+};
+
+// Function to get the file output `index` writes its heatmap to: `path` with "-<index>" inserted
+// before the extension
+static std::string OutputHeatmapPath(const char* path, size_t index) {
+    std::string name = path;
+    size_t separator = name.find_last_of("/\\");
+    size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) {
+        dot = name.size();
+    }
+    return name.substr(0, dot) + "-" + std::to_string(index) + name.substr(dot);
+}
+
+// Function to publish a heatmap's final heat and write it, printing what was written
+static bool WriteHeatmap(Heatmap& heatmap, const char* path) {
+    heatmap.Publish();
+    HeatmapSnapshot snapshot;
+    if (!heatmap.CopySnapshot(snapshot) || !heatmap.Write(path)) {
+        fprintf(stderr, "Failed to write heatmap %s\n", path);
+        return false;
+    }
+    uint32_t hottest = 0;
+    size_t warm = 0;
+    for (uint32_t value : snapshot.heat) {
+        hottest = std::max(hottest, value);
+        warm += value != 0;
+    }
+    // Each change adds about 2^32 >> decayShift, so this is the hottest tile's decayed count of changed frames
+    double hottestFrames = std::ldexp(static_cast<double>(hottest), heatmap.Config().decayShift - 32);
+    printf("heatmap %s: %dx%d tiles of %d px over %llu frames, %zu tiles changed, hottest in %.1f decayed frames\n", path,
+           snapshot.cols, snapshot.rows, snapshot.tileSize, static_cast<unsigned long long>(snapshot.frames), warm, hottestFrames);
+    return true;
+}
+
+// Function to replay several traces concurrently as the outputs of one desktop, returns the exit code
+static int RunOutputs(const ReplayOptions& options) {
+    std::vector<std::unique_ptr<ReplayFrameSource>> sources;
+    std::vector<std::unique_ptr<TraceCapture>> captures;
+    std::vector<OutputConfig> outputs;
+    std::vector<Box> bounds;
+    int left = 0;
+    for (const char* path : options.tracePaths) {
+        sources.push_back(std::make_unique<ReplayFrameSource>());
+        ReplayFrameSource& source = *sources.back();
+        if (!source.Open(path)) {
+            fprintf(stderr, "Failed to open trace %s\n", path);
+            return 1;
+        }
+        source.SetPacing(options.pacing);
+        captures.push_back(std::make_unique<TraceCapture>(source));
+        OutputConfig output;
+        output.capture = captures.back().get();
+        output.bounds = { left, 0, left + source.Width(), source.Height() };
+        outputs.push_back(output);
+        bounds.push_back(output.bounds);
+        printf("output %zu %s: %dx%d at %d,0, %u frames\n", outputs.size() - 1, path, source.Width(), source.Height(), left,
+               source.FrameCount());
+        left += source.Width();
+    }
+
+    PipelineConfig config;
+    config.detector = options.detector;
+    config.trackObjects = true;
+    config.estimateMotion = options.motion;
+    OutputCheck check(bounds);
+    MultiOutputPipeline pipeline(config, outputs, check);
+    if (options.maskPath) {
+        std::vector<MaskRegion> regions;
+        if (!LoadMaskRegions(options.maskPath, regions)) {
+            fprintf(stderr, "Failed to read mask %s\n", options.maskPath);
+            return 1;
+        }
+        pipeline.SetRegions(regions);
+        printf("mask %s: %zu regions\n", options.maskPath, regions.size());
+    }
+    EventRingWriter events;
+    if (options.eventsName) {
+        if (!events.Open(options.eventsName)) {
+            fprintf(stderr, "Failed to create event ring %s\n", options.eventsName);
+            return 1;
+        }
+        pipeline.SetEventRing(&events);
+        printf("publishing events to %s\n", options.eventsName);
+    }
+    std::vector<std::unique_ptr<Heatmap>> heatmaps;
+    if (options.heatmapPath) {
+        for (size_t i = 0; i < pipeline.OutputCount(); ++i) {
+            heatmaps.push_back(std::make_unique<Heatmap>(HeatmapConfig(), options.detector.kernel));
+            pipeline.SetHeatmap(i, heatmaps.back().get());
+        }
+    }
+    if (options.metricsPath && !StartMetricsExport(options.metricsPath, options.metricsIntervalMs)) {
+        fprintf(stderr, "Failed to create %s\n", options.metricsPath);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pipeline.Start();
+    // Run until every trace has been captured and each captured frame was detected or replaced
+    for (;;) {
+        bool done = true;
+        for (size_t i = 0; i < captures.size() && done; ++i) {
+            PipelineStats stats = pipeline.Output(i).Stats();
+            done = captures[i]->Finished() && stats.detected + stats.staleFrames >= stats.captured;
+        }
+        if (done) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pipeline.Stop();
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (options.metricsPath) {
+        StopMetricsExport();
+    }
+
+    for (size_t i = 0; i < pipeline.OutputCount(); ++i) {
+        PipelineStats stats = pipeline.Output(i).Stats();
+        printf("output %zu: captured=%llu detected=%llu stale=%llu\n", i, static_cast<unsigned long long>(stats.captured),
+               static_cast<unsigned long long>(stats.detected), static_cast<unsigned long long>(stats.staleFrames));
+    }
+    PipelineStats stats = pipeline.Stats();
+    printf("outputs=%zu elapsed=%.1fms detected=%llu (%.1f fps) merged=%llu mean latency=%.3fms max=%.3fms\n", pipeline.OutputCount(),
+           elapsed, static_cast<unsigned long long>(stats.detected), elapsed > 0.0 ? stats.detected * 1000.0 / elapsed : 0.0,
+           static_cast<unsigned long long>(stats.rendered), stats.MeanLatencyUs() / 1000.0, stats.maxLatencyUs / 1000.0);
+    printf("merged boxes=%llu moves=%llu tracks=%llu, outside their output: %llu boxes/moves/activity regions, %llu tracks\n",
+           static_cast<unsigned long long>(check.boxes), static_cast<unsigned long long>(check.moves),
+           static_cast<unsigned long long>(check.tracks), static_cast<unsigned long long>(check.outside),
+           static_cast<unsigned long long>(check.misplacedTracks));
+    if (options.eventsName) {
+        printf("published %llu event records\n", static_cast<unsigned long long>(events.Published()));
+    }
+    bool wroteHeatmaps = true;
+    for (size_t i = 0; i < heatmaps.size(); ++i) {
+        wroteHeatmaps &= WriteHeatmap(*heatmaps[i], OutputHeatmapPath(options.heatmapPath, i).c_str());
+    }
+    return check.outside == 0 && check.misplacedTracks == 0 && wroteHeatmaps ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s <trace> [<trace> ...] [--threads N] [--tile-size N] [--hash-tiles] [--verify-hashes] [--realtime] [--quiet]\n"
+                        "       [--pyramid 4|8] [--pyramid-threshold N] [--background N] [--min-box-area N] [--compare] [--motion]\n"
+                        "       [--mask <path>] [--events <name>] [--sample-hot N] [--metrics <path>] [--metrics-interval-ms N]\n"
+                        "       [--check-allocs N] [--heatmap <path>]\n", argv[0]);
+        return 1;
+    }
+    if (options.tracePaths.size() > 1) {
+        return RunOutputs(options);
+    }
+
+    const char* tracePath = options.tracePaths[0];
+    ReplayFrameSource source;
+    if (!source.Open(tracePath)) {
+        fprintf(stderr, "Failed to open trace %s\n", tracePath);
+        return 1;
+    }
+    source.SetPacing(options.pacing);
+    printf("%s: %dx%d, %u frames, %s\n", tracePath, source.Width(), source.Height(), source.FrameCount(),
+           source.Encoding() == TraceEncoding::DeltaTiles ? "delta-compressed" : "raw");
+
+    if (options.metricsPath && !StartMetricsExport(options.metricsPath, options.metricsIntervalMs)) {
+        fprintf(stderr, "Failed to create %s\n", options.metricsPath);
+        return 1;
+    }
+
+    MotionDetector detector(options.detector);
+    std::vector<Box> boxes;
+    std::vector<double> times;
+    times.reserve(source.FrameCount());
+
+    // Full-resolution reference for --compare, with the same threads and tiles
+    DetectorConfig referenceConfig = options.detector;
+    referenceConfig.mode = DetectionMode::PixelDiff;
+    referenceConfig.verifyHashes = false;
+    MotionDetector reference(referenceConfig);
+    if (options.maskPath) {
+        std::vector<MaskRegion> regions;
+        if (!LoadMaskRegions(options.maskPath, regions)) {
+            fprintf(stderr, "Failed to read mask %s\n", options.maskPath);
+            return 1;
+        }
+        detector.SetRegions(regions);
+        reference.SetRegions(regions);
+        printf("mask %s: %zu regions\n", options.maskPath, regions.size());
+    }
+    std::vector<Box> referenceBoxes;
+    std::vector<uint64_t> uncoveredBits;
+    double referenceTotal = 0.0;
+    unsigned long long referencePixels = 0;
+    unsigned long long missedPixels = 0;
+    size_t missedFrames = 0;
+    // Boxes plus activity regions, which --compare counts as covered
+    std::vector<Box> coveredBoxes;
+
+    // Demoted tiles for --sample-hot
+    unsigned long long demotedTiles = 0;
+    unsigned long long skippedTiles = 0;
+    unsigned long long activeTiles = 0;
+
+    // Moved versus newly drawn tiles for --motion
+    MotionEstimator estimator(MotionConfig(), options.detector.kernel);
+    std::vector<MoveRect> moves;
+    std::vector<Box> newBoxes;
+    double motionTotal = 0.0;
+    unsigned long long changedTiles = 0;
+    unsigned long long movedTiles = 0;
+
+    // Long-run motion heatmap for --heatmap
+    Heatmap heatmap(HeatmapConfig(), options.detector.kernel);
+
+    // Tracks and the event ring for --events; --check-allocs tracks and coalesces like the
+    // pipeline's detect thread without publishing
+    EventRingWriter events;
+    ObjectTracker tracker;
+    std::vector<Track> confirmed;
+    confirmed.reserve(tracker.Config().maxTracks);
+    const bool trackObjects = options.eventsName || options.checkAllocsAfter >= 0;
+    BoxCoalescer coalescer;
+    std::vector<Box> coalesced;
+    if (options.eventsName) {
+        if (!events.Open(options.eventsName)) {
+            fprintf(stderr, "Failed to create event ring %s\n", options.eventsName);
+            return 1;
+        }
+        printf("publishing events to %s\n", options.eventsName);
+    }
+
+    // Allocations made by frames after the warm-up for --check-allocs
+    unsigned long long allocatingFrames = 0;
+    unsigned long long frameAllocations = 0;
+
+    Frame previous, current;
+    bool havePrevious = false;
+    for (;;) {
+        uint64_t allocationsBefore = AllocationCount();
+        {
+            // Reading and decoding the trace stands in for desktop capture
+            OVERLAY_METRICS_SCOPE(StageMetric::Capture);
+            if (!source.NextFrame(current)) {
+                break;
+            }
+        }
+        // Whichever detector runs second finds the frames in cache, so alternate the order
+        bool referenceFirst = options.compare && (times.size() & 1) != 0;
+        double referenceElapsed = 0.0;
+        if (referenceFirst) {
+            referenceElapsed = RunReference(reference, current, havePrevious ? previous : current, referenceBoxes);
+        }
+        auto start = std::chrono::steady_clock::now();
+        if ((options.detector.mode == DetectionMode::TileHash && !options.detector.verifyHashes) ||
+            options.detector.mode == DetectionMode::Background) {
+            detector.Detect(current.view, boxes);
+        } else if (havePrevious) {
+            detector.Detect(current.view, previous.view, boxes);
+        } else {
+            // Like the overlay, the first frame only seeds the previous-frame state
+            detector.Detect(current.view, current.view, boxes);
+        }
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        times.push_back(elapsed);
+
+        if (options.compare) {
+            if (!referenceFirst) {
+                referenceElapsed = RunReference(reference, current, havePrevious ? previous : current, referenceBoxes);
+            }
+            referenceTotal += referenceElapsed;
+            // At most one box and one activity region per tile
+            coveredBoxes.reserve(2 * detector.Tiles().dirty.size());
+            coveredBoxes.assign(boxes.begin(), boxes.end());
+            coveredBoxes.insert(coveredBoxes.end(), detector.ActivityRegions().begin(), detector.ActivityRegions().end());
+            size_t missed = CountUncovered(reference.Mask(), coveredBoxes, uncoveredBits);
+            referencePixels += reference.ChangedPixels();
+            missedPixels += missed;
+            if (missed != 0) {
+                ++missedFrames;
+            }
+        }
+
+        if (detector.Activity().Enabled()) {
+            demotedTiles += detector.Activity().DemotedCount();
+            skippedTiles += detector.Activity().SkippedCount();
+            activeTiles += detector.Regions().AllActive() ? detector.Tiles().dirty.size() : detector.Regions().ActiveCount();
+        }
+
+        if (options.heatmapPath) {
+            heatmap.Update(detector.Tiles(), &detector.Activity());
+        }
+
+        moves.clear();
+        if (options.motion && havePrevious) {
+            auto motionStart = std::chrono::steady_clock::now();
+            estimator.Estimate(current.view, previous.view, detector.Tiles(), moves, newBoxes);
+            motionTotal += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - motionStart).count();
+            changedTiles += estimator.Stats().changedTiles;
+            movedTiles += estimator.Stats().movedTiles;
+        }
+
+        if (trackObjects) {
+            tracker.SetFrameSize(current.view.width, current.view.height);
+            tracker.Update(boxes);
+            confirmed.clear();
+            for (const Track& track : tracker.Tracks()) {
+                if (tracker.IsConfirmed(track)) {
+                    confirmed.push_back(track);
+                }
+            }
+        }
+        if (options.checkAllocsAfter >= 0) {
+            // The overlay draws the newly drawn boxes merged, as the pipeline does with coalesceBoxes
+            const std::vector<Box>& drawn = options.motion && havePrevious ? newBoxes : boxes;
+            coalescer.Reserve(detector.Tiles().dirty.size());
+            coalesced.reserve(detector.Tiles().dirty.size());
+            coalesced.assign(drawn.begin(), drawn.end());
+            coalescer.Coalesce(coalesced);
+        }
+        if (events.IsOpen()) {
+            // Stamped with the pipeline clock like the overlay's events, so readers can measure delivery latency
+            int64_t nowUs = PipelineClockUs();
+            events.Publish(current.index, nowUs - static_cast<int64_t>(elapsed * 1000.0), nowUs, boxes, confirmed);
+        }
+
+        if (!options.quiet) {
+            printf("frame %llu t=%.1fms changed=%zu tiles=%zu boxes=%zu detect=%.3fms\n",
+                   static_cast<unsigned long long>(current.index), current.timestampUs / 1000.0,
+                   detector.ChangedPixels(), detector.Tiles().DirtyCount(), boxes.size(), elapsed);
+            for (const Box& box : boxes) {
+                printf("  box %d,%d %dx%d\n", box.left, box.top, box.Width(), box.Height());
+            }
+            for (const MoveRect& move : moves) {
+                printf("  move %d,%d %dx%d by %d,%d\n", move.box.left, move.box.top, move.box.Width(), move.box.Height(), move.dx, move.dy);
+            }
+            for (const Box& region : detector.ActivityRegions()) {
+                printf("  activity %d,%d %dx%d\n", region.left, region.top, region.Width(), region.Height());
+            }
+        }
+        if (options.checkAllocsAfter >= 0 && times.size() > static_cast<size_t>(options.checkAllocsAfter)) {
+            uint64_t allocations = AllocationCount() - allocationsBefore;
+            if (allocations != 0) {
+                ++allocatingFrames;
+                frameAllocations += allocations;
+                fprintf(stderr, "frame %llu made %llu heap allocation(s)\n", static_cast<unsigned long long>(current.index),
+                        static_cast<unsigned long long>(allocations));
+            }
+        }
+        previous = current;
+        havePrevious = true;
+    }
+
+    if (options.metricsPath) {
+        StopMetricsExport();
+    }
+
+    if (times.empty()) {
+        printf("No frames replayed.\n");
+        return 0;
+    }
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double t : times) {
+        total += t;
+    }
+    printf("frames=%zu mean=%.3fms p50=%.3fms p99=%.3fms max=%.3fms\n", times.size(), total / times.size(),
+           sorted[sorted.size() / 2], sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)], sorted.back());
+    if (options.compare) {
+        printf("full resolution: mean=%.3fms (%.2fx), changed pixels missed %llu of %llu (%.3f%%) in %zu frame(s)\n",
+               referenceTotal / times.size(), total > 0.0 ? referenceTotal / total : 0.0, missedPixels, referencePixels,
+               referencePixels ? 100.0 * missedPixels / referencePixels : 0.0, missedFrames);
+    }
+    if (options.motion) {
+        printf("motion: mean=%.3fms, %llu of %llu changed tiles moved (%.1f%%)\n", motionTotal / times.size(), movedTiles,
+               changedTiles, changedTiles ? 100.0 * movedTiles / changedTiles : 0.0);
+    }
+    if (detector.Activity().Enabled()) {
+        printf("sampling: every %d frames, mean %.1f demoted tiles, %llu of %llu tile comparisons skipped (%.1f%%)\n",
+               detector.Activity().Config().sampleInterval, static_cast<double>(demotedTiles) / times.size(), skippedTiles,
+               activeTiles, activeTiles ? 100.0 * skippedTiles / activeTiles : 0.0);
+    }
+    if (options.heatmapPath && !WriteHeatmap(heatmap, options.heatmapPath)) {
+        return 1;
+    }
+    if (options.checkAllocsAfter >= 0) {
+        size_t checked = times.size() > static_cast<size_t>(options.checkAllocsAfter) ? times.size() - options.checkAllocsAfter : 0;
+        printf("allocations: %llu in %llu of %zu frame(s) after %d warm-up frame(s)\n", frameAllocations, allocatingFrames,
+               checked, options.checkAllocsAfter);
+        if (allocatingFrames != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
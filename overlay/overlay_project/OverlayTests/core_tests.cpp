@@ -0,0 +1,628 @@
+// Correctness checks for the detection core, run by CTest (ctest --test-dir build).
+//
+//   overlay_tests diff     every compiled diff kernel against the scalar reference
+//   overlay_tests bands    banded multi-thread detection against one band on one thread
+//   overlay_tests restart  frame slots stay owned by one stage across pipeline restarts
+//   overlay_tests record   delta traces recorded as the overlay does decode to the captured frames
+//   overlay_tests schedule frame pacing, idle back-off and missed deadlines on a manual clock
+//   overlay_tests motion   motion estimation searches no more tiles per frame than its budget
+//
+// Each check prints its failures and the program exits with 1 if any check failed.
+
+#include "frame_diff.h"
+#include "frame_pipeline.h"
+#include "frame_scheduler.h"
+#include "frame_trace.h"
+#include "motion_detector.h"
+#include "motion_estimator.h"
+#include "synthetic_scene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Deterministic xorshift generator, so a failure can be reproduced from its printed case
+class TestRandom {
+public:
+    explicit TestRandom(uint32_t seed) : state(seed ? seed : 1) {}
+
+    uint32_t Next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    int Below(int limit) { return static_cast<int>(Next() % static_cast<uint32_t>(limit)); }
+
+private:
+    uint32_t state;
+};
+
+static const PixelFormat kFormats[] = { PixelFormat::BGRA8, PixelFormat::RGB10A2, PixelFormat::RGBA16F };
+static const DiffKernel kVectorKernels[] = { DiffKernel::SSE2, DiffKernel::AVX2, DiffKernel::NEON };
+
+// Share of pixels changed in `previous` to make `current`, in 1/1000
+static const int kChangeRates[] = { 0, 5, 100, 500, 1000 };
+
+static const uint64_t kMaskPoison = 0xA5A5A5A5A5A5A5A5ull;
+static const int kMaskGuardWords = 2;
+
+// Function to fill `previous` with random bytes and copy it into `current`, then flip one random
+// byte in about `rate`/1000 of the pixels, so changes in every byte lane are covered
+static void FillPair(TestRandom& random, std::vector<uint8_t>& current, std::vector<uint8_t>& previous, int bytesPerPixel, int rate) {
+    for (uint8_t& value : previous) {
+        value = static_cast<uint8_t>(random.Next());
+    }
+    current = previous;
+    size_t pixels = current.size() / bytesPerPixel;
+    for (size_t i = 0; i < pixels; ++i) {
+        if (random.Below(1000) < rate) {
+            current[i * bytesPerPixel + random.Below(bytesPerPixel)] ^= static_cast<uint8_t>(1 + random.Below(255));
+        }
+    }
+}
+
+// Function to compare one row kernel with the scalar one over every width up to 320 and a few
+// frame widths, at unaligned start offsets and change densities from none to every pixel. The
+// count, every mask word covering the row and the guard words past it must match.
+static int CheckRowKernel(DiffKernel kernel, PixelFormat format) {
+    DiffRowFunc reference = GetDiffRowFunc(DiffKernel::Scalar, format);
+    DiffRowFunc tested = GetDiffRowFunc(kernel, format);
+    const int bytesPerPixel = PixelFormatBytes(format);
+    const int offsets[] = { 0, 1, bytesPerPixel, 3 * bytesPerPixel };
+
+    std::vector<int> widths;
+    for (int width = 1; width <= 320; ++width) {
+        widths.push_back(width);
+    }
+    widths.push_back(1279);
+    widths.push_back(1920);
+    widths.push_back(3843);
+
+    TestRandom random(0x9E3779B9u + static_cast<uint32_t>(format) * 977 + static_cast<uint32_t>(kernel));
+    std::vector<uint8_t> current, previous;
+    std::vector<uint64_t> expectedMask, testedMask;
+    int failures = 0;
+    for (int width : widths) {
+        int words = (width + 63) >> 6;
+        for (int offset : offsets) {
+            for (int rate : kChangeRates) {
+                size_t bytes = static_cast<size_t>(width) * bytesPerPixel + offset;
+                current.resize(bytes);
+                previous.resize(bytes);
+                FillPair(random, current, previous, bytesPerPixel, rate);
+                // Bytes before the offset may differ; a kernel must not read them
+                expectedMask.assign(words + kMaskGuardWords, kMaskPoison);
+                testedMask.assign(words + kMaskGuardWords, kMaskPoison);
+                size_t expectedCount = reference(current.data() + offset, previous.data() + offset, width, expectedMask.data());
+                size_t testedCount = tested(current.data() + offset, previous.data() + offset, width, testedMask.data());
+                if (expectedCount != testedCount || expectedMask != testedMask) {
+                    if (failures < 10) {
+                        printf("  %s %s: width %d, offset %d, change rate %d/1000: %zu changed pixels, scalar %zu%s\n",
+                            DiffKernelName(kernel), PixelFormatName(format), width, offset, rate, testedCount, expectedCount,
+                            expectedMask != testedMask ? ", mask differs" : "");
+                    }
+                    ++failures;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+// Function to compare DiffFrames with one kernel against the scalar kernel on frames whose rows are
+// padded to a larger pitch. The padding differs between the frames and must not be reported.
+static int CheckFrameKernel(DiffKernel kernel, PixelFormat format) {
+    const int bytesPerPixel = PixelFormatBytes(format);
+    const int sizes[][2] = { { 1, 1 }, { 17, 3 }, { 63, 9 }, { 65, 7 }, { 333, 31 }, { 1366, 12 } };
+    const int paddings[] = { 0, 4, 60, 256 };
+
+    TestRandom random(0x85EBCA6Bu + static_cast<uint32_t>(format) * 131 + static_cast<uint32_t>(kernel));
+    std::vector<uint8_t> current, previous;
+    ChangeMask expected, tested;
+    int failures = 0;
+    for (const int* size : sizes) {
+        for (int padding : paddings) {
+            int rowPitch = size[0] * bytesPerPixel + padding;
+            size_t bytes = static_cast<size_t>(rowPitch) * size[1];
+            current.resize(bytes);
+            previous.resize(bytes);
+            FillPair(random, current, previous, bytesPerPixel, 50);
+            for (int y = 0; y < size[1]; ++y) {
+                for (int i = 0; i < padding; ++i) {
+                    current[static_cast<size_t>(y) * rowPitch + size[0] * bytesPerPixel + i] ^= 0xFF;
+                }
+            }
+            FrameView currentView = { current.data(), size[0], size[1], rowPitch, format };
+            FrameView previousView = { previous.data(), size[0], size[1], rowPitch, format };
+            size_t expectedCount = DiffFrames(currentView, previousView, expected, DiffKernel::Scalar);
+            size_t testedCount = DiffFrames(currentView, previousView, tested, kernel);
+            if (expectedCount != testedCount || expected.bits != tested.bits) {
+                printf("  %s %s: %dx%d frame, pitch %d: %zu changed pixels, scalar %zu%s\n",
+                    DiffKernelName(kernel), PixelFormatName(format), size[0], size[1], rowPitch, testedCount, expectedCount,
+                    expected.bits != tested.bits ? ", mask differs" : "");
+                ++failures;
+            }
+        }
+    }
+    return failures;
+}
+
+// Function to check every compiled vector kernel that runs on this CPU against the scalar kernel
+static int RunDiffTests() {
+    int failures = 0;
+    int tested = 0;
+    for (DiffKernel kernel : kVectorKernels) {
+        if (!IsDiffKernelSupported(kernel)) {
+            printf("%s: not supported here, skipped\n", DiffKernelName(kernel));
+            continue;
+        }
+        for (PixelFormat format : kFormats) {
+            int kernelFailures = CheckRowKernel(kernel, format) + CheckFrameKernel(kernel, format);
+            printf("%s %s: %s\n", DiffKernelName(kernel), PixelFormatName(format), kernelFailures == 0 ? "ok" : "FAILED");
+            failures += kernelFailures;
+        }
+        ++tested;
+    }
+    printf("%d vector kernel(s) checked against scalar, %d mismatch(es)\n", tested, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Detector settings compared between the single-band and the banded path
+struct BandCase {
+    const char* name;
+    DetectionMode mode;
+    bool verifyHashes;
+    int sampleInterval;
+};
+
+static const BandCase kBandCases[] = {
+    { "pixel diff", DetectionMode::PixelDiff, false, 0 },
+    { "tile hash", DetectionMode::TileHash, false, 0 },
+    { "tile hash verified", DetectionMode::TileHash, true, 0 },
+    { "pyramid", DetectionMode::Pyramid, false, 0 },
+    { "background", DetectionMode::Background, false, 0 },
+    { "pixel diff sampled", DetectionMode::PixelDiff, false, 4 }
+};
+
+// Threads and bands of the banded runs; more bands than tile rows are clamped to one per row
+static const int kBandLayouts[][2] = { { 1, 0 }, { 2, 0 }, { 2, 3 }, { 4, 0 }, { 4, 7 }, { 3, 1000 } };
+
+// Function to sort boxes so results are compared independently of the order bands emit them in
+static void SortBoxes(std::vector<Box>& boxes) {
+    std::sort(boxes.begin(), boxes.end(), [](const Box& a, const Box& b) {
+        if (a.top != b.top) return a.top < b.top;
+        if (a.left != b.left) return a.left < b.left;
+        if (a.bottom != b.bottom) return a.bottom < b.bottom;
+        return a.right < b.right;
+    });
+}
+
+// Function to check two box lists are identical, in order
+static bool SameBoxes(const std::vector<Box>& a, const std::vector<Box>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Box& x, const Box& y) {
+        return x.left == y.left && x.top == y.top && x.right == y.right && x.bottom == y.bottom;
+    });
+}
+
+// Function to run one detector setting on a scene with sprites, a video and blinking carets whose
+// size is not a whole number of tiles, once with one band on one thread and once per band layout,
+// and compare every frame's boxes, activity regions and changed pixel count
+static int CheckBandCase(const BandCase& bandCase) {
+    const int width = 1000;
+    const int height = 563;
+    const int frames = 40;
+
+    DetectorConfig config;
+    config.mode = bandCase.mode;
+    config.verifyHashes = bandCase.verifyHashes;
+    config.sampling.sampleInterval = bandCase.sampleInterval;
+    config.threadCount = 1;
+    config.bandCount = 1;
+    MotionDetector reference(config);
+    std::vector<std::unique_ptr<MotionDetector>> banded;
+    for (const int* layout : kBandLayouts) {
+        config.threadCount = layout[0];
+        config.bandCount = layout[1];
+        banded.push_back(std::unique_ptr<MotionDetector>(new MotionDetector(config)));
+    }
+
+    SyntheticScene scene(width, height, 7);
+    scene.AddRandomSprites(24, 120);
+    for (int i = 0; i < 4; ++i) {
+        SceneSprite caret = { 60 + i * 230, 40 + i * 120, 2, 18, 0, 0, 0xFF101010u, 3 + i };
+        scene.AddSprite(caret);
+    }
+    scene.SetVideo(380, 190, 700, 370);
+
+    std::vector<uint8_t> previousPixels;
+    FrameView previous;
+    std::vector<Box> expectedBoxes, boxes, expectedRegions, regions;
+    int failures = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        scene.Step();
+        FrameView current = scene.View();
+        // Pixel diffing needs a previous frame; the other modes start their state on the first one
+        if (previous.pixels != nullptr || bandCase.mode != DetectionMode::PixelDiff) {
+            reference.Detect(current, previous, expectedBoxes);
+            SortBoxes(expectedBoxes);
+            expectedRegions = reference.ActivityRegions();
+            SortBoxes(expectedRegions);
+            for (size_t i = 0; i < banded.size(); ++i) {
+                MotionDetector& detector = *banded[i];
+                detector.Detect(current, previous, boxes);
+                SortBoxes(boxes);
+                regions = detector.ActivityRegions();
+                SortBoxes(regions);
+                if (!SameBoxes(boxes, expectedBoxes) || !SameBoxes(regions, expectedRegions) || detector.ChangedPixels() != reference.ChangedPixels()) {
+                    if (failures < 10) {
+                        printf("  %s, %d thread(s), %d band(s), frame %d: %zu boxes, %zu regions, %zu changed pixels; one band %zu, %zu, %zu\n",
+                            bandCase.name, kBandLayouts[i][0], kBandLayouts[i][1], frame, boxes.size(), regions.size(), detector.ChangedPixels(),
+                            expectedBoxes.size(), expectedRegions.size(), reference.ChangedPixels());
+                    }
+                    ++failures;
+                }
+            }
+        }
+        previousPixels.assign(current.pixels, current.pixels + static_cast<size_t>(current.rowPitch) * current.height);
+        previous = current;
+        previous.pixels = previousPixels.data();
+    }
+    return failures;
+}
+
+// Function to check that splitting detection into bands on several threads finds exactly the
+// boxes of the single-band path in every detection mode
+static int RunBandTests() {
+    int failures = 0;
+    for (const BandCase& bandCase : kBandCases) {
+        int caseFailures = CheckBandCase(bandCase);
+        printf("%s: %s\n", bandCase.name, caseFailures == 0 ? "ok" : "FAILED");
+        failures += caseFailures;
+    }
+    printf("%d banded frame(s) differ from the single-band result\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Detect listener remembering the last detected frame, which the detect stage keeps as the
+// previous frame until the next one is detected
+class HeldFrameListener : public DetectListener {
+public:
+    void OnFrameDetected(const PipelineFrame& frame, const MotionDetector&) override { held.store(&frame); }
+
+    std::atomic<const PipelineFrame*> held{ nullptr };
+};
+
+// Capture stage counting the captures into the frame the detect stage still holds
+class CheckedCapture : public CaptureStage {
+public:
+    CheckedCapture(int width, int height, const HeldFrameListener& listener) : width(width), height(height), listener(listener) {}
+
+    bool Capture(PipelineFrame& frame) override {
+        overwrites += &frame == listener.held.load() ? 1 : 0;
+        memset(frame.pixels.data(), ++value, frame.pixels.size());
+        frame.view.pixels = frame.pixels.data();
+        frame.view.width = width;
+        frame.view.height = height;
+        frame.view.rowPitch = width * 4;
+        frame.captureTimeUs = PipelineClockUs();
+        return true;
+    }
+
+    int overwrites = 0;
+
+private:
+    int width;
+    int height;
+    const HeldFrameListener& listener;
+    uint8_t value = 0;
+};
+
+class NullRender : public RenderStage {
+public:
+    void Render(const PipelineResult&) override {}
+};
+
+// Function to start and stop a pipeline many times and check the capture stage is never handed
+// the frame the detect stage keeps to diff against. Slots the last run left in its queues must
+// not be handed out a second time by the next Start.
+static int RunRestartTests() {
+    const int kRestarts = 200;
+    PipelineConfig config;
+    config.width = 64;
+    config.height = 64;
+    HeldFrameListener listener;
+    CheckedCapture capture(config.width, config.height, listener);
+    NullRender render;
+    FramePipeline pipeline(config, capture, render, &listener);
+    for (int i = 0; i < kRestarts; ++i) {
+        listener.held.store(nullptr);
+        pipeline.Start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        pipeline.Stop();
+    }
+    printf("%d restarts, %llu frames detected, %d capture(s) into the frame held for diffing\n", kRestarts,
+           static_cast<unsigned long long>(pipeline.Stats().detected), capture.overwrites);
+    return capture.overwrites == 0 ? 0 : 1;
+}
+
+// Detector settings the overlay can record a delta trace with
+struct RecordCase {
+    const char* name;
+    DetectionMode mode;
+    int sampleInterval;
+    // Whether the mask loaded halfway excludes half of the video instead of being empty
+    bool maskVideo;
+};
+
+static const RecordCase kRecordCases[] = {
+    { "pixel diff", DetectionMode::PixelDiff, 0, false },
+    { "pixel diff masked", DetectionMode::PixelDiff, 0, true },
+    { "pixel diff sampled", DetectionMode::PixelDiff, 8, false },
+    { "tile hash", DetectionMode::TileHash, 0, false },
+    { "background", DetectionMode::Background, 0, false },
+    { "pyramid", DetectionMode::Pyramid, 0, false },
+};
+
+static const char* const kRecordPath = "overlay_tests_record.trace";
+
+// Function to record a scene with sprites, blinking carets and a video into a delta trace the way
+// the overlay does, encoding the detector's tile map when it is exact and comparing tile hashes
+// otherwise, then replay the trace and count the frames that do not decode to the captured pixels.
+// Halfway through a mask is loaded, which restarts the detector's state as a reload does.
+static int CheckRecordCase(const RecordCase& recordCase) {
+    const int width = 480;
+    const int height = 270;
+    const int frames = 80;
+
+    DetectorConfig config;
+    config.mode = recordCase.mode;
+    config.sampling.sampleInterval = recordCase.sampleInterval;
+    MotionDetector detector(config);
+    TraceWriterOptions options;
+    options.encoding = TraceEncoding::DeltaTiles;
+    options.tileSize = config.tileSize;
+    TraceWriter writer;
+    if (!writer.Open(kRecordPath, width, height, options)) {
+        printf("  %s: cannot create %s\n", recordCase.name, kRecordPath);
+        return 1;
+    }
+
+    SyntheticScene scene(width, height, 11);
+    scene.AddRandomSprites(10, 60);
+    for (int i = 0; i < 3; ++i) {
+        SceneSprite caret = { 40 + i * 150, 30 + i * 80, 2, 18, 0, 0, 0xFF101010u, 3 + i };
+        scene.AddSprite(caret);
+    }
+    scene.SetVideo(160, 90, 330, 200);
+
+    const size_t frameBytes = static_cast<size_t>(width) * height * 4;
+    std::vector<uint8_t> captured(frameBytes * frames);
+    FrameView previous;
+    std::vector<Box> boxes;
+    int mapFrames = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        scene.Step();
+        if (frame == frames / 2) {
+            std::vector<MaskRegion> regions;
+            if (recordCase.maskVideo) {
+                MaskRegion region;
+                region.box = { 160, 90, 250, 200 };
+                regions.push_back(region);
+            }
+            detector.SetRegions(regions);
+        }
+        FrameView current = scene.View();
+        uint8_t* copy = &captured[frameBytes * frame];
+        std::copy(current.pixels, current.pixels + frameBytes, copy);
+        // The pipeline compares its first frame with itself
+        detector.Detect(current, previous.pixels ? previous : current, boxes);
+        bool exact = detector.TilesAreExact();
+        mapFrames += exact ? 1 : 0;
+        writer.WriteFrame(current, frame * 16667, exact ? &detector.Tiles() : nullptr);
+        previous = current;
+        previous.pixels = copy;
+    }
+    writer.Close();
+
+    ReplayFrameSource source;
+    int failures = 0;
+    if (!source.Open(kRecordPath) || source.FrameCount() != static_cast<uint32_t>(frames)) {
+        printf("  %s: cannot replay %s\n", recordCase.name, kRecordPath);
+        failures = frames;
+    }
+    Frame decoded;
+    for (int frame = 0; failures != frames && frame < frames; ++frame) {
+        bool same = source.NextFrame(decoded);
+        for (int y = 0; same && y < height; ++y) {
+            same = memcmp(decoded.view.Row(y), &captured[frameBytes * frame + static_cast<size_t>(y) * width * 4], static_cast<size_t>(width) * 4) == 0;
+        }
+        if (!same && failures < 5) {
+            printf("  %s, frame %d: decoded pixels differ from the captured frame\n", recordCase.name, frame);
+        }
+        failures += same ? 0 : 1;
+    }
+    remove(kRecordPath);
+    printf("%s: %d of %d frame(s) from the detector's tile map, %s\n", recordCase.name, mapFrames, frames, failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
+
+// Function to check that recording reuses the detector's tile map only when it holds every change
+static int RunRecordTests() {
+    int failures = 0;
+    for (const RecordCase& recordCase : kRecordCases) {
+        failures += CheckRecordCase(recordCase);
+    }
+    printf("%d recorded frame(s) decode differently from the captured frames\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Manual clock on which a change is reported while the loop sleeps, after `changeAfterUs`
+class ChangeDuringSleepClock : public ManualSchedulerClock {
+public:
+    void SleepUntil(int64_t deadlineUs) override {
+        if (scheduler && changeAfterUs > 0) {
+            Advance(changeAfterUs);
+            changeAfterUs = 0;
+            scheduler->ReportFrame(true);
+        }
+        ManualSchedulerClock::SleepUntil(deadlineUs);
+    }
+
+    FrameScheduler* scheduler = nullptr;
+    int64_t changeAfterUs = 0;
+};
+
+// Function to print a failed schedule check, returning 1 if it failed
+static int CheckSchedule(bool ok, const char* what, int64_t actual, int64_t expected) {
+    if (!ok) {
+        printf("  %s: %lld, expected %lld\n", what, static_cast<long long>(actual), static_cast<long long>(expected));
+    }
+    return ok ? 0 : 1;
+}
+
+// Function to run a 60 fps schedule on a manual clock and check that frames start on fixed
+// deadlines however long they take, that the interval doubles after each idleFrames frames without
+// change up to maxIntervalMs, that a change cuts a backed-off wait short and restores the target
+// rate, and that an overrun frame counts one missed deadline and is not followed by a burst
+static int RunScheduleTests() {
+    SchedulerConfig config;
+    config.targetFps = 60;
+    config.idleFrames = 30;
+    config.maxIntervalMs = 250;
+    const int64_t target = 1000000 / 60;
+    const int64_t cap = 250000;
+    ChangeDuringSleepClock clock;
+    FrameScheduler scheduler(config, clock);
+    clock.scheduler = &scheduler;
+    int failures = 0;
+
+    // Busy frames: each takes 5 ms of work, deadlines stay 1/60 s apart without drift
+    int64_t start = scheduler.WaitForNextFrame();
+    for (int frame = 1; frame <= 20; ++frame) {
+        clock.Advance(5000);
+        scheduler.ReportFrame(true);
+        int64_t now = scheduler.WaitForNextFrame();
+        failures += CheckSchedule(now == start + frame * target, "busy frame start", now - start, frame * target);
+    }
+
+    // Idle frames: the gap doubles after every 30 of them until it reaches the cap
+    int64_t last = start + 20 * target;
+    int64_t expected = target;
+    for (int frame = 0; frame < 200; ++frame) {
+        scheduler.ReportFrame(false);
+        int64_t now = scheduler.WaitForNextFrame();
+        // The wait after every 30th idle report is the first at the longer interval
+        if ((frame + 1) % config.idleFrames == 0) {
+            expected = std::min(expected * 2, cap);
+        }
+        failures += CheckSchedule(now - last == expected, "idle frame interval", now - last, expected);
+        last = now;
+    }
+    failures += CheckSchedule(expected == cap, "idle interval after 200 frames", expected, cap);
+    failures += CheckSchedule(scheduler.IntervalUs() == cap, "scheduled interval", scheduler.IntervalUs(), cap);
+
+    // A change 3 ms into a backed-off wait ends it at once; the next frame is at the target rate
+    scheduler.ReportFrame(false);
+    clock.changeAfterUs = 3000;
+    int64_t woken = scheduler.WaitForNextFrame();
+    failures += CheckSchedule(woken - last == 3000, "wake after a change", woken - last, 3000);
+    failures += CheckSchedule(scheduler.Stats().wakeups == 1, "wakeups", static_cast<int64_t>(scheduler.Stats().wakeups), 1);
+    int64_t next = scheduler.WaitForNextFrame();
+    failures += CheckSchedule(next - woken == target, "interval after a change", next - woken, target);
+
+    // A frame overrunning by 2.5 intervals misses one deadline; the schedule restarts from it
+    clock.Advance(target * 7 / 2);
+    scheduler.ReportFrame(true);
+    int64_t late = scheduler.WaitForNextFrame();
+    failures += CheckSchedule(late == next + target * 7 / 2, "start after an overrun", late - next, target * 7 / 2);
+    failures += CheckSchedule(scheduler.Stats().missedDeadlines == 1, "missed deadlines", static_cast<int64_t>(scheduler.Stats().missedDeadlines), 1);
+    last = late;
+    for (int frame = 0; frame < 5; ++frame) {
+        scheduler.ReportFrame(true);
+        int64_t now = scheduler.WaitForNextFrame();
+        failures += CheckSchedule(now - last == target, "interval after an overrun", now - last, target);
+        last = now;
+    }
+    failures += CheckSchedule(scheduler.Stats().missedDeadlines == 1, "missed deadlines after catching up", static_cast<int64_t>(scheduler.Stats().missedDeadlines), 1);
+
+    printf("%d schedule check(s) failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// Search budgets tried, against a video whose changed tiles match no candidate shift
+static const int kSearchBudgets[] = { 1, 5, 32, 50, 200 };
+
+// Function to estimate motion on a scene whose video covers most of the frame, so every frame
+// leaves hundreds of tiles unmatched, and check no frame runs more full searches than the budget
+static int RunMotionTests() {
+    const int width = 640;
+    const int height = 360;
+    const int frames = 12;
+    int failures = 0;
+    for (int budget : kSearchBudgets) {
+        SyntheticScene scene(width, height, 5);
+        scene.SetVideo(0, 0, width, 340);
+        MotionDetector detector;
+        MotionConfig config;
+        config.searchBudget = budget;
+        MotionEstimator estimator(config);
+        std::vector<uint8_t> previousPixels;
+        FrameView previous;
+        std::vector<Box> boxes;
+        std::vector<MoveRect> moves;
+        size_t mostSearches = 0;
+        size_t mostChanged = 0;
+        for (int frame = 0; frame < frames; ++frame) {
+            scene.Step();
+            FrameView current = scene.View();
+            if (previous.pixels != nullptr) {
+                detector.Detect(current, previous, boxes);
+                estimator.Estimate(current, previous, detector.Tiles(), moves, boxes);
+                const MotionStats& stats = estimator.Stats();
+                mostSearches = std::max(mostSearches, stats.searches);
+                mostChanged = std::max(mostChanged, stats.changedTiles);
+                if (stats.searches > static_cast<size_t>(budget)) {
+                    printf("  budget %d, frame %d: %zu searches over %zu changed tiles\n", budget, frame, stats.searches, stats.changedTiles);
+                    ++failures;
+                }
+            }
+            previousPixels.assign(current.pixels, current.pixels + static_cast<size_t>(current.rowPitch) * current.height);
+            previous = current;
+            previous.pixels = previousPixels.data();
+        }
+        printf("budget %d: at most %zu searches per frame, up to %zu changed tiles\n", budget, mostSearches, mostChanged);
+    }
+    printf("%d frame(s) searched more tiles than the budget\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "diff") == 0) {
+        return RunDiffTests();
+    }
+    if (argc >= 2 && strcmp(argv[1], "bands") == 0) {
+        return RunBandTests();
+    }
+    if (argc >= 2 && strcmp(argv[1], "restart") == 0) {
+        return RunRestartTests();
+    }
+    if (argc >= 2 && strcmp(argv[1], "record") == 0) {
+        return RunRecordTests();
+    }
+    if (argc >= 2 && strcmp(argv[1], "schedule") == 0) {
+        return RunScheduleTests();
+    }
+    if (argc >= 2 && strcmp(argv[1], "motion") == 0) {
+        return RunMotionTests();
+    }
+    printf("usage: overlay_tests diff|bands|restart|record|schedule|motion\n");
+    return 2;
+}